@@ -0,0 +1,119 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+// Frame compression on the responses that dominate the wire: bytes sent
+// and end-to-end latency (pack, transfer, unpack) per codec. The link is
+// modelled as `mbit` Mbit/s of payload bandwidth (default 100), so the
+// transfer time is wire bytes / rate; pack and unpack are measured.
+//
+//   bench_compression [mbit] [repetitions]
+
+#include "wininspect/base64.hpp"
+#include "wininspect/compress.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace wininspect;
+using Clock = std::chrono::steady_clock;
+
+// A 1920x1080 24-bit BMP of a desktop: a gradient wallpaper, flat windows
+// with title bars, and rows of dark "glyph" pixels for text, base64'd into
+// a screen.capture response.
+static std::string capture_response() {
+  const int w = 1920, h = 1080, stride = w * 3;
+  std::vector<std::uint8_t> bmp(54 + (size_t)stride * h);
+  bmp[0] = 'B';
+  bmp[1] = 'M';
+  std::mt19937 rng(1);
+  for (int y = 0; y < h; y++) {
+    auto *row = bmp.data() + 54 + (size_t)y * stride;
+    for (int x = 0; x < w; x++) {
+      std::uint8_t r = (std::uint8_t)(40 + y / 12), g = (std::uint8_t)(90 + x / 30), b = 160;
+      for (int win = 0; win < 4; win++) {
+        int x0 = 120 + win * 420, y0 = 100 + win * 150;
+        if (x < x0 || x >= x0 + 700 || y < y0 || y >= y0 + 500) continue;
+        if (y < y0 + 30) {
+          r = 0; g = 84; b = 166; // title bar
+        } else {
+          r = g = b = 240;
+          bool text_line = (y - y0) % 22 < 12 && x > x0 + 12 && x < x0 + 650;
+          if (text_line && rng() % 5 == 0) r = g = b = 30;
+        }
+      }
+      row[3 * x] = b;
+      row[3 * x + 1] = g;
+      row[3 * x + 2] = r;
+    }
+  }
+  return "{\"id\":\"1\",\"ok\":true,\"result\":{\"width\":1920,\"height\":1080,\"data_b64\":\"" +
+         base64::encode(bmp) + "\"}}";
+}
+
+// A window.getTree-style response: nested controls with repetitive keys.
+static std::string tree_response() {
+  std::string s = "{\"id\":\"2\",\"ok\":true,\"result\":[";
+  for (int i = 0; i < 4000; i++) {
+    char node[256];
+    std::snprintf(node, sizeof(node),
+                  "%s{\"hwnd\":\"0x%06X\",\"parent\":\"0x%06X\",\"class_name\":\"%s\","
+                  "\"title\":\"Item %d\",\"visible\":true,\"enabled\":%s,\"rect\":{\"left\":%d,"
+                  "\"top\":%d,\"right\":%d,\"bottom\":%d}}",
+                  i ? "," : "", 0x10000 + i * 4, 0x10000 + (i / 8) * 4,
+                  i % 3 ? "Button" : "SysListView32", i, i % 7 ? "true" : "false", i % 640,
+                  i % 480, i % 640 + 80, i % 480 + 24);
+    s += node;
+  }
+  return s + "]}";
+}
+
+int main(int argc, char **argv) {
+  double mbit = argc > 1 ? std::atof(argv[1]) : 100.0;
+  int reps = argc > 2 ? std::atoi(argv[2]) : 5;
+  const size_t record = 4 + 28; // length word, nonce and tag
+
+  struct Payload {
+    const char *name;
+    std::string body;
+  };
+  Payload payloads[] = {{"screen.capture", capture_response()}, {"window.getTree", tree_response()}};
+
+  std::printf("link: %.0f Mbit/s\n", mbit);
+  std::printf("%-15s %-5s %11s %7s %9s %9s %10s %10s\n", "response", "codec", "wire bytes",
+              "ratio", "pack ms", "unpack ms", "xfer ms", "total ms");
+  for (auto &p : payloads) {
+    std::vector<std::string> codecs = {"none"};
+    for (auto &c : compress::available()) codecs.push_back(c);
+    for (auto &name : codecs) {
+      auto codec = compress::codec_from_name(name);
+      std::string packed, out;
+      double pack_ms = 1e9, unpack_ms = 1e9;
+      size_t wire = p.body.size();
+      for (int r = 0; r < reps && codec != compress::Codec::None; r++) {
+        packed.clear();
+        auto t0 = Clock::now();
+        if (!compress::pack(codec, p.body.data(), p.body.size(), packed)) break;
+        auto t1 = Clock::now();
+        if (!compress::unpack(packed.data(), packed.size(), p.body.size(), out) || out != p.body) {
+          std::printf("%s: %s round trip failed\n", p.name, name.c_str());
+          return 1;
+        }
+        auto t2 = Clock::now();
+        pack_ms = std::min(pack_ms, std::chrono::duration<double, std::milli>(t1 - t0).count());
+        unpack_ms = std::min(unpack_ms, std::chrono::duration<double, std::milli>(t2 - t1).count());
+        wire = packed.size();
+      }
+      if (wire == p.body.size()) pack_ms = unpack_ms = 0;
+      wire += record;
+      double xfer_ms = (double)wire * 8 / (mbit * 1e6) * 1e3;
+      std::printf("%-15s %-5s %11zu %6.1fx %9.2f %9.2f %10.1f %10.1f\n", p.name, name.c_str(),
+                  wire, (double)(p.body.size() + record) / (double)wire, pack_ms, unpack_ms,
+                  xfer_ms, pack_ms + xfer_ms + unpack_ms);
+    }
+  }
+  return 0;
+}
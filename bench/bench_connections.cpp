@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+// Connection-model benchmark: holds `idle` open local connections against
+// a LocalServer over FakeBackend, then drives daemon.health round-trips
+// from `clients` busy connections for each I/O thread count. Reports
+// requests/s, the process thread count, and idle resident memory.
+// Raise `ulimit -n` for large idle counts.
+//
+//   bench_connections [idle] [clients] [seconds]
+
+#include "io_service.hpp"
+#include "local_server.hpp"
+#include "server_state.hpp"
+#include "transport.hpp"
+#include "wininspect/fake_backend.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace wininspect;
+using namespace wininspectd;
+using Clock = std::chrono::steady_clock;
+
+// Linux only; 0 elsewhere.
+static long proc_status(const char *key) {
+  std::ifstream f("/proc/self/status");
+  std::string line;
+  while (std::getline(f, line))
+    if (line.rfind(key, 0) == 0) return std::atol(line.c_str() + std::string(key).size());
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  int idle = argc > 1 ? std::atoi(argv[1]) : 1000;
+  int clients = argc > 2 ? std::atoi(argv[2]) : 32;
+  double seconds = argc > 3 ? std::atof(argv[3]) : 2;
+
+  unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<size_t> thread_counts;
+  for (size_t n = 1; n <= cores; n *= 2) thread_counts.push_back(n);
+  if (thread_counts.back() != cores) thread_counts.push_back(cores);
+
+  std::vector<FakeWindow> wins;
+  for (hwnd_u64 h = 1; h <= 50; h++) wins.push_back({h, 0, 0, "W", "C", true});
+  FakeBackend fb(wins);
+  const std::string req = "{\"id\":\"1\",\"method\":\"daemon.health\",\"params\":{}}";
+
+  std::printf("%-8s %8s %8s %12s %9s %11s\n", "threads", "idle", "clients", "req/s",
+              "proc_thr", "rss_kb");
+  for (size_t nthreads : thread_counts) {
+    ServerState st;
+    st.max_connections = idle + clients + 16;
+    st.io = std::make_shared<IoService>(nthreads);
+    std::atomic<bool> running{true};
+    std::string name = "wininspectd-bench-" + std::to_string(nthreads);
+    LocalServer srv(&st, &fb);
+    std::thread accept([&] { srv.start(&running, name); });
+
+    auto connect = [&] {
+      for (int k = 0; k < 500; k++) {
+        if (auto c = connect_local(name)) return c;
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+      }
+      return std::unique_ptr<IConnection>();
+    };
+    std::vector<std::unique_ptr<IConnection>> idlers;
+    for (int i = 0; i < idle; i++) {
+      auto c = connect();
+      if (!c) {
+        std::fprintf(stderr, "connect failed after %d idle connections\n", i);
+        break;
+      }
+      idlers.push_back(std::move(c));
+    }
+    for (int i = 0; i < 2000 && st.active_connections.load() < (int)idlers.size(); i++)
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    long rss = proc_status("VmRSS:");
+
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> done{0};
+    std::vector<std::thread> ts;
+    for (int i = 0; i < clients; i++) {
+      ts.emplace_back([&] {
+        auto c = connect();
+        if (!c) return;
+        FrameReader reader(*c);
+        std::string r;
+        while (!stop.load()) {
+          if (!write_frame(*c, req) || !reader.read(r)) break;
+          done++;
+        }
+      });
+    }
+    auto t0 = Clock::now();
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    long threads = proc_status("Threads:");
+    stop = true;
+    for (auto &t : ts) t.join();
+    double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    std::printf("%-8zu %8zu %8d %12.0f %9ld %11ld\n", nthreads, idlers.size(), clients,
+                done.load() / secs, threads, rss);
+    idlers.clear();
+    srv.stop();
+    accept.join();
+    st.io->stop();
+  }
+  return 0;
+}
@@ -0,0 +1,78 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+// Record-layer throughput: the allocating encrypt/decrypt pair against
+// in-place seal/open, and seal_batch over pipelined 1 KB responses.
+//
+//   bench_crypto [seconds-per-case]
+
+#include "wininspect/crypto.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace wininspect::crypto;
+using Clock = std::chrono::steady_clock;
+
+// Runs `f` (which processes `bytes` per call) for about `secs`; MB/s.
+template <typename F> static double mbps(double secs, size_t bytes, F &&f) {
+  size_t calls = 0;
+  auto t0 = Clock::now();
+  double el = 0;
+  do {
+    for (int i = 0; i < 8; i++) {
+      if (!f()) return -1;
+      calls++;
+    }
+    el = std::chrono::duration<double>(Clock::now() - t0).count();
+  } while (el < secs);
+  return (double)calls * (double)bytes / el / 1e6;
+}
+
+int main(int argc, char **argv) {
+  double secs = argc > 1 ? std::atof(argv[1]) : 1.0;
+  CryptoSession server(Role::Server), client;
+  auto spub = server.generate_local_key(), cpub = client.generate_local_key();
+  if (!server.compute_shared_secret(cpub) || !client.compute_shared_secret(spub)) {
+    std::printf("built without a crypto backend (WININSPECT_CRYPTO=none); nothing to measure\n");
+    return 0;
+  }
+  std::printf("backend: %s\n", backend_name());
+
+  std::printf("%-10s %16s %16s %16s\n", "frame", "encrypt+decrypt", "seal+open", "seal_batch x16");
+  for (size_t n : {(size_t)1024, (size_t)4 * 1024 * 1024}) {
+    std::string msg(n, 'x');
+    double alloc = mbps(secs, n, [&] {
+      auto ct = server.encrypt(msg);
+      return client.decrypt(ct).size() == n;
+    });
+
+    // One buffer for the life of the loop, as a connection would reuse it.
+    std::vector<uint8_t> rec(RECORD_OVERHEAD + n);
+    double inplace = mbps(secs, n, [&] {
+      std::memcpy(rec.data() + RECORD_OVERHEAD, msg.data(), n); // the serialized response
+      std::span<const uint8_t> pt(rec.data() + RECORD_OVERHEAD, n);
+      return server.seal(pt, rec) && client.open(rec);
+    });
+
+    double batch = -1;
+    if (n <= 64 * 1024) {
+      std::vector<std::vector<uint8_t>> recs(16, std::vector<uint8_t>(RECORD_OVERHEAD + n));
+      std::vector<SealJob> jobs;
+      for (auto &r : recs) jobs.push_back({{(const uint8_t *)msg.data(), n}, r});
+      batch = mbps(secs, 16 * n, [&] {
+        if (!server.seal_batch(jobs)) return false;
+        for (auto &r : recs)
+          if (!client.open(r)) return false;
+        return true;
+      });
+    }
+    std::printf("%-10zu %13.0fMB/s %13.0fMB/s ", n, alloc, inplace);
+    if (batch >= 0) std::printf("%13.0fMB/s\n", batch);
+    else std::printf("%16s\n", "-");
+  }
+  return 0;
+}
@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+// wrk-style HTTP gateway load test: `conns` client threads send
+// GET /api/v1/health to an HttpServer over FakeBackend for `seconds`,
+// first with a new connection per request (the old gateway's only mode),
+// then over keep-alive connections one request at a time, then with
+// `depth` requests pipelined per connection. Reports requests/s and
+// p50/p99 latency per request.
+//
+//   bench_http [conns] [depth] [seconds]
+
+#include "http_server.hpp"
+#include "io_service.hpp"
+#include "server_state.hpp"
+#include "transport.hpp"
+#include "wininspect/core.hpp"
+#include "wininspect/fake_backend.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace wininspect;
+using namespace wininspectd;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+// Reads one Content-Length framed response; false on close or error.
+bool read_response(IConnection &c, std::string &buf) {
+  char b[16384];
+  while (true) {
+    size_t end = buf.find("\r\n\r\n");
+    if (end != std::string::npos) {
+      size_t cl = buf.find("Content-Length: ");
+      size_t n = cl < end ? std::strtoul(buf.c_str() + cl + 16, nullptr, 10) : 0;
+      if (buf.size() >= end + 4 + n) {
+        buf.erase(0, end + 4 + n);
+        return true;
+      }
+    }
+    long r = c.read_some(b, sizeof(b));
+    if (r <= 0) return false;
+    buf.append(b, (size_t)r);
+  }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int conns = argc > 1 ? std::atoi(argv[1]) : 32;
+  int depth = argc > 2 ? std::max(1, std::atoi(argv[2])) : 8;
+  double seconds = argc > 3 ? std::atof(argv[3]) : 2;
+
+  std::vector<FakeWindow> wins;
+  for (hwnd_u64 h = 1; h <= 50; h++) wins.push_back({h, 0, 0, "W", "C", true});
+  FakeBackend fb(wins);
+  CoreEngine core(&fb);
+  ServerState st;
+  st.io = std::make_shared<IoService>();
+  std::atomic<bool> running{true};
+  HttpServer srv(core, "", &st);
+  std::thread accept([&] { srv.start(&running, 0); });
+  for (int i = 0; i < 500 && srv.bound_port() == 0; i++)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  int port = srv.bound_port();
+  if (!port) {
+    std::fprintf(stderr, "HTTP server did not start\n");
+    return 1;
+  }
+
+  const std::string keep = "GET /api/v1/health HTTP/1.1\r\nHost: bench\r\n\r\n";
+  const std::string close = "GET /api/v1/health HTTP/1.1\r\nHost: bench\r\nConnection: close\r\n\r\n";
+  struct Mode {
+    const char *name;
+    int depth; // 0: a connection per request
+  } modes[] = {{"close", 0}, {"keep-alive", 1}, {"pipelined", depth}};
+
+  std::printf("%-11s %6s %6s %12s %10s %10s\n", "mode", "conns", "depth", "req/s", "p50_us",
+              "p99_us");
+  for (auto &m : modes) {
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> done{0}, failed{0};
+    std::mutex lat_mu;
+    std::vector<double> lat;
+    std::vector<std::thread> ts;
+    for (int i = 0; i < conns; i++) {
+      ts.emplace_back([&] {
+        std::vector<double> mine;
+        std::unique_ptr<IConnection> c;
+        std::string buf, batch;
+        for (int k = 0; k < std::max(m.depth, 1); k++) batch += keep;
+        while (!stop.load()) {
+          auto t0 = Clock::now();
+          if (m.depth == 0) {
+            buf.clear();
+            c = connect_tcp("127.0.0.1", port);
+            if (!c || !c->write_all(close.data(), close.size()) || !read_response(*c, buf)) {
+              failed++;
+              continue;
+            }
+          } else {
+            if (!c) c = connect_tcp("127.0.0.1", port);
+            bool ok = c && c->write_all(batch.data(), batch.size());
+            for (int k = 0; ok && k < m.depth; k++) ok = read_response(*c, buf);
+            if (!ok) {
+              failed++;
+              c.reset();
+              buf.clear();
+              continue;
+            }
+          }
+          // Each of a pipelined batch waited about as long as the batch.
+          double us = std::chrono::duration<double, std::micro>(Clock::now() - t0).count();
+          for (int k = 0; k < std::max(m.depth, 1); k++) mine.push_back(us);
+          done += std::max(m.depth, 1);
+        }
+        std::lock_guard<std::mutex> lk(lat_mu);
+        lat.insert(lat.end(), mine.begin(), mine.end());
+      });
+    }
+    auto t0 = Clock::now();
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop = true;
+    for (auto &t : ts) t.join();
+    double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    std::sort(lat.begin(), lat.end());
+    auto pct = [&](double p) { return lat.empty() ? 0.0 : lat[(size_t)(p * (lat.size() - 1))]; };
+    std::printf("%-11s %6d %6d %12.0f %10.0f %10.0f", m.name, conns, std::max(m.depth, 1),
+                done.load() / secs, pct(0.50), pct(0.99));
+    if (failed.load()) std::printf("  (%llu failed)", (unsigned long long)failed.load());
+    std::printf("\n");
+  }
+
+  srv.stop();
+  accept.join();
+  st.io->stop();
+  return 0;
+}
@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+// Regex micro-benchmark: compile cost (std::regex, NFA compile, cache hit),
+// per-title search cost, and a catastrophic-backtracking pattern.
+//
+//   bench_regex [iterations]
+
+#include "wininspect/regex_engine.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <regex>
+#include <string>
+
+using namespace wininspect;
+using Clock = std::chrono::steady_clock;
+
+template <typename F> static double time_ns(int iters, F &&f) {
+  auto t0 = Clock::now();
+  size_t sink = 0;
+  for (int i = 0; i < iters; i++) sink += f();
+  auto t1 = Clock::now();
+  if (sink == (size_t)-1) std::puts("");
+  return std::chrono::duration<double, std::nano>(t1 - t0).count() / iters;
+}
+
+int main(int argc, char **argv) {
+  int iters = argc > 1 ? std::atoi(argv[1]) : 20000;
+  const char *patterns[] = {"Notepad", "^Untitled - .*pad$", "[A-Z]\\w+ \\d{4}",
+                            "(Report|Summary) (FINAL|draft)", "Chrome_WidgetWin_\\d"};
+  const std::string title = "Quarterly Report FINAL 2026 - Microsoft Excel";
+
+  std::printf("%-34s %12s %12s %12s %12s %12s\n", "pattern", "std compile",
+              "nfa compile", "cache hit", "std search", "nfa search");
+  RegexCache cache;
+  for (auto p : patterns) {
+    double std_c = time_ns(iters / 10, [&] { return (size_t)std::regex(p).mark_count(); });
+    double nfa_c = time_ns(iters / 10, [&] { return Regex(p, false).program_size(); });
+    cache.get(p, false);
+    double hit = time_ns(iters, [&] { return (size_t)cache.get(p, false)->program_size(); });
+    std::regex sre(p);
+    Regex nre(p, false);
+    double std_s = time_ns(iters, [&] { return (size_t)std::regex_search(title, sre); });
+    double nfa_s = time_ns(iters, [&] { return (size_t)nre.search(title); });
+    std::printf("%-34s %10.0fns %10.0fns %10.0fns %10.0fns %10.0fns\n", p, std_c,
+                nfa_c, hit, std_s, nfa_s);
+  }
+
+  // ^(a+)+$ against "aaa...ab": std::regex backtracks exponentially, the
+  // automaton stays linear. Keep the std::regex input short enough to finish.
+  std::printf("\ncatastrophic pattern ^(a+)+$\n");
+  Regex evil("^(a+)+$", false);
+  std::regex evil_std("^(a+)+$");
+  for (int n : {16, 20, 24}) {
+    std::string s(n, 'a');
+    s += 'b';
+    double nfa = time_ns(10, [&] { return (size_t)evil.search(s); });
+    double stdr = time_ns(1, [&] { return (size_t)std::regex_search(s, evil_std); });
+    std::printf("  n=%-6d std %12.0fns   nfa %10.0fns\n", n, stdr, nfa);
+  }
+  for (int n : {1000, 100000}) {
+    std::string s(n, 'a');
+    s += 'b';
+    double nfa = time_ns(10, [&] { return (size_t)evil.search(s); });
+    std::printf("  n=%-6d std %14s   nfa %10.0fns\n", n, "(skipped)", nfa);
+  }
+  return 0;
+}
@@ -0,0 +1,216 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+// Rendezvous server load test: `daemons` simulated daemons register over
+// `conns` keep-alive connections, then heartbeat for `seconds` while 1 in
+// 100 requests re-registers a daemon on a new port and `watchers` clients
+// poll GET /instances?since=V. A further batch of daemons registers with a
+// 1 s TTL and goes silent, so the run ends by expiring them. Reports
+// request throughput and p50/p99 latency, what the watchers were sent
+// compared with re-fetching the full list, and how long expiry took.
+//
+//   bench_rendezvous [daemons] [conns] [watchers] [seconds]
+
+#include "rendezvous_registry.hpp"
+#include "rendezvous_server.hpp"
+#include "transport.hpp"
+#include "wininspect/tinyjson.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace wininspect;
+using namespace wininspectd;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+// Sends one request and reads its response; false on close or error.
+bool roundtrip(IConnection &c, const std::string &req, std::string &buf, int *code = nullptr,
+               std::string *body = nullptr) {
+  if (!c.write_all(req.data(), req.size())) return false;
+  char b[65536];
+  while (true) {
+    size_t end = buf.find("\r\n\r\n");
+    if (end != std::string::npos) {
+      size_t cl = buf.find("Content-Length: ");
+      size_t n = cl < end ? std::strtoul(buf.c_str() + cl + 16, nullptr, 10) : 0;
+      if (buf.size() >= end + 4 + n) {
+        if (code) *code = std::atoi(buf.c_str() + 9);
+        if (body) body->assign(buf, end + 4, n);
+        buf.erase(0, end + 4 + n);
+        return true;
+      }
+    }
+    long r = c.read_some(b, sizeof(b));
+    if (r <= 0) return false;
+    buf.append(b, (size_t)r);
+  }
+}
+
+std::string reg_req(const std::string &uuid, int port, int ttl_sec) {
+  std::string body = R"({"uuid":")" + uuid + R"(","name":"bench","host":"10.1.2.3","port":)" +
+                     std::to_string(port) + R"(,"ttl_sec":)" + std::to_string(ttl_sec) +
+                     R"(,"pubkey":"AAAAC3NzaC1lZDI1NTE5AAAAIGJlbmNoLWtleS1wYWRkaW5n"})";
+  return "POST /api/v1/rendezvous/register HTTP/1.1\r\nHost: bench\r\nContent-Length: " +
+         std::to_string(body.size()) + "\r\n\r\n" + body;
+}
+
+std::string get_req(const std::string &path) {
+  return "GET " + path + " HTTP/1.1\r\nHost: bench\r\n\r\n";
+}
+
+double pct(std::vector<double> &v, double p) {
+  if (v.empty()) return 0;
+  std::sort(v.begin(), v.end());
+  return v[(size_t)(p * (v.size() - 1))];
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int daemons = argc > 1 ? std::atoi(argv[1]) : 10000;
+  int conns = argc > 2 ? std::max(1, std::atoi(argv[2])) : 64;
+  int watchers = argc > 3 ? std::atoi(argv[3]) : 4;
+  double seconds = argc > 4 ? std::atof(argv[4]) : 3;
+  int dead = std::max(1, daemons / 10);
+
+  RendezvousRegistry::Options opts;
+  opts.tick_ms = 50;
+  RendezvousRegistry reg(opts, std::chrono::duration_cast<std::chrono::milliseconds>(
+                                   Clock::now().time_since_epoch())
+                                   .count());
+  RendezvousServer srv(reg);
+  std::atomic<bool> running{true};
+  std::thread accept([&] { srv.start(&running, 0); });
+  for (int i = 0; i < 500 && srv.bound_port() == 0; i++)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  int port = srv.bound_port();
+  if (!port) {
+    std::fprintf(stderr, "rendezvous server did not start\n");
+    return 1;
+  }
+
+  // ── Registration ──
+  std::vector<std::unique_ptr<IConnection>> cs(conns);
+  for (auto &c : cs)
+    if (!(c = connect_tcp("127.0.0.1", port))) {
+      std::fprintf(stderr, "connect failed\n");
+      return 1;
+    }
+  auto uuid = [](int i) { return "daemon-" + std::to_string(i); };
+  auto t0 = Clock::now();
+  {
+    std::vector<std::thread> ts;
+    for (int k = 0; k < conns; k++)
+      ts.emplace_back([&, k] {
+        std::string buf;
+        for (int i = k; i < daemons + dead; i += conns)
+          (void)roundtrip(*cs[k], reg_req(uuid(i), 5000, i < daemons ? 60 : 1), buf);
+      });
+    for (auto &t : ts) t.join();
+  }
+  auto registered = Clock::now();
+  double reg_secs = std::chrono::duration<double>(registered - t0).count();
+  std::printf("registered %zu daemons over %d connections in %.2f s (%.0f/s)\n", reg.size(),
+              conns, reg_secs, (daemons + dead) / reg_secs);
+
+  // ── Heartbeats, churn and watchers ──
+  std::atomic<bool> stop{false};
+  std::atomic<std::uint64_t> beats{0}, changes{0}, failed{0};
+  std::mutex mu;
+  std::vector<double> lat;
+  std::atomic<std::uint64_t> polls{0}, not_modified{0}, delta_bytes{0}, removed_seen{0};
+  std::vector<std::thread> ts;
+  for (int k = 0; k < conns; k++)
+    ts.emplace_back([&, k] {
+      std::vector<double> mine;
+      std::string buf;
+      unsigned n = 0;
+      for (int i = k; !stop.load(); i = i + conns < daemons ? i + conns : k) {
+        bool change = ++n % 100 == 0;
+        std::string req = change ? reg_req(uuid(i), 5000 + (int)n % 1000, 60)
+                                 : "PUT /api/v1/rendezvous/heartbeat/" + uuid(i) +
+                                       " HTTP/1.1\r\nHost: bench\r\n\r\n";
+        auto s = Clock::now();
+        if (!roundtrip(*cs[k], req, buf)) {
+          failed++;
+          break;
+        }
+        mine.push_back(std::chrono::duration<double, std::micro>(Clock::now() - s).count());
+        (change ? changes : beats)++;
+      }
+      std::lock_guard<std::mutex> lk(mu);
+      lat.insert(lat.end(), mine.begin(), mine.end());
+    });
+  for (int w = 0; w < watchers; w++)
+    ts.emplace_back([&] {
+      auto c = connect_tcp("127.0.0.1", port);
+      std::string buf, body;
+      std::uint64_t version = 0;
+      int code = 0;
+      while (c && !stop.load()) {
+        if (!roundtrip(*c, get_req("/api/v1/rendezvous/instances?since=" + std::to_string(version)),
+                       buf, &code, &body))
+          break;
+        polls++;
+        if (code == 304) {
+          not_modified++;
+        } else if (code == 200) {
+          auto o = json::parse(body).as_obj();
+          if (version) delta_bytes += body.size(); // the first is the full list
+          version = (std::uint64_t)o.at("version").as_num();
+          removed_seen += o.at("removed").as_arr().size();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      }
+    });
+
+  t0 = Clock::now();
+  std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+
+  // The silent batch (1 s TTL, 3 missed beats) comes due 3 s after
+  // registering; wait for the server's sweep to remove it, and give the
+  // watchers a poll to see that.
+  auto e0 = Clock::now();
+  while (reg.size() > (size_t)daemons && Clock::now() - e0 < std::chrono::seconds(10))
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  double expired_at = std::chrono::duration<double>(Clock::now() - registered).count();
+  std::this_thread::sleep_for(std::chrono::milliseconds(250));
+  stop = true;
+  for (auto &t : ts) t.join();
+  double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+
+  std::string full, buf;
+  auto lc = connect_tcp("127.0.0.1", port);
+  int code = 0;
+  if (lc) (void)roundtrip(*lc, get_req("/api/v1/rendezvous/instances"), buf, &code, &full);
+
+  std::printf("%-10s %8s %8s %12s %10s %10s\n", "phase", "daemons", "conns", "req/s", "p50_us",
+              "p99_us");
+  std::printf("%-10s %8d %8d %12.0f %10.0f %10.0f", "heartbeat", daemons, conns,
+              (beats.load() + changes.load()) / secs, pct(lat, 0.50), pct(lat, 0.99));
+  if (failed.load()) std::printf("  (%llu failed)", (unsigned long long)failed.load());
+  std::printf("\n");
+  std::printf("re-registrations: %llu (changes watchers must see)\n",
+              (unsigned long long)changes.load());
+  std::uint64_t changed_polls = polls.load() - not_modified.load() - (std::uint64_t)watchers;
+  std::printf("watchers: %llu polls, %llu not modified, avg delta %.0f bytes vs full list %zu "
+              "bytes, %llu removals seen\n",
+              (unsigned long long)polls.load(), (unsigned long long)not_modified.load(),
+              changed_polls ? (double)delta_bytes.load() / (double)changed_polls : 0.0,
+              full.size(), (unsigned long long)removed_seen.load());
+  std::printf("expiry: %d silent daemons (due 3.00 s after registering) gone at %.2f s; %zu "
+              "remain\n",
+              dead, expired_at, reg.size());
+
+  srv.stop();
+  accept.join();
+  return 0;
+}
@@ -0,0 +1,112 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+// Window search over a synthetic 50k-window snapshot: trigram index vs. the
+// old per-call std::regex scan over every title and class.
+//
+//   bench_window_index [windows] [iterations]
+
+#include "wininspect/window_index.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+
+using namespace wininspect;
+using Clock = std::chrono::steady_clock;
+
+static std::vector<IndexedWindow> synth(size_t n) {
+  static const char *apps[] = {"Notepad", "Visual Studio Code", "Explorer",
+                               "Calculator", "Paint", "Terminal", "Outlook",
+                               "Excel", "Word", "Firefox", "Chrome", "Slack"};
+  static const char *classes[] = {"Notepad", "Chrome_WidgetWin_1", "CabinetWClass",
+                                  "ApplicationFrameWindow", "MSPaintApp",
+                                  "ConsoleWindowClass", "rctrl_renwnd32",
+                                  "XLMAIN", "OpusApp", "MozillaWindowClass",
+                                  "tooltips_class32", "IME"};
+  std::mt19937 rng(42);
+  std::vector<IndexedWindow> out;
+  out.reserve(n);
+  for (size_t i = 0; i < n; i++) {
+    size_t a = rng() % 12;
+    IndexedWindow w;
+    w.hwnd = 0x10000 + i * 4;
+    w.title = "document_" + std::to_string(rng() % 100000) + ".txt - " + apps[a];
+    w.class_name = classes[(a + rng() % 2) % 12];
+    out.push_back(std::move(w));
+  }
+  // A handful of needles to look for.
+  out[n / 3].title = "Quarterly Report FINAL - Excel";
+  out[n / 2].title = "Quarterly report draft - Word";
+  return out;
+}
+
+template <typename F> static double time_us(int iters, F &&f) {
+  auto t0 = Clock::now();
+  size_t sink = 0;
+  for (int i = 0; i < iters; i++) sink += f();
+  auto t1 = Clock::now();
+  if (sink == (size_t)-1) std::puts("");
+  return std::chrono::duration<double, std::micro>(t1 - t0).count() / iters;
+}
+
+int main(int argc, char **argv) {
+  size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 50000;
+  int iters = argc > 2 ? std::atoi(argv[2]) : 50;
+  auto windows = synth(n);
+
+  auto t0 = Clock::now();
+  WindowIndex idx(windows);
+  idx.find({"warm", "", MatchMode::Substring, false}); // forces the build
+  double build_ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+  std::printf("windows=%zu iterations=%d index_build=%.1f ms\n\n", n, iters, build_ms);
+
+  struct Case {
+    const char *name;
+    WindowQuery q;
+  } cases[] = {
+      {"substring 'Quarterly'", {"Quarterly", "", MatchMode::Substring, false}},
+      {"substring -i 'quarterly report'", {"quarterly report", "", MatchMode::Substring, true}},
+      {"prefix 'document_4242'", {"document_4242", "", MatchMode::Prefix, false}},
+      {"exact class 'XLMAIN'", {"", "XLMAIN", MatchMode::Exact, false}},
+      {"regex 'Report (FINAL|draft)'", {"Report (FINAL|draft)", "", MatchMode::Regex, false}},
+      {"regex -i 'report.*word$'", {"report.*word$", "", MatchMode::Regex, true}},
+      {"regex 'Paint' + class 'MSPaint'", {"Paint", "MSPaint", MatchMode::Regex, false}},
+      {"regex 'Calc|Paint' (scan)", {"Calc|Paint", "", MatchMode::Regex, false}},
+  };
+
+  std::printf("%-36s %8s %10s %12s %12s %8s\n", "query", "matches", "verified",
+              "index us", "scan us", "speedup");
+  for (auto &c : cases) {
+    WindowQueryStats st;
+    auto hits = idx.find(c.q, &st);
+    double indexed = time_us(iters, [&] { return idx.find(c.q).size(); });
+
+    // Baseline: what find_windows_regex did per call (minus the cross-process
+    // text fetches): compile both regexes, then search every window.
+    std::string t_re = c.q.title.empty() ? ".*" : c.q.title;
+    std::string c_re = c.q.class_name.empty() ? ".*" : c.q.class_name;
+    if (c.q.mode != MatchMode::Regex) {
+      static const std::regex meta(R"([.^$|()\[\]{}*+?\\])");
+      t_re = c.q.title.empty() ? ".*" : std::regex_replace(c.q.title, meta, "\\$&");
+      c_re = c.q.class_name.empty() ? ".*" : std::regex_replace(c.q.class_name, meta, "\\$&");
+    }
+    auto flags = std::regex::ECMAScript;
+    if (c.q.case_insensitive) flags |= std::regex::icase;
+    double scan = time_us(iters, [&] {
+      std::regex re_t(t_re, flags), re_c(c_re, flags);
+      size_t found = 0;
+      for (const auto &w : windows)
+        if (std::regex_search(w.title, re_t) && std::regex_search(w.class_name, re_c))
+          found++;
+      return found;
+    });
+
+    std::printf("%-36s %8zu %10zu %12.1f %12.1f %7.1fx\n", c.name, hits.size(),
+                st.candidates, indexed, scan, scan / indexed);
+  }
+  return 0;
+}
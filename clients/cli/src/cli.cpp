@@ -3,6 +3,7 @@
 // Copyright (c) 2026 Mark E. DeYoung
 
 #ifdef _WIN32
+#include <cstring>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -17,10 +18,24 @@
 #include <filesystem>
 #include <fstream>
 
+#include "wininspect/compress.hpp"
 #include "wininspect/crypto.hpp"
+#include "wininspect/session_ticket.hpp"
+
+#include "fleet.hpp"
+#include "rendezvous_client.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <memory>
+#include <wincrypt.h>
 
 #pragma comment(lib, "Ws2_32.lib")
 #pragma comment(lib, "Advapi32.lib") // For CryptGenRandom
+#pragma comment(lib, "Crypt32.lib")  // For CryptProtectData
 
 static std::wstring g_pipe_name = L"\\\\.\\pipe\\wininspectd";
 
@@ -28,6 +43,13 @@ struct Conn {
   HANDLE hPipe = INVALID_HANDLE_VALUE;
   SOCKET s = INVALID_SOCKET;
   bool is_tcp = false;
+  // Set once the TCP handshake has agreed a key; frames are then records.
+  std::unique_ptr<wininspect::crypto::CryptoSession> crypto;
+  // Set if the handshake agreed a codec; the daemon may then compress.
+  wininspect::compress::Codec codec = wininspect::compress::Codec::None;
+  // If set, every TCP send and receive fails past it, however the daemon
+  // paces its bytes; SO_RCVTIMEO alone would bound each recv, not the sum.
+  std::chrono::steady_clock::time_point deadline{};
 
   void close() {
     if (is_tcp) {
@@ -43,47 +65,105 @@ struct Conn {
     }
   }
 
-  bool send(const std::string &m) {
+  // One write per frame: WSASend gathers the length prefix and payload;
+  // a pipe has no gather write, so they are joined in a reused buffer.
+  bool send(const std::string &plain) {
+    const std::string &m = crypto ? seal(plain) : plain;
+    uint32_t len = (uint32_t)m.size();
     if (is_tcp) {
-      uint32_t len = (uint32_t)m.size();
-      if (::send(s, (const char *)&len, 4, 0) <= 0)
-        return false;
-      if (::send(s, m.data(), (int)len, 0) <= 0)
-        return false;
-      return true;
-    } else {
-      DWORD written;
-      uint32_t len = (uint32_t)m.size();
-      if (!WriteFile(hPipe, &len, 4, &written, nullptr))
-        return false;
-      if (!WriteFile(hPipe, m.data(), (DWORD)len, &written, nullptr))
+      if (!arm(SO_SNDTIMEO))
         return false;
-      return true;
+      WSABUF wb[2] = {{4, (CHAR *)&len}, {(ULONG)m.size(), (CHAR *)m.data()}};
+      DWORD sent = 0;
+      return WSASend(s, wb, 2, &sent, 0, nullptr, nullptr) == 0 && sent == 4 + m.size();
     }
+    wbuf.assign((const char *)&len, 4);
+    wbuf += m;
+    DWORD written = 0;
+    return WriteFile(hPipe, wbuf.data(), (DWORD)wbuf.size(), &written, nullptr) &&
+           written == wbuf.size();
   }
 
+  // Reads ahead into rbuf, so a frame usually costs one recv/ReadFile, and
+  // a frame split across reads is reassembled rather than truncated.
   bool recv(std::string &m) {
-    if (is_tcp) {
-      uint32_t len;
-      int r = ::recv(s, (char *)&len, 4, 0);
-      if (r <= 0)
-        return false;
-      m.resize(len);
-      r = ::recv(s, m.data(), (int)len, 0);
+    while (true) {
+      size_t avail = rbuf.size() - rpos;
+      if (avail >= 4) {
+        uint32_t len;
+        memcpy(&len, rbuf.data() + rpos, 4);
+        bool compressed = (len & 0x80000000u) != 0;
+        len &= 0x7FFFFFFFu;
+        if (len == 0 || len > 10 * 1024 * 1024)
+          return false;
+        if (avail - 4 >= len) {
+          m.assign(rbuf, rpos + 4, len);
+          rpos += 4 + len;
+          if (rpos == rbuf.size()) {
+            rbuf.clear();
+            rpos = 0;
+          }
+          if (crypto) {
+            if (!crypto->open({(uint8_t *)m.data(), m.size()})) return false;
+            m.erase(0, wininspect::crypto::RECORD_OVERHEAD);
+          }
+          if (!compressed) return true;
+          if (codec == wininspect::compress::Codec::None ||
+              !wininspect::compress::unpack(m.data(), m.size(), 10 * 1024 * 1024, ubuf))
+            return false;
+          m.swap(ubuf);
+          return true;
+        }
+      }
+      if (rpos > 0) {
+        rbuf.erase(0, rpos);
+        rpos = 0;
+      }
+      char chunk[16 * 1024];
+      long r = read_some(chunk, sizeof(chunk));
       if (r <= 0)
         return false;
+      rbuf.append(chunk, (size_t)r);
+    }
+  }
+
+private:
+  const std::string &seal(const std::string &plain) {
+    sbuf.resize(wininspect::crypto::RECORD_OVERHEAD + plain.size());
+    if (!crypto->seal({(const uint8_t *)plain.data(), plain.size()},
+                      {(uint8_t *)sbuf.data(), sbuf.size()}))
+      sbuf.clear(); // an empty frame: the daemon drops the connection
+    return sbuf;
+  }
+
+  // Sets `opt` to what is left before the deadline; false once it passed.
+  bool arm(int opt) {
+    if (deadline == std::chrono::steady_clock::time_point{})
       return true;
-    } else {
-      DWORD read;
-      uint32_t len;
-      if (!ReadFile(hPipe, &len, 4, &read, nullptr))
-        return false;
-      m.resize(len);
-      if (!ReadFile(hPipe, m.data(), (DWORD)len, &read, nullptr))
-        return false;
-      return true;
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    deadline - std::chrono::steady_clock::now())
+                    .count();
+    if (left <= 0)
+      return false;
+    DWORD t = (DWORD)left;
+    return setsockopt(s, SOL_SOCKET, opt, (const char *)&t, sizeof(t)) == 0;
+  }
+
+  long read_some(char *p, size_t n) {
+    if (is_tcp) {
+      if (!arm(SO_RCVTIMEO))
+        return -1;
+      int r = ::recv(s, p, (int)n, 0);
+      return r == SOCKET_ERROR ? -1 : r;
     }
+    DWORD read = 0;
+    if (!ReadFile(hPipe, p, (DWORD)n, &read, nullptr))
+      return -1;
+    return (long)read;
   }
+
+  std::string rbuf, wbuf, sbuf, ubuf;
+  size_t rpos = 0; // consumed prefix of rbuf
 };
 
 static std::string get_config_path() {
@@ -108,15 +188,135 @@ static std::string load_key_path() {
 }
 
 
-static bool perform_auth(Conn &conn) {
+// A resumption ticket from the last session with a daemon, so the next
+// short-lived invocation skips the signature and ECDH. The secret that goes
+// with it is kept under DPAPI, readable only by this Windows user.
+struct SavedTicket {
+  std::string ticket;
+  std::vector<uint8_t> secret;
+};
+
+static std::string ticket_path(const std::string &host, int port) {
+  return get_config_path() + ".ticket-" + host + "-" + std::to_string(port);
+}
+
+static void save_ticket(const std::string &path, const std::string &ticket,
+                        const std::array<uint8_t, 32> &secret) {
+  DATA_BLOB in{(DWORD)secret.size(), (BYTE *)secret.data()}, out{};
+  if (!CryptProtectData(&in, L"wininspect ticket", nullptr, nullptr, nullptr,
+                        CRYPTPROTECT_UI_FORBIDDEN, &out))
+    return;
+  std::vector<uint8_t> sealed(out.pbData, out.pbData + out.cbData);
+  LocalFree(out.pbData);
+  std::ofstream f(path, std::ios::trunc);
+  f << ticket << "\n" << wininspect::base64::encode(sealed) << "\n";
+}
+
+static SavedTicket load_ticket(const std::string &path) {
+  SavedTicket t;
+  std::ifstream f(path);
+  std::string sealed_b64;
+  if (!std::getline(f, t.ticket) || !std::getline(f, sealed_b64))
+    return {};
+  // Single use: whatever happens next, this one is spent.
+  f.close();
+  std::remove(path.c_str());
+  auto sealed = wininspect::base64::decode(sealed_b64);
+  DATA_BLOB in{(DWORD)sealed.size(), sealed.data()}, out{};
+  if (!CryptUnprotectData(&in, nullptr, nullptr, nullptr, nullptr,
+                          CRYPTPROTECT_UI_FORBIDDEN, &out))
+    return {};
+  t.secret.assign(out.pbData, out.pbData + out.cbData);
+  SecureZeroMemory(out.pbData, out.cbData);
+  LocalFree(out.pbData);
+  if (t.secret.size() != 32)
+    return {};
+  return t;
+}
+
+// Reads auth_status; on success switches the connection to records when
+// the daemon says traffic is encrypted, and keeps any ticket it sent.
+static bool finish_auth(Conn &conn, std::unique_ptr<wininspect::crypto::CryptoSession> session,
+                        const wininspect::json::Object &status,
+                        const std::string &ticket_file) {
+  auto it_ok = status.find("ok");
+  if (it_ok == status.end() || !it_ok->second.is_bool() || !it_ok->second.as_bool())
+    return false;
+  auto it_c = status.find("compression");
+  if (it_c != status.end() && it_c->second.is_str())
+    conn.codec = wininspect::compress::codec_from_name(it_c->second.as_str());
+  auto it_enc = status.find("encrypted");
+  if (it_enc == status.end() || !it_enc->second.is_bool() || !it_enc->second.as_bool())
+    return true; // an older daemon, or one without a crypto backend
+  if (!session->is_initialized())
+    return false;
+  auto it_t = status.find("ticket");
+  if (it_t != status.end() && it_t->second.is_str())
+    save_ticket(ticket_file, it_t->second.as_str(), session->resumption_secret());
+  conn.crypto = std::move(session);
+  return true;
+}
+
+// The first codec the daemon offers that this build has (it lists the
+// fastest first); empty if none.
+static std::string choose_codec(const wininspect::json::Object &hello) {
+  auto it = hello.find("compression");
+  if (it == hello.end() || !it->second.is_arr())
+    return "";
+  for (const auto &c : it->second.as_arr())
+    if (c.is_str() && wininspect::compress::codec_from_name(c.as_str()) !=
+                          wininspect::compress::Codec::None)
+      return c.as_str();
+  return "";
+}
+
+static bool perform_auth(Conn &conn, const std::string &host, int port) {
+  using wininspect::json::Object;
   std::string challenge_json;
   if (!conn.recv(challenge_json))
     return false;
   auto v = wininspect::json::parse(challenge_json);
   if (!v.is_obj() || v.as_obj().at("type").as_str() != "hello")
     return true; // No auth required (or old daemon)
+  const Object &hello = v.as_obj();
+  if (!hello.count("nonce"))
+    return true; // the daemon has no authorized keys
+
+  std::string nonce_b64 = hello.at("nonce").as_str();
+  auto nonce = wininspect::base64::decode(nonce_b64);
+  auto ticket_file = ticket_path(host, port);
+  auto codec = choose_codec(hello);
+  std::string status_json;
+
+  // One round trip with a ticket; a refused one falls through to the full
+  // handshake on the same connection.
+  auto saved = load_ticket(ticket_file);
+  if (!saved.ticket.empty()) {
+    std::vector<uint8_t> client_random(32);
+    auto session = std::make_unique<wininspect::crypto::CryptoSession>();
+    if (wininspect::crypto::random_bytes(client_random.data(), client_random.size())) {
+      Object req;
+      req["version"] = std::string(wininspect::PROTOCOL_VERSION);
+      req["resume"] = saved.ticket;
+      req["client_random"] = wininspect::base64::encode(client_random);
+      if (!codec.empty())
+        req["compression"] = codec;
+      if (!conn.send(wininspect::json::dumps(req)) || !conn.recv(status_json))
+        return false;
+      auto sv = wininspect::json::parse(status_json);
+      uint8_t key[32];
+      bool ok = sv.is_obj() && sv.as_obj().at("ok").as_bool() &&
+                wininspect::TicketKeeper::derive_key(saved.secret, nonce, client_random, key) &&
+                session->install_key(key);
+      SecureZeroMemory(key, sizeof(key));
+      SecureZeroMemory(saved.secret.data(), saved.secret.size());
+      if (ok)
+        return finish_auth(conn, std::move(session), sv.as_obj(), ticket_file);
+      if (sv.is_obj() && sv.as_obj().at("ok").as_bool())
+        return false; // accepted, but we could not key the session
+    }
+  }
 
-  std::string nonce_b64 = v.as_obj().at("nonce").as_str();
   std::string key_path = load_key_path();
   if (key_path.empty()) {
     std::cerr << "Daemon requires authentication. Set key with: wininspect "
@@ -124,30 +324,42 @@ static bool perform_auth(Conn &conn) {
     return false;
   }
 
-  std::string sig =
-      wininspect::crypto::sign_ssh_msg(wininspect::base64::decode(nonce_b64), key_path);
+  std::string sig = wininspect::crypto::sign_ssh_msg(nonce, key_path);
   if (sig.empty()) {
     std::cerr << "Failed to sign challenge with key: " << key_path << "\n";
     return false;
   }
 
-  wininspect::json::Object resp;
+  auto session = std::make_unique<wininspect::crypto::CryptoSession>();
+  Object resp;
   resp["version"] = std::string(wininspect::PROTOCOL_VERSION);
   resp["identity"] = "wininspect-user";
   resp["signature"] = sig;
+  if (!codec.empty())
+    resp["compression"] = codec;
+  auto it_pk = hello.find("pubkey");
+  auto local_pub = session->generate_local_key();
+  if (it_pk != hello.end() && it_pk->second.is_str() && !local_pub.empty())
+    resp["pubkey"] = wininspect::base64::encode(local_pub);
   if (!conn.send(wininspect::json::dumps(resp)))
     return false;
 
-  std::string status_json;
   if (!conn.recv(status_json))
     return false;
   auto sv = wininspect::json::parse(status_json);
-  return sv.is_obj() && sv.as_obj().at("type").as_str() == "auth_status" &&
-         sv.as_obj().at("ok").as_bool();
+  if (!sv.is_obj() || sv.as_obj().at("type").as_str() != "auth_status")
+    return false;
+  if (resp.count("pubkey"))
+    (void)session->compute_shared_secret(
+        wininspect::base64::decode(it_pk->second.as_str()));
+  return finish_auth(conn, std::move(session), sv.as_obj(), ticket_file);
 }
 
+// connect_ms bounds the TCP connect, and conn.deadline, if set, that and
+// everything after (the handshake included), so a daemon that accepts and
+// then stalls or trickles cannot hold the caller.
 static bool connect_daemon(Conn &conn, bool tcp, const std::string &host,
-                           int port) {
+                           int port, int connect_ms = 2000) {
   if (tcp) {
     WSADATA wsa;
     if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0)
@@ -163,16 +375,37 @@ static bool connect_daemon(Conn &conn, bool tcp, const std::string &host,
     sockaddr_in addr{};
     addr.sin_family = AF_INET;
     addr.sin_port = htons((u_short)port);
-    inet_pton(AF_INET, host.c_str(), &addr.sin_addr);
+    if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) {
+      addrinfo hints{}, *res = nullptr;
+      hints.ai_family = AF_INET;
+      hints.ai_socktype = SOCK_STREAM;
+      if (getaddrinfo(host.c_str(), nullptr, &hints, &res) != 0 || !res) {
+        closesocket(conn.s);
+        return false;
+      }
+      addr.sin_addr = ((sockaddr_in *)res->ai_addr)->sin_addr;
+      freeaddrinfo(res);
+    }
     
     connect(conn.s, (sockaddr *)&addr, sizeof(addr));
-
-    fd_set write_fds;
+    if (conn.deadline != std::chrono::steady_clock::time_point{})
+      connect_ms = (int)std::clamp<long long>(
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              conn.deadline - std::chrono::steady_clock::now())
+              .count(),
+          0, connect_ms);
+
+    // A refused connect shows up in the except set, so it fails now
+    // rather than at the timeout.
+    fd_set write_fds, except_fds;
     FD_ZERO(&write_fds);
     FD_SET(conn.s, &write_fds);
-    timeval tv{2, 0};
+    FD_ZERO(&except_fds);
+    FD_SET(conn.s, &except_fds);
+    timeval tv{connect_ms / 1000, (connect_ms % 1000) * 1000};
 
-    if (select(0, NULL, &write_fds, NULL, &tv) <= 0) {
+    if (select(0, NULL, &write_fds, &except_fds, &tv) <= 0 ||
+        FD_ISSET(conn.s, &except_fds)) {
       closesocket(conn.s);
       return false;
     }
@@ -181,7 +414,7 @@ static bool connect_daemon(Conn &conn, bool tcp, const std::string &host,
     ioctlsocket(conn.s, FIONBIO, &mode);
 
     conn.is_tcp = true;
-    if (!perform_auth(conn)) {
+    if (!perform_auth(conn, host, port)) {
       conn.close();
       return false;
     }
@@ -206,10 +439,219 @@ static std::string make_req(const std::string &id, const std::string &method,
   return dumps(o);
 }
 
+// ── Fleet ───────────────────────────────────────────────────────────────────
+
+using wininspect_cli::FleetTarget;
+
+// Broadcasts WININSPECT_DISCOVER on `port` and collects announcements:
+// (sender address, reply). Waits timeout_ms for the first, then until
+// half a second passes with no more.
+static std::vector<std::pair<std::string, std::string>> udp_discover(int port,
+                                                                    int timeout_ms) {
+  std::vector<std::pair<std::string, std::string>> found;
+  WSADATA wsa;
+  WSAStartup(MAKEWORD(2, 2), &wsa);
+  SOCKET s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  bool broadcast = true;
+  setsockopt(s, SOL_SOCKET, SO_BROADCAST, (const char *)&broadcast, sizeof(broadcast));
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons((u_short)port);
+  addr.sin_addr.s_addr = INADDR_BROADCAST;
+
+  std::string msg = "WININSPECT_DISCOVER";
+  sendto(s, msg.data(), (int)msg.size(), 0, (struct sockaddr *)&addr, sizeof(addr));
+
+  // Also try loopback directly as broadcast is often blocked/restricted in containers
+  addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+  sendto(s, msg.data(), (int)msg.size(), 0, (struct sockaddr *)&addr, sizeof(addr));
+
+  addr.sin_addr.s_addr = INADDR_ANY;
+  sendto(s, msg.data(), (int)msg.size(), 0, (struct sockaddr *)&addr, sizeof(addr));
+
+  fd_set fds;
+  FD_ZERO(&fds);
+  FD_SET(s, &fds);
+  timeval tv{timeout_ms / 1000, (timeout_ms % 1000) * 1000};
+
+  while (select(0, &fds, NULL, NULL, &tv) > 0) {
+    char buf[1024];
+    struct sockaddr_in from;
+    int from_len = sizeof(from);
+    int r = recvfrom(s, buf, sizeof(buf) - 1, 0, (struct sockaddr *)&from, &from_len);
+    if (r > 0) {
+      char ip[INET_ADDRSTRLEN];
+      inet_ntop(AF_INET, &from.sin_addr, ip, INET_ADDRSTRLEN);
+      found.emplace_back(ip, std::string(buf, (size_t)r));
+    }
+    FD_ZERO(&fds);
+    FD_SET(s, &fds);
+    tv = {0, 500000}; // quick check for more
+  }
+  closesocket(s);
+  WSACleanup();
+  return found;
+}
+
+static std::vector<FleetTarget> udp_targets(int port, int timeout_ms) {
+  std::vector<FleetTarget> out;
+  for (auto &[ip, reply] : udp_discover(port, timeout_ms)) {
+    FleetTarget t;
+    t.host = ip;
+    t.source = "udp";
+    try {
+      auto v = wininspect::json::parse(reply);
+      if (!v.is_obj())
+        continue;
+      const auto &o = v.as_obj();
+      auto it = o.find("port");
+      if (it != o.end() && it->second.is_num())
+        t.port = (int)it->second.as_num();
+      it = o.find("hostname");
+      if (it != o.end() && it->second.is_str())
+        t.name = it->second.as_str();
+    } catch (...) {
+      continue;
+    }
+    out.push_back(std::move(t));
+  }
+  return out;
+}
+
+// Offset just past the DNS name at `off`; 0 if it runs off the packet.
+static size_t dns_skip_name(const uint8_t *p, size_t n, size_t off) {
+  while (off < n) {
+    uint8_t len = p[off];
+    if (len == 0)
+      return off + 1;
+    if ((len & 0xC0) == 0xC0)
+      return off + 2 <= n ? off + 2 : 0;
+    off += 1 + (size_t)len;
+  }
+  return 0;
+}
+
+// Asks 224.0.0.251:5353 for _wininspect._tcp.local (as MdnsResponder
+// advertises it) and takes the port from each answer's SRV record. The
+// responder's A record is 0.0.0.0, so the sender's address is the host.
+static std::vector<FleetTarget> mdns_targets(int timeout_ms) {
+  std::vector<FleetTarget> out;
+  WSADATA wsa;
+  WSAStartup(MAKEWORD(2, 2), &wsa);
+  SOCKET s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (s == INVALID_SOCKET)
+    return out;
+
+  std::vector<uint8_t> q = {0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0}; // one question
+  for (const char *label : {"_wininspect", "_tcp", "local"}) {
+    q.push_back((uint8_t)strlen(label));
+    q.insert(q.end(), label, label + strlen(label));
+  }
+  q.insert(q.end(), {0, 0, 12, 0, 1}); // root, PTR, IN
+
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(5353);
+  addr.sin_addr.s_addr = inet_addr("224.0.0.251");
+  sendto(s, (const char *)q.data(), (int)q.size(), 0, (sockaddr *)&addr, sizeof(addr));
+
+  fd_set fds;
+  FD_ZERO(&fds);
+  FD_SET(s, &fds);
+  timeval tv{timeout_ms / 1000, (timeout_ms % 1000) * 1000};
+  while (select(0, &fds, NULL, NULL, &tv) > 0) {
+    uint8_t buf[1500];
+    sockaddr_in from;
+    int from_len = sizeof(from);
+    int r = recvfrom(s, (char *)buf, sizeof(buf), 0, (sockaddr *)&from, &from_len);
+    FD_ZERO(&fds);
+    FD_SET(s, &fds);
+    tv = {0, 500000};
+    if (r < 12 || !(buf[2] & 0x80))
+      continue; // not a response
+    size_t n = (size_t)r;
+    int questions = buf[4] << 8 | buf[5];
+    int records = (buf[6] << 8 | buf[7]) + (buf[8] << 8 | buf[9]) + (buf[10] << 8 | buf[11]);
+    size_t off = 12;
+    for (int i = 0; i < questions && off; i++) {
+      off = dns_skip_name(buf, n, off);
+      if (off)
+        off += 4; // QTYPE, QCLASS
+    }
+    for (int i = 0; i < records && off && off + 10 <= n; i++) {
+      size_t owner = off;
+      off = dns_skip_name(buf, n, off);
+      if (!off || off + 10 > n)
+        break;
+      int type = buf[off] << 8 | buf[off + 1];
+      size_t rdlen = (size_t)(buf[off + 8] << 8 | buf[off + 9]);
+      size_t rdata = off + 10;
+      off = rdata + rdlen <= n ? rdata + rdlen : 0;
+      if (type != 33 || !off || rdlen < 6)
+        continue; // not an SRV record
+      FleetTarget t;
+      char ip[INET_ADDRSTRLEN];
+      inet_ntop(AF_INET, &from.sin_addr, ip, INET_ADDRSTRLEN);
+      t.host = ip;
+      t.port = buf[rdata + 4] << 8 | buf[rdata + 5];
+      if ((buf[owner] & 0xC0) == 0 && owner + 1 + buf[owner] <= n)
+        t.name.assign((const char *)buf + owner + 1, buf[owner]);
+      t.source = "mdns";
+      out.push_back(std::move(t));
+    }
+  }
+  closesocket(s);
+  WSACleanup();
+  return out;
+}
+
+static std::vector<FleetTarget> rendezvous_targets(const std::string &url) {
+  std::vector<FleetTarget> out;
+  wininspect::RendezvousConfig cfg;
+  cfg.url = url;
+  auto rc = wininspectd::create_rendezvous_client(cfg);
+  if (!rc)
+    return out;
+  for (auto &d : rc->discover()) {
+    FleetTarget t;
+    t.host = d.host;
+    t.port = d.port;
+    t.name = d.name;
+    t.uuid = d.uuid;
+    t.source = "rendezvous";
+    out.push_back(std::move(t));
+  }
+  return out;
+}
+
+// One fleet target over TCP, on its own connection, within `deadline`.
+static wininspect_cli::FleetReply fleet_call(const FleetTarget &t, const std::string &request,
+                                             std::chrono::steady_clock::time_point deadline) {
+  wininspect_cli::FleetReply r;
+  auto t0 = std::chrono::steady_clock::now();
+  Conn conn;
+  conn.deadline = deadline;
+  if (!connect_daemon(conn, true, t.host, t.port, INT_MAX)) { // the deadline bounds it
+    r.error = "connect failed";
+    return r;
+  }
+  r.connect_ms = (double)std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - t0)
+                     .count();
+  if (!conn.send(request) || !conn.recv(r.response))
+    r.error = "no response";
+  conn.close();
+  return r;
+}
+
 static int usage() {
   std::cerr << "Usage: wininspect <command> [args] [--tcp host:port] [--pipe name]\n"
             << "Commands:\n"
             << "  discover\n"
+            << "  fleet <method> [params-json] [--targets host:port,..] [--udp] [--mdns]\n"
+            << "        [--rendezvous url] [--concurrency n] [--timeout-ms ms]\n"
             << "  capture\n"
             << "  top [--snapshot s-..]\n"
             << "  info <hwnd> [--snapshot s-..]\n"
@@ -233,8 +675,9 @@ static int usage() {
             << "  kill <pid>\n"
             << "  exec <command> [args]\n"
             << "  file-info <path>\n"
-            << "  file-read <path>\n"
-            << "  find-regex [title_regex] [class_regex]\n"
+            << "  file-read <path> [offset] [length]\n"
+            << "  file-tail <path> [lines]\n"
+            << "  find-regex [title] [class] [--mode regex|substring|prefix|exact] [-i] [--snapshot s-..]\n"
             << "  reg-read <path>\n"
             << "  reg-write <path> <name> <type> <data>\n"
             << "  reg-delete <path> [name]\n"
@@ -253,7 +696,7 @@ static int usage() {
             << "  mem-write <pid> <address> <base64_data>\n"
             << "  image-match <left> <top> <right> <bottom> <base64_bmp>\n"
             << "  input-hook <true|false>\n"
-            << "  events-poll <new_snap_id> [old_snap_id] [--wait-ms ms]\n"
+            << "  events-poll [new_snap_id [old_snap_id]] [--since seq] [--wait-ms ms]\n"
             << "  events-subscribe\n"
             << "  events-unsubscribe\n"
             << "  watch\n"
@@ -299,7 +742,8 @@ int main(int argc, char **argv) {
         size_t colon = host_port.find(':');
         if (colon != std::string::npos) {
           tcp_host = host_port.substr(0, colon);
-          tcp_port = std::stoi(host_port.substr(colon + 1));
+          if (!wininspect_cli::parse_int(host_port.substr(colon + 1), 1, 65535, tcp_port))
+            return usage();
         } else {
           tcp_host = host_port;
         }
@@ -356,60 +800,90 @@ int main(int argc, char **argv) {
     int disc_timeout_ms = 2000;
 
     for (int i = 1; i < argc; ++i) {
-      if (std::string(argv[i]) == "--discovery-port" && i + 1 < argc) {
-        disc_port = std::stoi(argv[++i]);
-      }
-      if (std::string(argv[i]) == "--discovery-timeout" && i + 1 < argc) {
-        disc_timeout_ms = std::stoi(argv[++i]);
-      }
+      if (std::string(argv[i]) == "--discovery-port" && i + 1 < argc &&
+          !wininspect_cli::parse_int(argv[++i], 1, 65535, disc_port))
+        return usage();
+      if (std::string(argv[i]) == "--discovery-timeout" && i + 1 < argc &&
+          !wininspect_cli::parse_int(argv[++i], 0, INT_MAX, disc_timeout_ms))
+        return usage();
     }
 
-    WSADATA wsa;
-    WSAStartup(MAKEWORD(2, 2), &wsa);
-    SOCKET s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-    bool broadcast = true;
-    setsockopt(s, SOL_SOCKET, SO_BROADCAST, (const char *)&broadcast, sizeof(broadcast));
-
-    struct sockaddr_in addr;
-    memset(&addr, 0, sizeof(addr));
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons((u_short)disc_port);
-    addr.sin_addr.s_addr = INADDR_BROADCAST;
-
-    std::string msg = "WININSPECT_DISCOVER";
-    sendto(s, msg.data(), (int)msg.size(), 0, (struct sockaddr *)&addr, sizeof(addr));
-
-    // Also try loopback directly as broadcast is often blocked/restricted in containers
-    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
-    sendto(s, msg.data(), (int)msg.size(), 0, (struct sockaddr *)&addr, sizeof(addr));
-
-    addr.sin_addr.s_addr = INADDR_ANY;
-    sendto(s, msg.data(), (int)msg.size(), 0, (struct sockaddr *)&addr, sizeof(addr));
-
     std::cout << "Scanning for WinInspect daemons on port " << disc_port << "...\n";
-    fd_set fds;
-    FD_ZERO(&fds);
-    FD_SET(s, &fds);
-    timeval tv{disc_timeout_ms / 1000, (disc_timeout_ms % 1000) * 1000};
-
-    while (select(0, &fds, NULL, NULL, &tv) > 0) {
-      char buf[1024];
-      struct sockaddr_in from;
-      int from_len = sizeof(from);
-      int r = recvfrom(s, buf, sizeof(buf) - 1, 0, (struct sockaddr *)&from, &from_len);
-      if (r > 0) {
-        buf[r] = '\0';
-        char ip[INET_ADDRSTRLEN];
-        inet_ntop(AF_INET, &from.sin_addr, ip, INET_ADDRSTRLEN);
-        std::cout << "[" << ip << "] " << buf << "\n";
+    for (auto &[ip, reply] : udp_discover(disc_port, disc_timeout_ms))
+      std::cout << "[" << ip << "] " << reply << "\n";
+    return 0;
+  }
+
+  if (cmd == "fleet") {
+    if (args.size() < 2)
+      return usage();
+    std::string method = args[1];
+    std::vector<FleetTarget> targets;
+    bool udp = false, mdns = false;
+    std::vector<std::string> rendezvous;
+    int concurrency = 32, timeout_ms = 5000;
+    int disc_port = 1986, disc_timeout_ms = 2000;
+    for (size_t i = 2; i < args.size(); i++) {
+      const std::string &a = args[i];
+      bool has_value = i + 1 < args.size();
+      if (i == 2 && !a.empty() && a[0] == '{') {
+        Value v;
+        try {
+          v = parse(a);
+        } catch (const std::exception &) {
+          return usage();
+        }
+        if (!v.is_obj())
+          return usage();
+        for (auto &[k, val] : v.as_obj())
+          params[k] = val;
+      } else if (a == "--targets" && has_value) {
+        if (!wininspect_cli::parse_targets(args[++i], targets))
+          return usage();
+      } else if (a == "--udp") {
+        udp = true;
+      } else if (a == "--mdns") {
+        mdns = true;
+      } else if (a == "--rendezvous" && has_value) {
+        rendezvous.push_back(args[++i]);
+      } else if (a == "--concurrency" && has_value) {
+        if (!wininspect_cli::parse_int(args[++i], 1, 1024, concurrency))
+          return usage();
+      } else if (a == "--timeout-ms" && has_value) {
+        if (!wininspect_cli::parse_int(args[++i], 1, INT_MAX, timeout_ms))
+          return usage();
+      } else if (a == "--discovery-port" && has_value) {
+        if (!wininspect_cli::parse_int(args[++i], 1, 65535, disc_port))
+          return usage();
+      } else if (a == "--discovery-timeout" && has_value) {
+        if (!wininspect_cli::parse_int(args[++i], 0, INT_MAX, disc_timeout_ms))
+          return usage();
+      } else {
+        return usage();
       }
-      FD_ZERO(&fds);
-      FD_SET(s, &fds);
-      tv = {0, 500000}; // quick check for more
     }
-    closesocket(s);
-    WSACleanup();
-    return 0;
+    if (targets.empty() && !mdns && rendezvous.empty())
+      udp = true; // nothing named: ask the LAN
+    if (udp)
+      for (auto &t : udp_targets(disc_port, disc_timeout_ms))
+        targets.push_back(std::move(t));
+    if (mdns)
+      for (auto &t : mdns_targets(disc_timeout_ms))
+        targets.push_back(std::move(t));
+    for (auto &url : rendezvous)
+      for (auto &t : rendezvous_targets(url))
+        targets.push_back(std::move(t));
+    auto sum = wininspect_cli::run_fleet(std::move(targets), method, params, concurrency,
+                                         timeout_ms, fleet_call, [](const std::string &line) {
+                                           std::cout << line << "\n" << std::flush;
+                                         });
+    if (sum.targets == 0) {
+      std::cerr << "fleet: no daemons found\n";
+      return 1;
+    }
+    std::cerr << "fleet: " << sum.targets - sum.failed << "/" << sum.targets << " ok in "
+              << sum.elapsed_ms << " ms\n";
+    return sum.failed ? 1 : 0;
   }
 
   if (cmd == "capture") {
@@ -604,12 +1078,28 @@ int main(int argc, char **argv) {
   if (cmd == "file-read") {
     if (args.size() < 2) return usage();
     params["path"] = args[1];
+    if (args.size() > 2) params["offset"] = std::stod(args[2]);
+    if (args.size() > 3) params["length"] = std::stod(args[3]);
     return send_and_print("file.read");
   }
 
+  if (cmd == "file-tail") {
+    if (args.size() < 2) return usage();
+    params["path"] = args[1];
+    if (args.size() > 2) params["lines"] = std::stod(args[2]);
+    return send_and_print("file.tail");
+  }
+
   if (cmd == "find-regex") {
-    if (args.size() > 1) params["title_regex"] = args[1];
-    if (args.size() > 2) params["class_regex"] = args[2];
+    std::vector<std::string> pos;
+    for (size_t i = 1; i < args.size();) {
+      if (get_snapshot(i)) continue;
+      if (args[i] == "--mode" && i + 1 < args.size()) { params["mode"] = args[i + 1]; i += 2; continue; }
+      if (args[i] == "-i") { params["case_insensitive"] = true; i++; continue; }
+      pos.push_back(args[i++]);
+    }
+    if (pos.size() > 0) params["title_regex"] = pos[0];
+    if (pos.size() > 1) params["class_regex"] = pos[1];
     return send_and_print("window.findRegex");
   }
 
@@ -716,9 +1206,8 @@ int main(int argc, char **argv) {
   }
 
   if (cmd == "events-poll") {
-    if (args.size() < 2)
-      return usage();
-    params["snapshot_id"] = args[1];
+    if (args.size() > 1 && args[1].rfind("--", 0) != 0)
+      params["snapshot_id"] = args[1];
     if (args.size() > 2 && args[2].rfind("0x", 0) != 0 && args[2].find("--") == std::string::npos)
       params["old_snapshot_id"] = args[2];
     
@@ -726,6 +1215,9 @@ int main(int argc, char **argv) {
       if (std::string(argv[i]) == "--wait-ms" && i + 1 < argc) {
         params["wait_ms"] = std::stod(argv[i+1]);
       }
+      if (std::string(argv[i]) == "--since" && i + 1 < argc) {
+        params["since"] = std::stod(argv[i+1]);
+      }
     }
     return send_and_print("events.poll");
   }
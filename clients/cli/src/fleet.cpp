@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "fleet.hpp"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <utility>
+
+namespace wininspect_cli {
+
+using namespace wininspect::json;
+
+bool parse_int(const std::string &s, int min, int max, int &out) {
+  int v = 0;
+  const char *end = s.data() + s.size();
+  auto r = std::from_chars(s.data(), end, v);
+  if (s.empty() || r.ec != std::errc() || r.ptr != end || v < min || v > max)
+    return false;
+  out = v;
+  return true;
+}
+
+bool parse_targets(const std::string &list, std::vector<FleetTarget> &out) {
+  size_t start = 0;
+  while (start <= list.size()) {
+    size_t comma = std::min(list.find(',', start), list.size());
+    std::string item = list.substr(start, comma - start);
+    FleetTarget t;
+    size_t colon = item.rfind(':');
+    t.host = item.substr(0, colon);
+    if (t.host.empty())
+      return false;
+    if (colon != std::string::npos && !parse_int(item.substr(colon + 1), 1, 65535, t.port))
+      return false;
+    t.source = "list";
+    out.push_back(std::move(t));
+    start = comma + 1;
+  }
+  return true;
+}
+
+void dedup_targets(std::vector<FleetTarget> &targets) {
+  std::set<std::pair<std::string, int>> seen;
+  targets.erase(std::remove_if(targets.begin(), targets.end(),
+                               [&](const FleetTarget &t) {
+                                 return t.host.empty() || !seen.insert({t.host, t.port}).second;
+                               }),
+                targets.end());
+}
+
+static double ms_since(FleetClock::time_point t) {
+  return (double)std::chrono::duration_cast<std::chrono::milliseconds>(FleetClock::now() - t)
+      .count();
+}
+
+FleetSummary run_fleet(std::vector<FleetTarget> targets, const std::string &method,
+                       const Object &params, int concurrency, int timeout_ms,
+                       const FleetCall &call,
+                       const std::function<void(const std::string &line)> &emit) {
+  dedup_targets(targets);
+  FleetSummary sum;
+  sum.targets = targets.size();
+  if (targets.empty())
+    return sum;
+
+  std::mutex out_mu;
+  std::atomic<size_t> next{0}, failed{0};
+  auto worker = [&] {
+    for (size_t i; (i = next++) < targets.size();) {
+      const FleetTarget &t = targets[i];
+      Object line;
+      line["target"] = t.host + ":" + std::to_string(t.port);
+      line["source"] = t.source;
+      if (!t.name.empty())
+        line["name"] = t.name;
+      if (!t.uuid.empty())
+        line["uuid"] = t.uuid;
+
+      Object req;
+      req["id"] = "fleet-" + std::to_string(i);
+      req["method"] = method;
+      req["params"] = params;
+      auto t0 = FleetClock::now();
+      FleetReply r = call(t, dumps(req), t0 + std::chrono::milliseconds(timeout_ms));
+      if (r.connect_ms >= 0)
+        line["connect_ms"] = r.connect_ms;
+      line["latency_ms"] = ms_since(t0);
+
+      bool ok = false;
+      std::string error = r.error;
+      if (error.empty()) {
+        try {
+          auto v = parse(r.response);
+          if (v.is_obj()) {
+            auto it = v.as_obj().find("ok");
+            ok = it != v.as_obj().end() && it->second.is_bool() && it->second.as_bool();
+            line["response"] = v;
+          } else {
+            error = "bad response";
+          }
+        } catch (...) {
+          error = "bad response";
+        }
+      }
+      line["ok"] = ok;
+      if (!error.empty())
+        line["error"] = error;
+      if (!ok)
+        failed++;
+      std::lock_guard<std::mutex> lk(out_mu);
+      emit(dumps(line));
+    }
+  };
+
+  auto t0 = FleetClock::now();
+  std::vector<std::thread> pool;
+  size_t n = std::min<size_t>((size_t)std::max(concurrency, 1), targets.size());
+  for (size_t i = 0; i < n; i++)
+    pool.emplace_back(worker);
+  for (auto &th : pool)
+    th.join();
+  sum.failed = failed.load();
+  sum.elapsed_ms = ms_since(t0);
+  return sum;
+}
+
+} // namespace wininspect_cli
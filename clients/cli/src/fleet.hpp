@@ -0,0 +1,67 @@
+#pragma once
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+// `wininspect fleet`: one method run across many daemons. Target parsing,
+// de-duplication, the worker pool and the NDJSON lines live here, apart
+// from the Win32 sockets, so they build and are tested on any platform;
+// cli.cpp supplies the call that talks to one daemon.
+
+#include "wininspect/tinyjson.hpp"
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace wininspect_cli {
+
+// A daemon to run against, and how it was found.
+struct FleetTarget {
+  std::string host;
+  int port = 1985;
+  std::string name, uuid;
+  std::string source; // "list", "udp", "mdns" or "rendezvous"
+};
+
+/// A whole decimal number in [min, max]; false, leaving `out`, otherwise.
+bool parse_int(const std::string &s, int min, int max, int &out);
+
+/// Appends each host[:port] of a comma-separated list as a "list" target.
+/// False on an empty host or a bad port; `out` then has the entries
+/// before it.
+bool parse_targets(const std::string &list, std::vector<FleetTarget> &out);
+
+/// Drops targets with no host and repeats of a host:port, keeping the
+/// first (a daemon both listed and discovered runs once).
+void dedup_targets(std::vector<FleetTarget> &targets);
+
+// What one target gave back: its raw response, or why there is none.
+struct FleetReply {
+  std::string response;
+  std::string error;     // empty when `response` arrived
+  double connect_ms = -1; // -1: never connected
+};
+
+using FleetClock = std::chrono::steady_clock;
+
+/// Sends `request` to `t` and reads one response, giving up at `deadline`
+/// however the daemon behaves (a trickle of bytes included).
+using FleetCall = std::function<FleetReply(const FleetTarget &t, const std::string &request,
+                                           FleetClock::time_point deadline)>;
+
+struct FleetSummary {
+  size_t targets = 0, failed = 0;
+  double elapsed_ms = 0;
+};
+
+/// Runs `method` on every target (after dedup_targets), `concurrency` at a
+/// time, each with a deadline timeout_ms after it starts. `emit` gets one
+/// NDJSON line per target as it finishes, never two at once, so a slow or
+/// dead daemon holds up only its own line.
+FleetSummary run_fleet(std::vector<FleetTarget> targets, const std::string &method,
+                       const wininspect::json::Object &params, int concurrency,
+                       int timeout_ms, const FleetCall &call,
+                       const std::function<void(const std::string &line)> &emit);
+
+} // namespace wininspect_cli
@@ -0,0 +1,5 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "doctest/doctest.h"
+int main() { return doctest::run_all(); }
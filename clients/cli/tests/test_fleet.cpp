@@ -0,0 +1,145 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "../src/fleet.hpp"
+#include "doctest/doctest.h"
+#include "wininspect/tinyjson.hpp"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <map>
+#include <mutex>
+#include <thread>
+
+using namespace wininspect_cli;
+using namespace wininspect;
+
+DOCTEST_TEST_CASE("fleet: numbers from the command line are checked, not thrown") {
+  int v = 7;
+  DOCTEST_REQUIRE(parse_int("42", 1, 100, v));
+  DOCTEST_REQUIRE_EQ(v, 42);
+  for (const char *bad : {"", "x", "4x", " 4", "+4", "-1", "0", "101", "99999999999"}) {
+    DOCTEST_REQUIRE(!parse_int(bad, 1, 100, v));
+    DOCTEST_REQUIRE_EQ(v, 42);
+  }
+  DOCTEST_REQUIRE(parse_int("0", 0, INT_MAX, v));
+  DOCTEST_REQUIRE_EQ(v, 0);
+}
+
+DOCTEST_TEST_CASE("fleet: --targets lists parse host[:port] and reject bad entries") {
+  std::vector<FleetTarget> t;
+  DOCTEST_REQUIRE(parse_targets("10.0.0.1:2000,box,localhost:1", t));
+  DOCTEST_REQUIRE_EQ(t.size(), 3u);
+  DOCTEST_REQUIRE_EQ(t[0].host, std::string("10.0.0.1"));
+  DOCTEST_REQUIRE_EQ(t[0].port, 2000);
+  DOCTEST_REQUIRE_EQ(t[1].host, std::string("box"));
+  DOCTEST_REQUIRE_EQ(t[1].port, 1985);
+  DOCTEST_REQUIRE_EQ(t[2].port, 1);
+  DOCTEST_REQUIRE_EQ(t[2].source, std::string("list"));
+
+  for (const char *bad : {"", "a,", ",a", "a:", ":1985", "a:0", "a:65536", "a:http"}) {
+    std::vector<FleetTarget> u;
+    DOCTEST_REQUIRE(!parse_targets(bad, u));
+  }
+}
+
+DOCTEST_TEST_CASE("fleet: runs each daemon once, at most `concurrency` at a time") {
+  std::vector<FleetTarget> targets;
+  DOCTEST_REQUIRE(parse_targets("a,b:1,c,a:1985,b:1,d,e,f,g,h", targets));
+  targets.push_back({"", 1985, "", "", "udp"}); // no address: dropped
+  targets.push_back({"d", 1985, "desk", "u-1", "mdns"}); // seen as "list" first
+
+  std::mutex mu;
+  std::map<std::string, int> calls;
+  std::atomic<int> active{0}, peak{0}, bad_requests{0};
+  auto call = [&](const FleetTarget &t, const std::string &request,
+                  FleetClock::time_point deadline) {
+    int now = ++active;
+    int p = peak.load();
+    while (now > p && !peak.compare_exchange_weak(p, now)) {}
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    active--;
+    auto req = json::parse(request).as_obj();
+    if (req.at("method").as_str() != "daemon.health" ||
+        !req.at("params").as_obj().at("canonical").as_bool() ||
+        deadline < FleetClock::now() + std::chrono::seconds(50))
+      bad_requests++;
+    {
+      std::lock_guard<std::mutex> lk(mu);
+      calls[t.host + ":" + std::to_string(t.port)]++;
+    }
+    FleetReply r;
+    r.connect_ms = 1;
+    if (t.host == "e") {
+      r.error = "connect failed";
+      r.connect_ms = -1;
+    } else if (t.host == "f") {
+      r.response = "not json";
+    } else if (t.host == "g") {
+      r.response = R"({"id":"x","ok":false})";
+    } else {
+      r.response = R"({"id":"x","ok":true,"result":{}})";
+    }
+    return r;
+  };
+
+  json::Object params;
+  params["canonical"] = true;
+  std::vector<std::string> lines;
+  auto sum = run_fleet(targets, "daemon.health", params, 3, 60000, call,
+                       [&](const std::string &l) { lines.push_back(l); });
+
+  DOCTEST_REQUIRE_EQ(sum.targets, 8u);
+  DOCTEST_REQUIRE_EQ(sum.failed, 3u);
+  DOCTEST_REQUIRE_EQ(lines.size(), 8u);
+  DOCTEST_REQUIRE_EQ(calls.size(), 8u);
+  for (auto &[k, n] : calls) DOCTEST_REQUIRE_EQ(n, 1);
+  DOCTEST_REQUIRE(peak.load() <= 3);
+  DOCTEST_REQUIRE_EQ(bad_requests.load(), 0);
+
+  std::map<std::string, json::Object> by;
+  for (auto &l : lines) {
+    auto o = json::parse(l).as_obj();
+    by[o.at("target").as_str()] = o;
+  }
+  DOCTEST_REQUIRE(by.at("a:1985").at("ok").as_bool());
+  DOCTEST_REQUIRE(by.at("a:1985").count("response") == 1);
+  DOCTEST_REQUIRE_EQ(by.at("d:1985").at("source").as_str(), std::string("list"));
+  DOCTEST_REQUIRE_EQ(by.at("e:1985").at("error").as_str(), std::string("connect failed"));
+  DOCTEST_REQUIRE(by.at("e:1985").count("connect_ms") == 0);
+  DOCTEST_REQUIRE_EQ(by.at("f:1985").at("error").as_str(), std::string("bad response"));
+  DOCTEST_REQUIRE(!by.at("g:1985").at("ok").as_bool());
+  DOCTEST_REQUIRE(by.at("g:1985").count("error") == 0);
+}
+
+DOCTEST_TEST_CASE("fleet: each target gets its own deadline, timeout_ms after it starts") {
+  std::vector<FleetTarget> targets;
+  DOCTEST_REQUIRE(parse_targets("a,b,c", targets));
+  std::mutex mu;
+  std::vector<std::chrono::milliseconds> left;
+  // A daemon that trickles forever: only the deadline ends the call.
+  auto call = [&](const FleetTarget &, const std::string &, FleetClock::time_point deadline) {
+    auto start = FleetClock::now();
+    while (FleetClock::now() < deadline)
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    std::lock_guard<std::mutex> lk(mu);
+    left.push_back(std::chrono::duration_cast<std::chrono::milliseconds>(deadline - start));
+    FleetReply r;
+    r.error = "no response";
+    return r;
+  };
+  std::vector<std::string> lines;
+  auto t0 = FleetClock::now();
+  auto sum = run_fleet(targets, "daemon.health", {}, 1, 100, call,
+                       [&](const std::string &l) { lines.push_back(l); });
+  auto took = FleetClock::now() - t0;
+
+  DOCTEST_REQUIRE_EQ(sum.failed, 3u);
+  DOCTEST_REQUIRE_EQ(left.size(), 3u);
+  for (auto ms : left)
+    DOCTEST_REQUIRE((ms > std::chrono::milliseconds(80) && ms <= std::chrono::milliseconds(100)));
+  DOCTEST_REQUIRE(took >= std::chrono::milliseconds(300));
+  DOCTEST_REQUIRE(took < std::chrono::milliseconds(2000));
+  auto none = run_fleet({}, "daemon.health", {}, 4, 100, call, [](const std::string &) {});
+  DOCTEST_REQUIRE_EQ(none.targets, 0u);
+}
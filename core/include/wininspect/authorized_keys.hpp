@@ -0,0 +1,72 @@
+#pragma once
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "crypto.hpp"
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace wininspect {
+
+/// An authorized_keys file parsed once into an index from identity to
+/// decoded Ed25519 keys, so a handshake costs one hash lookup and one
+/// signature check however long the file is.
+///
+/// Lines look like OpenSSH's: `[options] ssh-ed25519 <base64> <identity>`.
+/// The identity is the comment, matched exactly; one identity may list
+/// several keys. Comments, blank lines, other key types, malformed keys and
+/// keys without an identity are skipped.
+class AuthorizedKeys {
+public:
+  static AuthorizedKeys parse(const std::string &text);
+
+  /// Keys listed for `identity`; empty if none.
+  std::span<const crypto::Ed25519PublicKey> find(const std::string &identity) const;
+  /// A raw base64 Ed25519 signature of `message` by one of identity's keys.
+  bool verify(const std::string &identity, std::span<const std::uint8_t> message,
+              const std::string &signature_b64) const;
+
+  size_t identities() const { return index_.size(); }
+  size_t keys() const { return keys_; }
+  size_t skipped() const { return skipped_; } // unusable non-comment lines
+
+private:
+  std::unordered_map<std::string, std::vector<crypto::Ed25519PublicKey>> index_;
+  size_t keys_ = 0;
+  size_t skipped_ = 0;
+};
+
+/// An authorized_keys file on disk, re-read when it changes. current()
+/// checks the file's size and modification time at most once per
+/// `recheck` and reparses only when they moved, so keys can be added or
+/// revoked without restarting the daemon. A file that cannot be read
+/// authorizes nobody until it can. Thread-safe.
+class AuthorizedKeysFile {
+public:
+  explicit AuthorizedKeysFile(std::filesystem::path path,
+                              std::chrono::milliseconds recheck = std::chrono::seconds(1));
+
+  std::shared_ptr<const AuthorizedKeys> current();
+  const std::filesystem::path &path() const { return path_; }
+
+private:
+  void reload(); // mu_ held
+
+  std::filesystem::path path_;
+  std::chrono::milliseconds recheck_;
+  std::mutex mu_;
+  std::shared_ptr<const AuthorizedKeys> keys_;
+  std::chrono::steady_clock::time_point checked_;
+  std::filesystem::file_time_type mtime_{};
+  std::uintmax_t size_ = 0;
+  bool loaded_ = false;
+};
+
+} // namespace wininspect
@@ -6,6 +6,8 @@
 #include "types.hpp"
 #include "update.hpp"
 #include "tinyjson.hpp"
+#include "event_source.hpp"
+#include <memory>
 #include <optional>
 #include <vector>
 
@@ -72,7 +74,10 @@ public:
 
   // File System
   virtual std::optional<FileInfo> get_file_info(const std::string &path) = 0;
-  virtual std::optional<std::string> read_file_content(const std::string &path) = 0;
+  // Bytes [offset, offset + length) of a file, clipped to its end and read
+  // through a mapping of just that range. Null if it cannot be opened.
+  virtual std::optional<FileChunk> read_file_range(const std::string &path, uint64_t offset,
+                                                   size_t length) = 0;
 
   // Advanced Discovery
   virtual std::vector<hwnd_u64> find_windows_regex(const std::string &title_regex, const std::string &class_regex) = 0;
@@ -123,6 +128,8 @@ public:
   // Event polling
   virtual std::vector<Event> poll_events(const Snapshot &old_snap,
                                          const Snapshot &new_snap) = 0;
+  // Pushed events (hooks); nullptr if this backend only supports polling.
+  virtual std::unique_ptr<IEventSource> create_event_source() = 0;
 };
 
 } // namespace wininspect
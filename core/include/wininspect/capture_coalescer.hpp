@@ -0,0 +1,59 @@
+#pragma once
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "backend.hpp"
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+
+namespace wininspect {
+
+/// Single-flight front for IBackend::capture_snapshot().
+///
+/// A caller that arrives while a capture is running waits for it and gets
+/// the same result. One that arrives within `freshness_ms` of the last
+/// capture *starting* reuses it outright. So no result is ever older than
+/// freshness_ms plus one capture. A negative freshness turns coalescing off:
+/// every call captures.
+class CaptureCoalescer {
+public:
+  explicit CaptureCoalescer(IBackend *backend, int freshness_ms = 20);
+
+  struct Result {
+    std::shared_ptr<const Snapshot> snap;
+    bool shared = false; // true if another caller's capture was reused
+  };
+  /// Rethrows whatever the backend threw, to every caller sharing the capture.
+  Result capture() { return capture(freshness_ms_, false); }
+  /// As capture(), with this call's own window. 0 asks for a capture that
+  /// started after the call: one already running is waited out, not
+  /// joined. Ignored (every call captures) while coalescing is off.
+  Result capture(int max_age_ms) { return capture(max_age_ms, max_age_ms <= 0); }
+
+  struct Stats {
+    uint64_t requests = 0;  // capture() calls
+    uint64_t captures = 0;  // backend enumerations actually run
+    uint64_t joined = 0;    // waited on an in-flight capture
+    uint64_t fresh = 0;     // reused a completed capture inside the window
+  };
+  Stats stats() const;
+
+  int freshness_ms() const { return freshness_ms_; }
+
+private:
+  Result capture(int max_age_ms, bool after_call);
+
+  IBackend *backend_;
+  int freshness_ms_;
+
+  mutable std::mutex mu_;
+  std::shared_future<std::shared_ptr<const Snapshot>> inflight_;
+  std::shared_ptr<const Snapshot> last_;
+  std::chrono::steady_clock::time_point last_started_;
+  std::chrono::steady_clock::time_point inflight_started_;
+  Stats stats_;
+};
+
+} // namespace wininspect
@@ -0,0 +1,100 @@
+#pragma once
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "backend.hpp"
+#include "event_source.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace wininspect {
+
+/// One background thread that captures, diffs against the previous capture
+/// (IBackend::poll_events) and hands any events to a sink. Subscribers then
+/// read the sink's log instead of diffing snapshots themselves.
+///
+/// The tick interval adapts: it drops to min_interval_ms as soon as a diff
+/// finds changes and doubles on each quiet tick up to max_interval_ms. If
+/// nobody has called touch() for idle_stop_ms the thread stops capturing;
+/// the next touch() resumes it, and the first diff after that is taken
+/// against the last pre-pause capture, so net changes are still reported.
+///
+/// Given an IEventSource that starts, the detector stops diffing on every
+/// tick and forwards pushed events instead (still from its own thread, so
+/// the sink keeps a single caller). Pushes duplicating what it already
+/// knows (a create for a window it has, a destroy for one it never saw)
+/// are dropped. Every reconcile_ms, while someone is listening, it captures
+/// once and diffs against the windows it believes exist, to report
+/// anything the hooks missed.
+class ChangeDetector {
+public:
+  using Capture = std::function<std::shared_ptr<const Snapshot>()>;
+  using Sink = std::function<void(std::vector<Event> &events, const Snapshot &cur)>;
+
+  struct Options {
+    int min_interval_ms = 50;
+    int max_interval_ms = 1000;
+    int idle_stop_ms = 300000;
+    int reconcile_ms = 5000; // with an event source
+  };
+
+  /// `capture` defaults to backend->capture_snapshot(); pass one to route
+  /// through a CaptureCoalescer. `sink` is called on the detector thread
+  /// after every diff, with no events on a quiet tick, so consumers with
+  /// timers of their own (debouncing) can use it as a clock. With an event
+  /// source, `cur` is the most recent reconcile capture, not a fresh one.
+  ChangeDetector(IBackend *backend, Capture capture, Sink sink, Options opts,
+                 std::unique_ptr<IEventSource> source = nullptr);
+  ChangeDetector(IBackend *backend, Capture capture, Sink sink)
+      : ChangeDetector(backend, std::move(capture), std::move(sink), Options{}) {}
+  ~ChangeDetector();
+
+  ChangeDetector(const ChangeDetector &) = delete;
+  ChangeDetector &operator=(const ChangeDetector &) = delete;
+
+  /// Note that someone is listening. Wakes a paused detector; with
+  /// `urgent`, also drops to the fastest rate (a poller is waiting).
+  void touch(bool urgent = false);
+
+  struct Stats {
+    uint64_t ticks = 0;        // captures diffed
+    uint64_t changed_ticks = 0;
+    uint64_t events = 0;
+    int interval_ms = 0;       // current adaptive interval
+    bool paused = false;
+    bool hooked = false;       // events come from the source
+    uint64_t pushed = 0;       // events received from the source
+    uint64_t duplicates = 0;   // pushes dropped: already known, or unknown window
+    uint64_t reconciled = 0;   // events only the reconcile diff found
+  };
+  Stats stats() const;
+
+private:
+  void run();
+  /// False if the source would not start; `baseline` is then the capture
+  /// taken beforehand, for the diffing loop to continue from.
+  bool run_hooked(std::shared_ptr<const Snapshot> &baseline);
+  bool idle_locked() const;
+
+  IBackend *backend_;
+  Capture capture_;
+  Sink sink_;
+  Options opts_;
+  std::unique_ptr<IEventSource> source_;
+  std::vector<Event> inbox_; // pushed, not yet forwarded (under mu_)
+
+  mutable std::mutex mu_;
+  std::condition_variable cv_;
+  std::chrono::steady_clock::time_point last_touch_;
+  uint64_t touches_ = 0; // wakes a paused thread
+  bool urgent_ = false;
+  bool stop_ = false;
+  Stats stats_;
+  std::thread thread_;
+};
+
+} // namespace wininspect
@@ -0,0 +1,44 @@
+#pragma once
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace wininspect::compress {
+
+/// Payload codecs for compressed frames. LZ4 (block format) is built in
+/// and fast enough to pay for itself on any link; zlib trades speed for
+/// ratio and is present only when the build found it.
+enum class Codec : std::uint8_t { None = 0, Lz4 = 1, Zlib = 2 };
+
+/// "lz4", "zlib"; "" for None.
+const char *codec_name(Codec c);
+/// None for unknown names and for codecs this build lacks.
+Codec codec_from_name(std::string_view name);
+/// Built-in codecs by name, fastest first.
+std::vector<std::string> available();
+
+/// A packed payload: [codec][raw size, 4 bytes little-endian][data].
+inline constexpr size_t HEADER_BYTES = 5;
+
+/// Appends the packed form of `n` bytes to `out`. False (with `out` as it
+/// was) when the codec is unavailable or the result would not be smaller,
+/// in which case the payload should go uncompressed.
+bool pack(Codec c, const void *in, size_t n, std::string &out);
+/// Replaces `out` (which must not overlap `in`) with the unpacked payload.
+/// False on a malformed payload, an unavailable codec, or a raw size over
+/// `max`.
+bool unpack(const void *in, size_t n, size_t max, std::string &out);
+
+/// LZ4 block format, without a frame header: the worst-case compressed
+/// size; compress into at least that much room (returns the size written,
+/// or 0 if `cap` is short); decompress exactly `raw` bytes, or fail.
+size_t lz4_bound(size_t n);
+size_t lz4_compress(const std::uint8_t *src, size_t n, std::uint8_t *dst, size_t cap);
+bool lz4_decompress(const std::uint8_t *src, size_t n, std::uint8_t *dst, size_t raw);
+
+} // namespace wininspect::compress
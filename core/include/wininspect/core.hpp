@@ -7,14 +7,31 @@
 #include "logger.hpp"
 #include <functional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
 namespace wininspect {
 
+/// Raw bytes sent beside a JSON envelope rather than base64'd inside it.
+using Attachment = std::vector<std::uint8_t>;
+
+/// The most file.read and file.tail return in one response (or one stream
+/// chunk): even base64'd it fits in a frame.
+inline constexpr size_t FILE_READ_MAX_BYTES = 4 * 1024 * 1024;
+/// Cap on file.tail's wait_ms.
+inline constexpr int FILE_TAIL_MAX_WAIT_MS = 30000;
+
 struct CoreRequest {
   std::string id;
   std::string method;
   json::Object params;
+  /// The client takes attachments ("binary": true in the envelope): byte
+  /// results become {"attachment": i, "size": n} references into the
+  /// response's attachments instead of *_b64 strings.
+  bool binary = false;
+  /// Byte parameters referenced from params as {"attachment": i}.
+  std::vector<Attachment> attachments = {};
 };
 
 struct CoreResponse {
@@ -24,6 +41,7 @@ struct CoreResponse {
   std::string error_code;
   std::string error_message;
   json::Object metrics;
+  std::vector<Attachment> attachments = {};
 
   json::Object to_json_obj(bool canonical) const;
 };
@@ -52,4 +70,13 @@ private:
 [[nodiscard]] CoreRequest parse_request_json(std::string_view json_utf8);
 [[nodiscard]] std::string serialize_response_json(const CoreResponse &resp, bool canonical);
 
+/// A multipart payload: [JSON length, 4 bytes little-endian][JSON], then
+/// for each attachment [length, 4 bytes little-endian][bytes]. Transports
+/// mark it in the frame header; the JSON refers to attachments by index.
+void append_multipart(std::string &out, std::string_view json,
+                      const std::vector<Attachment> &attachments);
+/// False on a truncated or overlong payload.
+[[nodiscard]] bool split_multipart(std::string_view payload, std::string &json,
+                                   std::vector<Attachment> &attachments);
+
 } // namespace wininspect
@@ -3,46 +3,135 @@
 // Copyright (c) 2026 Mark E. DeYoung
 
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
+#include <memory>
+#include <span>
 #include <string>
 #include <vector>
 
 namespace wininspect::crypto {
 
+// Sealed record layout: [12-byte nonce][16-byte tag][ciphertext]. The
+// nonce is the sender's record counter (bytes 0-7, little-endian) plus a
+// direction byte (byte 11), so the two ends never reuse a nonce under the
+// shared key.
+inline constexpr size_t NONCE_BYTES = 12;
+inline constexpr size_t TAG_BYTES = 16;
+inline constexpr size_t RECORD_OVERHEAD = NONCE_BYTES + TAG_BYTES;
+
+enum class Role : uint8_t { Client = 0, Server = 1 };
+
+// One record for CryptoSession::seal_batch.
+struct SealJob {
+  std::span<const uint8_t> plaintext;
+  std::span<uint8_t> record; // RECORD_OVERHEAD + plaintext.size() bytes
+};
+
 struct Signature {
   std::string identity;
   std::vector<uint8_t> blob;
 };
 
 // Key exchange and session state
+// Which implementation this build uses: "cng" (Windows CNG), "openssl",
+// or "none" (no key exchange or encryption; everything fails closed).
+const char *backend_name();
+
+// Not thread-safe: callers serialize use of one session.
 class CryptoSession {
 public:
-  CryptoSession();
+  explicit CryptoSession(Role role = Role::Client);
   ~CryptoSession();
+  CryptoSession(const CryptoSession &) = delete;
+  CryptoSession &operator=(const CryptoSession &) = delete;
 
-  // Generates a local X25519 key pair and returns the public key
+  // Generates a local P-256 key pair and returns the public key
   [[nodiscard]] std::vector<uint8_t> generate_local_key();
 
-  // Computes the shared secret and initializes symmetric encryption
+  // Computes the shared secret and initializes symmetric encryption. The
+  // public keys on both sides are CNG BCRYPT_ECCPUBLIC_BLOBs (P-256), and
+  // the AES-256 key is SHA-256 of the shared X coordinate, whatever the
+  // backend.
   [[nodiscard]] bool compute_shared_secret(const std::vector<uint8_t> &remote_pubkey);
 
-  // Encrypts a message using AES-256-GCM
+  // Starts the record layer on a key derived elsewhere (32 bytes), with
+  // both counters back at zero.
+  [[nodiscard]] bool install_key(std::span<const uint8_t> key);
+
+  // SHA-256("wininspect resumption" || key) of the installed key: both
+  // ends know it, it never travels, and it keys the next session when a
+  // resumption ticket is redeemed (see session_ticket.hpp).
+  const std::array<uint8_t, 32> &resumption_secret() const { return resume_secret_; }
+
+  // Encrypts a message using AES-256-GCM (allocates; see seal)
   [[nodiscard]] std::vector<uint8_t> encrypt(const std::string &plaintext);
 
-  // Decrypts a message using AES-256-GCM
+  // Decrypts a message using AES-256-GCM (allocates; see open)
   [[nodiscard]] std::string decrypt(const std::vector<uint8_t> &ciphertext);
 
+  // Encrypts `plaintext` straight into `record`, which must be exactly
+  // RECORD_OVERHEAD bytes longer, with the next counter nonce. The
+  // plaintext may already sit at the tail of `record` (in place).
+  // Allocates nothing.
+  [[nodiscard]] bool seal(std::span<const uint8_t> plaintext, std::span<uint8_t> record);
+
+  // Seals several records in one pass with consecutive nonces, e.g. the
+  // responses that completed while the previous write was in progress.
+  [[nodiscard]] bool seal_batch(std::span<const SealJob> jobs);
+
+  // Authenticates and decrypts `record` in place; the plaintext is then
+  // record.subspan(RECORD_OVERHEAD). Rejects records sent in this
+  // session's own direction (reflected) or whose counter does not advance
+  // (replayed).
+  [[nodiscard]] bool open(std::span<uint8_t> record);
+
+  // AES-256-GCM under the installed key with a caller-supplied nonce,
+  // outside the record counters. The caller owns nonce uniqueness; this is
+  // for data sealed to itself (resumption tickets use random nonces).
+  [[nodiscard]] bool seal_with_nonce(const uint8_t nonce[NONCE_BYTES], const uint8_t *pt,
+                                     size_t n, uint8_t *ct, uint8_t tag[TAG_BYTES]);
+  [[nodiscard]] bool open_with_nonce(const uint8_t nonce[NONCE_BYTES], const uint8_t *ct,
+                                     size_t n, uint8_t *pt, const uint8_t tag[TAG_BYTES]);
+
   bool is_initialized() const { return initialized_; }
 
 private:
+  // Implemented once per backend (crypto_cng.cpp, crypto_openssl.cpp,
+  // crypto_none.cpp); the rest of the class is shared (crypto.cpp).
+  struct State;
+  bool ecdh_derive(const std::vector<uint8_t> &remote_pubkey, uint8_t key[32]);
+  bool set_aes_key(const uint8_t key[32]);
+  // AES-256-GCM with the session key; `ct`/`pt` may alias.
+  bool aead_seal(const uint8_t *nonce, const uint8_t *pt, size_t n, uint8_t *ct,
+                 uint8_t *tag);
+  bool aead_open(const uint8_t *nonce, const uint8_t *ct, size_t n, uint8_t *pt,
+                 const uint8_t *tag);
+
+  Role role_;
   bool initialized_ = false;
-  void *hAlgAES_ = nullptr;
-  void *hKeyAES_ = nullptr;
-  uint64_t nonce_counter_ = 0;
-  std::vector<uint8_t> shared_secret_;
+  std::unique_ptr<State> st_;
+  uint64_t nonce_counter_ = 0; // next record sent
+  uint64_t recv_next_ = 0;     // the only counter open() accepts
+  std::array<uint8_t, 32> resume_secret_{};
 };
 
+// Fills `out` from the system CSPRNG
+[[nodiscard]] bool random_bytes(uint8_t *out, size_t n);
+
+// SHA-256 of `data`
+[[nodiscard]] bool sha256(std::span<const uint8_t> data, uint8_t out[32]);
+
+using Ed25519PublicKey = std::array<uint8_t, 32>;
+
+// Verifies a raw 64-byte Ed25519 signature against a decoded public key
+[[nodiscard]] bool verify_ed25519(std::span<const uint8_t> message,
+                                  std::span<const uint8_t> signature,
+                                  const Ed25519PublicKey &public_key);
+
 // Verifies an Ed25519 SSH signature against an authorized_keys-style entry
+// (parses the line on every call; see AuthorizedKeys for an index)
 [[nodiscard]] bool verify_ssh_sig(const std::vector<uint8_t> &message,
                                    const std::string &signature_b64,
                                    const std::string &public_key_line);
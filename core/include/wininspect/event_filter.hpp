@@ -0,0 +1,75 @@
+#pragma once
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "regex_engine.hpp"
+#include "tinyjson.hpp"
+#include "types.hpp"
+#include "window_index.hpp"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace wininspect {
+
+/// What an EventFilter may test about the window an event refers to. For a
+/// destroyed window these are its last known values.
+struct WindowFacts {
+  std::string class_name;
+  std::string title;
+  std::uint32_t pid = 0;
+  std::vector<hwnd_u64> ancestors; // parent and owner chain, nearest first
+};
+
+/// A compiled events.subscribe filter. The spec is a JSON object; every key
+/// is optional and all present keys must match:
+///
+///   types             "window.created" | "window.destroyed" | "window.changed",
+///                     or an array of them
+///   class, title      patterns, interpreted per `match`
+///   match             "regex" (default) | "substring" | "prefix" | "exact"
+///   case_insensitive  bool
+///   pid               number or array of numbers
+///   under             "0x..." — the window itself or anything it is a
+///                     child or owned window of
+///
+/// Patterns are compiled once, here, not per event.
+class EventFilter {
+public:
+  /// Accepts everything.
+  EventFilter() = default;
+  /// Throws std::runtime_error (RegexError for a bad pattern) on a bad spec.
+  static EventFilter compile(const json::Object &spec);
+
+  bool accepts_type(const std::string &type) const;
+  /// True if matches() needs facts (class, title, pid or under is set).
+  bool needs_facts() const;
+  bool needs_ancestry() const { return under_ != 0; }
+  /// Whether window.changed events are wanted at all.
+  bool wants_changes() const { return accepts_type("window.changed"); }
+
+  /// `facts` may be null when the window is unknown; then only filters
+  /// without window predicates match.
+  bool matches(const Event &e, const WindowFacts *facts) const;
+  /// The predicates that do not change over a window's life (class, pid,
+  /// under); decides which windows are worth watching for title changes.
+  bool matches_static(hwnd_u64 hwnd, const WindowFacts &facts) const;
+
+private:
+  struct Pattern {
+    MatchMode mode = MatchMode::Regex;
+    bool icase = false;
+    std::string text; // ASCII-folded when icase (literal modes)
+    std::shared_ptr<const Regex> re;
+    bool operator()(const std::string &s) const;
+  };
+
+  unsigned types_ = ~0u; // bit per event type
+  std::optional<Pattern> class_, title_;
+  std::vector<std::uint32_t> pids_;
+  hwnd_u64 under_ = 0;
+};
+
+} // namespace wininspect
@@ -0,0 +1,77 @@
+#pragma once
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "types.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace wininspect {
+
+/// Bounded single-producer / multi-consumer event log.
+///
+/// push() numbers events 1, 2, 3, ... and overwrites the oldest once the
+/// ring is full. Readers keep their own cursor (the last seq they saw) and
+/// read without taking any lock: each slot is a seqlock, and a reader that
+/// loses a race with the producer simply learns it fell behind. Anything
+/// older than the retention window is reported as a gap rather than
+/// silently skipped.
+///
+/// Slots store events in fixed-width form: `type` and `property` are
+/// truncated to FIELD_LEN bytes (all event names in use are far shorter).
+class EventRing {
+public:
+  static constexpr size_t FIELD_LEN = 32;
+
+  /// Capacity is rounded up to a power of two (minimum 2).
+  explicit EventRing(size_t capacity);
+
+  EventRing(const EventRing &) = delete;
+  EventRing &operator=(const EventRing &) = delete;
+
+  /// Producer only (one thread at a time). Stamps e.seq and returns it.
+  uint64_t push(Event &e);
+
+  struct ReadResult {
+    uint64_t last_seq = 0; // new cursor: pass back as `since`
+    bool gap = false;      // events after `since` were overwritten
+  };
+  /// Append up to `max` events with seq > since to `out`, oldest first.
+  /// Never blocks. A cursor ahead of head() (e.g. from an earlier run)
+  /// is treated as a gap and reading restarts at the oldest event.
+  ReadResult read(uint64_t since, std::vector<Event> &out, size_t max) const;
+
+  /// Block until head() > since or the timeout passes. Returns head() > since.
+  bool wait_for(uint64_t since, std::chrono::milliseconds timeout) const;
+
+  uint64_t head() const { return head_.load(std::memory_order_acquire); }
+  /// Oldest seq still retained (head() + 1 when empty).
+  uint64_t oldest() const;
+  size_t capacity() const { return mask_ + 1; }
+
+private:
+  static constexpr size_t STR_WORDS = FIELD_LEN / 8;
+  struct Slot {
+    // (seq << 1) | writing. A reader accepts the slot only if this is the
+    // same, even value before and after copying the payload.
+    std::atomic<uint64_t> stamp{0};
+    std::atomic<uint64_t> hwnd{0};
+    std::atomic<uint64_t> type[STR_WORDS]{};
+    std::atomic<uint64_t> property[STR_WORDS]{};
+  };
+
+  std::unique_ptr<Slot[]> slots_;
+  size_t mask_;
+  std::atomic<uint64_t> head_{0}; // last published seq
+
+  mutable std::mutex wait_mu_; // only for blocking waiters
+  mutable std::condition_variable wait_cv_;
+  mutable std::atomic<int> waiters_{0};
+};
+
+} // namespace wininspect
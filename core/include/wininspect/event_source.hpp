@@ -0,0 +1,33 @@
+#pragma once
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "types.hpp"
+#include <functional>
+#include <vector>
+
+namespace wininspect {
+
+/// A source of pushed window events (hooks), as opposed to the snapshot
+/// diffing of IBackend::poll_events. Obtained from
+/// IBackend::create_event_source(); ChangeDetector consumes it and falls
+/// back to diffing when there is none or start() fails.
+///
+/// Events use the same vocabulary as poll_events (window.created,
+/// window.destroyed, window.changed + property) with seq left at 0.
+class IEventSource {
+public:
+  /// Called on the source's own thread, possibly with several events.
+  using Sink = std::function<void(std::vector<Event> &events)>;
+
+  virtual ~IEventSource() = default;
+
+  /// Begin delivering events. Returns false if the source is unavailable
+  /// here (no hook support, permissions); nothing is delivered then.
+  virtual bool start(Sink sink) = 0;
+  /// Stop delivering; no sink call is in progress or made after return.
+  virtual void stop() = 0;
+  virtual const char *name() const = 0;
+};
+
+} // namespace wininspect
@@ -0,0 +1,80 @@
+#pragma once
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "types.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace wininspect {
+
+/// Outbound event queue for one pushed stream (events.stream, SSE).
+///
+/// Bounded: when a slow client lets more than max_queue events pile up, the
+/// overflow policy applies. `Coalesce` first cancels events that no longer
+/// matter: a window created and destroyed within the backlog vanishes
+/// entirely, and repeated changes of one property keep only the last. If
+/// that is not enough, or with `DropOldest`, the oldest events are dropped
+/// and the next batch carries a gap marker with the count.
+///
+/// Flow control is credit-based: the client grants credit (in events) and
+/// take() never hands out more events than it has. Gap notices cost no
+/// credit, so a stalled client still learns that it lost events.
+class EventStream {
+public:
+  enum class Overflow { DropOldest, Coalesce };
+  static std::optional<Overflow> overflow_from_str(const std::string &s);
+
+  struct Options {
+    size_t max_queue = 256;
+    Overflow overflow = Overflow::Coalesce;
+    uint64_t credit = 64; // initial credit
+  };
+  explicit EventStream(Options opts);
+
+  /// Producer side. `gap` means events were already lost upstream.
+  void push(const std::vector<Event> &events, bool gap = false);
+  /// Adds credit; returns the new total.
+  uint64_t grant(uint64_t n);
+
+  struct Batch {
+    std::vector<Event> events;
+    bool gap = false;
+    uint64_t dropped = 0; // events dropped here since the previous batch
+  };
+  /// Waits up to `timeout` for something sendable: queued events with
+  /// credit to spare, or a gap notice. Returns false on timeout or close.
+  bool take(Batch &out, size_t max, std::chrono::milliseconds timeout);
+
+  void close();
+  bool closed() const;
+
+  struct Stats {
+    uint64_t delivered = 0, dropped = 0, coalesced = 0;
+    uint64_t credit = 0;
+    size_t queued = 0;
+  };
+  Stats stats() const;
+
+private:
+  void shrink_locked();
+  bool sendable_locked() const;
+
+  Options opts_;
+  mutable std::mutex mu_;
+  std::condition_variable cv_;
+  std::deque<Event> q_;
+  uint64_t credit_;
+  bool gap_ = false;
+  uint64_t pending_dropped_ = 0;
+  bool closed_ = false;
+  Stats stats_;
+};
+
+} // namespace wininspect
@@ -4,6 +4,7 @@
 
 
 #include "backend.hpp"
+#include "fake_timeline.hpp"
 #include <map>
 #include <mutex>
 
@@ -21,6 +22,7 @@ struct FakeWindow {
 class FakeBackend final : public IBackend {
 public:
   explicit FakeBackend(std::vector<FakeWindow> windows);
+  ~FakeBackend() override;
 
   void set_config(const json::Object &config) override;
 
@@ -68,7 +70,8 @@ public:
 
   // File System
   std::optional<FileInfo> get_file_info(const std::string &path) override;
-  std::optional<std::string> read_file_content(const std::string &path) override;
+  std::optional<FileChunk> read_file_range(const std::string &path, uint64_t offset,
+                                           size_t length) override;
 
   // Advanced Discovery
   std::vector<hwnd_u64> find_windows_regex(const std::string &title_regex, const std::string &class_regex) override;
@@ -113,17 +116,34 @@ public:
   void add_fake_ui_element(hwnd_u64 parent, const UIElementInfo &info);
   std::vector<std::string> get_injected_events() const;
   void clear_injected_events();
+  // Mutate the fake desktop (thread-safe; for change-detection tests)
+  void add_window(const FakeWindow &w);
+  bool remove_window(hwnd_u64 hwnd);
+  bool set_title(hwnd_u64 hwnd, const std::string &title);
+  // Fake files are real temp files, removed with the backend, so reads go
+  // through the same mapping code as on Windows. Other paths are read from
+  // the host as given.
+  void add_file(const std::string &path, const std::string &content);
+  void append_file(const std::string &path, const std::string &content);
 
   std::vector<Event> poll_events(const Snapshot &old_snap,
                                  const Snapshot &new_snap) override;
+  // nullptr until set_timeline(); then a ScriptedEventSource playing it.
+  std::unique_ptr<IEventSource> create_event_source() override;
+  void set_timeline(const FakeTimeline::Options &opts, bool realtime = true);
 
 private:
   mutable std::mutex mu_;
+  std::optional<FakeTimeline::Options> timeline_;
+  bool timeline_realtime_ = true;
   std::map<hwnd_u64, FakeWindow> w_;
   hwnd_u64 foreground_ = 0;
 
   std::map<hwnd_u64, std::vector<UIElementInfo>> ui_elements_;
   std::vector<std::string> injected_events_;
+  std::map<std::string, std::string> files_; // fake path -> temp file
+
+  std::string host_path(const std::string &path) const;
 };
 
 } // namespace wininspect
@@ -0,0 +1,92 @@
+#pragma once
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "event_source.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace wininspect {
+
+class FakeBackend;
+
+/// Deterministic window-event schedules for exercising the event pipeline
+/// without Windows. The same options and starting windows always produce
+/// the same steps.
+class FakeTimeline {
+public:
+  enum class Shape {
+    Steady,   // evenly spaced at `rate`
+    Burst,    // `burst` events at once, bursts spaced to average `rate`
+    Sawtooth, // rate ramps from 0 to 2x`rate` over each `period_ms`
+  };
+  static std::optional<Shape> shape_from_str(const std::string &s);
+
+  struct Options {
+    double rate = 1000; // average events per second
+    Shape shape = Shape::Steady;
+    size_t burst = 100;
+    int period_ms = 1000;
+    size_t total = 10000;
+    uint32_t seed = 1;
+    int create_pct = 30; // of events; destroy_pct likewise, the rest are
+    int destroy_pct = 30; // title changes
+  };
+
+  struct Step {
+    std::chrono::nanoseconds at{}; // offset from the start of playback
+    Event event;
+    std::string title; // new title for window.created / window.changed
+  };
+
+  /// `existing` are the top-level windows present at the start; new
+  /// windows are numbered from `next_hwnd`.
+  static std::vector<Step> generate(const Options &opts, std::vector<hwnd_u64> existing,
+                                    hwnd_u64 next_hwnd);
+};
+
+/// Plays a timeline against a FakeBackend: each step mutates the fake
+/// desktop and is then pushed, so get_info() and captures agree with the
+/// events. Steps due at the same instant are delivered as one batch.
+/// With `realtime` false the schedule is ignored and steps are played as
+/// fast as the sink accepts them.
+class ScriptedEventSource final : public IEventSource {
+public:
+  ScriptedEventSource(FakeBackend *backend, std::vector<FakeTimeline::Step> steps,
+                      bool realtime = true);
+  ~ScriptedEventSource() override;
+
+  bool start(Sink sink) override;
+  void stop() override;
+  const char *name() const override { return "scripted"; }
+
+  /// Waits until every step has been delivered.
+  bool wait_done(std::chrono::milliseconds timeout);
+  size_t delivered() const { return delivered_.load(); }
+  std::chrono::steady_clock::time_point started_at() const { return t0_; }
+  const std::vector<FakeTimeline::Step> &steps() const { return steps_; }
+
+private:
+  void run();
+
+  FakeBackend *backend_;
+  std::vector<FakeTimeline::Step> steps_;
+  bool realtime_;
+  Sink sink_;
+  std::chrono::steady_clock::time_point t0_;
+  std::atomic<size_t> delivered_{0};
+  std::mutex mu_;
+  std::condition_variable cv_;
+  bool stop_ = false;
+  bool done_ = false;
+  std::thread thread_;
+};
+
+} // namespace wininspect
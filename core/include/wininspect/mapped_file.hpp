@@ -0,0 +1,52 @@
+#pragma once
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace wininspect {
+
+/// Read-only memory mapping of a file (mmap / CreateFileMapping). Move-only.
+/// An empty file or range, or a failed open, yields an invalid mapping.
+class MappedFile {
+public:
+  MappedFile() = default;
+  /// Maps the first `length` bytes of `path`, or the whole file if 0.
+  explicit MappedFile(const std::string &path, uint64_t length = 0);
+  /// Maps only [offset, offset + length) of `path` (to its end if `length`
+  /// is 0), clipped to the file, so large files can be read a window at a
+  /// time.
+  MappedFile(const std::string &path, uint64_t offset, uint64_t length);
+  ~MappedFile();
+
+  MappedFile(MappedFile &&o) noexcept;
+  MappedFile &operator=(MappedFile &&o) noexcept;
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  bool valid() const { return data_ != nullptr; }
+  const uint8_t *data() const { return data_; }
+  size_t size() const { return size_; }
+  /// Whether the file could be opened, even if the range was empty.
+  bool opened() const { return opened_; }
+  /// The file's size when it was mapped.
+  uint64_t file_size() const { return file_size_; }
+
+private:
+  void close();
+
+  const uint8_t *data_ = nullptr; // offset's byte, inside the view
+  size_t size_ = 0;
+  const void *view_ = nullptr; // starts at the aligned offset
+  size_t view_size_ = 0;
+  uint64_t file_size_ = 0;
+  bool opened_ = false;
+#ifdef _WIN32
+  void *file_ = nullptr;
+  void *mapping_ = nullptr;
+#endif
+};
+
+} // namespace wininspect
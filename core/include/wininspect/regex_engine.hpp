@@ -0,0 +1,90 @@
+#pragma once
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include <bitset>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <regex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace wininspect {
+
+class RegexError : public std::runtime_error {
+public:
+  using std::runtime_error::runtime_error;
+};
+
+/// A compiled ECMAScript-style pattern, matched byte-wise like std::regex on
+/// std::string. Patterns are compiled to a Thompson NFA and searched with a
+/// Pike VM, so matching is O(pattern * text) whatever the input; there is no
+/// backtracking to blow up. Only patterns the automaton cannot express
+/// (back-references, lookahead) are handed to std::regex.
+///
+/// Supported natively: literals and escapes, `.`, `[...]` classes and ranges,
+/// `\d \w \s` (and negations), `^ $ \b \B`, groups `(...)` / `(?:...)`,
+/// alternation, and `* + ? {n} {n,} {n,m}` (greedy or lazy).
+class Regex {
+public:
+  static constexpr size_t MAX_PATTERN = 4096;
+  static constexpr size_t MAX_PROGRAM = 20000; // NFA instructions
+
+  /// Throws RegexError for a malformed or oversized pattern.
+  Regex(std::string_view pattern, bool icase);
+
+  /// True if the pattern matches anywhere in `text`.
+  bool search(std::string_view text) const;
+
+  bool uses_fallback() const { return fallback_ != nullptr; }
+  size_t program_size() const { return prog_.size(); }
+
+  enum class Op : uint8_t { Byte, Split, Jmp, Bol, Eol, WordB, NotWordB, Match };
+  struct Inst {
+    Op op;
+    uint32_t x = 0; // Byte: class index; Split/Jmp: target
+    uint32_t y = 0; // Split: second target
+  };
+
+private:
+  std::vector<Inst> prog_;
+  std::vector<std::bitset<256>> classes_;
+  bool anchored_ = false; // program starts with `^`
+  std::unique_ptr<std::regex> fallback_;
+};
+
+/// Bounded LRU of compiled patterns keyed by (pattern, flags). Shared
+/// instances are immutable and safe to search from several threads.
+class RegexCache {
+public:
+  explicit RegexCache(size_t capacity = 256) : capacity_(capacity) {}
+
+  /// Compiled pattern, from cache when possible. Compile errors propagate
+  /// and are not cached.
+  std::shared_ptr<const Regex> get(const std::string &pattern, bool icase);
+
+  struct Stats {
+    uint64_t hits = 0, misses = 0, evictions = 0;
+    size_t size = 0;
+  };
+  Stats stats() const;
+
+  /// Process-wide cache used by window searches.
+  static RegexCache &global();
+
+private:
+  using Entry = std::pair<std::string, std::shared_ptr<const Regex>>;
+
+  mutable std::mutex mu_;
+  size_t capacity_;
+  std::list<Entry> lru_; // front = most recently used
+  std::unordered_map<std::string, std::list<Entry>::iterator> map_;
+  Stats stats_;
+};
+
+} // namespace wininspect
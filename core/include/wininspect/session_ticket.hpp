@@ -0,0 +1,85 @@
+#pragma once
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace wininspect {
+
+namespace crypto {
+class CryptoSession;
+}
+
+/// What a redeemed resumption ticket vouches for.
+struct TicketClaims {
+  std::string identity;
+  std::array<std::uint8_t, 32> secret{}; // the issuing session's resumption secret
+};
+
+/// Session-resumption tickets for the TCP handshake (daemon side).
+///
+/// After a full handshake the daemon hands the client an opaque ticket:
+/// AES-256-GCM, under a key only the daemon holds, of the authenticated
+/// identity, an expiry, a single-use id and the session's resumption
+/// secret. A client that presents it on a later connection skips the
+/// signature and the ECDH; both ends derive the new session key from the
+/// secret and fresh randoms (derive_key).
+///
+/// The ticket key rotates every `lifetime`, and the previous key is kept
+/// for one more period, so a ticket always lives out its lifetime and no
+/// key outlives two. Each ticket redeems once. Thread-safe.
+class TicketKeeper {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit TicketKeeper(std::chrono::milliseconds lifetime = std::chrono::hours(1));
+  ~TicketKeeper();
+  TicketKeeper(const TicketKeeper &) = delete;
+  TicketKeeper &operator=(const TicketKeeper &) = delete;
+
+  /// A base64 ticket for `identity`, or empty if the crypto backend failed.
+  std::string issue(const std::string &identity, std::span<const std::uint8_t> secret,
+                    Clock::time_point now = Clock::now());
+  /// The claims of a ticket this keeper issued that has neither expired,
+  /// outlived its key, nor been redeemed before.
+  std::optional<TicketClaims> redeem(const std::string &ticket,
+                                     Clock::time_point now = Clock::now());
+
+  std::chrono::milliseconds lifetime() const { return lifetime_; }
+
+  /// The resumed session's key: SHA-256 of a label, the ticket secret, the
+  /// server's hello nonce and the client's random. False on bad sizes.
+  static bool derive_key(std::span<const std::uint8_t> secret,
+                         std::span<const std::uint8_t> server_nonce,
+                         std::span<const std::uint8_t> client_random, std::uint8_t key[32]);
+
+  /// Redeemed ids remembered until their tickets expire; past this many,
+  /// resumption is refused (clients fall back to the full handshake).
+  static constexpr size_t MAX_REDEEMED = 65536;
+
+private:
+  struct Key {
+    std::uint32_t id = 0;
+    Clock::time_point born;
+    std::unique_ptr<crypto::CryptoSession> aead;
+  };
+  bool rotate(Clock::time_point now); // mu_ held
+  void prune(Clock::time_point now);  // mu_ held
+
+  std::chrono::milliseconds lifetime_;
+  std::mutex mu_;
+  Key current_, previous_;
+  std::uint32_t next_key_id_ = 1;
+  std::unordered_map<std::string, std::int64_t> redeemed_; // ticket id -> expiry (ms)
+};
+
+} // namespace wininspect
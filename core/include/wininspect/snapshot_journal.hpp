@@ -0,0 +1,189 @@
+#pragma once
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+// Append-only on-disk history of snapshots.
+//
+// A journal is a directory of segment files named `journal-<first seq>.wij`.
+// All integers are little-endian.
+//
+//   FileHeader   magic "WIJRNL01", u32 version, u32 reserved, i64 created_ms
+//   Record...    u32 magic 'SREC', u32 total_len, u64 seq, i64 time_ms,
+//                u32 window_count, u32 pool_len, u64 same_as,
+//                window_count x { u64 hwnd, u32 title_off, u32 title_len,
+//                                 u32 class_off, u32 class_len },
+//                pool_len bytes of string data (offsets are pool-relative)
+//                A record whose windows are identical to the previous one
+//                carries no window data, only `same_as` (the seq to read
+//                them from, always in the same segment).
+//   Index        (sealed segments only) n x { u64 seq, i64 time_ms,
+//                                             u64 offset, u32 window_count,
+//                                             u32 reserved }
+//   Trailer      u64 index_offset, u64 entry_count, u32 magic 'WIJX',
+//                u32 reserved
+//
+// Readers map a segment and decode only the index (or, for a segment that
+// was never sealed, just the record headers); window data is read straight
+// out of the mapping when a record is asked for.
+
+#include "mapped_file.hpp"
+#include "types.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace wininspect {
+
+struct JournalEntry {
+  uint64_t seq{};
+  int64_t time_ms{};  // unix epoch milliseconds
+  uint32_t window_count{};
+  uint64_t offset{};  // record offset within its segment
+};
+
+struct JournalWindow {
+  hwnd_u64 hwnd{};
+  std::string_view title;
+  std::string_view class_name;
+};
+
+class JournalSegment;
+
+/// One decoded-on-demand record. Keeps its segment mapped while alive.
+class JournalRecord {
+public:
+  uint64_t seq() const { return entry_.seq; }
+  int64_t time_ms() const { return entry_.time_ms; }
+  uint32_t size() const { return entry_.window_count; }
+  JournalWindow window(uint32_t i) const;
+
+  /// Materialize as a live Snapshot (top-level list plus search index).
+  Snapshot to_snapshot() const;
+
+private:
+  friend class JournalSegment;
+  std::shared_ptr<const JournalSegment> seg_;
+  JournalEntry entry_;
+  const uint8_t *windows_ = nullptr;
+  const uint8_t *pool_ = nullptr;
+  uint32_t pool_len_ = 0;
+};
+
+/// Read-only view of one segment file.
+class JournalSegment : public std::enable_shared_from_this<JournalSegment> {
+public:
+  /// Maps `path` and reads its index. Returns null if the file is not a
+  /// journal segment. A truncated tail (crash mid-write) is ignored.
+  static std::shared_ptr<JournalSegment> open(const std::string &path);
+
+  const std::string &path() const { return path_; }
+  bool sealed() const { return sealed_; }
+  const std::vector<JournalEntry> &entries() const { return entries_; }
+  /// Bytes of whole records, i.e. where the next record would go.
+  uint64_t end_offset() const { return end_; }
+
+  std::optional<JournalRecord> record(uint64_t seq) const;
+
+private:
+  std::string path_;
+  MappedFile map_;
+  bool sealed_ = false;
+  uint64_t end_ = 0;
+  std::vector<JournalEntry> entries_;
+};
+
+class SnapshotJournal {
+public:
+  struct Options {
+    std::string dir;
+    uint64_t segment_bytes = 64ull * 1024 * 1024; // rotate after this size
+    size_t max_segments = 0;    // oldest segments deleted beyond this; 0 = keep all
+    size_t max_queue = 256;     // pending snapshots; further appends are dropped
+    int flush_interval_ms = 100; // how long the writer lets a batch build up
+  };
+
+  /// Opens (creating if needed) the journal directory and starts the writer
+  /// thread. Throws std::runtime_error if the directory is unusable.
+  explicit SnapshotJournal(Options opts);
+  ~SnapshotJournal(); // drains the queue and seals the active segment
+
+  SnapshotJournal(const SnapshotJournal &) = delete;
+  SnapshotJournal &operator=(const SnapshotJournal &) = delete;
+
+  /// Queue a snapshot for writing and return its sequence number, or 0 if
+  /// the queue is full. Never blocks on disk I/O.
+  uint64_t append(const Snapshot &s);
+
+  /// Block until everything appended so far is on disk.
+  void flush();
+
+  /// Entries with since_ms <= time_ms <= until_ms, oldest first, at most
+  /// `limit` of them (the newest `limit` if there are more).
+  std::vector<JournalEntry> list(int64_t since_ms, int64_t until_ms,
+                                 size_t limit) const;
+
+  std::optional<JournalRecord> record(uint64_t seq) const;
+  std::optional<Snapshot> load(uint64_t seq) const;
+
+  struct Stats {
+    uint64_t appended = 0, written = 0, dropped = 0, unchanged = 0;
+    uint64_t batches = 0;
+    size_t segments = 0;
+  };
+  Stats stats() const;
+
+  static std::string segment_name(uint64_t first_seq);
+
+private:
+  struct Pending {
+    uint64_t seq;
+    int64_t time_ms;
+    Snapshot snap;
+  };
+  struct Segment {
+    std::string path;
+    uint64_t first_seq;
+    std::vector<JournalEntry> entries; // authoritative for the active segment
+    mutable std::shared_ptr<JournalSegment> view; // cached mapping, sealed only
+  };
+
+  void writer_loop();
+  void write_batch(std::vector<Pending> &batch);
+  void open_active(uint64_t first_seq);
+  void seal_active();
+  void enforce_retention();
+  const Segment *find_segment(uint64_t seq) const;
+
+  Options opts_;
+
+  // Writer-thread state
+  std::FILE *out_ = nullptr;
+  uint64_t out_size_ = 0;
+  uint64_t last_full_seq_ = 0;  // last full record in the active segment; 0: none
+  std::string last_wins_, last_pool_; // its window data, for same_as
+
+  mutable std::mutex mu_; // segments_, active_, stats_
+  std::vector<Segment> segments_; // oldest first; back() is active when active_
+  bool active_ = false;            // the writer has back() open (out_ is its own)
+  Stats stats_;
+
+  std::mutex q_mu_;
+  std::condition_variable q_cv_, drained_cv_;
+  std::deque<Pending> queue_;
+  uint64_t next_seq_ = 1;
+  uint64_t done_seq_ = 0; // highest seq the writer has finished with
+  bool urgent_ = false;   // flush() is waiting; don't hold the batch open
+  bool stop_ = false;
+  std::thread writer_;
+};
+
+} // namespace wininspect
@@ -0,0 +1,103 @@
+#pragma once
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "backend.hpp"
+#include "event_filter.hpp"
+#include "event_ring.hpp"
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace wininspect {
+
+class SubscriptionHub;
+
+/// One filtered events.subscribe. Matching events land in its own ring with
+/// its own sequence numbers, so a subscriber's cursor only ever advances
+/// over events it asked for.
+class FilteredSubscription {
+public:
+  const EventRing &events() const { return ring_; }
+  const EventFilter &filter() const { return filter_; }
+  int debounce_ms() const { return debounce_ms_; }
+
+private:
+  friend class SubscriptionHub;
+  FilteredSubscription(EventFilter f, int debounce_ms, size_t capacity)
+      : filter_(std::move(f)), debounce_ms_(debounce_ms), ring_(capacity) {}
+
+  EventFilter filter_;
+  int debounce_ms_;
+  EventRing ring_;
+  // Held window.changed events, keyed by (hwnd, property): the latest one
+  // and when to release it. Detector thread only.
+  std::map<std::pair<hwnd_u64, std::string>,
+           std::pair<Event, std::chrono::steady_clock::time_point>> pending_;
+};
+
+/// Evaluates every filtered subscription against each detector tick, before
+/// anything is queued, so subscribers never see events they would discard.
+///
+/// Window facts (class, title, pid, ancestry) are looked up once per window
+/// and cached for as long as any subscription needs them; destroyed windows
+/// are judged on their last known facts. Subscriptions that accept
+/// window.changed also get title tracking: on every tick the hub re-reads
+/// the title of each window that passes some such subscription's class,
+/// pid and `under` predicates, and reports changes. With debounce_ms,
+/// the first change to a window property opens a window that long; later
+/// changes within it replace the held event, which is delivered once when
+/// the window ends (on the first tick after it), so a property that keeps
+/// changing is still reported. A destroyed window's held changes are
+/// discarded.
+///
+/// subscribe() may be called from any thread. dispatch() runs on the
+/// detector thread. A subscription ends when its last shared_ptr is dropped.
+class SubscriptionHub {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit SubscriptionHub(IBackend *backend, size_t ring_capacity = 1000);
+
+  std::shared_ptr<FilteredSubscription> subscribe(EventFilter filter, int debounce_ms);
+
+  /// One detector tick: `events` is this tick's diff (possibly empty) and
+  /// `cur` the capture it was taken from.
+  void dispatch(const std::vector<Event> &events, const Snapshot &cur,
+                Clock::time_point now = Clock::now());
+
+  struct Stats {
+    size_t active = 0;
+    uint64_t delivered = 0;  // events queued to some subscription
+    uint64_t filtered = 0;   // (event, subscription) pairs rejected
+    uint64_t debounced = 0;  // changes folded into a later one
+    size_t watched = 0;      // windows under title tracking
+  };
+  Stats stats() const;
+
+private:
+  struct Known {
+    WindowFacts facts;
+    bool watched = false;
+  };
+  Known load(const Snapshot &cur, hwnd_u64 h, bool ancestry);
+
+  IBackend *backend_;
+  size_t capacity_;
+
+  mutable std::mutex mu_; // subs_, gen_, stats_
+  std::vector<std::weak_ptr<FilteredSubscription>> subs_;
+  uint64_t gen_ = 0; // bumped when subs_ changes
+  Stats stats_;
+
+  // Detector thread only.
+  std::unordered_map<hwnd_u64, Known> known_;
+  bool primed_ = false;          // known_ covers every live window
+  bool primed_ancestry_ = false; // ...with ancestors filled in
+  uint64_t seen_gen_ = 0;
+};
+
+} // namespace wininspect
@@ -4,6 +4,7 @@
 
 
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 #include "tinyjson.hpp"
@@ -12,6 +13,8 @@ namespace wininspect {
 
 using hwnd_u64 = std::uint64_t;
 
+class WindowIndex;
+
 struct Hwnd {
   hwnd_u64 val{};
   explicit Hwnd(hwnd_u64 h = 0) : val(h) {}
@@ -41,7 +44,7 @@ struct Color {
 
 struct ScreenCapture {
   int width{}, height{};
-  std::string data_b64; // Base64 encoded BMP data
+  std::vector<uint8_t> data; // BMP file bytes
 };
 
 struct DesktopInfo {
@@ -70,6 +73,13 @@ struct FileInfo {
   std::string last_modified;
 };
 
+// One range of a file, as read.
+struct FileChunk {
+  uint64_t offset{};
+  uint64_t file_size{}; // when read; the range is clipped to it
+  std::vector<uint8_t> data;
+};
+
 struct RegistryValue {
   std::string name;
   std::string type; // "SZ", "DWORD", "BINARY", "MULTI_SZ"
@@ -101,7 +111,7 @@ struct EnvVar {
 
 struct MemoryRegion {
   uint64_t address{};
-  std::string data_b64;
+  std::vector<uint8_t> data;
 };
 
 struct ImageMatchResult {
@@ -147,6 +157,9 @@ struct Snapshot {
   // Minimal snapshot for v1: stable list of top windows and their metadata.
   // Real implementations can expand this.
   std::vector<hwnd_u64> top;
+  // Title/class search index over `top`, built lazily on first query and
+  // shared by every copy of this snapshot. May be null.
+  std::shared_ptr<const WindowIndex> index;
 };
 
 struct Event {
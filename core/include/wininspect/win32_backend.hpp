@@ -57,7 +57,8 @@ public:
 
   // File System
   std::optional<FileInfo> get_file_info(const std::string &path) override;
-  std::optional<std::string> read_file_content(const std::string &path) override;
+  std::optional<FileChunk> read_file_range(const std::string &path, uint64_t offset,
+                                           size_t length) override;
 
   // Advanced Discovery
   std::vector<hwnd_u64> find_windows_regex(const std::string &title_regex, const std::string &class_regex) override;
@@ -100,6 +101,7 @@ public:
 
   std::vector<Event> poll_events(const Snapshot &old_snap,
                                  const Snapshot &new_snap) override;
+  std::unique_ptr<IEventSource> create_event_source() override;
 
 private:
   bool is_wine_ = false;
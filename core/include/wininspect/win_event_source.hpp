@@ -0,0 +1,42 @@
+#pragma once
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "event_source.hpp"
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <thread>
+
+namespace wininspect {
+
+/// Window events from SetWinEventHook (out-of-context, so nothing is
+/// injected into other processes). A dedicated thread owns the hook and
+/// pumps its messages. Reports top-level windows only:
+///
+///   EVENT_OBJECT_CREATE / DESTROY  window.created / window.destroyed
+///   EVENT_OBJECT_NAMECHANGE        window.changed, property "title"
+///   EVENT_OBJECT_LOCATIONCHANGE    window.changed, property "rect"
+///   EVENT_OBJECT_SHOW / HIDE       window.changed, property "visible"
+///
+/// Destroyed windows can no longer be inspected, so destroy events are
+/// reported for any window object; consumers drop those they never saw
+/// created. start() returns false off Windows or if the hook is refused.
+class WinEventSource final : public IEventSource {
+public:
+  WinEventSource() = default;
+  ~WinEventSource() override;
+
+  bool start(Sink sink) override;
+  void stop() override;
+  const char *name() const override { return "winevent"; }
+
+private:
+  void run(std::promise<bool> *hooked);
+
+  Sink sink_;
+  std::thread thread_;
+  std::atomic<std::uint32_t> thread_id_{0};
+};
+
+} // namespace wininspect
@@ -0,0 +1,91 @@
+#pragma once
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "types.hpp"
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace wininspect {
+
+struct IndexedWindow {
+  hwnd_u64 hwnd{};
+  std::string title;
+  std::string class_name;
+};
+
+enum class MatchMode : uint8_t { Regex = 0, Substring, Prefix, Exact };
+
+/// Parse "regex" | "substring" | "prefix" | "exact". Returns nullopt for
+/// anything else.
+std::optional<MatchMode> match_mode_from_str(const std::string &s);
+
+/// A title/class query. An empty pattern places no constraint on that field.
+/// In Regex mode the patterns are ECMAScript regexes (searched, not anchored;
+/// see regex_engine.hpp); in the other modes they are taken literally.
+struct WindowQuery {
+  std::string title;
+  std::string class_name;
+  MatchMode mode = MatchMode::Regex;
+  bool case_insensitive = false;
+};
+
+struct WindowQueryStats {
+  size_t candidates = 0; // windows that survived posting-list intersection
+  size_t matched = 0;
+  bool full_scan = false; // no usable trigram could be derived from the query
+};
+
+/// Trigram index over the titles and class names of a snapshot's top-level
+/// windows. Text is ASCII case-folded before indexing so one set of posting
+/// lists serves both case-sensitive and case-insensitive queries; candidates
+/// are always verified against the original text.
+///
+/// The index is built on first query (at most once, thread-safe), so
+/// snapshots that are never searched pay nothing. When constructed with a
+/// loader, window text is also fetched lazily through it.
+class WindowIndex {
+public:
+  using Loader = std::function<IndexedWindow(hwnd_u64)>;
+
+  explicit WindowIndex(std::vector<IndexedWindow> windows);
+  WindowIndex(std::vector<hwnd_u64> hwnds, Loader loader);
+
+  WindowIndex(const WindowIndex &) = delete;
+  WindowIndex &operator=(const WindowIndex &) = delete;
+
+  /// Matching hwnds in snapshot order. Throws RegexError on a bad pattern
+  /// in Regex mode.
+  std::vector<hwnd_u64> find(const WindowQuery &q,
+                             WindowQueryStats *stats = nullptr) const;
+
+  const std::vector<IndexedWindow> &windows() const;
+  size_t size() const;
+
+private:
+  struct Field {
+    std::vector<std::string> folded;
+    // trigram -> [begin, end) into ids
+    std::unordered_map<uint32_t, std::pair<uint32_t, uint32_t>> postings;
+    std::vector<uint32_t> ids;
+  };
+
+  void ensure_built() const;
+  void build() const;
+  // Candidate ids for one field, or nullopt if the query can't be narrowed.
+  std::optional<std::vector<uint32_t>>
+  candidates(const Field &f, const std::vector<std::string> &literals) const;
+
+  mutable std::once_flag built_;
+  mutable std::vector<IndexedWindow> w_;
+  mutable Field title_, class_;
+  std::vector<hwnd_u64> pending_;
+  Loader loader_;
+};
+
+} // namespace wininspect
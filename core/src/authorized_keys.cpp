@@ -0,0 +1,123 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "wininspect/authorized_keys.hpp"
+#include "crypto_internal.hpp"
+#include "wininspect/base64.hpp"
+#include "wininspect/logger.hpp"
+
+#include <fstream>
+#include <sstream>
+
+namespace wininspect {
+
+namespace {
+
+std::string_view trim(std::string_view s) {
+  while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+  while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r'))
+    s.remove_suffix(1);
+  return s;
+}
+
+// The next whitespace-separated token; quoted option values may hold spaces.
+std::string_view next_token(std::string_view &s) {
+  s = trim(s);
+  size_t i = 0;
+  bool quoted = false;
+  for (; i < s.size(); i++) {
+    if (s[i] == '"') quoted = !quoted;
+    else if (!quoted && (s[i] == ' ' || s[i] == '\t')) break;
+  }
+  auto tok = s.substr(0, i);
+  s.remove_prefix(i);
+  return tok;
+}
+
+} // namespace
+
+AuthorizedKeys AuthorizedKeys::parse(const std::string &text) {
+  AuthorizedKeys ak;
+  std::istringstream in(text);
+  std::string line;
+  while (std::getline(in, line)) {
+    std::string_view rest = trim(line);
+    if (rest.empty() || rest.front() == '#') continue;
+    // Options, if any, come before the key type.
+    std::string_view type = next_token(rest);
+    if (type != "ssh-ed25519" && !rest.empty()) type = next_token(rest);
+    std::string_view b64 = next_token(rest);
+    std::string_view identity = trim(rest);
+    crypto::Ed25519PublicKey key;
+    if (type != "ssh-ed25519" || identity.empty() ||
+        !crypto::detail::ssh_ed25519_blob(std::string(b64), key)) {
+      ak.skipped_++;
+      continue;
+    }
+    ak.index_[std::string(identity)].push_back(key);
+    ak.keys_++;
+  }
+  return ak;
+}
+
+std::span<const crypto::Ed25519PublicKey> AuthorizedKeys::find(const std::string &identity) const {
+  auto it = index_.find(identity);
+  if (it == index_.end()) return {};
+  return it->second;
+}
+
+bool AuthorizedKeys::verify(const std::string &identity, std::span<const std::uint8_t> message,
+                            const std::string &signature_b64) const {
+  auto keys = find(identity);
+  if (keys.empty()) return false;
+  auto sig = base64::decode(signature_b64);
+  for (const auto &k : keys)
+    if (crypto::verify_ed25519(message, sig, k)) return true;
+  return false;
+}
+
+AuthorizedKeysFile::AuthorizedKeysFile(std::filesystem::path path,
+                                       std::chrono::milliseconds recheck)
+    : path_(std::move(path)), recheck_(recheck), keys_(std::make_shared<AuthorizedKeys>()) {}
+
+std::shared_ptr<const AuthorizedKeys> AuthorizedKeysFile::current() {
+  std::lock_guard<std::mutex> lk(mu_);
+  auto now = std::chrono::steady_clock::now();
+  if (!loaded_ || now - checked_ >= recheck_) {
+    checked_ = now;
+    reload();
+  }
+  return keys_;
+}
+
+void AuthorizedKeysFile::reload() {
+  std::error_code ec;
+  auto mtime = std::filesystem::last_write_time(path_, ec);
+  auto size = ec ? 0 : std::filesystem::file_size(path_, ec);
+  std::ifstream f;
+  if (!ec) f.open(path_, std::ios::binary);
+  if (ec || !f) {
+    if (!loaded_ || keys_->keys() > 0)
+      LOG_WARN("Authorized keys: cannot read " + path_.string() + "; no key is accepted");
+    keys_ = std::make_shared<AuthorizedKeys>();
+    loaded_ = true;
+    mtime_ = {};
+    size_ = 0;
+    return;
+  }
+  if (loaded_ && mtime == mtime_ && size == size_) return;
+
+  std::stringstream ss;
+  ss << f.rdbuf();
+  auto keys = std::make_shared<AuthorizedKeys>(AuthorizedKeys::parse(ss.str()));
+  LOG_INFO("Authorized keys: " + std::string(loaded_ ? "reloaded " : "loaded ") +
+           std::to_string(keys->keys()) + " key(s) for " + std::to_string(keys->identities()) +
+           " identities from " + path_.string() +
+           (keys->skipped() ? " (" + std::to_string(keys->skipped()) + " lines skipped)" : ""));
+  keys_ = std::move(keys);
+  mtime_ = mtime;
+  size_ = size;
+  loaded_ = true;
+}
+
+} // namespace wininspect
@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "wininspect/capture_coalescer.hpp"
+
+#include <algorithm>
+
+namespace wininspect {
+
+CaptureCoalescer::CaptureCoalescer(IBackend *backend, int freshness_ms)
+    : backend_(backend), freshness_ms_(freshness_ms) {}
+
+CaptureCoalescer::Result CaptureCoalescer::capture(int max_age_ms, bool after_call) {
+  using Clock = std::chrono::steady_clock;
+  std::unique_lock<std::mutex> lk(mu_);
+  stats_.requests++;
+
+  if (freshness_ms_ >= 0) {
+    auto not_before = Clock::now() - std::chrono::milliseconds(std::max(max_age_ms, 0));
+    while (true) {
+      if (last_ && last_started_ >= not_before) {
+        stats_.fresh++;
+        return {last_, true};
+      }
+      if (!inflight_.valid()) break;
+      auto f = inflight_;
+      if (!after_call || inflight_started_ >= not_before) {
+        stats_.joined++;
+        lk.unlock();
+        return {f.get(), true};
+      }
+      // Started before this call: let it finish, then share the next one.
+      lk.unlock();
+      f.wait();
+      lk.lock();
+    }
+  }
+
+  std::promise<std::shared_ptr<const Snapshot>> done;
+  auto started = Clock::now();
+  stats_.captures++;
+  if (freshness_ms_ >= 0) {
+    inflight_ = done.get_future().share();
+    inflight_started_ = started;
+  }
+  lk.unlock();
+
+  std::shared_ptr<const Snapshot> snap;
+  try {
+    snap = std::make_shared<const Snapshot>(backend_->capture_snapshot());
+  } catch (...) {
+    lk.lock();
+    inflight_ = {};
+    lk.unlock();
+    if (freshness_ms_ >= 0) done.set_exception(std::current_exception());
+    throw;
+  }
+
+  lk.lock();
+  if (freshness_ms_ >= 0) {
+    inflight_ = {};
+    last_ = snap;
+    last_started_ = started;
+  }
+  lk.unlock();
+  if (freshness_ms_ >= 0) done.set_value(snap);
+  return {snap, false};
+}
+
+CaptureCoalescer::Stats CaptureCoalescer::stats() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return stats_;
+}
+
+} // namespace wininspect
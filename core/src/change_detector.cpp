@@ -0,0 +1,209 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "wininspect/change_detector.hpp"
+#include "wininspect/logger.hpp"
+#include <algorithm>
+
+namespace wininspect {
+
+using Clock = std::chrono::steady_clock;
+
+ChangeDetector::ChangeDetector(IBackend *backend, Capture capture, Sink sink,
+                               Options opts, std::unique_ptr<IEventSource> source)
+    : backend_(backend), capture_(std::move(capture)), sink_(std::move(sink)),
+      opts_(opts), source_(std::move(source)) {
+  if (!capture_) capture_ = [this] {
+    return std::make_shared<const Snapshot>(backend_->capture_snapshot());
+  };
+  opts_.min_interval_ms = std::max(opts_.min_interval_ms, 1);
+  opts_.max_interval_ms = std::max(opts_.max_interval_ms, opts_.min_interval_ms);
+  stats_.interval_ms = opts_.min_interval_ms;
+  last_touch_ = Clock::now();
+  thread_ = std::thread([this] { run(); });
+}
+
+ChangeDetector::~ChangeDetector() {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  if (thread_.joinable()) thread_.join();
+}
+
+void ChangeDetector::touch(bool urgent) {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    last_touch_ = Clock::now();
+    touches_++;
+    if (urgent) urgent_ = true;
+  }
+  cv_.notify_all();
+}
+
+ChangeDetector::Stats ChangeDetector::stats() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return stats_;
+}
+
+bool ChangeDetector::idle_locked() const {
+  return opts_.idle_stop_ms > 0 &&
+         Clock::now() - last_touch_ > std::chrono::milliseconds(opts_.idle_stop_ms);
+}
+
+void ChangeDetector::run() {
+  std::shared_ptr<const Snapshot> prev;
+  if (source_) {
+    if (run_hooked(prev)) return;
+    LOG_INFO(std::string("Change detector: ") + source_->name() +
+             " events unavailable, diffing snapshots");
+    source_.reset();
+  }
+
+  int interval = opts_.min_interval_ms;
+  bool failed = false;
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lk(mu_);
+      if (prev || failed) {
+        cv_.wait_for(lk, std::chrono::milliseconds(interval),
+                     [&] { return stop_ || urgent_; });
+      }
+      if (!stop_ && idle_locked()) {
+        // Resumes on a touch, not on the clock: by the time this thread
+        // runs, a touch may be idle_stop_ms old again, and must still count.
+        auto seen = touches_;
+        stats_.paused = true;
+        cv_.wait(lk, [&] { return stop_ || touches_ != seen; });
+        stats_.paused = false;
+      }
+      if (stop_) return;
+      if (urgent_) interval = opts_.min_interval_ms;
+      urgent_ = false;
+    }
+
+    std::shared_ptr<const Snapshot> cur;
+    try {
+      cur = capture_();
+      failed = false;
+    } catch (const std::exception &e) {
+      LOG_WARN(std::string("Change detector: capture failed: ") + e.what());
+      failed = true;
+      continue;
+    }
+    if (!prev) { prev = cur; continue; }
+    if (cur == prev) continue; // coalesced with our own last capture
+
+    auto events = backend_->poll_events(*prev, *cur);
+    prev = std::move(cur);
+    bool changed = !events.empty();
+    sink_(events, *prev);
+
+    interval = changed ? opts_.min_interval_ms
+                       : std::min(interval * 2, opts_.max_interval_ms);
+    std::lock_guard<std::mutex> lk(mu_);
+    stats_.ticks++;
+    if (changed) stats_.changed_ticks++;
+    stats_.events += events.size();
+    stats_.interval_ms = interval;
+  }
+}
+
+bool ChangeDetector::run_hooked(std::shared_ptr<const Snapshot> &snap) {
+  std::vector<hwnd_u64> live; // sorted: the windows we believe exist
+  auto recapture = [&] {
+    try {
+      snap = capture_();
+      live = snap->top;
+      std::sort(live.begin(), live.end());
+      return true;
+    } catch (const std::exception &e) {
+      LOG_WARN(std::string("Change detector: capture failed: ") + e.what());
+      return false;
+    }
+  };
+  // Baseline first: a push racing the capture is then either already in it
+  // (and dropped as a duplicate) or reported; the reconcile covers the gap
+  // before the hook is in place.
+  recapture();
+  bool hooked = source_->start([this](std::vector<Event> &ev) {
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      inbox_.insert(inbox_.end(), ev.begin(), ev.end());
+      stats_.pushed += ev.size();
+    }
+    cv_.notify_all();
+  });
+  if (!hooked) return false; // diffing continues from the baseline
+  if (!snap) snap = std::make_shared<const Snapshot>();
+  LOG_INFO(std::string("Change detector: using pushed events from ") + source_->name());
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    stats_.hooked = true;
+  }
+
+  auto last_reconcile = Clock::now();
+  int interval = opts_.min_interval_ms;
+  std::vector<Event> batch, events;
+
+  while (true) {
+    bool idle;
+    {
+      std::unique_lock<std::mutex> lk(mu_);
+      cv_.wait_for(lk, std::chrono::milliseconds(interval),
+                   [&] { return stop_ || urgent_ || !inbox_.empty(); });
+      if (stop_) break;
+      if (urgent_) interval = opts_.min_interval_ms;
+      urgent_ = false;
+      batch.clear();
+      batch.swap(inbox_);
+      idle = idle_locked();
+    }
+
+    events.clear();
+    uint64_t dropped = 0;
+    for (auto &e : batch) {
+      auto it = std::lower_bound(live.begin(), live.end(), e.hwnd);
+      bool known = it != live.end() && *it == e.hwnd;
+      if (e.type == "window.created" ? known : !known) {
+        dropped++;
+        continue;
+      }
+      if (e.type == "window.created") live.insert(it, e.hwnd);
+      else if (e.type == "window.destroyed") live.erase(it);
+      events.push_back(std::move(e));
+    }
+
+    uint64_t found = 0;
+    if (!idle && opts_.reconcile_ms > 0 &&
+        Clock::now() - last_reconcile >= std::chrono::milliseconds(opts_.reconcile_ms)) {
+      last_reconcile = Clock::now();
+      Snapshot believed;
+      believed.top = live;
+      if (recapture()) {
+        auto missed = backend_->poll_events(believed, *snap);
+        found = missed.size();
+        events.insert(events.end(), missed.begin(), missed.end());
+      }
+    }
+
+    bool changed = !events.empty();
+    sink_(events, *snap);
+    interval = changed ? opts_.min_interval_ms
+                       : std::min(interval * 2, opts_.max_interval_ms);
+    std::lock_guard<std::mutex> lk(mu_);
+    stats_.ticks++;
+    if (changed) stats_.changed_ticks++;
+    stats_.events += events.size();
+    stats_.interval_ms = interval;
+    stats_.paused = idle; // hooks keep running; only reconciling stops
+    stats_.duplicates += dropped;
+    stats_.reconciled += found;
+  }
+  source_->stop();
+  return true;
+}
+
+} // namespace wininspect
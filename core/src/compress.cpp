@@ -0,0 +1,232 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "wininspect/compress.hpp"
+
+#include <cstring>
+#ifdef WININSPECT_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace wininspect::compress {
+
+namespace {
+
+// LZ4 block format limits: a match is at least 4 bytes, reaches back at
+// most 64 KiB, and starts at least 12 bytes before the end; the last 5
+// bytes are always literals.
+constexpr size_t MIN_MATCH = 4;
+constexpr size_t MAX_OFFSET = 65535;
+constexpr size_t MF_LIMIT = 12;
+constexpr size_t LAST_LITERALS = 5;
+constexpr int HASH_BITS = 12;
+
+std::uint32_t read32(const std::uint8_t *p) {
+  std::uint32_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+std::uint32_t hash4(std::uint32_t v) { return (v * 2654435761u) >> (32 - HASH_BITS); }
+
+// The bytes of a length after the 15 that fit in the token.
+std::uint8_t *put_length(std::uint8_t *op, size_t len) {
+  for (; len >= 255; len -= 255) *op++ = 255;
+  *op++ = (std::uint8_t)len;
+  return op;
+}
+
+bool get_length(const std::uint8_t *&ip, const std::uint8_t *end, size_t &len) {
+  std::uint8_t b;
+  do {
+    if (ip >= end) return false;
+    b = *ip++;
+    len += b;
+  } while (b == 255);
+  return true;
+}
+
+// One sequence: literals, then (unless it is the last) a match.
+std::uint8_t *put_sequence(std::uint8_t *op, const std::uint8_t *lit, size_t lit_len,
+                           size_t offset, size_t match_len) {
+  std::uint8_t *token = op++;
+  std::uint8_t t = (std::uint8_t)((lit_len >= 15 ? 15 : lit_len) << 4);
+  if (lit_len >= 15) op = put_length(op, lit_len - 15);
+  std::memcpy(op, lit, lit_len);
+  op += lit_len;
+  if (match_len) {
+    *op++ = (std::uint8_t)offset;
+    *op++ = (std::uint8_t)(offset >> 8);
+    size_t ml = match_len - MIN_MATCH;
+    t |= (std::uint8_t)(ml >= 15 ? 15 : ml);
+    if (ml >= 15) op = put_length(op, ml - 15);
+  }
+  *token = t;
+  return op;
+}
+
+void put_le32(std::uint8_t *p, std::uint32_t v) {
+  for (int i = 0; i < 4; i++) p[i] = (std::uint8_t)(v >> (8 * i));
+}
+
+std::uint32_t get_le32(const std::uint8_t *p) {
+  return (std::uint32_t)p[0] | (std::uint32_t)p[1] << 8 | (std::uint32_t)p[2] << 16 |
+         (std::uint32_t)p[3] << 24;
+}
+
+} // namespace
+
+const char *codec_name(Codec c) {
+  switch (c) {
+  case Codec::Lz4: return "lz4";
+  case Codec::Zlib: return "zlib";
+  default: return "";
+  }
+}
+
+Codec codec_from_name(std::string_view name) {
+  if (name == "lz4") return Codec::Lz4;
+#ifdef WININSPECT_HAVE_ZLIB
+  if (name == "zlib") return Codec::Zlib;
+#endif
+  return Codec::None;
+}
+
+std::vector<std::string> available() {
+#ifdef WININSPECT_HAVE_ZLIB
+  return {"lz4", "zlib"};
+#else
+  return {"lz4"};
+#endif
+}
+
+size_t lz4_bound(size_t n) { return n + n / 255 + 16; }
+
+size_t lz4_compress(const std::uint8_t *src, size_t n, std::uint8_t *dst, size_t cap) {
+  if (cap < lz4_bound(n) || n > 0x7FFFFFFF) return 0;
+  // Positions + 1, so that 0 is an empty slot. Every candidate is checked
+  // against the input, so a collision only costs a missed match.
+  std::uint32_t table[1 << HASH_BITS] = {};
+  const std::uint8_t *ip = src, *anchor = src, *end = src + n;
+  std::uint8_t *op = dst;
+
+  if (n > MF_LIMIT) {
+    const std::uint8_t *mflimit = end - MF_LIMIT;
+    const std::uint8_t *matchlimit = end - LAST_LITERALS;
+    size_t misses = 0;
+    while (ip < mflimit) {
+      std::uint32_t seq = read32(ip);
+      std::uint32_t &slot = table[hash4(seq)];
+      std::uint32_t cand = slot;
+      slot = (std::uint32_t)(ip - src) + 1;
+      const std::uint8_t *ref = cand ? src + (cand - 1) : nullptr;
+      if (!ref || (size_t)(ip - ref) > MAX_OFFSET || read32(ref) != seq) {
+        ip += 1 + (misses++ >> 6); // skip faster through data that will not compress
+        continue;
+      }
+      while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+        ip--;
+        ref--;
+      }
+      const std::uint8_t *p = ip + MIN_MATCH, *q = ref + MIN_MATCH;
+      while (p < matchlimit && *p == *q) {
+        p++;
+        q++;
+      }
+      op = put_sequence(op, anchor, (size_t)(ip - anchor), (size_t)(ip - ref), (size_t)(p - ip));
+      ip = anchor = p;
+      misses = 0;
+      if (ip - 2 > src) table[hash4(read32(ip - 2))] = (std::uint32_t)(ip - 2 - src) + 1;
+    }
+  }
+  op = put_sequence(op, anchor, (size_t)(end - anchor), 0, 0);
+  return (size_t)(op - dst);
+}
+
+bool lz4_decompress(const std::uint8_t *src, size_t n, std::uint8_t *dst, size_t raw) {
+  const std::uint8_t *ip = src, *iend = src + n;
+  std::uint8_t *op = dst, *oend = dst + raw;
+  while (ip < iend) {
+    std::uint8_t t = *ip++;
+    size_t lit = t >> 4;
+    if (lit == 15 && !get_length(ip, iend, lit)) return false;
+    if ((size_t)(iend - ip) < lit || (size_t)(oend - op) < lit) return false;
+    std::memcpy(op, ip, lit);
+    ip += lit;
+    op += lit;
+    if (ip == iend) return op == oend; // the last sequence has no match
+
+    if (iend - ip < 2) return false;
+    size_t offset = (size_t)ip[0] | (size_t)ip[1] << 8;
+    ip += 2;
+    if (offset == 0 || offset > (size_t)(op - dst)) return false;
+    size_t ml = t & 15;
+    if (ml == 15 && !get_length(ip, iend, ml)) return false;
+    ml += MIN_MATCH;
+    if ((size_t)(oend - op) < ml) return false;
+    const std::uint8_t *m = op - offset;
+    if (offset >= ml) {
+      std::memcpy(op, m, ml);
+      op += ml;
+    } else {
+      while (ml--) *op++ = *m++; // overlapping: repeats the last `offset` bytes
+    }
+  }
+  return false;
+}
+
+bool pack(Codec c, const void *in, size_t n, std::string &out) {
+  if (n > 0xFFFFFFFF) return false;
+  size_t cap;
+  switch (c) {
+  case Codec::Lz4: cap = lz4_bound(n); break;
+#ifdef WININSPECT_HAVE_ZLIB
+  case Codec::Zlib: cap = compressBound((uLong)n); break;
+#endif
+  default: return false;
+  }
+  size_t base = out.size();
+  out.resize(base + HEADER_BYTES + cap);
+  auto *h = (std::uint8_t *)out.data() + base;
+  h[0] = (std::uint8_t)c;
+  put_le32(h + 1, (std::uint32_t)n);
+  size_t z = 0;
+  if (c == Codec::Lz4) z = lz4_compress((const std::uint8_t *)in, n, h + HEADER_BYTES, cap);
+#ifdef WININSPECT_HAVE_ZLIB
+  if (c == Codec::Zlib) {
+    uLongf len = (uLongf)cap;
+    if (compress2(h + HEADER_BYTES, &len, (const Bytef *)in, (uLong)n, Z_DEFAULT_COMPRESSION) ==
+        Z_OK)
+      z = len;
+  }
+#endif
+  if (z == 0 || HEADER_BYTES + z >= n) {
+    out.resize(base);
+    return false;
+  }
+  out.resize(base + HEADER_BYTES + z);
+  return true;
+}
+
+bool unpack(const void *in, size_t n, size_t max, std::string &out) {
+  auto *p = (const std::uint8_t *)in;
+  if (n < HEADER_BYTES) return false;
+  auto c = (Codec)p[0];
+  size_t raw = get_le32(p + 1);
+  if (raw == 0 || raw > max) return false;
+  out.resize(raw);
+  auto *dst = (std::uint8_t *)out.data();
+  bool ok = false;
+  if (c == Codec::Lz4) ok = lz4_decompress(p + HEADER_BYTES, n - HEADER_BYTES, dst, raw);
+#ifdef WININSPECT_HAVE_ZLIB
+  if (c == Codec::Zlib) {
+    uLongf len = (uLongf)raw;
+    ok = uncompress(dst, &len, p + HEADER_BYTES, (uLong)(n - HEADER_BYTES)) == Z_OK &&
+         len == raw;
+  }
+#endif
+  if (!ok) out.clear();
+  return ok;
+}
+
+} // namespace wininspect::compress
@@ -3,7 +3,10 @@
 // Copyright (c) 2026 Mark E. DeYoung
 
 #include "wininspect/core.hpp"
+#include "wininspect/window_index.hpp"
+#include <algorithm>
 #include <cctype>
+#include <cstdio>
 #include <sstream>
 #include <chrono>
 #include <thread>
@@ -17,6 +20,12 @@ std::string Hwnd::to_string() const {
   return oss.str();
 }
 
+std::string Color::to_hex() const {
+  char buf[8];
+  snprintf(buf, sizeof(buf), "#%02X%02X%02X", r, g, b);
+  return buf;
+}
+
 static json::Value make_error(const std::string &code, const std::string &msg) {
   json::Object e;
   e["code"] = code;
@@ -51,6 +60,61 @@ static std::optional<double> get_num(const json::Object &o, const std::string &k
   if (it == o.end() || !it->second.is_num()) return std::nullopt;
   return it->second.as_num();
 }
+// Byte results go out as an attachment reference to clients that take them
+// and as base64 under `name`_b64 to the rest.
+static void put_bytes(CoreResponse &resp, const CoreRequest &req, json::Object &o,
+                      const std::string &name, std::vector<uint8_t> bytes) {
+  if (!req.binary) {
+    o[name + "_b64"] = base64::encode(bytes);
+    return;
+  }
+  json::Object ref;
+  ref["attachment"] = (double)resp.attachments.size();
+  ref["size"] = (double)bytes.size();
+  o[name] = ref;
+  resp.attachments.push_back(std::move(bytes));
+}
+// Byte parameters come as {"attachment": i} under `name` or as base64 under
+// `name`_b64; null when neither is present. `decoded` holds the base64 case.
+static const std::vector<uint8_t> *get_bytes(const CoreRequest &req, const std::string &name,
+                                             std::vector<uint8_t> &decoded) {
+  auto it = req.params.find(name);
+  if (it != req.params.end() && it->second.is_obj()) {
+    auto i = get_num(it->second.as_obj(), "attachment");
+    if (!i || *i < 0 || (size_t)*i >= req.attachments.size())
+      throw std::runtime_error("bad attachment reference in " + name);
+    return &req.attachments[(size_t)*i];
+  }
+  auto b64 = get_str(req.params, name + "_b64");
+  if (!b64) return nullptr;
+  decoded = base64::decode(*b64);
+  return &decoded;
+}
+// A file.read / file.tail result for one range of a file.
+static json::Object file_chunk_json(CoreResponse &resp, const CoreRequest &req, FileChunk &c) {
+  json::Object o;
+  o["offset"] = (double)c.offset;
+  o["length"] = (double)c.data.size();
+  o["size"] = (double)c.file_size;
+  o["eof"] = c.offset + c.data.size() >= c.file_size;
+  put_bytes(resp, req, o, "content", std::move(c.data));
+  return o;
+}
+// Where the last `lines` lines of a `size`-byte file start, looking back
+// no further than `window` bytes. A final newline does not start a line.
+static uint64_t tail_start(IBackend *backend, const std::string &path, uint64_t size,
+                           size_t lines, size_t window) {
+  if (lines == 0 || size == 0) return size;
+  uint64_t from = size > window ? size - window : 0;
+  auto c = backend->read_file_range(path, from, window);
+  if (!c) return size;
+  const auto &d = c->data;
+  size_t i = d.size();
+  if (i && d[i - 1] == '\n') i--;
+  for (; i > 0; i--)
+    if (d[i - 1] == '\n' && --lines == 0) break;
+  return from + i;
+}
 static std::optional<hwnd_u64> parse_hwnd(const std::string &s) {
   if (s.rfind("0x", 0) != 0) return std::nullopt;
   std::uint64_t v = 0;
@@ -353,9 +417,10 @@ void CoreEngine::build_dispatch_table() {
   dispatch_["input.send"] = [this]( const CoreRequest &req,
                                  const Snapshot &, const Snapshot *) {
     CoreResponse resp;
-    auto data_b64 = get_str(req.params, "data_b64");
-    if (!data_b64) throw std::runtime_error("missing data_b64");
-    resp.ok = true; resp.result = sent_json(backend_->send_input(base64::decode(*data_b64)));
+    std::vector<uint8_t> decoded;
+    auto data = get_bytes(req, "data", decoded);
+    if (!data) throw std::runtime_error("missing data");
+    resp.ok = true; resp.result = sent_json(backend_->send_input(*data));
     return resp;
   };
 
@@ -455,7 +520,8 @@ void CoreEngine::build_dispatch_table() {
     auto sc = backend_->capture_screen(rect);
     if (!sc) throw std::runtime_error("capture failed");
     json::Object o;
-    o["width"] = (double)sc->width; o["height"] = (double)sc->height; o["data_b64"] = sc->data_b64;
+    o["width"] = (double)sc->width; o["height"] = (double)sc->height;
+    put_bytes(resp, req, o, "data", std::move(sc->data));
     resp.ok = true; resp.result = o; return resp;
   };
 
@@ -531,14 +597,71 @@ void CoreEngine::build_dispatch_table() {
     resp.ok = true; resp.result = o; return resp;
   };
 
+  // Ranged: at most FILE_READ_MAX_BYTES from `offset`; read on from
+  // offset + length until `eof`. Only that range of the file is mapped.
   dispatch_["file.read"] = [this]( const CoreRequest &req,
                                 const Snapshot &, const Snapshot *) {
     CoreResponse resp;
     auto path = get_str(req.params, "path");
     if (!path) throw std::runtime_error("missing path");
-    auto content = backend_->read_file_content(*path);
-    if (!content) { resp.ok = false; resp.error_code = "E_READ_FAILED"; return resp; }
-    json::Object o; o["content_b64"] = base64::encode(std::vector<uint8_t>(content->begin(), content->end()));
+    double offset = get_num(req.params, "offset").value_or(0);
+    double length = get_num(req.params, "length").value_or((double)FILE_READ_MAX_BYTES);
+    if (offset < 0 || length < 0) throw std::runtime_error("offset and length must be >= 0");
+    size_t n = (size_t)std::min(length, (double)FILE_READ_MAX_BYTES);
+    std::optional<FileChunk> chunk;
+    if (n > 0) {
+      chunk = backend_->read_file_range(*path, (uint64_t)offset, n);
+    } else if (auto fi = backend_->get_file_info(*path); fi && !fi->is_directory) {
+      chunk = FileChunk{(uint64_t)offset, fi->size, {}};
+    }
+    if (!chunk) { resp.ok = false; resp.error_code = "E_READ_FAILED"; return resp; }
+    resp.ok = true; resp.result = file_chunk_json(resp, req, *chunk); return resp;
+  };
+
+  // Following a growing file: pass each result's `next` back as `since` to
+  // get what was appended, waiting up to wait_ms for it. Without `since`,
+  // starts with the last `lines` lines. A file that shrank below `since`
+  // was truncated or replaced, and is read again from the start.
+  dispatch_["file.tail"] = [this]( const CoreRequest &req,
+                                const Snapshot &, const Snapshot *) {
+    CoreResponse resp;
+    auto path = get_str(req.params, "path");
+    if (!path) throw std::runtime_error("missing path");
+    double max = get_num(req.params, "max").value_or(1024.0 * 1024);
+    if (max < 1) throw std::runtime_error("max must be >= 1");
+    size_t n = (size_t)std::min(max, (double)FILE_READ_MAX_BYTES);
+    auto fi = backend_->get_file_info(*path);
+    if (!fi || fi->is_directory) { resp.ok = false; resp.error_code = "E_READ_FAILED"; return resp; }
+
+    uint64_t from;
+    bool truncated = false;
+    if (auto since = get_num(req.params, "since")) {
+      if (*since < 0) throw std::runtime_error("since must be >= 0");
+      from = (uint64_t)*since;
+      int wait_ms = (int)std::clamp(get_num(req.params, "wait_ms").value_or(0), 0.0,
+                                    (double)FILE_TAIL_MAX_WAIT_MS);
+      auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(wait_ms);
+      while (fi && fi->size == from && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        fi = backend_->get_file_info(*path);
+      }
+      if (!fi) { resp.ok = false; resp.error_code = "E_READ_FAILED"; return resp; }
+      if (fi->size < from) {
+        truncated = true;
+        from = 0;
+      }
+    } else {
+      double lines = get_num(req.params, "lines").value_or(10);
+      from = tail_start(backend_, *path, fi->size, (size_t)std::max(lines, 0.0), n);
+    }
+
+    std::optional<FileChunk> chunk;
+    if (from < fi->size) chunk = backend_->read_file_range(*path, from, n);
+    else chunk = FileChunk{from, fi->size, {}};
+    if (!chunk) { resp.ok = false; resp.error_code = "E_READ_FAILED"; return resp; }
+    auto o = file_chunk_json(resp, req, *chunk);
+    o["next"] = (double)(from + (uint64_t)o["length"].as_num());
+    o["truncated"] = truncated;
     resp.ok = true; resp.result = o; return resp;
   };
 
@@ -670,17 +793,18 @@ void CoreEngine::build_dispatch_table() {
     if (!pid || !addr || !sz) throw std::runtime_error("missing parameters");
     auto res = backend_->mem_read((uint32_t)*pid, (uint64_t)*addr, (size_t)*sz);
     if (!res) { resp.ok = false; return resp; }
-    json::Object o; o["address"] = (double)res->address; o["data_b64"] = res->data_b64;
+    json::Object o; o["address"] = (double)res->address;
+    put_bytes(resp, req, o, "data", std::move(res->data));
     resp.ok = true; resp.result = o; return resp;
   };
 
   dispatch_["mem.write"] = [this]( const CoreRequest &req,
                                 const Snapshot &, const Snapshot *) {
     CoreResponse resp;
-    auto pid = get_num(req.params, "pid"); auto addr = get_num(req.params, "address"); auto data_b64 = get_str(req.params, "data_b64");
-    if (!pid || !addr || !data_b64) throw std::runtime_error("missing parameters");
-    auto data = base64::decode(*data_b64);
-    resp.ok = true; resp.result = ok_json(backend_->mem_write((uint32_t)*pid, (uint64_t)*addr, data));
+    std::vector<uint8_t> decoded;
+    auto pid = get_num(req.params, "pid"); auto addr = get_num(req.params, "address"); auto data = get_bytes(req, "data", decoded);
+    if (!pid || !addr || !data) throw std::runtime_error("missing parameters");
+    resp.ok = true; resp.result = ok_json(backend_->mem_write((uint32_t)*pid, (uint64_t)*addr, *data));
     return resp;
   };
 
@@ -690,11 +814,11 @@ void CoreEngine::build_dispatch_table() {
     CoreResponse resp;
     auto l = get_num(req.params, "left"), t = get_num(req.params, "top");
     auto r = get_num(req.params, "right"), bm = get_num(req.params, "bottom");
-    auto sub_b64 = get_str(req.params, "sub_image_b64");
-    if (!l || !t || !r || !bm || !sub_b64) throw std::runtime_error("missing parameters");
+    std::vector<uint8_t> decoded;
+    auto sub = get_bytes(req, "sub_image", decoded);
+    if (!l || !t || !r || !bm || !sub) throw std::runtime_error("missing parameters");
     Rect rect{(long)*l, (long)*t, (long)*r, (long)*bm};
-    auto sub = base64::decode(*sub_b64);
-    auto res = backend_->image_match(rect, sub);
+    auto res = backend_->image_match(rect, *sub);
     if (!res) { resp.ok = false; return resp; }
     json::Object o; o["x"] = (double)res->x; o["y"] = (double)res->y; o["confidence"] = res->confidence;
     resp.ok = true; resp.result = o; return resp;
@@ -714,9 +838,23 @@ void CoreEngine::build_dispatch_table() {
   dispatch_["window.findRegex"] = [this]( const CoreRequest &req,
                                        const Snapshot &snap, const Snapshot *) {
     CoreResponse resp;
-    auto t_re = get_str(req.params, "title_regex").value_or(".*");
-    auto c_re = get_str(req.params, "class_regex").value_or(".*");
-    auto hwnds = backend_->find_windows_regex(t_re, c_re);
+    WindowQuery q;
+    q.title = get_str(req.params, "title_regex").value_or("");
+    q.class_name = get_str(req.params, "class_regex").value_or("");
+    if (auto m = get_str(req.params, "mode")) {
+      auto mode = match_mode_from_str(*m);
+      if (!mode) throw std::runtime_error("invalid mode");
+      q.mode = *mode;
+    }
+    q.case_insensitive = get_bool(req.params, "case_insensitive").value_or(false);
+
+    // Hand-built snapshots carry no index; search a fresh capture instead.
+    auto index = snap.index ? snap.index : backend_->capture_snapshot().index;
+    if (!index) throw std::runtime_error("window index unavailable");
+    WindowQueryStats stats;
+    auto hwnds = index->find(q, &stats);
+    resp.metrics["candidates"] = (double)stats.candidates;
+    resp.metrics["full_scan"] = stats.full_scan;
     json::Array arr;
     for (auto h : hwnds) { json::Object e; e["hwnd"] = Hwnd(h).to_string(); arr.push_back(e); }
     resp.ok = true; resp.result = arr; return resp;
@@ -877,6 +1015,7 @@ CoreResponse CoreEngine::handle(const CoreRequest &req,
     auto it = dispatch_.find(req.method);
     if (it != dispatch_.end()) {
       resp = it->second(req, snapshot, old_snapshot);
+      resp.id = req.id; // handlers build their own response
     } else {
       resp.ok = false;
       resp.error_code = "E_BAD_METHOD";
@@ -912,6 +1051,8 @@ CoreRequest parse_request_json(std::string_view json_utf8) {
   r.id = it_id->second.as_str();
   r.method = it_m->second.as_str();
   r.params = it_p->second.as_obj();
+  auto it_b = o.find("binary");
+  r.binary = it_b != o.end() && it_b->second.is_bool() && it_b->second.as_bool();
   return r;
 }
 
@@ -920,4 +1061,45 @@ std::string serialize_response_json(const CoreResponse &resp, bool canonical) {
   return json::dumps(resp.to_json_obj(canonical));
 }
 
+static void put_le32(std::string &out, size_t v) {
+  for (int i = 0; i < 4; i++) out.push_back((char)(uint8_t)(v >> (8 * i)));
+}
+
+static bool take_le32(std::string_view &in, size_t &v) {
+  if (in.size() < 4) return false;
+  auto *p = (const uint8_t *)in.data();
+  v = (size_t)p[0] | (size_t)p[1] << 8 | (size_t)p[2] << 16 | (size_t)p[3] << 24;
+  in.remove_prefix(4);
+  return v <= in.size();
+}
+
+void append_multipart(std::string &out, std::string_view json,
+                      const std::vector<Attachment> &attachments) {
+  size_t n = 4 + json.size();
+  for (auto &a : attachments) n += 4 + a.size();
+  out.reserve(out.size() + n);
+  put_le32(out, json.size());
+  out.append(json);
+  for (auto &a : attachments) {
+    put_le32(out, a.size());
+    out.append((const char *)a.data(), a.size());
+  }
+}
+
+bool split_multipart(std::string_view payload, std::string &json,
+                     std::vector<Attachment> &attachments) {
+  size_t n;
+  if (!take_le32(payload, n)) return false;
+  json.assign(payload.data(), n);
+  payload.remove_prefix(n);
+  attachments.clear();
+  while (!payload.empty()) {
+    if (!take_le32(payload, n)) return false;
+    auto *p = (const uint8_t *)payload.data();
+    attachments.emplace_back(p, p + n);
+    payload.remove_prefix(n);
+  }
+  return true;
+}
+
 } // namespace wininspect
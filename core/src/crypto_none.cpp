@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+// No crypto library: the encrypted channel is unavailable and every
+// operation fails closed. Only random_bytes works (/dev/urandom).
+
+#include "wininspect/crypto.hpp"
+#include <cstdio>
+
+namespace wininspect::crypto {
+
+const char *backend_name() { return "none"; }
+
+struct CryptoSession::State {};
+
+CryptoSession::CryptoSession(Role role) : role_(role) {}
+CryptoSession::~CryptoSession() = default;
+std::vector<uint8_t> CryptoSession::generate_local_key() { return {}; }
+bool CryptoSession::ecdh_derive(const std::vector<uint8_t> &, uint8_t[32]) { return false; }
+bool CryptoSession::set_aes_key(const uint8_t[32]) { return false; }
+bool CryptoSession::aead_seal(const uint8_t *, const uint8_t *, size_t, uint8_t *,
+                              uint8_t *) {
+  return false;
+}
+bool CryptoSession::aead_open(const uint8_t *, const uint8_t *, size_t, uint8_t *,
+                              const uint8_t *) {
+  return false;
+}
+
+bool verify_ed25519(std::span<const uint8_t>, std::span<const uint8_t>,
+                    const Ed25519PublicKey &) {
+  return false;
+}
+std::string sign_ssh_msg(const std::vector<uint8_t> &, const std::string &) {
+  return "";
+}
+bool random_bytes(uint8_t *out, size_t n) {
+  FILE *f = fopen("/dev/urandom", "rb");
+  if (!f) return false;
+  bool ok = fread(out, 1, n, f) == n;
+  fclose(f);
+  return ok;
+}
+
+bool sha256(std::span<const uint8_t>, uint8_t[32]) { return false; }
+
+} // namespace wininspect::crypto
@@ -0,0 +1,214 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+// OpenSSL (libcrypto 3) backend for CryptoSession; see crypto.cpp. It
+// speaks the same wire formats as the CNG backend: public keys travel as
+// BCRYPT_ECCPUBLIC_BLOBs and the session key is SHA-256 of the ECDH
+// shared secret, so either end may run either backend.
+
+#include "crypto_internal.hpp"
+#include "wininspect/base64.hpp"
+#include "wininspect/crypto.hpp"
+
+#include <cstring>
+#include <openssl/core_names.h>
+#include <openssl/evp.h>
+#include <openssl/param_build.h>
+#include <openssl/rand.h>
+#include <openssl/sha.h>
+
+namespace wininspect::crypto {
+
+namespace {
+
+// BCRYPT_ECCPUBLIC_BLOB for P-256: BCRYPT_ECDH_PUBLIC_P256_MAGIC ("ECK1"),
+// cbKey, then X and Y big-endian. Header words are little-endian.
+constexpr uint32_t ECDH_P256_MAGIC = 0x314B4345;
+constexpr size_t COORD_BYTES = 32;
+constexpr size_t BLOB_BYTES = 8 + 2 * COORD_BYTES;
+
+void put_le32(uint8_t *p, uint32_t v) {
+  for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+uint32_t get_le32(const uint8_t *p) {
+  return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// A P-256 public key from an ECCPUBLIC_BLOB; null if malformed or off the
+// curve.
+EVP_PKEY *import_p256(const std::vector<uint8_t> &blob) {
+  if (blob.size() != BLOB_BYTES || get_le32(blob.data()) != ECDH_P256_MAGIC ||
+      get_le32(blob.data() + 4) != COORD_BYTES)
+    return nullptr;
+  uint8_t point[1 + 2 * COORD_BYTES];
+  point[0] = 0x04; // uncompressed SEC1 point
+  std::memcpy(point + 1, blob.data() + 8, 2 * COORD_BYTES);
+
+  EVP_PKEY *pkey = nullptr;
+  OSSL_PARAM_BLD *bld = OSSL_PARAM_BLD_new();
+  OSSL_PARAM *params = nullptr;
+  EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new_from_name(nullptr, "EC", nullptr);
+  bool ok =
+      bld && ctx &&
+      OSSL_PARAM_BLD_push_utf8_string(bld, OSSL_PKEY_PARAM_GROUP_NAME, "prime256v1", 0) &&
+      OSSL_PARAM_BLD_push_octet_string(bld, OSSL_PKEY_PARAM_PUB_KEY, point, sizeof(point)) &&
+      (params = OSSL_PARAM_BLD_to_param(bld)) && EVP_PKEY_fromdata_init(ctx) == 1 &&
+      EVP_PKEY_fromdata(ctx, &pkey, EVP_PKEY_PUBLIC_KEY, params) == 1;
+  if (!ok) {
+    EVP_PKEY_free(pkey);
+    pkey = nullptr;
+  }
+  OSSL_PARAM_free(params);
+  OSSL_PARAM_BLD_free(bld);
+  EVP_PKEY_CTX_free(ctx);
+  if (!pkey) return nullptr;
+
+  // fromdata does not check that the point is on the curve.
+  EVP_PKEY_CTX *chk = EVP_PKEY_CTX_new_from_pkey(nullptr, pkey, nullptr);
+  bool valid = chk && EVP_PKEY_public_check(chk) == 1;
+  EVP_PKEY_CTX_free(chk);
+  if (!valid) {
+    EVP_PKEY_free(pkey);
+    return nullptr;
+  }
+  return pkey;
+}
+
+} // namespace
+
+const char *backend_name() { return "openssl"; }
+
+struct CryptoSession::State {
+  EVP_PKEY *local = nullptr;
+  // One context per direction, keyed once; each record only sets the IV.
+  EVP_CIPHER_CTX *enc = nullptr;
+  EVP_CIPHER_CTX *dec = nullptr;
+
+  ~State() {
+    EVP_PKEY_free(local);
+    EVP_CIPHER_CTX_free(enc);
+    EVP_CIPHER_CTX_free(dec);
+  }
+};
+
+CryptoSession::CryptoSession(Role role) : role_(role), st_(std::make_unique<State>()) {}
+
+CryptoSession::~CryptoSession() = default;
+
+std::vector<uint8_t> CryptoSession::generate_local_key() {
+  State *st = st_.get();
+  EVP_PKEY_free(st->local);
+  st->local = EVP_PKEY_Q_keygen(nullptr, nullptr, "EC", "prime256v1");
+  if (!st->local) return {};
+
+  uint8_t point[1 + 2 * COORD_BYTES];
+  size_t len = 0;
+  if (EVP_PKEY_get_octet_string_param(st->local, OSSL_PKEY_PARAM_PUB_KEY, point,
+                                      sizeof(point), &len) != 1 ||
+      len != sizeof(point) || point[0] != 0x04)
+    return {};
+  std::vector<uint8_t> blob(BLOB_BYTES);
+  put_le32(blob.data(), ECDH_P256_MAGIC);
+  put_le32(blob.data() + 4, COORD_BYTES);
+  std::memcpy(blob.data() + 8, point + 1, 2 * COORD_BYTES);
+  return blob;
+}
+
+bool CryptoSession::ecdh_derive(const std::vector<uint8_t> &remote_pubkey,
+                                uint8_t key[32]) {
+  State *st = st_.get();
+  if (!st->local) return false;
+  EVP_PKEY *peer = import_p256(remote_pubkey);
+  if (!peer) return false;
+
+  uint8_t z[COORD_BYTES];
+  size_t zlen = sizeof(z);
+  EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new_from_pkey(nullptr, st->local, nullptr);
+  bool ok = ctx && EVP_PKEY_derive_init(ctx) == 1 && EVP_PKEY_derive_set_peer(ctx, peer) == 1 &&
+            EVP_PKEY_derive(ctx, z, &zlen) == 1 && zlen == sizeof(z);
+  EVP_PKEY_CTX_free(ctx);
+  EVP_PKEY_free(peer);
+  // Same as CNG's BCRYPT_KDF_HASH with SHA-256 and no prepend/append.
+  if (ok) SHA256(z, sizeof(z), key);
+  OPENSSL_cleanse(z, sizeof(z));
+  return ok;
+}
+
+bool CryptoSession::set_aes_key(const uint8_t key[32]) {
+  State *st = st_.get();
+  if (!st->enc) st->enc = EVP_CIPHER_CTX_new();
+  if (!st->dec) st->dec = EVP_CIPHER_CTX_new();
+  return st->enc && st->dec &&
+         EVP_EncryptInit_ex(st->enc, EVP_aes_256_gcm(), nullptr, key, nullptr) == 1 &&
+         EVP_DecryptInit_ex(st->dec, EVP_aes_256_gcm(), nullptr, key, nullptr) == 1;
+}
+
+bool CryptoSession::aead_seal(const uint8_t *nonce, const uint8_t *pt, size_t n, uint8_t *ct,
+                              uint8_t *tag) {
+  EVP_CIPHER_CTX *c = st_->enc;
+  int len = 0;
+  if (!c || n > (size_t)INT32_MAX) return false;
+  if (EVP_EncryptInit_ex(c, nullptr, nullptr, nullptr, nonce) != 1) return false;
+  if (n > 0 && EVP_EncryptUpdate(c, ct, &len, pt, (int)n) != 1) return false;
+  if (EVP_EncryptFinal_ex(c, ct + len, &len) != 1) return false;
+  return EVP_CIPHER_CTX_ctrl(c, EVP_CTRL_GCM_GET_TAG, (int)TAG_BYTES, tag) == 1;
+}
+
+bool CryptoSession::aead_open(const uint8_t *nonce, const uint8_t *ct, size_t n, uint8_t *pt,
+                              const uint8_t *tag) {
+  EVP_CIPHER_CTX *c = st_->dec;
+  int len = 0;
+  if (!c || n > (size_t)INT32_MAX) return false;
+  if (EVP_DecryptInit_ex(c, nullptr, nullptr, nullptr, nonce) != 1) return false;
+  if (n > 0 && EVP_DecryptUpdate(c, pt, &len, ct, (int)n) != 1) return false;
+  if (EVP_CIPHER_CTX_ctrl(c, EVP_CTRL_GCM_SET_TAG, (int)TAG_BYTES, (void *)tag) != 1)
+    return false;
+  if (EVP_DecryptFinal_ex(c, pt + len, &len) != 1) {
+    OPENSSL_cleanse(pt, n); // no unauthenticated plaintext left behind
+    return false;
+  }
+  return true;
+}
+
+bool verify_ed25519(std::span<const uint8_t> message, std::span<const uint8_t> signature,
+                    const Ed25519PublicKey &public_key) {
+  if (signature.size() < 64) return false;
+  EVP_PKEY *pkey =
+      EVP_PKEY_new_raw_public_key(EVP_PKEY_ED25519, nullptr, public_key.data(), 32);
+  if (!pkey) return false;
+  EVP_MD_CTX *md = EVP_MD_CTX_new();
+  bool ok = md && EVP_DigestVerifyInit(md, nullptr, nullptr, nullptr, pkey) == 1 &&
+            EVP_DigestVerify(md, signature.data(), 64, message.data(), message.size()) == 1;
+  EVP_MD_CTX_free(md);
+  EVP_PKEY_free(pkey);
+  return ok;
+}
+
+std::string sign_ssh_msg(const std::vector<uint8_t> &message,
+                         const std::string &private_key_path) {
+  uint8_t seed[32], pub[32];
+  if (!detail::read_openssh_ed25519(private_key_path, seed, pub)) return "";
+  EVP_PKEY *pkey = EVP_PKEY_new_raw_private_key(EVP_PKEY_ED25519, nullptr, seed, 32);
+  OPENSSL_cleanse(seed, sizeof(seed));
+  if (!pkey) return "";
+  std::vector<uint8_t> sig(64);
+  size_t siglen = sig.size();
+  EVP_MD_CTX *md = EVP_MD_CTX_new();
+  bool ok = md && EVP_DigestSignInit(md, nullptr, nullptr, nullptr, pkey) == 1 &&
+            EVP_DigestSign(md, sig.data(), &siglen, message.data(), message.size()) == 1 &&
+            siglen == 64;
+  EVP_MD_CTX_free(md);
+  EVP_PKEY_free(pkey);
+  return ok ? base64::encode(sig) : "";
+}
+
+bool random_bytes(uint8_t *out, size_t n) {
+  return n <= (size_t)INT32_MAX && RAND_bytes(out, (int)n) == 1;
+}
+
+bool sha256(std::span<const uint8_t> data, uint8_t out[32]) {
+  return SHA256(data.data(), data.size(), out) != nullptr;
+}
+
+} // namespace wininspect::crypto
@@ -0,0 +1,139 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "wininspect/event_filter.hpp"
+#include <algorithm>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+
+namespace wininspect {
+
+namespace {
+
+const char *const kTypes[] = {"window.created", "window.destroyed", "window.changed"};
+
+unsigned type_bit(const std::string &type) {
+  for (unsigned i = 0; i < std::size(kTypes); i++)
+    if (type == kTypes[i]) return 1u << i;
+  return 0;
+}
+
+std::string ascii_fold(std::string s) {
+  for (auto &c : s)
+    if (c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+  return s;
+}
+
+// One value or an array of them.
+template <typename F> void each(const json::Value &v, F &&f) {
+  if (v.is_arr()) {
+    for (const auto &x : v.as_arr()) f(x);
+  } else {
+    f(v);
+  }
+}
+
+} // namespace
+
+bool EventFilter::Pattern::operator()(const std::string &s) const {
+  if (mode == MatchMode::Regex) return re->search(s);
+  const std::string &hay = icase ? ascii_fold(s) : s;
+  switch (mode) {
+  case MatchMode::Substring: return hay.find(text) != std::string::npos;
+  case MatchMode::Prefix: return hay.compare(0, text.size(), text) == 0;
+  case MatchMode::Exact: return hay == text;
+  default: return false;
+  }
+}
+
+EventFilter EventFilter::compile(const json::Object &spec) {
+  EventFilter f;
+  auto get = [&](const char *k) -> const json::Value * {
+    auto it = spec.find(k);
+    return it == spec.end() ? nullptr : &it->second;
+  };
+
+  if (auto v = get("types")) {
+    f.types_ = 0;
+    each(*v, [&](const json::Value &t) {
+      unsigned bit = t.is_str() ? type_bit(t.as_str()) : 0;
+      if (!bit) throw std::runtime_error("filter.types: unknown event type");
+      f.types_ |= bit;
+    });
+  }
+
+  MatchMode mode = MatchMode::Regex;
+  if (auto v = get("match")) {
+    auto m = v->is_str() ? match_mode_from_str(v->as_str()) : std::nullopt;
+    if (!m) throw std::runtime_error("filter.match: invalid mode");
+    mode = *m;
+  }
+  bool icase = false;
+  if (auto v = get("case_insensitive")) {
+    if (!v->is_bool()) throw std::runtime_error("filter.case_insensitive: expected bool");
+    icase = v->as_bool();
+  }
+  auto pattern = [&](const char *k, std::optional<Pattern> &out) {
+    auto v = get(k);
+    if (!v) return;
+    if (!v->is_str()) throw std::runtime_error(std::string("filter.") + k + ": expected string");
+    Pattern p;
+    p.mode = mode;
+    p.icase = icase;
+    if (mode == MatchMode::Regex) {
+      p.re = RegexCache::global().get(v->as_str(), icase);
+      p.text = v->as_str();
+    } else {
+      p.text = icase ? ascii_fold(v->as_str()) : v->as_str();
+    }
+    out = std::move(p);
+  };
+  pattern("class", f.class_);
+  pattern("title", f.title_);
+
+  if (auto v = get("pid")) {
+    each(*v, [&](const json::Value &p) {
+      if (!p.is_num() || p.as_num() < 0) throw std::runtime_error("filter.pid: expected number");
+      f.pids_.push_back((std::uint32_t)p.as_num());
+    });
+  }
+  if (auto v = get("under")) {
+    std::uint64_t h = 0;
+    if (v->is_str() && v->as_str().rfind("0x", 0) == 0) {
+      std::stringstream ss;
+      ss << std::hex << v->as_str().substr(2);
+      ss >> h;
+    }
+    if (!h) throw std::runtime_error("filter.under: expected hwnd");
+    f.under_ = (hwnd_u64)h;
+  }
+  return f;
+}
+
+bool EventFilter::accepts_type(const std::string &type) const {
+  return (types_ & type_bit(type)) != 0;
+}
+
+bool EventFilter::needs_facts() const {
+  return class_ || title_ || !pids_.empty() || under_ != 0;
+}
+
+bool EventFilter::matches_static(hwnd_u64 hwnd, const WindowFacts &w) const {
+  if (class_ && !(*class_)(w.class_name)) return false;
+  if (!pids_.empty() && std::find(pids_.begin(), pids_.end(), w.pid) == pids_.end())
+    return false;
+  if (under_ && hwnd != under_ &&
+      std::find(w.ancestors.begin(), w.ancestors.end(), under_) == w.ancestors.end())
+    return false;
+  return true;
+}
+
+bool EventFilter::matches(const Event &e, const WindowFacts *w) const {
+  if (!accepts_type(e.type)) return false;
+  if (!needs_facts()) return true;
+  if (!w) return false;
+  return matches_static(e.hwnd, *w) && (!title_ || (*title_)(w->title));
+}
+
+} // namespace wininspect
@@ -0,0 +1,121 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "wininspect/event_ring.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace wininspect {
+
+namespace {
+
+template <size_t N>
+void store_str(std::atomic<uint64_t> (&dst)[N], const std::string &s) {
+  char buf[N * 8] = {};
+  std::memcpy(buf, s.data(), std::min(s.size(), sizeof(buf)));
+  for (size_t i = 0; i < N; i++) {
+    uint64_t w;
+    std::memcpy(&w, buf + i * 8, 8);
+    dst[i].store(w, std::memory_order_relaxed);
+  }
+}
+
+template <size_t N>
+std::string load_str(const std::atomic<uint64_t> (&src)[N]) {
+  char buf[N * 8];
+  for (size_t i = 0; i < N; i++) {
+    uint64_t w = src[i].load(std::memory_order_relaxed);
+    std::memcpy(buf + i * 8, &w, 8);
+  }
+  return std::string(buf, strnlen(buf, sizeof(buf)));
+}
+
+} // namespace
+
+EventRing::EventRing(size_t capacity) {
+  size_t cap = 2;
+  while (cap < capacity) cap <<= 1;
+  slots_ = std::make_unique<Slot[]>(cap);
+  mask_ = cap - 1;
+}
+
+uint64_t EventRing::push(Event &e) {
+  uint64_t seq = head_.load(std::memory_order_relaxed) + 1;
+  Slot &s = slots_[seq & mask_];
+  s.stamp.store((seq << 1) | 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  s.hwnd.store(e.hwnd, std::memory_order_relaxed);
+  store_str(s.type, e.type);
+  store_str(s.property, e.property);
+  s.stamp.store(seq << 1, std::memory_order_release);
+  head_.store(seq, std::memory_order_release);
+  e.seq = seq;
+
+  // Store head, then load waiters_; wait_for() does the mirror image. Without
+  // a full fence on both sides each could miss the other's store and the
+  // waiter would sleep through this event until its timeout.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (waiters_.load(std::memory_order_relaxed) > 0) {
+    // Taking the lock orders this notify after any waiter's predicate check.
+    { std::lock_guard<std::mutex> lk(wait_mu_); }
+    wait_cv_.notify_all();
+  }
+  return seq;
+}
+
+uint64_t EventRing::oldest() const {
+  uint64_t h = head();
+  return h > capacity() ? h - capacity() + 1 : 1;
+}
+
+EventRing::ReadResult EventRing::read(uint64_t since, std::vector<Event> &out,
+                                      size_t max) const {
+  ReadResult r;
+  uint64_t h = head();
+  if (since > h) { r.gap = true; since = 0; }
+  uint64_t next = since + 1;
+
+  for (size_t n = 0; n < max && next <= h;) {
+    uint64_t lo = h > capacity() ? h - capacity() + 1 : 1;
+    if (next < lo) { r.gap = true; next = lo; }
+
+    const Slot &s = slots_[next & mask_];
+    uint64_t before = s.stamp.load(std::memory_order_acquire);
+    if (before != (next << 1)) {
+      // Being rewritten or already rewritten by a later lap: fell behind.
+      r.gap = true;
+      h = head();
+      next = std::max(next + 1, h > capacity() ? h - capacity() + 1 : 1);
+      continue;
+    }
+    Event e;
+    e.seq = next;
+    e.hwnd = s.hwnd.load(std::memory_order_relaxed);
+    e.type = load_str(s.type);
+    e.property = load_str(s.property);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (s.stamp.load(std::memory_order_relaxed) != before) {
+      r.gap = true;
+      h = head();
+      continue; // `next` is now below the window; the check above skips ahead
+    }
+    out.push_back(std::move(e));
+    r.last_seq = next;
+    ++next;
+    ++n;
+  }
+  if (r.last_seq == 0) r.last_seq = next - 1;
+  return r;
+}
+
+bool EventRing::wait_for(uint64_t since, std::chrono::milliseconds timeout) const {
+  if (head() > since) return true;
+  std::unique_lock<std::mutex> lk(wait_mu_);
+  waiters_.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst); // pairs with push()
+  bool ok = wait_cv_.wait_for(lk, timeout, [&] { return head() > since; });
+  waiters_.fetch_sub(1, std::memory_order_relaxed);
+  return ok;
+}
+
+} // namespace wininspect
@@ -0,0 +1,126 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "wininspect/event_stream.hpp"
+#include <algorithm>
+#include <map>
+
+namespace wininspect {
+
+std::optional<EventStream::Overflow> EventStream::overflow_from_str(const std::string &s) {
+  if (s == "coalesce") return Overflow::Coalesce;
+  if (s == "drop_oldest") return Overflow::DropOldest;
+  return std::nullopt;
+}
+
+EventStream::EventStream(Options opts) : opts_(opts), credit_(opts.credit) {
+  opts_.max_queue = std::max<size_t>(opts_.max_queue, 1);
+}
+
+void EventStream::push(const std::vector<Event> &events, bool gap) {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (closed_) return;
+    q_.insert(q_.end(), events.begin(), events.end());
+    if (gap) gap_ = true;
+    if (q_.size() > opts_.max_queue) shrink_locked();
+  }
+  cv_.notify_all();
+}
+
+void EventStream::shrink_locked() {
+  if (opts_.overflow == Overflow::Coalesce) {
+    std::vector<bool> dead(q_.size(), false);
+    std::map<hwnd_u64, std::vector<size_t>> born;        // created in backlog
+    std::map<std::pair<hwnd_u64, std::string>, size_t> last_change;
+    for (size_t i = 0; i < q_.size(); i++) {
+      const auto &e = q_[i];
+      if (e.type == "window.created") {
+        born[e.hwnd] = {i};
+      } else if (e.type == "window.destroyed") {
+        auto it = born.find(e.hwnd);
+        if (it != born.end()) {
+          for (auto j : it->second) dead[j] = true;
+          dead[i] = true;
+          born.erase(it);
+        }
+      } else {
+        auto key = std::make_pair(e.hwnd, e.property);
+        auto it = last_change.find(key);
+        if (it != last_change.end()) dead[it->second] = true;
+        last_change[key] = i;
+        auto b = born.find(e.hwnd);
+        if (b != born.end()) b->second.push_back(i);
+      }
+    }
+    std::deque<Event> kept;
+    for (size_t i = 0; i < q_.size(); i++)
+      if (!dead[i]) kept.push_back(std::move(q_[i]));
+    stats_.coalesced += q_.size() - kept.size();
+    q_ = std::move(kept);
+  }
+  if (q_.size() > opts_.max_queue) {
+    size_t n = q_.size() - opts_.max_queue;
+    q_.erase(q_.begin(), q_.begin() + (std::ptrdiff_t)n);
+    stats_.dropped += n;
+    pending_dropped_ += n;
+    gap_ = true;
+  }
+}
+
+uint64_t EventStream::grant(uint64_t n) {
+  uint64_t c;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    credit_ += n;
+    c = credit_;
+  }
+  cv_.notify_all();
+  return c;
+}
+
+bool EventStream::sendable_locked() const {
+  return gap_ || (!q_.empty() && credit_ > 0);
+}
+
+bool EventStream::take(Batch &out, size_t max, std::chrono::milliseconds timeout) {
+  std::unique_lock<std::mutex> lk(mu_);
+  if (!cv_.wait_for(lk, timeout, [&] { return closed_ || sendable_locked(); }) || closed_)
+    return false;
+  out.events.clear();
+  out.gap = gap_;
+  out.dropped = pending_dropped_;
+  gap_ = false;
+  pending_dropped_ = 0;
+  size_t n = (size_t)std::min<uint64_t>({(uint64_t)max, credit_, (uint64_t)q_.size()});
+  for (size_t i = 0; i < n; i++) {
+    out.events.push_back(std::move(q_.front()));
+    q_.pop_front();
+  }
+  credit_ -= n;
+  stats_.delivered += n;
+  return true;
+}
+
+void EventStream::close() {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    closed_ = true;
+  }
+  cv_.notify_all();
+}
+
+bool EventStream::closed() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return closed_;
+}
+
+EventStream::Stats EventStream::stats() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  Stats s = stats_;
+  s.credit = credit_;
+  s.queued = q_.size();
+  return s;
+}
+
+} // namespace wininspect
@@ -2,7 +2,14 @@
 // Copyright (c) 2026 Mark E. DeYoung
 
 #include "wininspect/fake_backend.hpp"
+#include "wininspect/mapped_file.hpp"
+#include "wininspect/window_index.hpp"
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
 
 namespace wininspect {
 
@@ -11,18 +18,27 @@ FakeBackend::FakeBackend(std::vector<FakeWindow> windows) {
     w_.emplace(w.hwnd, std::move(w));
 }
 
+FakeBackend::~FakeBackend() {
+  std::error_code ec;
+  for (auto &[path, host] : files_) std::filesystem::remove(host, ec);
+}
+
 void FakeBackend::set_config(const json::Object &) {
   // Fake backend doesn't currently use dynamic limits, but needs to implement the interface
 }
 
 Snapshot FakeBackend::capture_snapshot() {
+  std::lock_guard<std::mutex> lk(mu_);
   Snapshot s;
-  // stable ordering by hwnd
+  std::vector<IndexedWindow> indexed;
+  // stable ordering by hwnd (std::map iterates in key order)
   for (const auto &[hwnd, w] : w_) {
-    if (w.parent == 0)
+    if (w.parent == 0) {
       s.top.push_back(hwnd);
+      indexed.push_back({hwnd, w.title, w.cls});
+    }
   }
-  std::sort(s.top.begin(), s.top.end());
+  s.index = std::make_shared<WindowIndex>(std::move(indexed));
   return s;
 }
 
@@ -30,6 +46,7 @@ std::vector<hwnd_u64> FakeBackend::list_top(const Snapshot &s) { return s.top; }
 
 std::vector<hwnd_u64> FakeBackend::list_children(const Snapshot &,
                                                  hwnd_u64 parent) {
+  std::lock_guard<std::mutex> lk(mu_);
   std::vector<hwnd_u64> out;
   for (const auto &[hwnd, w] : w_)
     if (w.parent == parent)
@@ -40,6 +57,7 @@ std::vector<hwnd_u64> FakeBackend::list_children(const Snapshot &,
 
 std::optional<WindowInfo> FakeBackend::get_info(const Snapshot &,
                                                 hwnd_u64 hwnd) {
+  std::lock_guard<std::mutex> lk(mu_);
   auto it = w_.find(hwnd);
   if (it == w_.end())
     return std::nullopt;
@@ -142,7 +160,25 @@ std::optional<Color> FakeBackend::get_pixel(int, int) {
 }
 
 std::optional<ScreenCapture> FakeBackend::capture_screen(Rect) {
-  return ScreenCapture{100, 100, "fake_b64"};
+  // A 100x100 24-bit BMP in the get_pixel colour, so callers see real bytes.
+  const int w = 100, h = 100, stride = w * 3;
+  const uint32_t off = 54, size = off + (uint32_t)(stride * h);
+  std::vector<uint8_t> bmp(size);
+  auto put32 = [&](size_t at, uint32_t v) {
+    for (int i = 0; i < 4; i++) bmp[at + i] = (uint8_t)(v >> (8 * i));
+  };
+  bmp[0] = 'B';
+  bmp[1] = 'M';
+  put32(2, size);
+  put32(10, off);
+  put32(14, 40); // BITMAPINFOHEADER
+  put32(18, (uint32_t)w);
+  put32(22, (uint32_t)h);
+  bmp[26] = 1;  // planes
+  bmp[28] = 24; // bits per pixel
+  put32(34, (uint32_t)(stride * h));
+  for (size_t i = off; i < size; i += 3) bmp[i + 2] = 255; // BGR
+  return ScreenCapture{w, h, std::move(bmp)};
 }
 
 std::optional<std::pair<int, int>> FakeBackend::pixel_search(Rect, Color, int) {
@@ -167,17 +203,58 @@ ProcessExecResult FakeBackend::execute_process(const std::string &, const std::s
   return {0, "fake output", "", 0};
 }
 
-std::optional<FileInfo> FakeBackend::get_file_info(const std::string &path) {
-  return FileInfo{path, 1024, false, "2026-02-19"};
+std::string FakeBackend::host_path(const std::string &path) const {
+  std::lock_guard<std::mutex> lk(mu_);
+  auto it = files_.find(path);
+  return it != files_.end() ? it->second : path;
+}
+
+void FakeBackend::add_file(const std::string &path, const std::string &content) {
+  static std::atomic<unsigned> counter{0};
+  std::string host;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto &h = files_[path];
+    if (h.empty()) {
+      auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+      h = (std::filesystem::temp_directory_path() /
+           ("wininspect-fake-" + std::to_string(stamp) + "-" + std::to_string(counter++)))
+              .string();
+    }
+    host = h;
+  }
+  std::ofstream(host, std::ios::binary | std::ios::trunc) << content;
 }
 
-std::optional<std::string> FakeBackend::read_file_content(const std::string &) {
-  return "fake content";
+void FakeBackend::append_file(const std::string &path, const std::string &content) {
+  std::ofstream(host_path(path), std::ios::binary | std::ios::app) << content;
 }
 
-std::vector<hwnd_u64> FakeBackend::find_windows_regex(const std::string &,
-                                                       const std::string &) {
-  return {0x1234};
+std::optional<FileInfo> FakeBackend::get_file_info(const std::string &path) {
+  std::error_code ec;
+  auto host = host_path(path);
+  auto status = std::filesystem::status(host, ec);
+  if (ec || !std::filesystem::exists(status)) return std::nullopt;
+  FileInfo fi{path, 0, std::filesystem::is_directory(status), ""};
+  if (!fi.is_directory) fi.size = std::filesystem::file_size(host, ec);
+  return fi;
+}
+
+std::optional<FileChunk> FakeBackend::read_file_range(const std::string &path, uint64_t offset,
+                                                      size_t length) {
+  MappedFile m(host_path(path), offset, length);
+  if (!m.opened()) return std::nullopt;
+  FileChunk c;
+  c.offset = offset;
+  c.file_size = m.file_size();
+  if (m.valid()) c.data.assign(m.data(), m.data() + m.size());
+  return c;
+}
+
+std::vector<hwnd_u64> FakeBackend::find_windows_regex(const std::string &title_regex,
+                                                       const std::string &class_regex) {
+  auto s = capture_snapshot();
+  return s.index->find({title_regex, class_regex});
 }
 
 std::optional<RegistryKeyInfo> FakeBackend::reg_read(const std::string &path) {
@@ -235,7 +312,8 @@ bool FakeBackend::sync_create_mutex(const std::string &name, bool) {
 }
 
 std::optional<MemoryRegion> FakeBackend::mem_read(uint32_t pid, uint64_t addr, size_t) {
-  return MemoryRegion{addr, "ZmFrZSBtZW1vcnk="}; // "fake memory"
+  static const std::string text = "fake memory";
+  return MemoryRegion{addr, std::vector<uint8_t>(text.begin(), text.end())};
 }
 
 bool FakeBackend::mem_write(uint32_t pid, uint64_t addr, const std::vector<uint8_t> &) {
@@ -415,9 +493,60 @@ void FakeBackend::clear_injected_events() {
   injected_events_.clear();
 }
 
-std::vector<Event> FakeBackend::poll_events(const Snapshot &,
-                                            const Snapshot &) {
-  return {}; // Placeholder
+void FakeBackend::add_window(const FakeWindow &w) {
+  std::lock_guard<std::mutex> lk(mu_);
+  w_[w.hwnd] = w;
+}
+
+bool FakeBackend::remove_window(hwnd_u64 hwnd) {
+  std::lock_guard<std::mutex> lk(mu_);
+  return w_.erase(hwnd) > 0;
+}
+
+bool FakeBackend::set_title(hwnd_u64 hwnd, const std::string &title) {
+  std::lock_guard<std::mutex> lk(mu_);
+  auto it = w_.find(hwnd);
+  if (it == w_.end()) return false;
+  it->second.title = title;
+  return true;
+}
+
+std::vector<Event> FakeBackend::poll_events(const Snapshot &old_snap,
+                                            const Snapshot &new_snap) {
+  // Same created/destroyed diff as Win32Backend; snapshots are hwnd-sorted.
+  std::vector<Event> out;
+  std::vector<hwnd_u64> created, destroyed;
+  std::set_difference(new_snap.top.begin(), new_snap.top.end(), old_snap.top.begin(),
+                      old_snap.top.end(), std::back_inserter(created));
+  std::set_difference(old_snap.top.begin(), old_snap.top.end(), new_snap.top.begin(),
+                      new_snap.top.end(), std::back_inserter(destroyed));
+  for (auto h : created) out.push_back({0, "window.created", h, ""});
+  for (auto h : destroyed) out.push_back({0, "window.destroyed", h, ""});
+  return out;
+}
+
+void FakeBackend::set_timeline(const FakeTimeline::Options &opts, bool realtime) {
+  std::lock_guard<std::mutex> lk(mu_);
+  timeline_ = opts;
+  timeline_realtime_ = realtime;
+}
+
+std::unique_ptr<IEventSource> FakeBackend::create_event_source() {
+  std::vector<hwnd_u64> top;
+  hwnd_u64 next = 1;
+  FakeTimeline::Options opts;
+  bool realtime;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (!timeline_) return nullptr;
+    opts = *timeline_;
+    realtime = timeline_realtime_;
+    for (const auto &[hwnd, w] : w_)
+      if (w.parent == 0) top.push_back(hwnd);
+    if (!w_.empty()) next = w_.rbegin()->first + 1;
+  }
+  return std::make_unique<ScriptedEventSource>(
+      this, FakeTimeline::generate(opts, std::move(top), next), realtime);
 }
 
 } // namespace wininspect
@@ -0,0 +1,132 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "wininspect/fake_timeline.hpp"
+#include "wininspect/fake_backend.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace wininspect {
+
+std::optional<FakeTimeline::Shape> FakeTimeline::shape_from_str(const std::string &s) {
+  if (s == "steady") return Shape::Steady;
+  if (s == "burst") return Shape::Burst;
+  if (s == "sawtooth") return Shape::Sawtooth;
+  return std::nullopt;
+}
+
+std::vector<FakeTimeline::Step> FakeTimeline::generate(const Options &opts,
+                                                       std::vector<hwnd_u64> live,
+                                                       hwnd_u64 next_hwnd) {
+  const double rate = std::max(opts.rate, 1e-3);
+  const size_t burst = std::max<size_t>(opts.burst, 1);
+  const double period = std::max(opts.period_ms, 1) / 1000.0;
+  const double per_period = rate * period; // sawtooth events per period
+  uint64_t rng = opts.seed ? opts.seed : 1;
+  auto next = [&] { // xorshift64: stable across platforms
+    rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+    return rng;
+  };
+
+  std::vector<Step> out;
+  out.reserve(opts.total);
+  for (size_t i = 0; i < opts.total; i++) {
+    double t = 0;
+    switch (opts.shape) {
+    case Shape::Steady: t = i / rate; break;
+    case Shape::Burst: t = (double)(i / burst * burst) / rate; break;
+    case Shape::Sawtooth: {
+      // Events so far in a period grow as rate*t^2/period; invert that.
+      double p = std::floor(i / per_period);
+      double j = i - p * per_period;
+      t = p * period + std::sqrt(j * period / rate);
+      break;
+    }
+    }
+
+    Step s;
+    s.at = std::chrono::nanoseconds(std::llround(t * 1e9));
+    int roll = (int)(next() % 100);
+    if (live.empty() || roll < opts.create_pct) {
+      hwnd_u64 h = next_hwnd++;
+      live.push_back(h);
+      s.event = {0, "window.created", h, ""};
+      s.title = "Window " + std::to_string(h);
+    } else {
+      size_t k = next() % live.size();
+      hwnd_u64 h = live[k];
+      if (roll < opts.create_pct + opts.destroy_pct) {
+        live[k] = live.back();
+        live.pop_back();
+        s.event = {0, "window.destroyed", h, ""};
+      } else {
+        s.event = {0, "window.changed", h, "title"};
+        s.title = "Step " + std::to_string(i);
+      }
+    }
+    out.push_back(std::move(s));
+  }
+  return out;
+}
+
+ScriptedEventSource::ScriptedEventSource(FakeBackend *backend,
+                                         std::vector<FakeTimeline::Step> steps,
+                                         bool realtime)
+    : backend_(backend), steps_(std::move(steps)), realtime_(realtime) {}
+
+ScriptedEventSource::~ScriptedEventSource() { stop(); }
+
+bool ScriptedEventSource::start(Sink sink) {
+  if (thread_.joinable()) return false;
+  sink_ = std::move(sink);
+  t0_ = std::chrono::steady_clock::now();
+  thread_ = std::thread([this] { run(); });
+  return true;
+}
+
+void ScriptedEventSource::stop() {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  if (thread_.joinable()) thread_.join();
+}
+
+bool ScriptedEventSource::wait_done(std::chrono::milliseconds timeout) {
+  std::unique_lock<std::mutex> lk(mu_);
+  return cv_.wait_for(lk, timeout, [&] { return done_; });
+}
+
+void ScriptedEventSource::run() {
+  std::vector<Event> batch;
+  for (size_t i = 0; i < steps_.size();) {
+    auto at = steps_[i].at;
+    if (realtime_) {
+      std::unique_lock<std::mutex> lk(mu_);
+      if (cv_.wait_until(lk, t0_ + at, [&] { return stop_; })) return;
+    } else {
+      std::lock_guard<std::mutex> lk(mu_);
+      if (stop_) return;
+    }
+    batch.clear();
+    for (; i < steps_.size() && steps_[i].at == at; i++) {
+      const auto &s = steps_[i];
+      if (s.event.type == "window.created")
+        backend_->add_window({s.event.hwnd, 0, 0, s.title, "ScriptedWindow", true});
+      else if (s.event.type == "window.destroyed")
+        backend_->remove_window(s.event.hwnd);
+      else
+        backend_->set_title(s.event.hwnd, s.title);
+      batch.push_back(s.event);
+    }
+    size_t n = batch.size();
+    sink_(batch);
+    delivered_ += n;
+  }
+  std::lock_guard<std::mutex> lk(mu_);
+  done_ = true;
+  cv_.notify_all();
+}
+
+} // namespace wininspect
@@ -0,0 +1,147 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "wininspect/mapped_file.hpp"
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace wininspect {
+
+MappedFile::MappedFile(const std::string &path, uint64_t length) : MappedFile(path, 0, length) {}
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string &path, uint64_t offset, uint64_t length) {
+  int wlen = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
+  std::wstring wpath(wlen > 0 ? wlen - 1 : 0, L'\0');
+  if (wlen > 1) MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, wpath.data(), wlen);
+
+  // Share write/delete so a journal segment can be mapped while it is still
+  // being appended to or rotated away.
+  HANDLE f = CreateFileW(wpath.c_str(), GENERIC_READ,
+                         FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                         nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (f == INVALID_HANDLE_VALUE) return;
+  LARGE_INTEGER sz;
+  if (!GetFileSizeEx(f, &sz)) { CloseHandle(f); return; }
+  opened_ = true;
+  file_size_ = (uint64_t)sz.QuadPart;
+  if (offset >= file_size_) { CloseHandle(f); return; }
+  uint64_t rest = file_size_ - offset;
+  uint64_t len = (length == 0 || length > rest) ? rest : length;
+
+  // Views start on the allocation granularity (64 KiB), not the page.
+  SYSTEM_INFO si;
+  GetSystemInfo(&si);
+  uint64_t base = offset - offset % si.dwAllocationGranularity;
+  size_t view = (size_t)(offset - base + len);
+
+  HANDLE m = CreateFileMappingW(f, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!m) { CloseHandle(f); return; }
+  void *p = MapViewOfFile(m, FILE_MAP_READ, (DWORD)(base >> 32), (DWORD)base, view);
+  if (!p) { CloseHandle(m); CloseHandle(f); return; }
+
+  file_ = f;
+  mapping_ = m;
+  view_ = p;
+  view_size_ = view;
+  data_ = static_cast<const uint8_t *>(p) + (offset - base);
+  size_ = (size_t)len;
+}
+
+void MappedFile::close() {
+  if (view_) UnmapViewOfFile(view_);
+  if (mapping_) CloseHandle((HANDLE)mapping_);
+  if (file_) CloseHandle((HANDLE)file_);
+  data_ = nullptr;
+  size_ = 0;
+  view_ = nullptr;
+  view_size_ = 0;
+  mapping_ = file_ = nullptr;
+}
+
+MappedFile::MappedFile(MappedFile &&o) noexcept
+    : data_(std::exchange(o.data_, nullptr)), size_(std::exchange(o.size_, 0)),
+      view_(std::exchange(o.view_, nullptr)), view_size_(std::exchange(o.view_size_, 0)),
+      file_size_(std::exchange(o.file_size_, 0)), opened_(std::exchange(o.opened_, false)),
+      file_(std::exchange(o.file_, nullptr)), mapping_(std::exchange(o.mapping_, nullptr)) {}
+
+MappedFile &MappedFile::operator=(MappedFile &&o) noexcept {
+  if (this != &o) {
+    close();
+    data_ = std::exchange(o.data_, nullptr);
+    size_ = std::exchange(o.size_, 0);
+    view_ = std::exchange(o.view_, nullptr);
+    view_size_ = std::exchange(o.view_size_, 0);
+    file_size_ = std::exchange(o.file_size_, 0);
+    opened_ = std::exchange(o.opened_, false);
+    file_ = std::exchange(o.file_, nullptr);
+    mapping_ = std::exchange(o.mapping_, nullptr);
+  }
+  return *this;
+}
+
+#else
+
+MappedFile::MappedFile(const std::string &path, uint64_t offset, uint64_t length) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) { ::close(fd); return; }
+  opened_ = true;
+  file_size_ = (uint64_t)st.st_size;
+  if (offset >= file_size_) { ::close(fd); return; }
+  uint64_t rest = file_size_ - offset;
+  uint64_t len = (length == 0 || length > rest) ? rest : length;
+
+  uint64_t page = (uint64_t)sysconf(_SC_PAGESIZE);
+  uint64_t base = offset - offset % page;
+  size_t view = (size_t)(offset - base + len);
+  void *p = mmap(nullptr, view, PROT_READ, MAP_SHARED, fd, (off_t)base);
+  ::close(fd); // the mapping keeps its own reference
+  if (p == MAP_FAILED) return;
+  view_ = p;
+  view_size_ = view;
+  data_ = static_cast<const uint8_t *>(p) + (offset - base);
+  size_ = (size_t)len;
+}
+
+void MappedFile::close() {
+  if (view_) munmap(const_cast<void *>(view_), view_size_);
+  data_ = nullptr;
+  size_ = 0;
+  view_ = nullptr;
+  view_size_ = 0;
+}
+
+MappedFile::MappedFile(MappedFile &&o) noexcept
+    : data_(std::exchange(o.data_, nullptr)), size_(std::exchange(o.size_, 0)),
+      view_(std::exchange(o.view_, nullptr)), view_size_(std::exchange(o.view_size_, 0)),
+      file_size_(std::exchange(o.file_size_, 0)), opened_(std::exchange(o.opened_, false)) {}
+
+MappedFile &MappedFile::operator=(MappedFile &&o) noexcept {
+  if (this != &o) {
+    close();
+    data_ = std::exchange(o.data_, nullptr);
+    size_ = std::exchange(o.size_, 0);
+    view_ = std::exchange(o.view_, nullptr);
+    view_size_ = std::exchange(o.view_size_, 0);
+    file_size_ = std::exchange(o.file_size_, 0);
+    opened_ = std::exchange(o.opened_, false);
+  }
+  return *this;
+}
+
+#endif
+
+MappedFile::~MappedFile() { close(); }
+
+} // namespace wininspect
@@ -0,0 +1,534 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "wininspect/regex_engine.hpp"
+#include <cctype>
+
+namespace wininspect {
+
+namespace {
+
+using ByteSet = std::bitset<256>;
+
+struct Node {
+  enum Kind { Empty, Set, Bol, Eol, WordB, NotWordB, Cat, Alt, Repeat };
+  Kind kind = Empty;
+  ByteSet set;
+  std::vector<Node> kids;
+  int min = 0, max = -1; // Repeat; max -1 = unbounded
+  int cls = -1;          // Set: class index once emitted
+};
+
+// Thrown when the pattern needs something a plain automaton can't do.
+struct NeedsFallback {};
+
+bool is_word(unsigned char c) { return std::isalnum(c) || c == '_'; }
+
+ByteSet make_set(bool (*pred)(unsigned char)) {
+  ByteSet s;
+  for (int c = 0; c < 256; c++)
+    if (pred((unsigned char)c)) s.set(c);
+  return s;
+}
+
+const ByteSet &digit_set() {
+  static const ByteSet s = make_set([](unsigned char c) { return c >= '0' && c <= '9'; });
+  return s;
+}
+const ByteSet &word_set() {
+  static const ByteSet s = make_set(is_word);
+  return s;
+}
+const ByteSet &space_set() {
+  static const ByteSet s = make_set([](unsigned char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+  });
+  return s;
+}
+
+int hexval(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return 10 + (c - 'a');
+  if (c >= 'A' && c <= 'F') return 10 + (c - 'A');
+  return -1;
+}
+
+class Parser {
+public:
+  Parser(std::string_view p, bool icase) : p_(p), icase_(icase) {}
+
+  Node parse() {
+    Node n = alt();
+    if (i_ != p_.size()) throw RegexError("unmatched ')' in regular expression");
+    return n;
+  }
+
+private:
+  static constexpr int MAX_DEPTH = 256;
+
+  std::string_view p_;
+  bool icase_;
+  size_t i_ = 0;
+  int depth_ = 0;
+
+  bool at_end() const { return i_ >= p_.size(); }
+  char peek() const { return at_end() ? '\0' : p_[i_]; }
+  char get() {
+    if (at_end()) throw RegexError("unexpected end of regular expression");
+    return p_[i_++];
+  }
+
+  ByteSet fold(ByteSet s) const {
+    if (!icase_) return s;
+    for (int c = 'a'; c <= 'z'; c++) {
+      if (s[c] || s[c - 32]) {
+        s.set(c);
+        s.set(c - 32);
+      }
+    }
+    return s;
+  }
+
+  // Escapes and class members are built unfolded; case folding is applied
+  // once to the finished set.
+  static Node set_node(const ByteSet &s) {
+    Node n;
+    n.kind = Node::Set;
+    n.set = s;
+    return n;
+  }
+
+  static Node byte_node(unsigned char c) {
+    ByteSet s;
+    s.set(c);
+    return set_node(s);
+  }
+
+  Node alt() {
+    Node first = cat();
+    if (peek() != '|') return first;
+    Node a;
+    a.kind = Node::Alt;
+    a.kids.push_back(std::move(first));
+    while (!at_end() && peek() == '|') {
+      i_++;
+      a.kids.push_back(cat());
+    }
+    return a;
+  }
+
+  Node cat() {
+    Node c;
+    c.kind = Node::Cat;
+    while (!at_end() && peek() != '|' && peek() != ')') c.kids.push_back(repeat());
+    return c;
+  }
+
+  // Parses "{n}", "{n,}" or "{n,m}" at i_. Returns false (leaving i_ alone)
+  // if there is no well-formed brace quantifier here.
+  bool braces(int &mn, int &mx) {
+    size_t j = i_ + 1;
+    auto number = [&](int &out) {
+      size_t start = j;
+      long v = 0;
+      while (j < p_.size() && std::isdigit((unsigned char)p_[j])) {
+        v = v * 10 + (p_[j] - '0');
+        if (v > 100000) throw RegexError("repetition count too large");
+        j++;
+      }
+      out = (int)v;
+      return j > start;
+    };
+    if (!number(mn)) return false;
+    mx = mn;
+    if (j < p_.size() && p_[j] == ',') {
+      j++;
+      if (!number(mx)) mx = -1;
+    }
+    if (j >= p_.size() || p_[j] != '}') return false;
+    if (mx != -1 && mx < mn) throw RegexError("invalid repetition range");
+    i_ = j + 1;
+    return true;
+  }
+
+  Node repeat() {
+    Node a = atom();
+    int mn = 0, mx = -1;
+    char c = peek();
+    if (c == '*') { mn = 0; mx = -1; i_++; }
+    else if (c == '+') { mn = 1; mx = -1; i_++; }
+    else if (c == '?') { mn = 0; mx = 1; i_++; }
+    else if (c == '{') {
+      if (!braces(mn, mx)) throw RegexError("invalid brace quantifier");
+    } else {
+      return a;
+    }
+    if (a.kind == Node::Bol || a.kind == Node::Eol || a.kind == Node::WordB ||
+        a.kind == Node::NotWordB)
+      throw RegexError("nothing to repeat");
+    if (peek() == '?') i_++; // lazy: same language, same boolean answer
+    c = peek();
+    if (c == '*' || c == '+' || c == '?' || c == '{')
+      throw RegexError("nothing to repeat");
+
+    Node r;
+    r.kind = Node::Repeat;
+    r.min = mn;
+    r.max = mx;
+    r.kids.push_back(std::move(a));
+    return r;
+  }
+
+  Node atom() {
+    char c = get();
+    switch (c) {
+    case '(': {
+      if (++depth_ > MAX_DEPTH) throw RegexError("regular expression nested too deeply");
+      if (peek() == '?') {
+        i_++;
+        char k = get();
+        if (k == '=' || k == '!') throw NeedsFallback{};
+        if (k != ':') throw RegexError("invalid group");
+      }
+      Node inner = alt();
+      if (get() != ')') throw RegexError("missing ')' in regular expression");
+      depth_--;
+      return inner;
+    }
+    case '.': {
+      ByteSet s;
+      s.set();
+      s.reset('\n');
+      s.reset('\r');
+      return set_node(s);
+    }
+    case '^': { Node n; n.kind = Node::Bol; return n; }
+    case '$': { Node n; n.kind = Node::Eol; return n; }
+    case '[': return char_class();
+    case '\\': {
+      Node n = escape(false);
+      if (n.kind == Node::Set) n.set = fold(n.set);
+      return n;
+    }
+    case '*':
+    case '+':
+    case '?':
+    case '{':
+      throw RegexError("nothing to repeat");
+    default:
+      return set_node(fold(byte_node((unsigned char)c).set));
+    }
+  }
+
+  Node escape(bool in_class) {
+    char e = get();
+    switch (e) {
+    case 'd': return set_node(digit_set());
+    case 'D': return set_node(~digit_set());
+    case 'w': return set_node(word_set());
+    case 'W': return set_node(~word_set());
+    case 's': return set_node(space_set());
+    case 'S': return set_node(~space_set());
+    case 'b':
+      if (in_class) return byte_node('\b');
+      { Node n; n.kind = Node::WordB; return n; }
+    case 'B':
+      if (in_class) throw RegexError("invalid escape in character class");
+      { Node n; n.kind = Node::NotWordB; return n; }
+    case 'n': return byte_node('\n');
+    case 'r': return byte_node('\r');
+    case 't': return byte_node('\t');
+    case 'f': return byte_node('\f');
+    case 'v': return byte_node('\v');
+    case '0':
+      if (std::isdigit((unsigned char)peek())) throw NeedsFallback{};
+      return byte_node('\0');
+    case 'x': {
+      int h1 = hexval(get()), h2 = hexval(get());
+      if (h1 < 0 || h2 < 0) throw RegexError("invalid \\x escape");
+      return byte_node((unsigned char)(h1 * 16 + h2));
+    }
+    case 'u': {
+      int v = 0;
+      for (int k = 0; k < 4; k++) {
+        int h = hexval(get());
+        if (h < 0) throw RegexError("invalid \\u escape");
+        v = v * 16 + h;
+      }
+      if (v > 0x7F) throw NeedsFallback{}; // leave code-unit semantics to std::regex
+      return byte_node((unsigned char)v);
+    }
+    case 'c': {
+      char l = get();
+      if (!std::isalpha((unsigned char)l)) throw RegexError("invalid \\c escape");
+      return byte_node((unsigned char)(l % 32));
+    }
+    default:
+      if (e >= '1' && e <= '9') {
+        if (in_class) throw RegexError("invalid escape in character class");
+        throw NeedsFallback{}; // back-reference
+      }
+      if (std::isalnum((unsigned char)e)) throw RegexError("invalid escape");
+      return byte_node((unsigned char)e);
+    }
+  }
+
+  // One class member: a single byte (which may start a range) or, for
+  // escapes like \d, a whole set.
+  int class_member(char c, ByteSet &s) {
+    if (c != '\\') return (unsigned char)c;
+    Node e = escape(true);
+    if (e.set.count() == 1)
+      for (int k = 0; k < 256; k++)
+        if (e.set[k]) return k;
+    s |= e.set;
+    return -1;
+  }
+
+  Node char_class() {
+    bool negate = false;
+    if (peek() == '^') {
+      negate = true;
+      i_++;
+    }
+    ByteSet s;
+    while (true) {
+      if (at_end()) throw RegexError("missing ']' in regular expression");
+      char c = get();
+      if (c == ']') break;
+      int lo = class_member(c, s);
+      if (peek() == '-' && i_ + 1 < p_.size() && p_[i_ + 1] != ']') {
+        i_++;
+        int hi = class_member(get(), s);
+        if (lo < 0 || hi < 0 || hi < lo)
+          throw RegexError("invalid range in character class");
+        for (int k = lo; k <= hi; k++) s.set(k);
+      } else if (lo >= 0) {
+        s.set(lo);
+      }
+    }
+    s = fold(s);
+    if (negate) s.flip();
+    return set_node(s);
+  }
+};
+
+class Compiler {
+public:
+  Compiler(std::vector<Regex::Inst> &prog, std::vector<ByteSet> &classes)
+      : prog_(prog), classes_(classes) {}
+
+  void emit(Node &n) {
+    using Op = Regex::Op;
+    switch (n.kind) {
+    case Node::Empty:
+      break;
+    case Node::Set:
+      if (n.cls < 0) {
+        n.cls = (int)classes_.size();
+        classes_.push_back(n.set);
+      }
+      push({Op::Byte, (uint32_t)n.cls});
+      break;
+    case Node::Bol: push({Op::Bol}); break;
+    case Node::Eol: push({Op::Eol}); break;
+    case Node::WordB: push({Op::WordB}); break;
+    case Node::NotWordB: push({Op::NotWordB}); break;
+    case Node::Cat:
+      for (auto &k : n.kids) emit(k);
+      break;
+    case Node::Alt: {
+      std::vector<size_t> to_end;
+      for (size_t k = 0; k + 1 < n.kids.size(); k++) {
+        size_t split = push({Op::Split});
+        prog_[split].x = (uint32_t)prog_.size();
+        emit(n.kids[k]);
+        to_end.push_back(push({Op::Jmp}));
+        prog_[split].y = (uint32_t)prog_.size();
+      }
+      emit(n.kids.back());
+      for (auto j : to_end) prog_[j].x = (uint32_t)prog_.size();
+      break;
+    }
+    case Node::Repeat: {
+      Node &kid = n.kids[0];
+      for (int k = 0; k < n.min; k++) emit(kid);
+      if (n.max < 0) {
+        size_t loop = push({Op::Split});
+        prog_[loop].x = (uint32_t)prog_.size();
+        emit(kid);
+        push({Op::Jmp, (uint32_t)loop});
+        prog_[loop].y = (uint32_t)prog_.size();
+      } else {
+        std::vector<size_t> skips;
+        for (int k = n.min; k < n.max; k++) {
+          size_t split = push({Op::Split});
+          prog_[split].x = (uint32_t)prog_.size();
+          emit(kid);
+          skips.push_back(split);
+        }
+        for (auto s : skips) prog_[s].y = (uint32_t)prog_.size();
+      }
+      break;
+    }
+    }
+  }
+
+  size_t push(Regex::Inst in) {
+    if (prog_.size() >= Regex::MAX_PROGRAM)
+      throw RegexError("regular expression too complex");
+    prog_.push_back(in);
+    return prog_.size() - 1;
+  }
+
+private:
+  std::vector<Regex::Inst> &prog_;
+  std::vector<ByteSet> &classes_;
+};
+
+// Per-thread scratch so searches don't allocate.
+struct VmScratch {
+  std::vector<uint32_t> cur, next, stack, seen;
+  uint32_t gen = 0;
+
+  void reset(size_t n) {
+    if (seen.size() < n) {
+      seen.assign(n, 0);
+      gen = 0;
+    }
+    if (++gen == 0) { // wrapped; start over
+      std::fill(seen.begin(), seen.end(), 0);
+      gen = 1;
+    }
+  }
+};
+
+} // namespace
+
+Regex::Regex(std::string_view pattern, bool icase) {
+  if (pattern.size() > MAX_PATTERN) throw RegexError("regular expression too long");
+  try {
+    Node root = Parser(pattern, icase).parse();
+    Compiler c(prog_, classes_);
+    c.emit(root);
+    c.push({Op::Match});
+    anchored_ = !prog_.empty() && prog_[0].op == Op::Bol;
+  } catch (const NeedsFallback &) {
+    prog_.clear();
+    classes_.clear();
+    auto flags = std::regex::ECMAScript;
+    if (icase) flags |= std::regex::icase;
+    try {
+      fallback_ = std::make_unique<std::regex>(std::string(pattern), flags);
+    } catch (const std::regex_error &e) {
+      throw RegexError(e.what());
+    }
+  }
+}
+
+bool Regex::search(std::string_view text) const {
+  if (fallback_) return std::regex_search(text.begin(), text.end(), *fallback_);
+
+  thread_local VmScratch vm;
+  const size_t n = prog_.size();
+  const size_t len = text.size();
+  bool matched = false;
+
+  auto add = [&](std::vector<uint32_t> &list, uint32_t start, size_t pos) {
+    vm.stack.clear();
+    vm.stack.push_back(start);
+    while (!vm.stack.empty()) {
+      uint32_t pc = vm.stack.back();
+      vm.stack.pop_back();
+      if (vm.seen[pc] == vm.gen) continue;
+      vm.seen[pc] = vm.gen;
+      const Inst &in = prog_[pc];
+      switch (in.op) {
+      case Op::Byte: list.push_back(pc); break;
+      case Op::Match: matched = true; break;
+      case Op::Jmp: vm.stack.push_back(in.x); break;
+      case Op::Split:
+        vm.stack.push_back(in.y);
+        vm.stack.push_back(in.x);
+        break;
+      case Op::Bol:
+        if (pos == 0) vm.stack.push_back(pc + 1);
+        break;
+      case Op::Eol:
+        if (pos == len) vm.stack.push_back(pc + 1);
+        break;
+      case Op::WordB:
+      case Op::NotWordB: {
+        bool before = pos > 0 && is_word((unsigned char)text[pos - 1]);
+        bool after = pos < len && is_word((unsigned char)text[pos]);
+        if ((before != after) == (in.op == Op::WordB)) vm.stack.push_back(pc + 1);
+        break;
+      }
+      }
+    }
+  };
+
+  vm.reset(n);
+  vm.cur.clear();
+  for (size_t pos = 0;; pos++) {
+    // Unanchored search: a new thread starts at every position.
+    if (!anchored_ || pos == 0) add(vm.cur, 0, pos);
+    if (matched) return true;
+    if (pos == len || (anchored_ && vm.cur.empty())) return false;
+
+    auto c = (unsigned char)text[pos];
+    vm.reset(n);
+    vm.next.clear();
+    for (uint32_t pc : vm.cur)
+      if (classes_[prog_[pc].x][c]) add(vm.next, pc + 1, pos + 1);
+    if (matched) return true;
+    vm.cur.swap(vm.next);
+  }
+}
+
+std::shared_ptr<const Regex> RegexCache::get(const std::string &pattern, bool icase) {
+  std::string key;
+  key.reserve(pattern.size() + 2);
+  key += icase ? "i:" : "c:";
+  key += pattern;
+
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto it = map_.find(key);
+    if (it != map_.end()) {
+      lru_.splice(lru_.begin(), lru_, it->second);
+      stats_.hits++;
+      return it->second->second;
+    }
+    stats_.misses++;
+  }
+
+  // Compile outside the lock; a racing miss on the same key just loses.
+  auto re = std::make_shared<const Regex>(pattern, icase);
+
+  std::lock_guard<std::mutex> lk(mu_);
+  auto it = map_.find(key);
+  if (it != map_.end()) return it->second->second;
+  lru_.emplace_front(key, re);
+  map_[std::move(key)] = lru_.begin();
+  while (lru_.size() > capacity_) {
+    map_.erase(lru_.back().first);
+    lru_.pop_back();
+    stats_.evictions++;
+  }
+  return re;
+}
+
+RegexCache::Stats RegexCache::stats() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  Stats s = stats_;
+  s.size = lru_.size();
+  return s;
+}
+
+RegexCache &RegexCache::global() {
+  static RegexCache cache;
+  return cache;
+}
+
+} // namespace wininspect
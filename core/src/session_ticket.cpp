@@ -0,0 +1,133 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "wininspect/session_ticket.hpp"
+#include "wininspect/base64.hpp"
+#include "wininspect/crypto.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace wininspect {
+
+namespace {
+
+// Ticket: [4 key id][12 nonce][16 tag][sealed body], key id little-endian.
+// Body: [16 ticket id][8 expiry ms, little-endian][32 secret][identity].
+constexpr size_t KEY_ID_BYTES = 4;
+constexpr size_t TICKET_ID_BYTES = 16;
+constexpr size_t HEADER_BYTES = KEY_ID_BYTES + crypto::NONCE_BYTES + crypto::TAG_BYTES;
+constexpr size_t BODY_FIXED = TICKET_ID_BYTES + 8 + 32;
+constexpr size_t MAX_IDENTITY = 256;
+
+std::int64_t ms(TicketKeeper::Clock::time_point t) {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(t.time_since_epoch()).count();
+}
+
+void put_le(std::uint8_t *p, std::uint64_t v, int n) {
+  for (int i = 0; i < n; i++) p[i] = (std::uint8_t)(v >> (8 * i));
+}
+
+std::uint64_t get_le(const std::uint8_t *p, int n) {
+  std::uint64_t v = 0;
+  for (int i = 0; i < n; i++) v |= (std::uint64_t)p[i] << (8 * i);
+  return v;
+}
+
+} // namespace
+
+TicketKeeper::TicketKeeper(std::chrono::milliseconds lifetime) : lifetime_(lifetime) {}
+
+TicketKeeper::~TicketKeeper() = default;
+
+bool TicketKeeper::rotate(Clock::time_point now) {
+  if (current_.aead && now - current_.born < lifetime_) return true;
+  std::uint8_t key[32];
+  auto aead = std::make_unique<crypto::CryptoSession>(crypto::Role::Server);
+  bool ok = crypto::random_bytes(key, sizeof(key)) && aead->install_key(key);
+  std::memset(key, 0, sizeof(key));
+  if (!ok) return false;
+  // A current key more than a period old has no live tickets left to keep.
+  if (current_.aead && now - current_.born < 2 * lifetime_)
+    previous_ = std::move(current_);
+  else
+    previous_ = Key{};
+  current_ = Key{next_key_id_++, now, std::move(aead)};
+  return true;
+}
+
+void TicketKeeper::prune(Clock::time_point now) {
+  auto t = ms(now);
+  std::erase_if(redeemed_, [&](const auto &kv) { return kv.second <= t; });
+}
+
+std::string TicketKeeper::issue(const std::string &identity,
+                                std::span<const std::uint8_t> secret, Clock::time_point now) {
+  if (secret.size() != 32 || identity.size() > MAX_IDENTITY) return "";
+  std::lock_guard<std::mutex> lk(mu_);
+  if (!rotate(now)) return "";
+
+  std::vector<std::uint8_t> t(HEADER_BYTES + BODY_FIXED + identity.size());
+  std::uint8_t *body = t.data() + HEADER_BYTES;
+  if (!crypto::random_bytes(body, TICKET_ID_BYTES)) return "";
+  put_le(body + TICKET_ID_BYTES, (std::uint64_t)ms(now + lifetime_), 8);
+  std::memcpy(body + TICKET_ID_BYTES + 8, secret.data(), 32);
+  std::memcpy(body + BODY_FIXED, identity.data(), identity.size());
+
+  put_le(t.data(), current_.id, KEY_ID_BYTES);
+  std::uint8_t *nonce = t.data() + KEY_ID_BYTES;
+  std::uint8_t *tag = nonce + crypto::NONCE_BYTES;
+  if (!crypto::random_bytes(nonce, crypto::NONCE_BYTES)) return "";
+  size_t n = t.size() - HEADER_BYTES;
+  if (!current_.aead->seal_with_nonce(nonce, body, n, body, tag)) return "";
+  return base64::encode(t);
+}
+
+std::optional<TicketClaims> TicketKeeper::redeem(const std::string &ticket,
+                                                 Clock::time_point now) {
+  auto t = base64::decode(ticket);
+  if (t.size() < HEADER_BYTES + BODY_FIXED || t.size() > HEADER_BYTES + BODY_FIXED + MAX_IDENTITY)
+    return std::nullopt;
+  std::lock_guard<std::mutex> lk(mu_);
+  if (!rotate(now)) return std::nullopt;
+
+  auto key_id = (std::uint32_t)get_le(t.data(), KEY_ID_BYTES);
+  Key *k = key_id == current_.id ? &current_ : key_id == previous_.id ? &previous_ : nullptr;
+  if (!k || !k->aead) return std::nullopt; // rotated out
+
+  const std::uint8_t *nonce = t.data() + KEY_ID_BYTES;
+  const std::uint8_t *tag = nonce + crypto::NONCE_BYTES;
+  std::uint8_t *body = t.data() + HEADER_BYTES;
+  if (!k->aead->open_with_nonce(nonce, body, t.size() - HEADER_BYTES, body, tag))
+    return std::nullopt;
+
+  auto expiry = (std::int64_t)get_le(body + TICKET_ID_BYTES, 8);
+  if (expiry <= ms(now)) return std::nullopt;
+  prune(now);
+  if (redeemed_.size() >= MAX_REDEEMED) return std::nullopt;
+  if (!redeemed_.emplace(std::string((const char *)body, TICKET_ID_BYTES), expiry).second)
+    return std::nullopt; // replayed
+
+  TicketClaims c;
+  std::memcpy(c.secret.data(), body + TICKET_ID_BYTES + 8, 32);
+  c.identity.assign((const char *)body + BODY_FIXED, t.size() - HEADER_BYTES - BODY_FIXED);
+  std::memset(t.data(), 0, t.size());
+  return c;
+}
+
+bool TicketKeeper::derive_key(std::span<const std::uint8_t> secret,
+                              std::span<const std::uint8_t> server_nonce,
+                              std::span<const std::uint8_t> client_random, std::uint8_t key[32]) {
+  if (secret.size() != 32 || server_nonce.size() != 32 || client_random.size() != 32)
+    return false;
+  static const char LABEL[] = "wininspect resume key";
+  std::vector<std::uint8_t> in(LABEL, LABEL + sizeof(LABEL) - 1);
+  in.insert(in.end(), secret.begin(), secret.end());
+  in.insert(in.end(), server_nonce.begin(), server_nonce.end());
+  in.insert(in.end(), client_random.begin(), client_random.end());
+  bool ok = crypto::sha256(in, key);
+  std::memset(in.data(), 0, in.size());
+  return ok;
+}
+
+} // namespace wininspect
@@ -0,0 +1,504 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "wininspect/snapshot_journal.hpp"
+#include "wininspect/logger.hpp"
+#include "wininspect/window_index.hpp"
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+namespace wininspect {
+
+static_assert(std::endian::native == std::endian::little,
+              "journal records are written in host byte order");
+
+namespace {
+
+constexpr char FILE_MAGIC[8] = {'W', 'I', 'J', 'R', 'N', 'L', '0', '1'};
+constexpr uint32_t FILE_VERSION = 1;
+constexpr size_t FILE_HEADER = 24;
+constexpr uint32_t REC_MAGIC = 0x43455253;   // "SREC"
+constexpr size_t REC_HEADER = 40;
+constexpr size_t WIN_REC = 24;
+constexpr uint32_t INDEX_MAGIC = 0x584A4957; // "WIJX"
+constexpr size_t INDEX_ENTRY = 32;
+constexpr size_t TRAILER = 24;
+
+template <typename T> T rd(const uint8_t *p) {
+  T v;
+  std::memcpy(&v, p, sizeof(T));
+  return v;
+}
+template <typename T> void put(std::string &out, T v) {
+  out.append(reinterpret_cast<const char *>(&v), sizeof(T));
+}
+
+int64_t now_ms() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+std::string footer(const std::vector<JournalEntry> &entries, uint64_t index_offset) {
+  std::string out;
+  out.reserve(entries.size() * INDEX_ENTRY + TRAILER);
+  for (const auto &e : entries) {
+    put<uint64_t>(out, e.seq);
+    put<int64_t>(out, e.time_ms);
+    put<uint64_t>(out, e.offset);
+    put<uint32_t>(out, e.window_count);
+    put<uint32_t>(out, 0);
+  }
+  put<uint64_t>(out, index_offset);
+  put<uint64_t>(out, entries.size());
+  put<uint32_t>(out, INDEX_MAGIC);
+  put<uint32_t>(out, 0);
+  return out;
+}
+
+std::optional<uint64_t> parse_segment_name(const std::string &name) {
+  // journal-<16 hex>.wij
+  if (name.size() != 28 || name.rfind("journal-", 0) != 0 ||
+      name.compare(24, 4, ".wij") != 0)
+    return std::nullopt;
+  uint64_t v = 0;
+  for (size_t i = 8; i < 24; i++) {
+    char c = name[i];
+    int d = (c >= '0' && c <= '9') ? c - '0'
+          : (c >= 'a' && c <= 'f') ? 10 + (c - 'a') : -1;
+    if (d < 0) return std::nullopt;
+    v = (v << 4) | (uint64_t)d;
+  }
+  return v;
+}
+
+} // namespace
+
+// ── JournalRecord ───────────────────────────────────────────────────────────
+
+JournalWindow JournalRecord::window(uint32_t i) const {
+  JournalWindow w;
+  if (i >= entry_.window_count) return w;
+  const uint8_t *p = windows_ + (size_t)i * WIN_REC;
+  w.hwnd = rd<uint64_t>(p);
+  auto str = [this](uint32_t off, uint32_t len) -> std::string_view {
+    if ((uint64_t)off + len > pool_len_) return {};
+    return {reinterpret_cast<const char *>(pool_ + off), len};
+  };
+  w.title = str(rd<uint32_t>(p + 8), rd<uint32_t>(p + 12));
+  w.class_name = str(rd<uint32_t>(p + 16), rd<uint32_t>(p + 20));
+  return w;
+}
+
+Snapshot JournalRecord::to_snapshot() const {
+  Snapshot s;
+  std::vector<IndexedWindow> indexed;
+  s.top.reserve(size());
+  indexed.reserve(size());
+  for (uint32_t i = 0; i < size(); i++) {
+    auto w = window(i);
+    s.top.push_back(w.hwnd);
+    indexed.push_back({w.hwnd, std::string(w.title), std::string(w.class_name)});
+  }
+  s.index = std::make_shared<WindowIndex>(std::move(indexed));
+  return s;
+}
+
+// ── JournalSegment ──────────────────────────────────────────────────────────
+
+std::shared_ptr<JournalSegment> JournalSegment::open(const std::string &path) {
+  auto seg = std::make_shared<JournalSegment>();
+  seg->path_ = path;
+  seg->map_ = MappedFile(path);
+  const uint8_t *d = seg->map_.data();
+  size_t n = seg->map_.size();
+  if (!seg->map_.valid() || n < FILE_HEADER || std::memcmp(d, FILE_MAGIC, 8) != 0 ||
+      rd<uint32_t>(d + 8) != FILE_VERSION)
+    return nullptr;
+
+  if (n >= FILE_HEADER + TRAILER) {
+    const uint8_t *t = d + n - TRAILER;
+    uint64_t index_off = rd<uint64_t>(t);
+    uint64_t count = rd<uint64_t>(t + 8);
+    if (rd<uint32_t>(t + 16) == INDEX_MAGIC && index_off >= FILE_HEADER &&
+        count <= (n - TRAILER) / INDEX_ENTRY &&
+        index_off + count * INDEX_ENTRY + TRAILER == n) {
+      seg->entries_.reserve((size_t)count);
+      for (uint64_t i = 0; i < count; i++) {
+        const uint8_t *e = d + index_off + i * INDEX_ENTRY;
+        seg->entries_.push_back({rd<uint64_t>(e), rd<int64_t>(e + 8),
+                                 rd<uint32_t>(e + 24), rd<uint64_t>(e + 16)});
+      }
+      seg->sealed_ = true;
+      seg->end_ = index_off;
+      return seg;
+    }
+  }
+
+  // Unsealed (active, or the daemon died): walk the record headers only.
+  uint64_t off = FILE_HEADER;
+  while (off + REC_HEADER <= n) {
+    const uint8_t *r = d + off;
+    uint32_t len = rd<uint32_t>(r + 4);
+    if (rd<uint32_t>(r) != REC_MAGIC || len < REC_HEADER || off + len > n) break;
+    seg->entries_.push_back({rd<uint64_t>(r + 8), rd<int64_t>(r + 16),
+                             rd<uint32_t>(r + 24), off});
+    off += len;
+  }
+  seg->end_ = off;
+  return seg;
+}
+
+std::optional<JournalRecord> JournalSegment::record(uint64_t seq) const {
+  auto find = [this](uint64_t s) -> const JournalEntry * {
+    auto it = std::lower_bound(entries_.begin(), entries_.end(), s,
+                               [](const JournalEntry &e, uint64_t v) { return e.seq < v; });
+    return (it != entries_.end() && it->seq == s) ? &*it : nullptr;
+  };
+  const JournalEntry *e = find(seq);
+  if (!e || e->offset + REC_HEADER > map_.size()) return std::nullopt;
+
+  JournalRecord rec;
+  rec.seg_ = shared_from_this();
+  rec.entry_ = *e;
+
+  const uint8_t *r = map_.data() + e->offset;
+  uint64_t same_as = rd<uint64_t>(r + 32);
+  if (same_as != 0) {
+    e = find(same_as);
+    if (!e || e->offset + REC_HEADER > map_.size()) return std::nullopt;
+    r = map_.data() + e->offset;
+  }
+  uint32_t len = rd<uint32_t>(r + 4);
+  uint32_t count = rd<uint32_t>(r + 24);
+  uint32_t pool_len = rd<uint32_t>(r + 28);
+  if (e->offset + len > map_.size() ||
+      REC_HEADER + (uint64_t)count * WIN_REC + pool_len != len)
+    return std::nullopt;
+
+  rec.entry_.window_count = count;
+  rec.windows_ = r + REC_HEADER;
+  rec.pool_ = rec.windows_ + (size_t)count * WIN_REC;
+  rec.pool_len_ = pool_len;
+  return rec;
+}
+
+// ── SnapshotJournal ─────────────────────────────────────────────────────────
+
+std::string SnapshotJournal::segment_name(uint64_t first_seq) {
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), "journal-%016llx.wij", (unsigned long long)first_seq);
+  return buf;
+}
+
+SnapshotJournal::SnapshotJournal(Options opts) : opts_(std::move(opts)) {
+  std::error_code ec;
+  fs::create_directories(opts_.dir, ec);
+  if (!fs::is_directory(opts_.dir, ec))
+    throw std::runtime_error("journal directory unusable: " + opts_.dir);
+
+  std::vector<std::pair<uint64_t, std::string>> found;
+  for (const auto &de : fs::directory_iterator(opts_.dir, ec)) {
+    auto first = parse_segment_name(de.path().filename().string());
+    if (first) found.emplace_back(*first, de.path().string());
+  }
+  std::sort(found.begin(), found.end());
+
+  for (auto &[first, path] : found) {
+    auto view = JournalSegment::open(path);
+    if (!view) {
+      LOG_WARN("Journal: ignoring unreadable segment " + path);
+      continue;
+    }
+    Segment seg{path, first, view->entries(), nullptr};
+    if (!view->sealed()) {
+      // Left open by a crash: drop any torn tail and seal it in place.
+      uint64_t end = view->end_offset();
+      view.reset(); // unmap before truncating
+      fs::resize_file(path, end, ec);
+      if (std::FILE *f = std::fopen(path.c_str(), "ab")) {
+        auto tail = footer(seg.entries, end);
+        std::fwrite(tail.data(), 1, tail.size(), f);
+        std::fclose(f);
+        LOG_INFO("Journal: recovered unsealed segment " + path);
+      }
+    }
+    if (!seg.entries.empty()) next_seq_ = std::max(next_seq_, seg.entries.back().seq + 1);
+    segments_.push_back(std::move(seg));
+  }
+  stats_.segments = segments_.size();
+  enforce_retention();
+
+  writer_ = std::thread([this] { writer_loop(); });
+}
+
+SnapshotJournal::~SnapshotJournal() {
+  {
+    std::lock_guard<std::mutex> lk(q_mu_);
+    stop_ = true;
+  }
+  q_cv_.notify_all();
+  if (writer_.joinable()) writer_.join();
+}
+
+uint64_t SnapshotJournal::append(const Snapshot &s) {
+  uint64_t seq;
+  {
+    std::lock_guard<std::mutex> lk(q_mu_);
+    if (stop_ || queue_.size() >= opts_.max_queue) {
+      std::lock_guard<std::mutex> slk(mu_);
+      stats_.dropped++;
+      return 0;
+    }
+    seq = next_seq_++;
+    queue_.push_back({seq, now_ms(), s});
+  }
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    stats_.appended++;
+  }
+  q_cv_.notify_one();
+  return seq;
+}
+
+void SnapshotJournal::flush() {
+  std::unique_lock<std::mutex> lk(q_mu_);
+  uint64_t target = next_seq_ - 1;
+  urgent_ = true;
+  q_cv_.notify_one();
+  drained_cv_.wait(lk, [&] { return done_seq_ >= target || !writer_.joinable(); });
+  urgent_ = false;
+}
+
+void SnapshotJournal::writer_loop() {
+  while (true) {
+    std::vector<Pending> batch;
+    {
+      std::unique_lock<std::mutex> lk(q_mu_);
+      q_cv_.wait(lk, [&] { return stop_ || !queue_.empty(); });
+      if (queue_.empty()) break; // stopping and drained
+      // Let a batch build up so bursts cost one write + flush.
+      q_cv_.wait_for(lk, std::chrono::milliseconds(opts_.flush_interval_ms), [&] {
+        return stop_ || urgent_ || queue_.size() >= opts_.max_queue / 2;
+      });
+      batch.assign(std::make_move_iterator(queue_.begin()),
+                   std::make_move_iterator(queue_.end()));
+      queue_.clear();
+    }
+    write_batch(batch);
+    {
+      std::lock_guard<std::mutex> lk(q_mu_);
+      done_seq_ = batch.back().seq;
+    }
+    drained_cv_.notify_all();
+  }
+  seal_active();
+  drained_cv_.notify_all();
+}
+
+void SnapshotJournal::write_batch(std::vector<Pending> &batch) {
+  std::string buf;
+  std::vector<JournalEntry> added;
+
+  for (auto &p : batch) {
+    if (!out_ || out_size_ + buf.size() >= opts_.segment_bytes) {
+      // Flush what we have into the current segment before rotating.
+      if (out_ && !buf.empty()) {
+        std::fwrite(buf.data(), 1, buf.size(), out_);
+        out_size_ += buf.size();
+        buf.clear();
+        std::fflush(out_);
+        std::lock_guard<std::mutex> lk(mu_);
+        auto &ents = segments_.back().entries;
+        ents.insert(ents.end(), added.begin(), added.end());
+        added.clear();
+      }
+      if (out_) seal_active();
+      open_active(p.seq);
+      if (!out_) {
+        std::lock_guard<std::mutex> lk(mu_);
+        stats_.dropped += batch.size();
+        return;
+      }
+    }
+
+    // Pulls titles/classes now if the backend indexes lazily, which keeps
+    // that cost on this thread rather than the request thread.
+    std::string wins, pool;
+    if (p.snap.index) {
+      const auto &ws = p.snap.index->windows();
+      wins.reserve(ws.size() * WIN_REC);
+      for (const auto &w : ws) {
+        put<uint64_t>(wins, w.hwnd);
+        put<uint32_t>(wins, (uint32_t)pool.size());
+        put<uint32_t>(wins, (uint32_t)w.title.size());
+        pool += w.title;
+        put<uint32_t>(wins, (uint32_t)pool.size());
+        put<uint32_t>(wins, (uint32_t)w.class_name.size());
+        pool += w.class_name;
+      }
+    } else {
+      for (auto h : p.snap.top) {
+        put<uint64_t>(wins, h);
+        for (int k = 0; k < 4; k++) put<uint32_t>(wins, 0);
+      }
+    }
+    uint32_t count = (uint32_t)(wins.size() / WIN_REC);
+    // Compared byte for byte: a same_as reference must never stand in for
+    // a snapshot that merely hashes alike.
+    bool same = last_full_seq_ != 0 && wins == last_wins_ && pool == last_pool_;
+    JournalEntry e{p.seq, p.time_ms, count, out_size_ + buf.size()};
+    put<uint32_t>(buf, REC_MAGIC);
+    put<uint32_t>(buf, (uint32_t)(REC_HEADER + (same ? 0 : wins.size() + pool.size())));
+    put<uint64_t>(buf, p.seq);
+    put<int64_t>(buf, p.time_ms);
+    put<uint32_t>(buf, same ? 0 : count);
+    put<uint32_t>(buf, same ? 0 : (uint32_t)pool.size());
+    put<uint64_t>(buf, same ? last_full_seq_ : 0);
+    if (!same) {
+      buf += wins;
+      buf += pool;
+      last_wins_ = std::move(wins);
+      last_pool_ = std::move(pool);
+      last_full_seq_ = p.seq;
+    }
+    added.push_back(e);
+    if (same) {
+      std::lock_guard<std::mutex> lk(mu_);
+      stats_.unchanged++;
+    }
+  }
+
+  if (!buf.empty()) {
+    bool ok = std::fwrite(buf.data(), 1, buf.size(), out_) == buf.size() &&
+              std::fflush(out_) == 0;
+    out_size_ += buf.size();
+    if (!ok) LOG_ERROR("Journal: write failed on " + segments_.back().path);
+  }
+  std::lock_guard<std::mutex> lk(mu_);
+  auto &ents = segments_.back().entries;
+  ents.insert(ents.end(), added.begin(), added.end());
+  stats_.written += batch.size();
+  stats_.batches++;
+}
+
+void SnapshotJournal::open_active(uint64_t first_seq) {
+  std::string path = (fs::path(opts_.dir) / segment_name(first_seq)).string();
+  out_ = std::fopen(path.c_str(), "wb");
+  if (!out_) {
+    LOG_ERROR("Journal: cannot create segment " + path);
+    return;
+  }
+  std::string hdr(FILE_MAGIC, 8);
+  put<uint32_t>(hdr, FILE_VERSION);
+  put<uint32_t>(hdr, 0);
+  put<int64_t>(hdr, now_ms());
+  std::fwrite(hdr.data(), 1, hdr.size(), out_);
+  out_size_ = hdr.size();
+  last_full_seq_ = 0; // same_as references never cross segments
+  last_wins_.clear();
+  last_pool_.clear();
+
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    segments_.push_back({path, first_seq, {}, nullptr});
+    active_ = true;
+    stats_.segments = segments_.size();
+  }
+  enforce_retention();
+}
+
+void SnapshotJournal::seal_active() {
+  if (!out_) return;
+  std::vector<JournalEntry> entries;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    entries = segments_.back().entries;
+  }
+  auto tail = footer(entries, out_size_);
+  std::fwrite(tail.data(), 1, tail.size(), out_);
+  std::fclose(out_);
+  out_ = nullptr;
+  out_size_ = 0;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    active_ = false; // complete now, footer and all
+  }
+  enforce_retention();
+}
+
+void SnapshotJournal::enforce_retention() {
+  if (opts_.max_segments == 0) return;
+  std::vector<std::string> doomed;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    size_t active = active_ ? 1 : 0;
+    while (segments_.size() > opts_.max_segments && segments_.size() > active) {
+      doomed.push_back(segments_.front().path);
+      segments_.erase(segments_.begin());
+    }
+    stats_.segments = segments_.size();
+  }
+  for (const auto &p : doomed) {
+    std::error_code ec;
+    fs::remove(p, ec);
+    LOG_INFO("Journal: retired segment " + p);
+  }
+}
+
+const SnapshotJournal::Segment *SnapshotJournal::find_segment(uint64_t seq) const {
+  auto it = std::upper_bound(segments_.begin(), segments_.end(), seq,
+                             [](uint64_t v, const Segment &s) { return v < s.first_seq; });
+  if (it == segments_.begin()) return nullptr;
+  return &*std::prev(it);
+}
+
+std::vector<JournalEntry> SnapshotJournal::list(int64_t since_ms, int64_t until_ms,
+                                                size_t limit) const {
+  std::vector<JournalEntry> out;
+  std::lock_guard<std::mutex> lk(mu_);
+  for (const auto &seg : segments_)
+    for (const auto &e : seg.entries)
+      if (e.time_ms >= since_ms && e.time_ms <= until_ms) out.push_back(e);
+  if (limit && out.size() > limit) out.erase(out.begin(), out.end() - limit);
+  return out;
+}
+
+std::optional<JournalRecord> SnapshotJournal::record(uint64_t seq) const {
+  std::shared_ptr<JournalSegment> view;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto *seg = find_segment(seq);
+    if (!seg) return std::nullopt;
+    bool active = active_ && seg == &segments_.back();
+    if (!active && seg->view) {
+      view = seg->view;
+    } else {
+      // The active segment grows, so it is mapped afresh for each lookup;
+      // sealed segments are mapped once and kept.
+      view = JournalSegment::open(seg->path);
+      if (view && !active) seg->view = view;
+    }
+  }
+  if (!view) return std::nullopt;
+  return view->record(seq);
+}
+
+std::optional<Snapshot> SnapshotJournal::load(uint64_t seq) const {
+  auto rec = record(seq);
+  if (!rec) return std::nullopt;
+  return rec->to_snapshot();
+}
+
+SnapshotJournal::Stats SnapshotJournal::stats() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return stats_;
+}
+
+} // namespace wininspect
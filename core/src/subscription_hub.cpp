@@ -0,0 +1,176 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "wininspect/subscription_hub.hpp"
+#include <algorithm>
+
+namespace wininspect {
+
+SubscriptionHub::SubscriptionHub(IBackend *backend, size_t ring_capacity)
+    : backend_(backend), capacity_(ring_capacity) {}
+
+std::shared_ptr<FilteredSubscription> SubscriptionHub::subscribe(EventFilter filter,
+                                                                 int debounce_ms) {
+  std::shared_ptr<FilteredSubscription> s(
+      new FilteredSubscription(std::move(filter), std::max(debounce_ms, 0), capacity_));
+  std::lock_guard<std::mutex> lk(mu_);
+  subs_.push_back(s);
+  gen_++;
+  return s;
+}
+
+SubscriptionHub::Stats SubscriptionHub::stats() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return stats_;
+}
+
+SubscriptionHub::Known SubscriptionHub::load(const Snapshot &cur, hwnd_u64 h,
+                                             bool ancestry) {
+  Known k;
+  auto info = backend_->get_info(cur, h);
+  if (!info) return k;
+  k.facts.class_name = info->class_name;
+  k.facts.title = info->title;
+  k.facts.pid = info->pid;
+  if (ancestry) {
+    // Child windows lead to their parent, top-level ones to their owner.
+    hwnd_u64 next = info->parent ? info->parent : info->owner;
+    for (int depth = 0; next && depth < 32; depth++) {
+      if (next == h || std::count(k.facts.ancestors.begin(), k.facts.ancestors.end(), next))
+        break;
+      k.facts.ancestors.push_back(next);
+      auto up = backend_->get_info(cur, next);
+      if (!up) break;
+      next = up->parent ? up->parent : up->owner;
+    }
+  }
+  return k;
+}
+
+void SubscriptionHub::dispatch(const std::vector<Event> &events, const Snapshot &cur,
+                               Clock::time_point now) {
+  std::vector<std::shared_ptr<FilteredSubscription>> subs;
+  uint64_t gen;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto dead = std::remove_if(subs_.begin(), subs_.end(),
+                               [](const auto &w) { return w.expired(); });
+    if (dead != subs_.end()) { subs_.erase(dead, subs_.end()); gen_++; }
+    for (const auto &w : subs_)
+      if (auto s = w.lock()) subs.push_back(std::move(s));
+    gen = gen_;
+    stats_.active = subs.size();
+  }
+
+  bool facts = false, ancestry = false, changes = false;
+  for (const auto &s : subs) {
+    facts |= s->filter_.needs_facts();
+    ancestry |= s->filter_.needs_ancestry();
+    changes |= s->filter_.wants_changes();
+  }
+  facts |= changes; // title tracking compares against the cached title
+
+  if (!facts) {
+    known_.clear();
+    primed_ = false;
+  } else if (!primed_ || (ancestry && !primed_ancestry_)) {
+    // First subscription that needs facts: learn the windows that already
+    // exist, so their destruction can be judged too.
+    known_.clear();
+    for (auto h : cur.top) known_.emplace(h, load(cur, h, ancestry));
+    primed_ = true;
+    primed_ancestry_ = ancestry;
+    seen_gen_ = gen - 1;
+  }
+
+  auto rewatch = [&](hwnd_u64 h, Known &k) {
+    k.watched = false;
+    for (const auto &s : subs) {
+      if (s->filter_.wants_changes() && s->filter_.matches_static(h, k.facts)) {
+        k.watched = true;
+        return;
+      }
+    }
+  };
+
+  std::vector<Event> out(events.begin(), events.end());
+  if (facts) {
+    for (const auto &e : events) {
+      if (e.type == "window.created") {
+        auto &k = known_[e.hwnd] = load(cur, e.hwnd, primed_ancestry_);
+        if (changes) rewatch(e.hwnd, k);
+      } else if (e.type == "window.changed" && e.property == "title") {
+        // Pushed by an event source: take the new title now so the
+        // polling below does not report the same change again.
+        auto it = known_.find(e.hwnd);
+        auto info = it == known_.end() ? std::nullopt : backend_->get_info(cur, e.hwnd);
+        if (info) it->second.facts.title = info->title;
+      }
+    }
+    if (seen_gen_ != gen) {
+      for (auto &[h, k] : known_) rewatch(h, k);
+      seen_gen_ = gen;
+    }
+  }
+
+  size_t watched = 0;
+  if (changes) {
+    for (auto &[h, k] : known_) {
+      if (!k.watched) continue;
+      watched++;
+      auto info = backend_->get_info(cur, h);
+      if (info && info->title != k.facts.title) {
+        k.facts.title = info->title;
+        out.push_back({0, "window.changed", h, "title"});
+      }
+    }
+  }
+
+  uint64_t delivered = 0, rejected = 0, debounced = 0;
+  for (const auto &s : subs) {
+    for (const auto &e : out) {
+      if (e.type == "window.destroyed") {
+        auto &p = s->pending_;
+        for (auto it = p.lower_bound({e.hwnd, ""}); it != p.end() && it->first.first == e.hwnd;)
+          it = p.erase(it);
+      }
+      const WindowFacts *f = nullptr;
+      if (facts) {
+        auto it = known_.find(e.hwnd);
+        if (it != known_.end()) f = &it->second.facts;
+      }
+      if (!s->filter_.matches(e, f)) { rejected++; continue; }
+
+      if (e.type == "window.changed" && s->debounce_ms_ > 0) {
+        // The first change opens the window; later ones only replace the
+        // event, so a property that never stops changing is still reported.
+        auto due = now + std::chrono::milliseconds(s->debounce_ms_);
+        auto [it, fresh] = s->pending_.try_emplace({e.hwnd, e.property}, e, due);
+        if (!fresh) { it->second.first = e; debounced++; }
+        continue;
+      }
+      Event copy = e;
+      s->ring_.push(copy);
+      delivered++;
+    }
+    for (auto it = s->pending_.begin(); it != s->pending_.end();) {
+      if (it->second.second > now) { ++it; continue; }
+      s->ring_.push(it->second.first);
+      delivered++;
+      it = s->pending_.erase(it);
+    }
+  }
+
+  if (facts) {
+    for (const auto &e : events)
+      if (e.type == "window.destroyed") known_.erase(e.hwnd);
+  }
+
+  std::lock_guard<std::mutex> lk(mu_);
+  stats_.delivered += delivered;
+  stats_.filtered += rejected;
+  stats_.debounced += debounced;
+  stats_.watched = watched;
+}
+
+} // namespace wininspect
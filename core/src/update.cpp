@@ -1,17 +1,9 @@
 // SPDX-License-Identifier: Apache-2.0
 // Copyright (c) 2026 Mark E. DeYoung
 
-#ifdef _WIN32
-#include <windows.h>
-#include <winhttp.h>
+#include "wininspect/update.hpp"
 #include <sstream>
 #include <vector>
-#include <cstdlib>
-
-#include "wininspect/update.hpp"
-#include "wininspect/tinyjson.hpp"
-
-#pragma comment(lib, "winhttp.lib")
 
 namespace wininspect::update {
 
@@ -47,6 +39,19 @@ int compare_versions(const std::vector<int> &a, const std::vector<int> &b) {
   return 0;
 }
 
+} // namespace wininspect::update
+
+#ifdef _WIN32
+#include <windows.h>
+#include <winhttp.h>
+#include <cstdlib>
+
+#include "wininspect/tinyjson.hpp"
+
+#pragma comment(lib, "winhttp.lib")
+
+namespace wininspect::update {
+
 // Helper: make an HTTPS GET request and return the response body
 static std::string https_get(const std::wstring &host, const std::wstring &path) {
   std::string body;
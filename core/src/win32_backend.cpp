@@ -1,11 +1,13 @@
-#include "wininspect/base64.hpp"
 #include "wininspect/network_config.hpp"
 // SPDX-License-Identifier: Apache-2.0
 // Copyright (c) 2026 Mark E. DeYoung
 
 #include "wininspect/win32_backend.hpp"
+#include "wininspect/mapped_file.hpp"
 #include "wininspect/util_win32.hpp"
 #include "wininspect/update.hpp"
+#include "wininspect/window_index.hpp"
+#include "wininspect/win_event_source.hpp"
 
 // MinGW compatibility: UIA header spells this TreeScope_SubTree (capital T)
 // while MSVC uses TreeScope_Subtree. Keep both happy.
@@ -15,11 +17,10 @@
 
 #include <chrono>
 #include <thread>
-#include <regex>
-#include <tlhelp32.h>
-#include <winsvc.h>
 
 #ifdef _WIN32
+#include <tlhelp32.h>
+#include <winsvc.h>
 #include <uiautomation.h>
 #include <comdef.h>
 #include <psapi.h>
@@ -147,6 +148,14 @@ Snapshot Win32Backend::capture_snapshot() {
         return TRUE;
       },
       reinterpret_cast<LPARAM>(&s.top));
+  // Titles and classes are only pulled (cross-process) if someone searches
+  // this snapshot.
+  s.index = std::make_shared<WindowIndex>(s.top, [](hwnd_u64 h) {
+    IndexedWindow iw;
+    iw.title = w2u8(get_window_text_w(from_u64(h)));
+    iw.class_name = w2u8(get_class_name_w(from_u64(h)));
+    return iw;
+  });
   return s;
 }
 
@@ -386,12 +395,6 @@ std::optional<std::pair<int,int>> Win32Backend::get_z_order(hwnd_u64 hwnd) {
   return std::make_pair(z, count);
 }
 
-std::string Color::to_hex() const {
-  char buf[8];
-  snprintf(buf, sizeof(buf), "#%02X%02X%02X", r, g, b);
-  return buf;
-}
-
 bool Win32Backend::set_property(hwnd_u64 hwnd_u, const std::string &name,
                                 const std::string &value) {
   HWND hwnd = from_u64(hwnd_u);
@@ -773,7 +776,7 @@ std::optional<ScreenCapture> Win32Backend::try_dxgi_capture(Rect region) {
   ScreenCapture sc;
   sc.width = cap_w;
   sc.height = cap_h;
-  sc.data_b64 = base64::encode(buffer);
+  sc.data = std::move(buffer);
   return sc;
 }
 
@@ -821,7 +824,7 @@ std::optional<ScreenCapture> Win32Backend::capture_screen(Rect region) {
   ScreenCapture sc;
   sc.width = w;
   sc.height = h;
-  sc.data_b64 = base64::encode(buffer);
+  sc.data = std::move(buffer);
 
   DeleteObject(hbm);
   DeleteDC(hdcMem);
@@ -843,18 +846,17 @@ std::optional<FileInfo> Win32Backend::get_file_info(const std::string &path) {
   return fi;
 }
 
-std::optional<std::string> Win32Backend::read_file_content(const std::string &path) {
-  std::wstring wpath(path.begin(), path.end());
-  SafeHandle h = CreateFileW(wpath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
-                         OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
-  if (!h.is_valid()) return std::nullopt;
-
-  DWORD size = GetFileSize(h, NULL);
-  std::string out;
-  out.resize(size);
-  DWORD read;
-  ReadFile(h, out.data(), size, &read, NULL);
-  return out;
+std::optional<FileChunk> Win32Backend::read_file_range(const std::string &path, uint64_t offset,
+                                                       size_t length) {
+  // Maps only the requested window, so a read costs the same at any offset
+  // of any size of file, and a log still being written can be followed.
+  MappedFile m(path, offset, length);
+  if (!m.opened()) return std::nullopt;
+  FileChunk c;
+  c.offset = offset;
+  c.file_size = m.file_size();
+  if (m.valid()) c.data.assign(m.data(), m.data() + m.size());
+  return c;
 }
 
 static HKEY parse_hkey(const std::string &path, std::string &subpath) {
@@ -871,27 +873,8 @@ static HKEY parse_hkey(const std::string &path, std::string &subpath) {
 
 std::vector<hwnd_u64> Win32Backend::find_windows_regex(const std::string &title_re,
                                                        const std::string &class_re) {
-  std::vector<hwnd_u64> out;
-  std::regex re_t(title_re), re_c(class_re);
-
-  struct RegexParam {
-    std::vector<hwnd_u64> *out;
-    std::regex *re_t;
-    std::regex *re_c;
-  } p = { &out, &re_t, &re_c };
-
-  EnumWindows([](HWND h, LPARAM lp) -> BOOL {
-    auto* p = reinterpret_cast<RegexParam*>(lp);
-    std::string title = w2u8(get_window_text_w(h));
-    std::string cls = w2u8(get_class_name_w(h));
-
-    if (std::regex_search(title, *(p->re_t)) && std::regex_search(cls, *(p->re_c))) {
-      p->out->push_back(to_u64(h));
-    }
-    return TRUE;
-  }, reinterpret_cast<LPARAM>(&p));
-
-  return out;
+  auto s = capture_snapshot();
+  return s.index->find({title_re, class_re});
 }
 
 std::optional<RegistryKeyInfo> Win32Backend::reg_read(const std::string &path) {
@@ -1216,7 +1199,7 @@ std::optional<MemoryRegion> Win32Backend::mem_read(uint32_t pid, uint64_t addres
     MemoryRegion mr;
     mr.address = address;
     buffer.resize(read);
-    mr.data_b64 = base64::encode(buffer);
+    mr.data = std::move(buffer);
     return mr;
   }
   return std::nullopt;
@@ -1777,6 +1760,10 @@ std::vector<Event> Win32Backend::poll_events(const Snapshot &old_snap,
   return out;
 }
 
+std::unique_ptr<IEventSource> Win32Backend::create_event_source() {
+  return std::make_unique<WinEventSource>();
+}
+
 update::UpdateInfo Win32Backend::check_for_update() {
   return update::check_for_update(std::string(WININSPECT_VERSION));
 }
@@ -1859,5 +1846,6 @@ std::vector<Event> Win32Backend::poll_events(const Snapshot &,
                                              const Snapshot &) {
   return {};
 }
+std::unique_ptr<IEventSource> Win32Backend::create_event_source() { return nullptr; }
 } // namespace wininspect
 #endif
@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "wininspect/win_event_source.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+
+namespace wininspect {
+
+namespace {
+
+// The hook procedure has no user pointer; out-of-context callbacks run on
+// the thread that installed the hook, so a thread-local is enough.
+thread_local IEventSource::Sink *t_sink = nullptr;
+
+void CALLBACK win_event_proc(HWINEVENTHOOK, DWORD event, HWND hwnd, LONG id_object,
+                             LONG id_child, DWORD, DWORD) {
+  if (!t_sink || !hwnd || id_object != OBJID_WINDOW || id_child != CHILDID_SELF) return;
+
+  const char *type = "window.changed";
+  const char *prop = "";
+  switch (event) {
+  case EVENT_OBJECT_CREATE: type = "window.created"; break;
+  case EVENT_OBJECT_DESTROY: type = "window.destroyed"; break;
+  case EVENT_OBJECT_NAMECHANGE: prop = "title"; break;
+  case EVENT_OBJECT_LOCATIONCHANGE: prop = "rect"; break;
+  case EVENT_OBJECT_SHOW:
+  case EVENT_OBJECT_HIDE: prop = "visible"; break;
+  default: return;
+  }
+  // Top-level only (children of the desktop; this also excludes
+  // message-only windows). Not checkable once a window is destroyed.
+  if (event != EVENT_OBJECT_DESTROY && GetAncestor(hwnd, GA_PARENT) != GetDesktopWindow())
+    return;
+
+  std::vector<Event> ev{{0, type, (hwnd_u64)(uintptr_t)hwnd, prop}};
+  (*t_sink)(ev);
+}
+
+} // namespace
+
+WinEventSource::~WinEventSource() { stop(); }
+
+bool WinEventSource::start(Sink sink) {
+  if (thread_.joinable()) return false;
+  sink_ = std::move(sink);
+  std::promise<bool> hooked;
+  auto f = hooked.get_future();
+  thread_ = std::thread([this, &hooked] { run(&hooked); });
+  if (!f.get()) {
+    thread_.join();
+    return false;
+  }
+  return true;
+}
+
+void WinEventSource::stop() {
+  if (!thread_.joinable()) return;
+  PostThreadMessageW(thread_id_.load(), WM_QUIT, 0, 0);
+  thread_.join();
+}
+
+void WinEventSource::run(std::promise<bool> *hooked) {
+  // Create the message queue before anyone can PostThreadMessage to us.
+  MSG msg;
+  PeekMessageW(&msg, nullptr, WM_USER, WM_USER, PM_NOREMOVE);
+  thread_id_ = GetCurrentThreadId();
+  t_sink = &sink_;
+
+  HWINEVENTHOOK hook =
+      SetWinEventHook(EVENT_OBJECT_CREATE, EVENT_OBJECT_NAMECHANGE, nullptr, win_event_proc,
+                      0, 0, WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS);
+  hooked->set_value(hook != nullptr);
+  if (!hook) return;
+
+  while (GetMessageW(&msg, nullptr, 0, 0) > 0) {
+    TranslateMessage(&msg);
+    DispatchMessageW(&msg);
+  }
+  UnhookWinEvent(hook);
+  t_sink = nullptr;
+}
+
+} // namespace wininspect
+#else
+namespace wininspect {
+WinEventSource::~WinEventSource() = default;
+bool WinEventSource::start(Sink) { return false; }
+void WinEventSource::stop() {}
+void WinEventSource::run(std::promise<bool> *hooked) { hooked->set_value(false); }
+} // namespace wininspect
+#endif
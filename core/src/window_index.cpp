@@ -0,0 +1,305 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "wininspect/window_index.hpp"
+#include "wininspect/regex_engine.hpp"
+#include <algorithm>
+#include <cctype>
+
+namespace wininspect {
+
+std::optional<MatchMode> match_mode_from_str(const std::string &s) {
+  if (s == "regex") return MatchMode::Regex;
+  if (s == "substring") return MatchMode::Substring;
+  if (s == "prefix") return MatchMode::Prefix;
+  if (s == "exact") return MatchMode::Exact;
+  return std::nullopt;
+}
+
+static std::string ascii_fold(const std::string &s) {
+  std::string out(s);
+  for (auto &c : out)
+    if (c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+  return out;
+}
+
+static uint32_t trigram(const char *p) {
+  return ((uint32_t)(unsigned char)p[0] << 16) |
+         ((uint32_t)(unsigned char)p[1] << 8) | (uint32_t)(unsigned char)p[2];
+}
+
+// Skip a quantifier ("*", "+", "?", "{m,n}", each optionally lazy) at i.
+static size_t skip_quantifier(const std::string &re, size_t i) {
+  if (i >= re.size()) return i;
+  if (re[i] == '*' || re[i] == '+' || re[i] == '?') {
+    i++;
+  } else if (re[i] == '{') {
+    auto close = re.find('}', i);
+    i = (close == std::string::npos) ? re.size() : close + 1;
+  } else {
+    return i;
+  }
+  if (i < re.size() && re[i] == '?') i++;
+  return i;
+}
+
+// Conservatively extract literal runs that every match of an ECMAScript
+// regex must contain. Anything we don't fully understand breaks the current
+// run; a top-level alternation means no literal is mandatory, so we return
+// nothing and the caller falls back to a scan.
+static std::vector<std::string> regex_literals(const std::string &re) {
+  std::vector<std::string> out;
+  std::string run;
+  int depth = 0;
+  auto flush = [&] {
+    if (!run.empty()) out.push_back(run);
+    run.clear();
+  };
+
+  size_t i = 0;
+  while (i < re.size()) {
+    char c = re[i];
+    std::optional<char> lit;
+
+    if (c == '|') {
+      if (depth == 0) return {};
+      i++;
+      continue;
+    }
+    if (c == '(') {
+      flush();
+      depth++;
+      i++;
+      if (i < re.size() && re[i] == '?') i += 2; // (?: (?= (?!
+      continue;
+    }
+    if (c == ')') {
+      flush();
+      if (depth > 0) depth--;
+      i = skip_quantifier(re, i + 1);
+      continue;
+    }
+    if (c == '[') {
+      flush();
+      i++;
+      if (i < re.size() && re[i] == '^') i++;
+      if (i < re.size() && re[i] == ']') i++;
+      while (i < re.size() && re[i] != ']') i += (re[i] == '\\') ? 2 : 1;
+      i = skip_quantifier(re, i + 1);
+      continue;
+    }
+    if (c == '.' || c == '^' || c == '$' || c == '*' || c == '+' ||
+        c == '?' || c == '{') {
+      flush();
+      i = skip_quantifier(re, i + 1);
+      continue;
+    }
+    if (c == '\\') {
+      if (i + 1 >= re.size()) return {};
+      char e = re[i + 1];
+      i += 2;
+      if (std::isalnum((unsigned char)e)) {
+        // Class escapes, assertions, back-references and code-unit escapes
+        // are never treated as literals; just consume them whole.
+        if (e == 'x') i += 2;
+        else if (e == 'u') i += 4;
+        else if (e == 'c') i += 1;
+        else if (std::isdigit((unsigned char)e))
+          while (i < re.size() && std::isdigit((unsigned char)re[i])) i++;
+        flush();
+        i = skip_quantifier(re, std::min(i, re.size()));
+        continue;
+      }
+      lit = e;
+    } else {
+      lit = c;
+      i++;
+    }
+
+    // A literal atom: its quantifier decides whether it is mandatory.
+    char q = i < re.size() ? re[i] : '\0';
+    if (q == '*' || q == '?' || q == '{') {
+      flush();
+      i = skip_quantifier(re, i);
+    } else if (q == '+') {
+      if (depth == 0) run.push_back(*lit);
+      flush();
+      i = skip_quantifier(re, i);
+    } else if (depth == 0) {
+      run.push_back(*lit);
+    }
+  }
+  flush();
+  return out;
+}
+
+static bool matches_all(const WindowQuery &q, const std::string &pattern) {
+  return pattern.empty() || (q.mode == MatchMode::Regex && pattern == ".*");
+}
+
+WindowIndex::WindowIndex(std::vector<IndexedWindow> windows)
+    : w_(std::move(windows)) {}
+
+WindowIndex::WindowIndex(std::vector<hwnd_u64> hwnds, Loader loader)
+    : pending_(std::move(hwnds)), loader_(std::move(loader)) {}
+
+const std::vector<IndexedWindow> &WindowIndex::windows() const {
+  ensure_built();
+  return w_;
+}
+
+size_t WindowIndex::size() const {
+  return loader_ ? pending_.size() : w_.size();
+}
+
+void WindowIndex::ensure_built() const {
+  std::call_once(built_, [this] { build(); });
+}
+
+void WindowIndex::build() const {
+  if (loader_) {
+    w_.reserve(pending_.size());
+    for (auto h : pending_) {
+      auto iw = loader_(h);
+      iw.hwnd = h;
+      w_.push_back(std::move(iw));
+    }
+  }
+
+  auto index_field = [this](Field &f, std::string IndexedWindow::*member) {
+    f.folded.reserve(w_.size());
+    std::vector<uint64_t> pairs; // (trigram << 32) | window id
+    for (uint32_t id = 0; id < (uint32_t)w_.size(); id++) {
+      f.folded.push_back(ascii_fold(w_[id].*member));
+      const auto &s = f.folded.back();
+      for (size_t j = 0; j + 3 <= s.size(); j++)
+        pairs.push_back(((uint64_t)trigram(&s[j]) << 32) | id);
+    }
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+    f.ids.reserve(pairs.size());
+    for (size_t j = 0; j < pairs.size();) {
+      uint32_t key = (uint32_t)(pairs[j] >> 32);
+      uint32_t begin = (uint32_t)f.ids.size();
+      for (; j < pairs.size() && (uint32_t)(pairs[j] >> 32) == key; j++)
+        f.ids.push_back((uint32_t)pairs[j]);
+      f.postings.emplace(key, std::make_pair(begin, (uint32_t)f.ids.size()));
+    }
+  };
+  index_field(title_, &IndexedWindow::title);
+  index_field(class_, &IndexedWindow::class_name);
+}
+
+std::optional<std::vector<uint32_t>>
+WindowIndex::candidates(const Field &f,
+                        const std::vector<std::string> &literals) const {
+  std::vector<std::pair<uint32_t, uint32_t>> lists;
+  for (const auto &lit : literals) {
+    auto folded = ascii_fold(lit);
+    for (size_t j = 0; j + 3 <= folded.size(); j++) {
+      auto it = f.postings.find(trigram(&folded[j]));
+      if (it == f.postings.end()) return std::vector<uint32_t>{};
+      lists.push_back(it->second);
+    }
+  }
+  if (lists.empty()) return std::nullopt;
+
+  // Intersect shortest-first so the working set only ever shrinks.
+  std::sort(lists.begin(), lists.end(), [](const auto &a, const auto &b) {
+    return (a.second - a.first) < (b.second - b.first);
+  });
+  lists.erase(std::unique(lists.begin(), lists.end()), lists.end());
+
+  std::vector<uint32_t> cur(f.ids.begin() + lists[0].first,
+                            f.ids.begin() + lists[0].second);
+  std::vector<uint32_t> next;
+  for (size_t k = 1; k < lists.size() && !cur.empty(); k++) {
+    next.clear();
+    std::set_intersection(cur.begin(), cur.end(), f.ids.begin() + lists[k].first,
+                          f.ids.begin() + lists[k].second,
+                          std::back_inserter(next));
+    cur.swap(next);
+  }
+  return cur;
+}
+
+std::vector<hwnd_u64> WindowIndex::find(const WindowQuery &q,
+                                        WindowQueryStats *stats) const {
+  ensure_built();
+
+  struct Matcher {
+    const WindowQuery &q;
+    const std::string &pattern;
+    std::string folded_pattern;
+    std::shared_ptr<const Regex> re;
+
+    Matcher(const WindowQuery &query, const std::string &p)
+        : q(query), pattern(p), folded_pattern(ascii_fold(p)) {
+      if (q.mode == MatchMode::Regex)
+        re = RegexCache::global().get(pattern, q.case_insensitive);
+    }
+
+    bool operator()(const std::string &text, const std::string &folded) const {
+      const auto &hay = q.case_insensitive ? folded : text;
+      const auto &needle = q.case_insensitive ? folded_pattern : pattern;
+      switch (q.mode) {
+      case MatchMode::Regex: return re->search(text);
+      case MatchMode::Substring: return hay.find(needle) != std::string::npos;
+      case MatchMode::Prefix: return hay.compare(0, needle.size(), needle) == 0;
+      case MatchMode::Exact: return hay == needle;
+      }
+      return false;
+    }
+  };
+
+  std::optional<Matcher> title_m, class_m;
+  std::optional<std::vector<uint32_t>> cand;
+  bool narrowed = false;
+
+  auto constrain = [&](const Field &f, const std::string &pattern,
+                       std::optional<Matcher> &m) {
+    if (matches_all(q, pattern)) return;
+    m.emplace(q, pattern);
+    auto lits = q.mode == MatchMode::Regex ? regex_literals(pattern)
+                                           : std::vector<std::string>{pattern};
+    auto c = candidates(f, lits);
+    if (!c) return;
+    narrowed = true;
+    if (!cand) {
+      cand = std::move(*c);
+    } else {
+      std::vector<uint32_t> both;
+      std::set_intersection(cand->begin(), cand->end(), c->begin(), c->end(),
+                            std::back_inserter(both));
+      cand = std::move(both);
+    }
+  };
+  constrain(title_, q.title, title_m);
+  constrain(class_, q.class_name, class_m);
+
+  std::vector<hwnd_u64> out;
+  auto check = [&](uint32_t id) {
+    if (title_m && !(*title_m)(w_[id].title, title_.folded[id])) return;
+    if (class_m && !(*class_m)(w_[id].class_name, class_.folded[id])) return;
+    out.push_back(w_[id].hwnd);
+  };
+
+  size_t considered = 0;
+  if (cand) {
+    considered = cand->size();
+    for (auto id : *cand) check(id);
+  } else {
+    considered = w_.size();
+    for (uint32_t id = 0; id < (uint32_t)w_.size(); id++) check(id);
+  }
+
+  if (stats) {
+    stats->candidates = considered;
+    stats->matched = out.size();
+    stats->full_scan = !narrowed && (title_m || class_m);
+  }
+  return out;
+}
+
+} // namespace wininspect
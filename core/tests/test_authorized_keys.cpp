@@ -0,0 +1,110 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "doctest/doctest.h"
+#include "wininspect/authorized_keys.hpp"
+#include <filesystem>
+#include <fstream>
+
+using namespace wininspect;
+
+namespace {
+
+const std::string TEST_KEY = "AAAAC3NzaC1lZDI1NTE5AAAAIEkYdjCD2Xgej+vVkM5TIx+RVKP44xIjL+fU6046wib1";
+// 00 01 .. 1f: well-formed, but nobody holds its private half.
+const std::string OTHER_KEY = "AAAAC3NzaC1lZDI1NTE5AAAAIAABAgMEBQYHCAkKCwwNDg8QERITFBUWFxgZGhscHR4f";
+const std::string SIG = "UpFCJ9hd6ZMsi45mVk0fjr9Nn8ZYQao+8XRtuhmIb3yLSrdLTRO/ryR65d8SQI2kXCXS+"
+                        "O+SwsBDDQce0zCzBw==";
+
+std::vector<std::uint8_t> nonce() {
+  std::string n = "wininspect-test-nonce";
+  return std::vector<std::uint8_t>(n.begin(), n.end());
+}
+
+void write_file(const std::filesystem::path &p, const std::string &text) {
+  std::ofstream f(p, std::ios::binary | std::ios::trunc);
+  f << text;
+}
+
+} // namespace
+
+DOCTEST_TEST_CASE("AuthorizedKeys: parses options and comments, skips bad lines") {
+  auto ak = AuthorizedKeys::parse(
+      "# operators\n"
+      "\n"
+      "ssh-ed25519 " + TEST_KEY + " wininspect-test\r\n"
+      "from=\"10.0.0.0/8\",no-pty ssh-ed25519 " + OTHER_KEY + " ops team\n"
+      "ssh-rsa AAAAB3NzaC1yc2EAAAADAQABAAABAQ rsa-user\n"
+      "ssh-ed25519 AAAAC3NzaC1lZDI1NTE5AAAAHwAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA= short\n"
+      "ssh-ed25519 " + TEST_KEY + "\n"
+      "ssh-ed25519 not-base64!! broken\n");
+  DOCTEST_REQUIRE_EQ(ak.keys(), 2u);
+  DOCTEST_REQUIRE_EQ(ak.identities(), 2u);
+  DOCTEST_REQUIRE_EQ(ak.skipped(), 4u);
+  DOCTEST_REQUIRE_EQ(ak.find("wininspect-test").size(), 1u);
+  DOCTEST_REQUIRE_EQ(ak.find("ops team").size(), 1u); // the whole comment is the identity
+  DOCTEST_REQUIRE(ak.find("rsa-user").empty());
+}
+
+DOCTEST_TEST_CASE("AuthorizedKeys: identities match exactly") {
+  auto ak = AuthorizedKeys::parse("ssh-ed25519 " + TEST_KEY + " wininspect-test\n");
+  DOCTEST_REQUIRE(!ak.find("wininspect-test").empty());
+  DOCTEST_REQUIRE(ak.find("wininspect").empty());
+  DOCTEST_REQUIRE(ak.find("test").empty());
+  DOCTEST_REQUIRE(ak.find("wininspect-test2").empty());
+  DOCTEST_REQUIRE(ak.find("ssh-ed25519").empty());
+  DOCTEST_REQUIRE(ak.find("").empty());
+}
+
+DOCTEST_TEST_CASE("AuthorizedKeys: verifies against any of an identity's keys") {
+  if (std::string(crypto::backend_name()) == "none") return;
+  auto msg = nonce();
+  auto ak = AuthorizedKeys::parse("ssh-ed25519 " + OTHER_KEY + " wininspect-test\n"
+                                  "ssh-ed25519 " + TEST_KEY + " wininspect-test\n"
+                                  "ssh-ed25519 " + TEST_KEY + " someone-else-prefix\n");
+  DOCTEST_REQUIRE_EQ(ak.find("wininspect-test").size(), 2u);
+  DOCTEST_REQUIRE(ak.verify("wininspect-test", msg, SIG));
+  DOCTEST_REQUIRE(!ak.verify("wininspect", msg, SIG));
+  DOCTEST_REQUIRE(!ak.verify("wininspect-test", msg, "AAAA"));
+  msg.back() ^= 1;
+  DOCTEST_REQUIRE(!ak.verify("wininspect-test", msg, SIG));
+
+  // Lookup cost does not grow with the file.
+  std::string big;
+  for (int i = 0; i < 5000; i++) big += "ssh-ed25519 " + OTHER_KEY + " user" + std::to_string(i) + "\n";
+  big += "ssh-ed25519 " + TEST_KEY + " wininspect-test\n";
+  auto many = AuthorizedKeys::parse(big);
+  DOCTEST_REQUIRE_EQ(many.identities(), 5001u);
+  DOCTEST_REQUIRE(many.verify("wininspect-test", nonce(), SIG));
+}
+
+DOCTEST_TEST_CASE("AuthorizedKeysFile: reloads when the file changes") {
+  auto path = std::filesystem::temp_directory_path() / "wininspect_test_authorized_keys";
+  write_file(path, "ssh-ed25519 " + TEST_KEY + " alice\n");
+  AuthorizedKeysFile file(path, std::chrono::milliseconds(0));
+  auto first = file.current();
+  DOCTEST_REQUIRE(!first->find("alice").empty());
+  DOCTEST_REQUIRE(file.current() == first); // unchanged: same index
+
+  // Different size, so the change is seen even within the mtime granularity.
+  write_file(path, "ssh-ed25519 " + TEST_KEY + " bob\nssh-ed25519 " + OTHER_KEY + " carol\n");
+  auto second = file.current();
+  DOCTEST_REQUIRE(second->find("alice").empty());
+  DOCTEST_REQUIRE(!second->find("bob").empty());
+  DOCTEST_REQUIRE(!first->find("alice").empty()); // held snapshots stay valid
+
+  // Gone means nobody is authorized.
+  std::filesystem::remove(path);
+  DOCTEST_REQUIRE_EQ(file.current()->keys(), 0u);
+  write_file(path, "ssh-ed25519 " + TEST_KEY + " alice\n");
+  DOCTEST_REQUIRE(!file.current()->find("alice").empty());
+  std::filesystem::remove(path);
+
+  // A long recheck interval serves the cached index between checks.
+  write_file(path, "ssh-ed25519 " + TEST_KEY + " alice\n");
+  AuthorizedKeysFile slow(path, std::chrono::hours(1));
+  DOCTEST_REQUIRE(!slow.current()->find("alice").empty());
+  write_file(path, "ssh-ed25519 " + TEST_KEY + " bob-and-more\n");
+  DOCTEST_REQUIRE(!slow.current()->find("alice").empty());
+  std::filesystem::remove(path);
+}
@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "doctest/doctest.h"
+#include "wininspect/capture_coalescer.hpp"
+#include "wininspect/fake_backend.hpp"
+#include <thread>
+#include <vector>
+
+using namespace wininspect;
+
+static FakeBackend make_backend() {
+  return FakeBackend({{0x10, 0, 0, "Untitled - Notepad", "Notepad", true},
+                      {0x20, 0, 0, "Calculator", "CalcFrame", true}});
+}
+
+DOCTEST_TEST_CASE("capture coalescer: reuse within the freshness window") {
+  auto fb = make_backend();
+  CaptureCoalescer cc(&fb, 60000);
+  auto a = cc.capture();
+  auto b = cc.capture();
+  DOCTEST_REQUIRE(!a.shared);
+  DOCTEST_REQUIRE(b.shared);
+  DOCTEST_REQUIRE(a.snap == b.snap);
+  DOCTEST_REQUIRE_EQ(a.snap->top.size(), 2u);
+  auto st = cc.stats();
+  DOCTEST_REQUIRE_EQ(st.requests, 2u);
+  DOCTEST_REQUIRE_EQ(st.captures, 1u);
+  DOCTEST_REQUIRE_EQ(st.fresh, 1u);
+}
+
+DOCTEST_TEST_CASE("capture coalescer: concurrent callers share one capture") {
+  auto fb = make_backend();
+  CaptureCoalescer cc(&fb, 60000);
+  std::vector<std::shared_ptr<const Snapshot>> got(16);
+  std::vector<std::thread> ts;
+  for (size_t i = 0; i < got.size(); i++)
+    ts.emplace_back([&, i] { got[i] = cc.capture().snap; });
+  for (auto &t : ts) t.join();
+  for (auto &g : got) DOCTEST_REQUIRE(g == got[0]);
+  auto st = cc.stats();
+  DOCTEST_REQUIRE_EQ(st.captures, 1u);
+  DOCTEST_REQUIRE_EQ(st.joined + st.fresh, 15u);
+}
+
+DOCTEST_TEST_CASE("capture coalescer: zero window only shares in-flight, negative disables") {
+  auto fb = make_backend();
+  CaptureCoalescer zero(&fb, 0);
+  auto a = zero.capture();
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  auto b = zero.capture();
+  DOCTEST_REQUIRE(a.snap != b.snap);
+
+  CaptureCoalescer off(&fb, -1);
+  for (int i = 0; i < 5; i++) DOCTEST_REQUIRE(!off.capture().shared);
+  DOCTEST_REQUIRE_EQ(off.stats().captures, 5u);
+}
+
+DOCTEST_TEST_CASE("capture coalescer: per-call max age, and 0 for a capture after the call") {
+  auto fb = make_backend();
+  CaptureCoalescer cc(&fb, 60000);
+  auto a = cc.capture();
+  DOCTEST_REQUIRE(cc.capture(60000).snap == a.snap);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  auto b = cc.capture(5);
+  DOCTEST_REQUIRE(!b.shared);
+  DOCTEST_REQUIRE(b.snap != a.snap);
+  DOCTEST_REQUIRE(cc.capture().snap == b.snap); // the default window still applies
+
+  auto c = cc.capture(0);
+  DOCTEST_REQUIRE(!c.shared);
+  DOCTEST_REQUIRE(c.snap != b.snap);
+
+  // Concurrent fresh callers: none reuses a capture that began before it
+  // asked, but they can still share one that began after.
+  std::vector<std::thread> ts;
+  for (int i = 0; i < 8; i++) ts.emplace_back([&] { (void)cc.capture(0); });
+  for (auto &t : ts) t.join();
+  auto st = cc.stats();
+  DOCTEST_REQUIRE(st.captures >= 4u);
+  DOCTEST_REQUIRE(st.captures <= 3u + 8u);
+}
@@ -0,0 +1,207 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "doctest/doctest.h"
+#include "wininspect/change_detector.hpp"
+#include "wininspect/fake_backend.hpp"
+#include "wininspect/fake_timeline.hpp"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+using namespace wininspect;
+
+namespace {
+
+struct Collected {
+  std::mutex mu;
+  std::condition_variable cv;
+  std::vector<Event> events;
+
+  ChangeDetector::Sink sink() {
+    return [this](std::vector<Event> &ev, const Snapshot &) {
+      std::lock_guard<std::mutex> lk(mu);
+      events.insert(events.end(), ev.begin(), ev.end());
+      cv.notify_all();
+    };
+  }
+  bool wait_for_count(size_t n, int ms = 3000) {
+    std::unique_lock<std::mutex> lk(mu);
+    return cv.wait_for(lk, std::chrono::milliseconds(ms), [&] { return events.size() >= n; });
+  }
+};
+
+template <typename F> bool eventually(F &&f, int ms = 3000) {
+  auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+  while (std::chrono::steady_clock::now() < until) {
+    if (f()) return true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  return f();
+}
+
+// Pushes whatever the test hands it, on the test's thread.
+struct ManualSource : IEventSource {
+  bool available = true;
+  Sink sink;
+  bool start(Sink s) override {
+    sink = std::move(s);
+    return available;
+  }
+  void stop() override {}
+  const char *name() const override { return "manual"; }
+  void push(std::vector<Event> ev) { sink(ev); }
+};
+
+} // namespace
+
+DOCTEST_TEST_CASE("change detector: reports created and destroyed windows") {
+  FakeBackend fb({{0x10, 0, 0, "A", "C", true}});
+  Collected got;
+  ChangeDetector::Options o;
+  o.min_interval_ms = 2;
+  o.max_interval_ms = 20;
+  ChangeDetector det(&fb, nullptr, got.sink(), o);
+
+  DOCTEST_REQUIRE(eventually([&] { return det.stats().ticks > 0; }));
+  fb.add_window({0x20, 0, 0, "B", "C", true});
+  DOCTEST_REQUIRE(got.wait_for_count(1));
+  fb.remove_window(0x10);
+  DOCTEST_REQUIRE(got.wait_for_count(2));
+
+  std::lock_guard<std::mutex> lk(got.mu);
+  DOCTEST_REQUIRE(got.events[0].type == "window.created");
+  DOCTEST_REQUIRE_EQ(got.events[0].hwnd, 0x20u);
+  DOCTEST_REQUIRE(got.events[1].type == "window.destroyed");
+  DOCTEST_REQUIRE_EQ(got.events[1].hwnd, 0x10u);
+}
+
+DOCTEST_TEST_CASE("change detector: backs off when quiet, speeds up on change") {
+  FakeBackend fb({{0x10, 0, 0, "A", "C", true}});
+  Collected got;
+  ChangeDetector::Options o;
+  o.min_interval_ms = 1;
+  o.max_interval_ms = 16;
+  ChangeDetector det(&fb, nullptr, got.sink(), o);
+
+  DOCTEST_REQUIRE(eventually([&] { return det.stats().interval_ms == 16; }));
+  fb.add_window({0x20, 0, 0, "B", "C", true});
+  DOCTEST_REQUIRE(got.wait_for_count(1));
+  DOCTEST_REQUIRE(eventually([&] { return det.stats().changed_ticks == 1; }));
+  // The tick that saw the change reset the rate; quiet ticks then back off again.
+  DOCTEST_REQUIRE(eventually([&] { return det.stats().interval_ms == 16; }));
+}
+
+DOCTEST_TEST_CASE("change detector: pauses when untouched, catches up on resume") {
+  FakeBackend fb({{0x10, 0, 0, "A", "C", true}});
+  Collected got;
+  ChangeDetector::Options o;
+  o.min_interval_ms = 1;
+  o.max_interval_ms = 4;
+  // Shorter than any scheduling delay: the touch below is already stale
+  // when the detector thread wakes for it, and must still resume it.
+  o.idle_stop_ms = 1;
+  ChangeDetector det(&fb, nullptr, got.sink(), o);
+
+  DOCTEST_REQUIRE(eventually([&] { return det.stats().paused; }));
+  auto ticks = det.stats().ticks;
+  fb.add_window({0x20, 0, 0, "B", "C", true});
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  DOCTEST_REQUIRE_EQ(det.stats().ticks, ticks);
+
+  det.touch(true);
+  DOCTEST_REQUIRE(got.wait_for_count(1));
+  std::lock_guard<std::mutex> lk(got.mu);
+  DOCTEST_REQUIRE(got.events[0].type == "window.created");
+}
+
+DOCTEST_TEST_CASE("change detector: forwards pushed events, dropping duplicates") {
+  FakeBackend fb({{0x10, 0, 0, "A", "C", true}});
+  Collected got;
+  auto src = std::make_unique<ManualSource>();
+  auto *manual = src.get();
+  ChangeDetector::Options o;
+  o.min_interval_ms = 1;
+  o.reconcile_ms = 0;
+  ChangeDetector det(&fb, nullptr, got.sink(), o, std::move(src));
+
+  DOCTEST_REQUIRE(eventually([&] { return det.stats().ticks > 0; }));
+  DOCTEST_REQUIRE(det.stats().hooked);
+  manual->push({{0, "window.created", 0x10, ""},   // already known
+                {0, "window.created", 0x20, ""},
+                {0, "window.changed", 0x20, "title"},
+                {0, "window.destroyed", 0x99, ""}, // never seen
+                {0, "window.destroyed", 0x10, ""}});
+  DOCTEST_REQUIRE(got.wait_for_count(3));
+  DOCTEST_REQUIRE(eventually([&] { return det.stats().duplicates == 2; }));
+
+  std::lock_guard<std::mutex> lk(got.mu);
+  DOCTEST_REQUIRE_EQ(got.events.size(), 3u);
+  DOCTEST_REQUIRE(got.events[0].type == "window.created");
+  DOCTEST_REQUIRE(got.events[1].property == "title");
+  DOCTEST_REQUIRE(got.events[2].type == "window.destroyed");
+  DOCTEST_REQUIRE_EQ(got.events[2].hwnd, 0x10u);
+}
+
+DOCTEST_TEST_CASE("change detector: reconcile reports what the source missed") {
+  FakeBackend fb({{0x10, 0, 0, "A", "C", true}});
+  Collected got;
+  ChangeDetector::Options o;
+  o.min_interval_ms = 1;
+  o.max_interval_ms = 4;
+  o.reconcile_ms = 10;
+  ChangeDetector det(&fb, nullptr, got.sink(), o, std::make_unique<ManualSource>());
+
+  DOCTEST_REQUIRE(eventually([&] { return det.stats().ticks > 0; }));
+  fb.add_window({0x20, 0, 0, "B", "C", true}); // no push for this one
+  DOCTEST_REQUIRE(got.wait_for_count(1));
+  DOCTEST_REQUIRE(eventually([&] { return det.stats().reconciled == 1; }));
+  std::lock_guard<std::mutex> lk(got.mu);
+  DOCTEST_REQUIRE(got.events[0].type == "window.created");
+  DOCTEST_REQUIRE_EQ(got.events[0].hwnd, 0x20u);
+}
+
+DOCTEST_TEST_CASE("change detector: falls back to diffing when the source fails") {
+  FakeBackend fb({{0x10, 0, 0, "A", "C", true}});
+  Collected got;
+  auto src = std::make_unique<ManualSource>();
+  src->available = false;
+  ChangeDetector::Options o;
+  o.min_interval_ms = 2;
+  ChangeDetector det(&fb, nullptr, got.sink(), o, std::move(src));
+
+  DOCTEST_REQUIRE(eventually([&] { return det.stats().ticks > 0; }));
+  fb.add_window({0x20, 0, 0, "B", "C", true});
+  DOCTEST_REQUIRE(got.wait_for_count(1));
+  DOCTEST_REQUIRE(!det.stats().hooked);
+}
+
+DOCTEST_TEST_CASE("change detector: delivers a scripted timeline exactly once") {
+  FakeBackend fb({{0x10, 0, 0, "A", "C", true}});
+  FakeTimeline::Options t;
+  t.total = 500;
+  t.shape = FakeTimeline::Shape::Burst;
+  t.burst = 50;
+  fb.set_timeline(t, false);
+  auto src = fb.create_event_source();
+  DOCTEST_REQUIRE(src != nullptr);
+  auto *scripted = static_cast<ScriptedEventSource *>(src.get());
+  std::vector<Event> expected;
+  for (const auto &s : scripted->steps()) expected.push_back(s.event);
+
+  Collected got;
+  ChangeDetector::Options o;
+  o.min_interval_ms = 1;
+  o.reconcile_ms = 5;
+  ChangeDetector det(&fb, nullptr, got.sink(), o, std::move(src));
+  DOCTEST_REQUIRE(scripted->wait_done(std::chrono::milliseconds(3000)));
+  DOCTEST_REQUIRE(got.wait_for_count(expected.size()));
+  std::this_thread::sleep_for(std::chrono::milliseconds(20)); // a reconcile or two
+
+  std::lock_guard<std::mutex> lk(got.mu);
+  DOCTEST_REQUIRE_EQ(got.events.size(), expected.size());
+  for (size_t i = 0; i < expected.size(); i++) {
+    DOCTEST_REQUIRE(got.events[i].type == expected[i].type);
+    DOCTEST_REQUIRE_EQ(got.events[i].hwnd, expected[i].hwnd);
+  }
+}
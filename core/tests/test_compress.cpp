@@ -0,0 +1,112 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "doctest/doctest.h"
+#include "wininspect/compress.hpp"
+#include <cstring>
+#include <random>
+
+using namespace wininspect::compress;
+
+namespace {
+
+std::string lz4_round_trip(const std::string &in) {
+  std::vector<std::uint8_t> z(lz4_bound(in.size()));
+  size_t n = lz4_compress((const std::uint8_t *)in.data(), in.size(), z.data(), z.size());
+  if (n == 0) return "<compress failed>";
+  std::string out(in.size(), '\0');
+  if (!lz4_decompress(z.data(), n, (std::uint8_t *)out.data(), out.size()))
+    return "<decompress failed>";
+  return out;
+}
+
+std::string tree_json(int nodes) {
+  std::string s = "{\"id\":\"1\",\"ok\":true,\"result\":[";
+  for (int i = 0; i < nodes; i++) {
+    if (i) s += ",";
+    s += "{\"hwnd\":\"0x" + std::to_string(0x10000 + i * 16) +
+         "\",\"class_name\":\"Button\",\"title\":\"OK\",\"visible\":true,\"enabled\":true}";
+  }
+  return s + "]}";
+}
+
+} // namespace
+
+DOCTEST_TEST_CASE("LZ4: blocks round-trip at every boundary size") {
+  std::mt19937 rng(43);
+  for (size_t n : {0, 1, 4, 11, 12, 13, 16, 64, 1000, 70000}) {
+    std::string text(n, '\0'), noise(n, '\0');
+    for (size_t i = 0; i < n; i++) {
+      text[i] = "abcab"[i % 5];
+      noise[i] = (char)rng();
+    }
+    DOCTEST_REQUIRE(lz4_round_trip(text) == text);
+    DOCTEST_REQUIRE(lz4_round_trip(noise) == noise);
+  }
+  auto tree = tree_json(2000);
+  DOCTEST_REQUIRE(lz4_round_trip(tree) == tree);
+  // A repeat more than 64 KiB back cannot be a match, but must still decode.
+  std::string far(70000, '\0');
+  for (size_t i = 0; i < 1000; i++) far[i] = far[69000 + i] = (char)rng();
+  DOCTEST_REQUIRE(lz4_round_trip(far) == far);
+}
+
+DOCTEST_TEST_CASE("LZ4: decodes the reference block format") {
+  // Token 0x2A: two literals, then a 14-byte match at offset 2 (an
+  // overlapping copy); token 0x50: the five closing literals.
+  const std::uint8_t block[] = {0x2A, 'a', 'b', 0x02, 0x00, 0x50, 'x', 'y', 'z', 'w', 'v'};
+  std::string out(21, '\0');
+  DOCTEST_REQUIRE(lz4_decompress(block, sizeof(block), (std::uint8_t *)out.data(), out.size()));
+  DOCTEST_REQUIRE_EQ(out, std::string("abababababababab") + "xyzwv");
+
+  // The wrong size, an offset before the start, and truncation all fail.
+  DOCTEST_REQUIRE(!lz4_decompress(block, sizeof(block), (std::uint8_t *)out.data(), 20));
+  std::uint8_t bad[sizeof(block)];
+  std::memcpy(bad, block, sizeof(block));
+  bad[3] = 3;
+  DOCTEST_REQUIRE(!lz4_decompress(bad, sizeof(bad), (std::uint8_t *)out.data(), out.size()));
+  DOCTEST_REQUIRE(!lz4_decompress(block, 4, (std::uint8_t *)out.data(), out.size()));
+}
+
+DOCTEST_TEST_CASE("compress: pack and unpack frames") {
+  auto tree = tree_json(500);
+  std::string packed = "prefix";
+  DOCTEST_REQUIRE(pack(Codec::Lz4, tree.data(), tree.size(), packed));
+  DOCTEST_REQUIRE_EQ(packed.substr(0, 6), std::string("prefix")); // appended
+  DOCTEST_REQUIRE(packed.size() < 6 + tree.size() / 4);
+
+  std::string out;
+  DOCTEST_REQUIRE(unpack(packed.data() + 6, packed.size() - 6, tree.size(), out));
+  DOCTEST_REQUIRE(out == tree);
+  DOCTEST_REQUIRE(!unpack(packed.data() + 6, packed.size() - 6, tree.size() - 1, out)); // over max
+  packed[6] = 9; // unknown codec
+  DOCTEST_REQUIRE(!unpack(packed.data() + 6, packed.size() - 6, tree.size(), out));
+
+  // Incompressible or tiny payloads are left alone.
+  std::string noise(4096, '\0');
+  std::mt19937 rng(7);
+  for (auto &c : noise) c = (char)rng();
+  std::string none;
+  DOCTEST_REQUIRE(!pack(Codec::Lz4, noise.data(), noise.size(), none));
+  DOCTEST_REQUIRE(!pack(Codec::Lz4, "{}", 2, none));
+  DOCTEST_REQUIRE(!pack(Codec::None, tree.data(), tree.size(), none));
+  DOCTEST_REQUIRE(none.empty());
+
+  // Every advertised codec round-trips; a mangled payload fails cleanly
+  // or decodes to the declared size, never past it.
+  DOCTEST_REQUIRE_EQ(available().front(), std::string("lz4"));
+  for (auto &name : available()) {
+    auto c = codec_from_name(name);
+    DOCTEST_REQUIRE(c != Codec::None);
+    std::string z;
+    DOCTEST_REQUIRE(pack(c, tree.data(), tree.size(), z));
+    DOCTEST_REQUIRE(unpack(z.data(), z.size(), tree.size(), out));
+    DOCTEST_REQUIRE(out == tree);
+    for (int i = 0; i < 200; i++) {
+      std::string m = z;
+      m[HEADER_BYTES + rng() % (m.size() - HEADER_BYTES)] ^= (char)(1 + rng() % 255);
+      if (unpack(m.data(), m.size(), tree.size(), out)) DOCTEST_REQUIRE_EQ(out.size(), tree.size());
+    }
+  }
+  DOCTEST_REQUIRE(codec_from_name("zstd") == Codec::None);
+}
@@ -310,6 +310,7 @@ DOCTEST_TEST_CASE("contract: control.status") {
 DOCTEST_TEST_CASE("contract: file.getInfo") {
   auto fb = make_fake();
   CoreEngine core(&fb);
+  fb.add_file("C:\\test.txt", "fake content");
   json::Object p; p["path"] = std::string("C:\\test.txt");
   CoreRequest req{"t23","file.getInfo",p};
   auto r = core.handle(req, fb.capture_snapshot());
@@ -319,6 +320,7 @@ DOCTEST_TEST_CASE("contract: file.getInfo") {
 DOCTEST_TEST_CASE("contract: file.read") {
   auto fb = make_fake();
   CoreEngine core(&fb);
+  fb.add_file("C:\\test.txt", "fake content");
   json::Object p; p["path"] = std::string("C:\\test.txt");
   CoreRequest req{"t24","file.read",p};
   auto r = core.handle(req, fb.capture_snapshot());
@@ -462,6 +464,86 @@ DOCTEST_TEST_CASE("contract: image.match") {
   DOCTEST_REQUIRE(r.ok);
 }
 
+// --- binary attachments ---
+
+DOCTEST_TEST_CASE("contract: byte results are attachments for binary clients") {
+  auto fb = make_fake();
+  CoreEngine core(&fb);
+  json::Object p; p["left"] = 0.0; p["top"] = 0.0; p["right"] = 100.0; p["bottom"] = 100.0;
+  CoreRequest legacy{"t50","screen.capture",p};
+  auto r64 = core.handle(legacy, fb.capture_snapshot());
+  DOCTEST_REQUIRE(r64.ok);
+  DOCTEST_REQUIRE(r64.attachments.empty());
+  auto bmp = base64::decode(r64.result.as_obj().at("data_b64").as_str());
+  DOCTEST_REQUIRE(bmp.size() > 54u);
+
+  CoreRequest binary = legacy;
+  binary.binary = true;
+  auto r = core.handle(binary, fb.capture_snapshot());
+  DOCTEST_REQUIRE(r.ok);
+  const auto &o = r.result.as_obj();
+  DOCTEST_REQUIRE(!o.count("data_b64"));
+  const auto &ref = o.at("data").as_obj();
+  DOCTEST_REQUIRE_EQ(ref.at("attachment").as_num(), 0.0);
+  DOCTEST_REQUIRE_EQ(ref.at("size").as_num(), (double)bmp.size());
+  DOCTEST_REQUIRE_EQ(r.attachments.size(), 1u);
+  DOCTEST_REQUIRE(r.attachments[0] == bmp);
+
+  json::Object m; m["pid"] = 1234.0; m["address"] = 4096.0; m["size"] = 32.0;
+  CoreRequest mem{"t51","mem.read",m};
+  mem.binary = true;
+  r = core.handle(mem, fb.capture_snapshot());
+  DOCTEST_REQUIRE(r.ok);
+  DOCTEST_REQUIRE_EQ(std::string(r.attachments.at(0).begin(), r.attachments.at(0).end()),
+                     std::string("fake memory"));
+}
+
+DOCTEST_TEST_CASE("contract: byte parameters may be attachments") {
+  auto fb = make_fake();
+  CoreEngine core(&fb);
+  json::Object ref; ref["attachment"] = 0.0;
+  json::Object p; p["pid"] = 1234.0; p["address"] = 4096.0; p["data"] = ref;
+  CoreRequest req{"t52","mem.write",p};
+  req.attachments.push_back({1, 2, 3});
+  DOCTEST_REQUIRE(core.handle(req, fb.capture_snapshot()).ok);
+
+  // A reference past the attachments sent is a bad request.
+  ref["attachment"] = 1.0;
+  req.params["data"] = ref;
+  auto r = core.handle(req, fb.capture_snapshot());
+  DOCTEST_REQUIRE(!r.ok);
+  req.attachments.clear();
+  ref["attachment"] = 0.0;
+  req.params["data"] = ref;
+  DOCTEST_REQUIRE(!core.handle(req, fb.capture_snapshot()).ok);
+}
+
+DOCTEST_TEST_CASE("contract: parse_request_json reads the binary flag") {
+  DOCTEST_REQUIRE(!parse_request_json(R"({"id":"1","method":"m","params":{}})").binary);
+  DOCTEST_REQUIRE(parse_request_json(R"({"id":"1","method":"m","params":{},"binary":true})").binary);
+  DOCTEST_REQUIRE(!parse_request_json(R"({"id":"1","method":"m","params":{},"binary":1})").binary);
+}
+
+DOCTEST_TEST_CASE("multipart: payloads round-trip and reject truncation") {
+  std::vector<Attachment> atts = {{1, 2, 3}, {}, Attachment(70000, 0xAB)};
+  std::string payload = "x";
+  append_multipart(payload, R"({"id":"1"})", atts);
+  DOCTEST_REQUIRE_EQ(payload.size(), 1u + 4 + 10 + 4 + 3 + 4 + 0 + 4 + 70000);
+
+  std::string json;
+  std::vector<Attachment> out;
+  DOCTEST_REQUIRE(split_multipart(std::string_view(payload).substr(1), json, out));
+  DOCTEST_REQUIRE_EQ(json, std::string(R"({"id":"1"})"));
+  DOCTEST_REQUIRE(out == atts);
+
+  DOCTEST_REQUIRE(!split_multipart(std::string_view(payload).substr(1, payload.size() - 2), json, out));
+  DOCTEST_REQUIRE(!split_multipart(std::string_view(payload).substr(1, 3), json, out));
+  std::string bare;
+  append_multipart(bare, "{}", {});
+  DOCTEST_REQUIRE(split_multipart(bare, json, out));
+  DOCTEST_REQUIRE(out.empty());
+}
+
 // --- input hook ---
 
 DOCTEST_TEST_CASE("contract: input.hook") {
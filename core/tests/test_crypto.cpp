@@ -3,12 +3,29 @@
 
 #include "doctest/doctest.h"
 #include "wininspect/crypto.hpp"
+#include <cstring>
 
-#ifdef _WIN32
 using namespace wininspect::crypto;
 
+// Without a backend ("none") every operation fails closed; nothing to test.
+static bool have_backend() { return std::string(backend_name()) != "none"; }
+
+static std::vector<uint8_t> unhex(const char *s) {
+  std::vector<uint8_t> out;
+  for (; s[0] && s[1]; s += 2) out.push_back((uint8_t)std::stoi(std::string(s, 2), nullptr, 16));
+  return out;
+}
+
+static void handshake(CryptoSession &server, CryptoSession &client) {
+  auto server_pub = server.generate_local_key();
+  auto client_pub = client.generate_local_key();
+  DOCTEST_REQUIRE(server.compute_shared_secret(client_pub));
+  DOCTEST_REQUIRE(client.compute_shared_secret(server_pub));
+}
+
 DOCTEST_TEST_CASE("CryptoSession handshake and encryption") {
-  CryptoSession server;
+  if (!have_backend()) return;
+  CryptoSession server(Role::Server);
   CryptoSession client;
 
   // 1. Generate keys
@@ -31,4 +48,139 @@ DOCTEST_TEST_CASE("CryptoSession handshake and encryption") {
   std::string decrypted = server.decrypt(encrypted);
   DOCTEST_REQUIRE_EQ(message, decrypted);
 }
-#endif
+
+DOCTEST_TEST_CASE("CryptoSession seals in place and in batches") {
+  if (!have_backend()) return;
+  CryptoSession server(Role::Server);
+  CryptoSession client;
+  handshake(server, client);
+
+  // In place: the plaintext already sits where the ciphertext goes.
+  std::string msg = "{\"id\":\"1\",\"ok\":true}";
+  std::vector<uint8_t> rec(RECORD_OVERHEAD + msg.size());
+  std::memcpy(rec.data() + RECORD_OVERHEAD, msg.data(), msg.size());
+  std::span<const uint8_t> tail(rec.data() + RECORD_OVERHEAD, msg.size());
+  DOCTEST_REQUIRE(server.seal(tail, rec));
+  DOCTEST_REQUIRE(std::memcmp(rec.data() + RECORD_OVERHEAD, msg.data(), msg.size()) != 0);
+  DOCTEST_REQUIRE(client.open(rec));
+  DOCTEST_REQUIRE_EQ(std::string((const char *)rec.data() + RECORD_OVERHEAD, msg.size()), msg);
+
+  // Several records, one pass; each opens on its own, in order.
+  std::vector<std::string> msgs = {"a", std::string(5000, 'b'), "c"};
+  std::vector<std::vector<uint8_t>> recs;
+  std::vector<SealJob> jobs;
+  for (auto &m : msgs) recs.emplace_back(RECORD_OVERHEAD + m.size());
+  for (size_t i = 0; i < msgs.size(); i++)
+    jobs.push_back({{(const uint8_t *)msgs[i].data(), msgs[i].size()}, recs[i]});
+  DOCTEST_REQUIRE(server.seal_batch(jobs));
+  for (size_t i = 0; i < msgs.size(); i++) {
+    DOCTEST_REQUIRE(client.open(recs[i]));
+    DOCTEST_REQUIRE_EQ(std::string((const char *)recs[i].data() + RECORD_OVERHEAD,
+                                   msgs[i].size()),
+                       msgs[i]);
+  }
+  std::vector<uint8_t> wrong_size(RECORD_OVERHEAD);
+  DOCTEST_REQUIRE(!server.seal(tail, wrong_size));
+}
+
+DOCTEST_TEST_CASE("CryptoSession rejects replayed, skipped, reflected and tampered records") {
+  if (!have_backend()) return;
+  CryptoSession server(Role::Server);
+  CryptoSession client;
+  handshake(server, client);
+
+  auto first = client.encrypt("one");
+  auto second = client.encrypt("two");
+  auto third = client.encrypt("three");
+  DOCTEST_REQUIRE(server.decrypt(second).empty()); // `first` was dropped on the way
+  DOCTEST_REQUIRE_EQ(server.decrypt(first), std::string("one"));
+  DOCTEST_REQUIRE_EQ(server.decrypt(second), std::string("two"));
+  DOCTEST_REQUIRE(server.decrypt(first).empty());  // counter went backwards
+  DOCTEST_REQUIRE(server.decrypt(second).empty()); // the same record again
+  DOCTEST_REQUIRE_EQ(server.decrypt(third), std::string("three"));
+
+  auto own = server.encrypt("mine");
+  DOCTEST_REQUIRE(server.decrypt(own).empty()); // reflected back at its sender
+
+  auto fourth = client.encrypt("four");
+  fourth.back() ^= 1;
+  DOCTEST_REQUIRE(server.decrypt(fourth).empty());
+}
+
+// Recorded records, so that each backend is held to the same bytes: a
+// record sealed by CNG opens under OpenSSL and the other way round.
+DOCTEST_TEST_CASE("CryptoSession records match recorded vectors in both directions") {
+  if (!have_backend()) return;
+
+  // GCM spec test case 14: zero key, zero IV (client record 0), 16 zero bytes.
+  std::vector<uint8_t> zero_key(32, 0);
+  auto tc14 = unhex("000000000000000000000000"           // nonce
+                    "d0d1c8a799996bf0265b98b5d48ab919"   // tag
+                    "cea7403d4d606b6e074ec5d3baf39d18"); // ciphertext
+  CryptoSession client;
+  DOCTEST_REQUIRE(client.install_key(zero_key));
+  uint8_t zeros[16] = {};
+  std::vector<uint8_t> rec(RECORD_OVERHEAD + sizeof(zeros));
+  DOCTEST_REQUIRE(client.seal({zeros, sizeof(zeros)}, rec));
+  DOCTEST_REQUIRE(rec == tc14);
+  CryptoSession server(Role::Server);
+  DOCTEST_REQUIRE(server.install_key(zero_key));
+  DOCTEST_REQUIRE(server.open(tc14));
+  DOCTEST_REQUIRE(std::memcmp(tc14.data() + RECORD_OVERHEAD, zeros, sizeof(zeros)) == 0);
+
+  // Server record 7 under key 00 01 .. 1f.
+  std::vector<uint8_t> key(32);
+  for (size_t i = 0; i < key.size(); i++) key[i] = (uint8_t)i;
+  std::string msg = "{\"id\":\"1\",\"ok\":true}";
+  auto rec7 = unhex("070000000000000000000001"
+                    "0f9950fbfbea08b66875a8eb5cd83cd3"
+                    "84955b4d0804e741f5dd9125ebcf81b917aad13b");
+  DOCTEST_REQUIRE(server.install_key(key));
+  std::vector<std::vector<uint8_t>> before; // records 0-6, opened in turn
+  for (int i = 0; i < 7; i++) before.push_back(server.encrypt("skip"));
+  DOCTEST_REQUIRE(server.encrypt(msg) == rec7);
+  DOCTEST_REQUIRE(client.install_key(key));
+  for (auto &r : before) DOCTEST_REQUIRE_EQ(client.decrypt(r), std::string("skip"));
+  DOCTEST_REQUIRE_EQ(client.decrypt(rec7), msg);
+  DOCTEST_REQUIRE(!client.install_key({key.data(), 16}));
+}
+
+DOCTEST_TEST_CASE("CryptoSession public keys are P-256 ECCPUBLIC_BLOBs") {
+  if (!have_backend()) return;
+  CryptoSession server(Role::Server);
+  CryptoSession client;
+  auto server_pub = server.generate_local_key();
+  auto client_pub = client.generate_local_key();
+  DOCTEST_REQUIRE_EQ(client_pub.size(), 72u);
+  DOCTEST_REQUIRE(std::memcmp(client_pub.data(), "ECK1\x20\0\0\0", 8) == 0);
+
+  auto bad_magic = client_pub;
+  bad_magic[3] = '2';
+  DOCTEST_REQUIRE(!server.compute_shared_secret(bad_magic));
+  auto off_curve = client_pub;
+  off_curve.back() ^= 1;
+  DOCTEST_REQUIRE(!server.compute_shared_secret(off_curve));
+  DOCTEST_REQUIRE(server.compute_shared_secret(client_pub));
+  DOCTEST_REQUIRE(client.compute_shared_secret(server_pub));
+  DOCTEST_REQUIRE_EQ(server.decrypt(client.encrypt("hi")), std::string("hi"));
+}
+
+DOCTEST_TEST_CASE("Ed25519 identity signatures match a recorded vector") {
+  if (!have_backend()) return;
+  const std::string pub_line = "ssh-ed25519 "
+                               "AAAAC3NzaC1lZDI1NTE5AAAAIEkYdjCD2Xgej+vVkM5TIx+RVKP44xIjL+fU6046wib1 "
+                               "wininspect-test";
+  const std::string sig = "UpFCJ9hd6ZMsi45mVk0fjr9Nn8ZYQao+8XRtuhmIb3yLSrdLTRO/ryR65d8SQI2kXCXS+"
+                          "O+SwsBDDQce0zCzBw==";
+  std::string nonce = "wininspect-test-nonce";
+  std::vector<uint8_t> msg(nonce.begin(), nonce.end());
+  DOCTEST_REQUIRE(verify_ssh_sig(msg, sig, pub_line));
+  msg.back() ^= 1;
+  DOCTEST_REQUIRE(!verify_ssh_sig(msg, sig, pub_line));
+  msg.back() ^= 1;
+
+  // CNG has no OpenSSH key reader; signing is OpenSSL-only for now.
+  if (std::string(backend_name()) != "openssl") return;
+  DOCTEST_REQUIRE_EQ(sign_ssh_msg(msg, "tests/keys/wininspect-test"), sig); // deterministic
+  DOCTEST_REQUIRE(sign_ssh_msg(msg, "tests/keys/wininspect-test.pub").empty());
+}
@@ -0,0 +1,135 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "doctest/doctest.h"
+#include "wininspect/event_filter.hpp"
+#include "wininspect/fake_backend.hpp"
+#include "wininspect/subscription_hub.hpp"
+
+using namespace wininspect;
+using namespace std::chrono_literals;
+
+static EventFilter compile(const std::string &spec) {
+  return EventFilter::compile(json::parse(spec).as_obj());
+}
+
+static bool throws(const std::string &spec) {
+  try { compile(spec); } catch (const std::runtime_error &) { return true; }
+  return false;
+}
+
+// Drives a hub the way the detector does: capture, diff, dispatch.
+struct Ticker {
+  FakeBackend &fb;
+  SubscriptionHub &hub;
+  Snapshot prev;
+  SubscriptionHub::Clock::time_point now = SubscriptionHub::Clock::now();
+
+  Ticker(FakeBackend &b, SubscriptionHub &h) : fb(b), hub(h), prev(b.capture_snapshot()) {}
+  void tick(std::chrono::milliseconds advance = 0ms) {
+    now += advance;
+    auto cur = fb.capture_snapshot();
+    hub.dispatch(fb.poll_events(prev, cur), cur, now);
+    prev = cur;
+  }
+};
+
+static std::vector<Event> drain(const FilteredSubscription &s, uint64_t &cursor) {
+  std::vector<Event> out;
+  cursor = s.events().read(cursor, out, 1000).last_seq;
+  return out;
+}
+
+DOCTEST_TEST_CASE("event filter: compile and match") {
+  WindowFacts dlg{"#32770", "Save As", 1234, {0x10}};
+  Event created{0, "window.created", 0x20, ""};
+  Event destroyed{0, "window.destroyed", 0x20, ""};
+
+  auto any = compile("{}");
+  DOCTEST_REQUIRE(!any.needs_facts());
+  DOCTEST_REQUIRE(any.matches(created, nullptr));
+
+  auto f = compile(R"({"types":"window.created","class":"#32770","pid":[1,1234]})");
+  DOCTEST_REQUIRE(f.needs_facts());
+  DOCTEST_REQUIRE(f.matches(created, &dlg));
+  DOCTEST_REQUIRE(!f.matches(destroyed, &dlg));
+  DOCTEST_REQUIRE(!f.matches(created, nullptr)); // unknown window
+  WindowFacts other = dlg;
+  other.pid = 99;
+  DOCTEST_REQUIRE(!f.matches(created, &other));
+
+  auto t = compile(R"({"title":"save","match":"prefix","case_insensitive":true})");
+  DOCTEST_REQUIRE(t.matches(created, &dlg));
+  auto under = compile(R"({"under":"0x10"})");
+  DOCTEST_REQUIRE(under.needs_ancestry());
+  DOCTEST_REQUIRE(under.matches(created, &dlg));
+  WindowFacts none;
+  DOCTEST_REQUIRE(under.matches({0, "window.created", 0x10, ""}, &none)); // the root itself
+  DOCTEST_REQUIRE(!under.matches(created, &none));
+
+  DOCTEST_REQUIRE(throws(R"({"types":["window.moved"]})"));
+  DOCTEST_REQUIRE(throws(R"({"match":"fuzzy"})"));
+  DOCTEST_REQUIRE(throws(R"({"title":"("})"));
+  DOCTEST_REQUIRE(throws(R"({"under":"16"})"));
+}
+
+DOCTEST_TEST_CASE("subscription hub: only matching events are queued") {
+  FakeBackend fb({{0x10, 0, 0, "Editor", "MainWnd", true},
+                  {0x11, 0, 0, "Other", "MainWnd", true}});
+  SubscriptionHub hub(&fb);
+  Ticker tk(fb, hub);
+  auto dialogs = hub.subscribe(compile(R"({"class":"#32770","under":"0x10"})"), 0);
+  auto all = hub.subscribe(EventFilter(), 0);
+  tk.tick(); // primes the window facts
+
+  fb.add_window({0x20, 0, 0x10, "Save As", "#32770", true}); // owned by 0x10
+  fb.add_window({0x21, 0, 0x11, "Open", "#32770", true});    // someone else's
+  fb.add_window({0x22, 0, 0, "Tool", "ToolWnd", true});
+  tk.tick();
+  fb.remove_window(0x20);
+  fb.remove_window(0x22);
+  tk.tick();
+
+  uint64_t c1 = 0, c2 = 0;
+  auto got = drain(*dialogs, c1);
+  DOCTEST_REQUIRE_EQ(got.size(), 2u);
+  DOCTEST_REQUIRE(got[0].type == "window.created" && got[0].hwnd == 0x20u);
+  DOCTEST_REQUIRE(got[1].type == "window.destroyed" && got[1].hwnd == 0x20u);
+  DOCTEST_REQUIRE_EQ(got[1].seq, 2u); // own sequence, no holes
+  DOCTEST_REQUIRE_EQ(drain(*all, c2).size(), 5u);
+  DOCTEST_REQUIRE_EQ(hub.stats().active, 2u);
+
+  all.reset();
+  tk.tick();
+  DOCTEST_REQUIRE_EQ(hub.stats().active, 1u);
+}
+
+DOCTEST_TEST_CASE("subscription hub: title changes are tracked and debounced") {
+  FakeBackend fb({{0x10, 0, 0, "Build 0%", "Progress", true},
+                  {0x11, 0, 0, "Idle", "Other", true}});
+  SubscriptionHub hub(&fb);
+  Ticker tk(fb, hub);
+  auto s = hub.subscribe(compile(R"({"types":"window.changed","class":"Progress"})"), 100);
+  tk.tick();
+  DOCTEST_REQUIRE_EQ(hub.stats().watched, 1u);
+
+  uint64_t cursor = 0;
+  for (int i = 1; i <= 5; i++) {
+    fb.set_title(0x10, "Build " + std::to_string(i * 10) + "%");
+    fb.set_title(0x11, "Busy " + std::to_string(i));
+    tk.tick(10ms);
+  }
+  DOCTEST_REQUIRE(drain(*s, cursor).empty()); // still inside the window
+  tk.tick(100ms);
+  auto got = drain(*s, cursor);
+  DOCTEST_REQUIRE_EQ(got.size(), 1u); // five changes, one event
+  DOCTEST_REQUIRE(got[0].hwnd == 0x10u && got[0].property == "title");
+  DOCTEST_REQUIRE_EQ(hub.stats().debounced, 4u);
+
+  // A window destroyed while a change is held never reports it.
+  fb.set_title(0x10, "Build done");
+  tk.tick();
+  fb.remove_window(0x10);
+  tk.tick(200ms);
+  DOCTEST_REQUIRE(drain(*s, cursor).empty());
+}
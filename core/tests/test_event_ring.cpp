@@ -0,0 +1,116 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "doctest/doctest.h"
+#include "wininspect/event_ring.hpp"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace wininspect;
+
+static Event make_event(uint64_t n) {
+  // Payload derived from the seq it will get, so readers can check for torn
+  // or misplaced slots.
+  return {0, (n % 2) ? "window.created" : "window.destroyed", n * 7, "p" + std::to_string(n)};
+}
+
+DOCTEST_TEST_CASE("event ring: read from cursor, capacity and gaps") {
+  EventRing ring(5); // rounds up to 8
+  DOCTEST_REQUIRE_EQ(ring.capacity(), 8u);
+  std::vector<Event> out;
+  auto r = ring.read(0, out, 100);
+  DOCTEST_REQUIRE(out.empty() && !r.gap && r.last_seq == 0u);
+
+  for (uint64_t i = 1; i <= 5; i++) {
+    auto e = make_event(i);
+    DOCTEST_REQUIRE_EQ(ring.push(e), i);
+  }
+  r = ring.read(2, out, 100);
+  DOCTEST_REQUIRE_EQ(out.size(), 3u);
+  DOCTEST_REQUIRE_EQ(out[0].seq, 3u);
+  DOCTEST_REQUIRE(out[0].type == "window.created");
+  DOCTEST_REQUIRE(out[2].property == "p5");
+  DOCTEST_REQUIRE_EQ(r.last_seq, 5u);
+  DOCTEST_REQUIRE(!r.gap);
+
+  out.clear();
+  r = ring.read(0, out, 2); // max respected
+  DOCTEST_REQUIRE_EQ(out.size(), 2u);
+  DOCTEST_REQUIRE_EQ(r.last_seq, 2u);
+
+  for (uint64_t i = 6; i <= 20; i++) {
+    auto e = make_event(i);
+    ring.push(e);
+  }
+  DOCTEST_REQUIRE_EQ(ring.oldest(), 13u);
+  out.clear();
+  r = ring.read(3, out, 100); // 4..12 are gone
+  DOCTEST_REQUIRE(r.gap);
+  DOCTEST_REQUIRE_EQ(out.front().seq, 13u);
+  DOCTEST_REQUIRE_EQ(r.last_seq, 20u);
+
+  out.clear();
+  r = ring.read(500, out, 100); // cursor from an earlier run
+  DOCTEST_REQUIRE(r.gap);
+  DOCTEST_REQUIRE_EQ(out.size(), 8u);
+
+  DOCTEST_REQUIRE(!ring.wait_for(20, std::chrono::milliseconds(1)));
+  DOCTEST_REQUIRE(ring.wait_for(19, std::chrono::milliseconds(0)));
+}
+
+DOCTEST_TEST_CASE("event ring: stress, 1 writer and 64 lock-free readers") {
+  constexpr uint64_t TOTAL = 200000;
+  constexpr int READERS = 64;
+  EventRing ring(1024);
+  std::atomic<bool> failed{false};
+  std::atomic<uint64_t> gaps{0}, delivered{0};
+  std::string why;
+  std::mutex why_mu;
+  auto fail = [&](const std::string &m) {
+    std::lock_guard<std::mutex> lk(why_mu);
+    if (!failed.exchange(true)) why = m;
+  };
+
+  std::vector<std::thread> readers;
+  for (int t = 0; t < READERS; t++) {
+    readers.emplace_back([&, t] {
+      uint64_t cursor = 0;
+      std::vector<Event> out;
+      while (cursor < TOTAL && !failed) {
+        out.clear();
+        auto r = ring.read(cursor, out, 64 + t);
+        uint64_t expect = cursor + 1;
+        for (const auto &e : out) {
+          if (e.seq < expect) { fail("seq went backwards"); return; }
+          if (e.seq != expect && !r.gap) { fail("hole without gap flag"); return; }
+          auto want = make_event(e.seq);
+          if (e.hwnd != want.hwnd || e.type != want.type || e.property != want.property) {
+            fail("torn slot at seq " + std::to_string(e.seq)); return;
+          }
+          expect = e.seq + 1;
+        }
+        if (r.gap) gaps++;
+        delivered += out.size();
+        if (r.last_seq < cursor) { fail("cursor went backwards"); return; }
+        cursor = r.last_seq;
+        if (out.empty()) ring.wait_for(cursor, std::chrono::milliseconds(5));
+      }
+    });
+  }
+
+  std::thread writer([&] {
+    for (uint64_t i = 1; i <= TOTAL; i++) {
+      auto e = make_event(i);
+      if (ring.push(e) != i) { fail("push seq mismatch"); return; }
+      if (i % 4096 == 0) std::this_thread::yield();
+    }
+  });
+
+  writer.join();
+  for (auto &r : readers) r.join();
+  if (failed) throw doctest::failure(why);
+  DOCTEST_REQUIRE_EQ(ring.head(), TOTAL);
+  DOCTEST_REQUIRE(delivered.load() > 0u);
+}
@@ -0,0 +1,84 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "doctest/doctest.h"
+#include "wininspect/event_stream.hpp"
+#include <thread>
+
+using namespace wininspect;
+using namespace std::chrono_literals;
+
+static Event ev(uint64_t seq, const std::string &type, hwnd_u64 h, const std::string &prop = "") {
+  return {seq, type, h, prop};
+}
+
+DOCTEST_TEST_CASE("event stream: credit gates delivery, gap notices are free") {
+  EventStream::Options o;
+  o.credit = 2;
+  EventStream s(o);
+  s.push({ev(1, "window.created", 1), ev(2, "window.created", 2), ev(3, "window.created", 3)});
+
+  EventStream::Batch b;
+  DOCTEST_REQUIRE(s.take(b, 10, 0ms));
+  DOCTEST_REQUIRE_EQ(b.events.size(), 2u);
+  DOCTEST_REQUIRE_EQ(b.events[1].seq, 2u);
+  DOCTEST_REQUIRE(!s.take(b, 10, 1ms)); // out of credit, event 3 waits
+
+  s.push({}, true); // upstream loss is reported even without credit
+  DOCTEST_REQUIRE(s.take(b, 10, 0ms));
+  DOCTEST_REQUIRE(b.gap && b.events.empty());
+
+  std::thread granter([&] {
+    std::this_thread::sleep_for(10ms);
+    s.grant(5);
+  });
+  DOCTEST_REQUIRE(s.take(b, 10, 2000ms)); // woken by the grant
+  granter.join();
+  DOCTEST_REQUIRE_EQ(b.events.size(), 1u);
+  DOCTEST_REQUIRE_EQ(b.events[0].seq, 3u);
+  DOCTEST_REQUIRE_EQ(s.stats().credit, 4u);
+  DOCTEST_REQUIRE_EQ(s.stats().delivered, 3u);
+
+  s.close();
+  DOCTEST_REQUIRE(!s.take(b, 10, 1000ms));
+}
+
+DOCTEST_TEST_CASE("event stream: drop_oldest reports how much was lost") {
+  EventStream::Options o;
+  o.max_queue = 4;
+  o.overflow = EventStream::Overflow::DropOldest;
+  EventStream s(o);
+  std::vector<Event> in;
+  for (uint64_t i = 1; i <= 10; i++) in.push_back(ev(i, "window.changed", 7, "title"));
+  s.push(in);
+
+  EventStream::Batch b;
+  DOCTEST_REQUIRE(s.take(b, 100, 0ms));
+  DOCTEST_REQUIRE(b.gap);
+  DOCTEST_REQUIRE_EQ(b.dropped, 6u);
+  DOCTEST_REQUIRE_EQ(b.events.size(), 4u);
+  DOCTEST_REQUIRE_EQ(b.events[0].seq, 7u);
+  DOCTEST_REQUIRE_EQ(s.stats().coalesced, 0u);
+}
+
+DOCTEST_TEST_CASE("event stream: coalesce cancels short-lived windows and stale changes") {
+  EventStream::Options o;
+  o.max_queue = 3;
+  EventStream s(o);
+  s.push({
+      ev(1, "window.created", 10),
+      ev(2, "window.changed", 10, "title"),
+      ev(3, "window.changed", 20, "title"),
+      ev(4, "window.destroyed", 10), // 1, 2, 4 cancel out
+      ev(5, "window.changed", 20, "title"),
+      ev(6, "window.changed", 20, "rect"),
+  });
+
+  EventStream::Batch b;
+  DOCTEST_REQUIRE(s.take(b, 100, 0ms));
+  DOCTEST_REQUIRE(!b.gap); // coalescing alone lost nothing that mattered
+  DOCTEST_REQUIRE_EQ(b.events.size(), 2u);
+  DOCTEST_REQUIRE_EQ(b.events[0].seq, 5u); // last title change wins
+  DOCTEST_REQUIRE_EQ(b.events[1].seq, 6u);
+  DOCTEST_REQUIRE_EQ(s.stats().coalesced, 4u);
+}
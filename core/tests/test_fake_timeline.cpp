@@ -0,0 +1,98 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "doctest/doctest.h"
+#include "wininspect/fake_backend.hpp"
+#include "wininspect/fake_timeline.hpp"
+#include <set>
+
+using namespace wininspect;
+
+DOCTEST_TEST_CASE("fake timeline: deterministic and consistent with the desktop") {
+  FakeTimeline::Options o;
+  o.total = 2000;
+  o.seed = 7;
+  auto a = FakeTimeline::generate(o, {0x10, 0x20}, 0x100);
+  auto b = FakeTimeline::generate(o, {0x10, 0x20}, 0x100);
+  DOCTEST_REQUIRE_EQ(a.size(), 2000u);
+  std::set<hwnd_u64> live{0x10, 0x20};
+  size_t created = 0, destroyed = 0, changed = 0;
+  for (size_t i = 0; i < a.size(); i++) {
+    DOCTEST_REQUIRE(a[i].event.type == b[i].event.type);
+    DOCTEST_REQUIRE_EQ(a[i].event.hwnd, b[i].event.hwnd);
+    DOCTEST_REQUIRE(a[i].at == b[i].at);
+    const auto &e = a[i].event;
+    if (e.type == "window.created") {
+      DOCTEST_REQUIRE(live.insert(e.hwnd).second);
+      created++;
+    } else if (e.type == "window.destroyed") {
+      DOCTEST_REQUIRE_EQ(live.erase(e.hwnd), 1u);
+      destroyed++;
+    } else {
+      DOCTEST_REQUIRE(live.count(e.hwnd) == 1);
+      changed++;
+    }
+  }
+  // Roughly the requested 30/30/40 mix.
+  DOCTEST_REQUIRE(created > 400 && destroyed > 400 && changed > 600);
+
+  o.seed = 8;
+  auto c = FakeTimeline::generate(o, {0x10, 0x20}, 0x100);
+  bool differs = false;
+  for (size_t i = 0; i < c.size() && !differs; i++)
+    differs = c[i].event.hwnd != a[i].event.hwnd || c[i].event.type != a[i].event.type;
+  DOCTEST_REQUIRE(differs);
+}
+
+DOCTEST_TEST_CASE("fake timeline: shapes") {
+  using std::chrono::milliseconds;
+  FakeTimeline::Options o;
+  o.rate = 1000;
+  o.total = 1000;
+
+  o.shape = FakeTimeline::Shape::Steady;
+  auto steady = FakeTimeline::generate(o, {}, 1);
+  DOCTEST_REQUIRE(steady[1].at == milliseconds(1));
+  DOCTEST_REQUIRE(steady[999].at == milliseconds(999));
+
+  o.shape = FakeTimeline::Shape::Burst;
+  o.burst = 100;
+  auto burst = FakeTimeline::generate(o, {}, 1);
+  DOCTEST_REQUIRE(burst[0].at == burst[99].at);
+  DOCTEST_REQUIRE(burst[100].at == milliseconds(100));
+
+  o.shape = FakeTimeline::Shape::Sawtooth;
+  o.period_ms = 500;
+  auto saw = FakeTimeline::generate(o, {}, 1);
+  // 500 events per period: the first half of them take ~71% of the period.
+  DOCTEST_REQUIRE(saw[250].at > milliseconds(300));
+  DOCTEST_REQUIRE(saw[500].at == milliseconds(500));
+  for (size_t i = 1; i < saw.size(); i++) DOCTEST_REQUIRE(saw[i].at >= saw[i - 1].at);
+
+  DOCTEST_REQUIRE(FakeTimeline::shape_from_str("burst") == FakeTimeline::Shape::Burst);
+  DOCTEST_REQUIRE(!FakeTimeline::shape_from_str("square"));
+}
+
+DOCTEST_TEST_CASE("fake timeline: scripted source mutates the backend before pushing") {
+  FakeBackend fb({{0x10, 0, 0, "A", "C", true}});
+  DOCTEST_REQUIRE(fb.create_event_source() == nullptr);
+  FakeTimeline::Options o;
+  o.total = 200;
+  fb.set_timeline(o, false);
+  auto src = fb.create_event_source();
+  DOCTEST_REQUIRE(src != nullptr);
+  auto *scripted = static_cast<ScriptedEventSource *>(src.get());
+
+  size_t mismatches = 0;
+  Snapshot none;
+  src->start([&](std::vector<Event> &ev) {
+    for (const auto &e : ev) {
+      bool present = fb.get_info(none, e.hwnd).has_value();
+      if (present != (e.type != "window.destroyed")) mismatches++;
+    }
+  });
+  DOCTEST_REQUIRE(scripted->wait_done(std::chrono::milliseconds(3000)));
+  src->stop();
+  DOCTEST_REQUIRE_EQ(scripted->delivered(), 200u);
+  DOCTEST_REQUIRE_EQ(mismatches, 0u);
+}
@@ -0,0 +1,190 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "doctest/doctest.h"
+#include "wininspect/base64.hpp"
+#include "wininspect/core.hpp"
+#include "wininspect/fake_backend.hpp"
+#include "wininspect/mapped_file.hpp"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+using namespace wininspect;
+
+namespace {
+
+// Distinct bytes at every position, so a read from the wrong offset shows.
+std::string pattern(size_t n) {
+  std::string s(n, '\0');
+  for (size_t i = 0; i < n; i++) s[i] = (char)(i * 7 + i / 251);
+  return s;
+}
+
+CoreResponse call(CoreEngine &core, const std::string &method, json::Object params,
+                  bool binary = false) {
+  CoreRequest req{"f", method, std::move(params)};
+  req.binary = binary;
+  return core.handle(req, Snapshot{});
+}
+
+std::string content(const CoreResponse &r) {
+  auto b = base64::decode(r.result.as_obj().at("content_b64").as_str());
+  return std::string(b.begin(), b.end());
+}
+
+} // namespace
+
+DOCTEST_TEST_CASE("MappedFile: maps unaligned ranges, clipped to the file") {
+  auto path = (std::filesystem::temp_directory_path() / "wininspect_test_mapped_range").string();
+  auto data = pattern(300000);
+  std::ofstream(path, std::ios::binary | std::ios::trunc) << data;
+
+  for (uint64_t off : {0ull, 1ull, 4095ull, 4097ull, 65537ull, 299990ull}) {
+    MappedFile m(path, off, 5000);
+    DOCTEST_REQUIRE(m.valid());
+    DOCTEST_REQUIRE_EQ(m.file_size(), 300000u);
+    size_t want = std::min<size_t>(5000, 300000 - (size_t)off);
+    DOCTEST_REQUIRE_EQ(m.size(), want);
+    DOCTEST_REQUIRE(std::string((const char *)m.data(), m.size()) == data.substr((size_t)off, want));
+  }
+  MappedFile rest(path, 299000, 0); // 0: to the end
+  DOCTEST_REQUIRE_EQ(rest.size(), 1000u);
+
+  // Past the end: opened, with the size known, but nothing mapped.
+  MappedFile past(path, 300000, 10);
+  DOCTEST_REQUIRE(past.opened());
+  DOCTEST_REQUIRE(!past.valid());
+  DOCTEST_REQUIRE_EQ(past.file_size(), 300000u);
+
+  MappedFile moved(std::move(rest));
+  DOCTEST_REQUIRE_EQ(moved.size(), 1000u);
+  DOCTEST_REQUIRE(!rest.valid());
+
+  DOCTEST_REQUIRE(!MappedFile(path + ".missing", 0, 10).opened());
+  DOCTEST_REQUIRE(!MappedFile(std::filesystem::temp_directory_path().string(), 0, 10).opened());
+  std::filesystem::remove(path);
+}
+
+DOCTEST_TEST_CASE("file.read: ranges from real files") {
+  FakeBackend fb({});
+  CoreEngine core(&fb);
+  auto data = pattern(100000);
+  fb.add_file("C:\\logs\\app.log", data);
+
+  json::Object p;
+  p["path"] = std::string("C:\\logs\\app.log");
+  auto r = call(core, "file.read", p);
+  DOCTEST_REQUIRE(r.ok);
+  DOCTEST_REQUIRE(content(r) == data);
+  DOCTEST_REQUIRE(r.result.as_obj().at("eof").as_bool());
+
+  p["offset"] = 70000.0;
+  p["length"] = 20000.0;
+  r = call(core, "file.read", p);
+  DOCTEST_REQUIRE(r.ok);
+  const auto &o = r.result.as_obj();
+  DOCTEST_REQUIRE_EQ(o.at("offset").as_num(), 70000.0);
+  DOCTEST_REQUIRE_EQ(o.at("length").as_num(), 20000.0);
+  DOCTEST_REQUIRE_EQ(o.at("size").as_num(), 100000.0);
+  DOCTEST_REQUIRE(!o.at("eof").as_bool());
+  DOCTEST_REQUIRE(content(r) == data.substr(70000, 20000));
+
+  // Clipped at the end, empty past it, and raw for binary clients.
+  p["offset"] = 95000.0;
+  r = call(core, "file.read", p, true);
+  DOCTEST_REQUIRE(r.ok);
+  DOCTEST_REQUIRE_EQ(r.result.as_obj().at("length").as_num(), 5000.0);
+  DOCTEST_REQUIRE(r.result.as_obj().at("eof").as_bool());
+  DOCTEST_REQUIRE(std::string(r.attachments.at(0).begin(), r.attachments.at(0).end()) ==
+                  data.substr(95000));
+  p["offset"] = 200000.0;
+  r = call(core, "file.read", p);
+  DOCTEST_REQUIRE(r.ok);
+  DOCTEST_REQUIRE_EQ(r.result.as_obj().at("length").as_num(), 0.0);
+  p["offset"] = 0.0;
+  p["length"] = 0.0;
+  r = call(core, "file.read", p);
+  DOCTEST_REQUIRE(r.ok);
+  DOCTEST_REQUIRE_EQ(r.result.as_obj().at("size").as_num(), 100000.0);
+
+  p["offset"] = -1.0;
+  DOCTEST_REQUIRE_EQ(call(core, "file.read", p).error_code, std::string("E_BAD_REQUEST"));
+  p.erase("offset");
+  p["path"] = std::string("C:\\logs\\missing.log");
+  DOCTEST_REQUIRE_EQ(call(core, "file.read", p).error_code, std::string("E_READ_FAILED"));
+}
+
+DOCTEST_TEST_CASE("file.read: one response is capped below the frame limit") {
+  FakeBackend fb({});
+  CoreEngine core(&fb);
+  fb.add_file("big.bin", std::string(FILE_READ_MAX_BYTES + 1000, 'x'));
+  json::Object p;
+  p["path"] = std::string("big.bin");
+  p["length"] = 1e12;
+  auto r = call(core, "file.read", p, true);
+  DOCTEST_REQUIRE(r.ok);
+  DOCTEST_REQUIRE_EQ(r.attachments.at(0).size(), FILE_READ_MAX_BYTES);
+  DOCTEST_REQUIRE(!r.result.as_obj().at("eof").as_bool());
+  // Base64'd it still fits in a 10 MiB frame.
+  DOCTEST_REQUIRE((FILE_READ_MAX_BYTES + 2) / 3 * 4 < 10u * 1024 * 1024);
+}
+
+DOCTEST_TEST_CASE("file.tail: last lines, then what was appended") {
+  FakeBackend fb({});
+  CoreEngine core(&fb);
+  std::string log;
+  for (int i = 1; i <= 100; i++) log += "line " + std::to_string(i) + "\n";
+  fb.add_file("app.log", log);
+
+  json::Object p;
+  p["path"] = std::string("app.log");
+  p["lines"] = 3.0;
+  auto r = call(core, "file.tail", p);
+  DOCTEST_REQUIRE(r.ok);
+  DOCTEST_REQUIRE_EQ(content(r), std::string("line 98\nline 99\nline 100\n"));
+  double next = r.result.as_obj().at("next").as_num();
+  DOCTEST_REQUIRE_EQ(next, (double)log.size());
+
+  // Nothing new: an empty result at the same position.
+  p.erase("lines");
+  p["since"] = next;
+  r = call(core, "file.tail", p);
+  DOCTEST_REQUIRE(r.ok);
+  DOCTEST_REQUIRE_EQ(r.result.as_obj().at("length").as_num(), 0.0);
+  DOCTEST_REQUIRE_EQ(r.result.as_obj().at("next").as_num(), next);
+
+  // A long poll returns as soon as the file grows.
+  std::thread writer([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    fb.append_file("app.log", "line 101\n");
+  });
+  p["wait_ms"] = 5000.0;
+  auto t0 = std::chrono::steady_clock::now();
+  r = call(core, "file.tail", p);
+  writer.join();
+  DOCTEST_REQUIRE(std::chrono::steady_clock::now() - t0 < std::chrono::seconds(3));
+  DOCTEST_REQUIRE_EQ(content(r), std::string("line 101\n"));
+  DOCTEST_REQUIRE(!r.result.as_obj().at("truncated").as_bool());
+  next = r.result.as_obj().at("next").as_num();
+
+  // Rotated to something shorter: start over from the beginning.
+  fb.add_file("app.log", "fresh\n");
+  p["since"] = next;
+  p["wait_ms"] = 0.0;
+  r = call(core, "file.tail", p);
+  DOCTEST_REQUIRE(r.result.as_obj().at("truncated").as_bool());
+  DOCTEST_REQUIRE_EQ(content(r), std::string("fresh\n"));
+
+  // More than `max` behind: the next `max` bytes, then the caller reads on.
+  p["since"] = 0.0;
+  p["max"] = 3.0;
+  r = call(core, "file.tail", p);
+  DOCTEST_REQUIRE_EQ(content(r), std::string("fre"));
+  DOCTEST_REQUIRE(!r.result.as_obj().at("eof").as_bool());
+  DOCTEST_REQUIRE_EQ(r.result.as_obj().at("next").as_num(), 3.0);
+
+  p["path"] = std::string("missing.log");
+  DOCTEST_REQUIRE_EQ(call(core, "file.tail", p).error_code, std::string("E_READ_FAILED"));
+}
@@ -0,0 +1,102 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "doctest/doctest.h"
+#include "wininspect/regex_engine.hpp"
+#include <chrono>
+
+using namespace wininspect;
+
+DOCTEST_TEST_CASE("regex engine agrees with std::regex") {
+  const char *patterns[] = {
+      "abc", "^abc", "abc$", "^abc$", "a.c", "a*", "ab+c", "ab?c", "a{2}",
+      "a{2,}", "a{1,3}b", "colou?r", "[abc]+", "[^abc]", "[a-z]{3}", "[A-Z][a-z]+",
+      "\\d+", "\\D", "\\w+\\s\\w+", "\\S+$", "\\bNote", "pad\\b", "o\\B", "(ab)+",
+      "(?:ab|cd)e", "a|b|c", "^(Note|Word)pad", "x*?y", "a+?", "\\.", "\\+\\+$",
+      "[\\d.]+", "[a\\-z]", "[-a]", "[a-]", "[]a]", "()", "(a*)*b", "\\x41",
+      "\\u0041", "\\t", "[\\w]+!", ".*", "", "^$", "Untitled - .*",
+  };
+  const char *texts[] = {
+      "", "abc", "xabcx", "ab", "aac", "abbbc", "color", "colour", "aaa",
+      "Notepad", "Notepad++", "Wordpad", "The quick brown fox", "123.45",
+      "a-z", "]", "b", "ABC", "x y", "tab\there", "hello!", "Untitled - Notepad",
+      "line\nbreak", "cd", "abe", "cde", "xxxy",
+  };
+  for (bool icase : {false, true}) {
+    auto flags = std::regex::ECMAScript;
+    if (icase) flags |= std::regex::icase;
+    for (auto p : patterns) {
+      Regex mine(p, icase);
+      DOCTEST_REQUIRE(!mine.uses_fallback());
+      std::regex ref(p, flags);
+      for (auto t : texts) {
+        bool want = std::regex_search(std::string(t), ref);
+        if (mine.search(t) != want)
+          throw doctest::failure(std::string("mismatch: /") + p + "/ on \"" + t +
+                                 "\" icase=" + (icase ? "1" : "0"));
+      }
+    }
+  }
+}
+
+DOCTEST_TEST_CASE("regex engine falls back only for back-references") {
+  DOCTEST_REQUIRE(Regex("(a)\\1", false).uses_fallback());
+  DOCTEST_REQUIRE(Regex("(a)\\1", false).search("xaax"));
+  DOCTEST_REQUIRE(!Regex("(a)\\1", false).search("xax"));
+  DOCTEST_REQUIRE(!Regex("(a|b)+c", false).uses_fallback());
+}
+
+DOCTEST_TEST_CASE("regex engine rejects malformed patterns") {
+  const char *bad[] = {"(abc", "abc)", "[abc", "*a", "a**", "a{3,1}", "\\",
+                       "[z-a]", "\\q", "a{2}{3}"};
+  for (auto p : bad) {
+    bool threw = false;
+    try {
+      Regex r(p, false);
+    } catch (const RegexError &) {
+      threw = true;
+    }
+    if (!threw) throw doctest::failure(std::string("accepted: ") + p);
+  }
+  bool threw = false;
+  try {
+    Regex r("(?:a{1000}){1000}", false); // would expand to a huge NFA
+  } catch (const RegexError &) {
+    threw = true;
+  }
+  DOCTEST_REQUIRE(threw);
+}
+
+DOCTEST_TEST_CASE("regex engine is linear on catastrophic patterns") {
+  Regex re("^(a+)+$", false);
+  std::string text(20000, 'a');
+  text += 'b';
+  auto t0 = std::chrono::steady_clock::now();
+  DOCTEST_REQUIRE(!re.search(text));
+  auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - t0).count();
+  DOCTEST_REQUIRE(ms < 2000);
+}
+
+DOCTEST_TEST_CASE("regex cache is a bounded LRU keyed by flags") {
+  RegexCache cache(2);
+  auto a = cache.get("abc", false);
+  DOCTEST_REQUIRE(cache.get("abc", false) == a);
+  DOCTEST_REQUIRE(cache.get("abc", true) != a);
+  cache.get("abc", false); // touch: "abc"/icase becomes the LRU entry
+  cache.get("xyz", false);
+  auto st = cache.stats();
+  DOCTEST_REQUIRE_EQ(st.size, 2u);
+  DOCTEST_REQUIRE_EQ(st.evictions, 1u);
+  DOCTEST_REQUIRE_EQ(st.hits, 2u);
+  DOCTEST_REQUIRE(cache.get("abc", false) == a);
+
+  bool threw = false;
+  try {
+    cache.get("(", false);
+  } catch (const RegexError &) {
+    threw = true;
+  }
+  DOCTEST_REQUIRE(threw);
+  DOCTEST_REQUIRE_EQ(cache.stats().size, 2u);
+}
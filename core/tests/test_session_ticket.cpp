@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "doctest/doctest.h"
+#include "wininspect/base64.hpp"
+#include "wininspect/crypto.hpp"
+#include "wininspect/session_ticket.hpp"
+#include <cstring>
+
+using namespace wininspect;
+using namespace std::chrono_literals;
+
+namespace {
+
+bool have_backend() { return std::string(crypto::backend_name()) != "none"; }
+
+std::array<std::uint8_t, 32> secret_of(std::uint8_t fill) {
+  std::array<std::uint8_t, 32> s;
+  s.fill(fill);
+  return s;
+}
+
+} // namespace
+
+DOCTEST_TEST_CASE("TicketKeeper: a ticket redeems once for its identity and secret") {
+  if (!have_backend()) return;
+  TicketKeeper keeper(1h);
+  auto t0 = TicketKeeper::Clock::now();
+  auto ticket = keeper.issue("alice@host", secret_of(7), t0);
+  DOCTEST_REQUIRE(!ticket.empty());
+
+  auto claims = keeper.redeem(ticket, t0 + 1s);
+  DOCTEST_REQUIRE(claims.has_value());
+  DOCTEST_REQUIRE_EQ(claims->identity, std::string("alice@host"));
+  DOCTEST_REQUIRE(claims->secret == secret_of(7));
+  DOCTEST_REQUIRE(!keeper.redeem(ticket, t0 + 2s)); // replayed
+
+  // Another keeper (a restarted daemon) cannot read it, nor a changed byte.
+  auto other = keeper.issue("alice@host", secret_of(7), t0);
+  TicketKeeper stranger(1h);
+  DOCTEST_REQUIRE(!stranger.redeem(other, t0));
+  auto raw = base64::decode(other);
+  raw.back() ^= 1;
+  DOCTEST_REQUIRE(!keeper.redeem(base64::encode(raw), t0));
+  DOCTEST_REQUIRE(!keeper.redeem("not a ticket", t0));
+}
+
+DOCTEST_TEST_CASE("TicketKeeper: tickets expire and keys rotate") {
+  if (!have_backend()) return;
+  TicketKeeper keeper(10min);
+  auto t0 = TicketKeeper::Clock::now();
+  auto early = keeper.issue("bob", secret_of(1), t0);
+  auto late = keeper.issue("bob", secret_of(2), t0 + 9min);
+  DOCTEST_REQUIRE(!keeper.redeem(early, t0 + 10min)); // expired; the key rotates
+
+  // Issued just before the rotation, redeemed after it: the previous key
+  // still opens it, up to its expiry.
+  auto fresh = keeper.issue("bob", secret_of(3), t0 + 11min);
+  DOCTEST_REQUIRE(keeper.redeem(late, t0 + 18min + 59s).has_value());
+  DOCTEST_REQUIRE(keeper.redeem(fresh, t0 + 20min + 59s).has_value());
+  DOCTEST_REQUIRE(!keeper.redeem(keeper.issue("bob", secret_of(4), t0 + 21min), t0 + 31min));
+}
+
+DOCTEST_TEST_CASE("TicketKeeper: both ends derive the same resumed key") {
+  if (!have_backend()) return;
+  crypto::CryptoSession server(crypto::Role::Server), client;
+  auto spub = server.generate_local_key(), cpub = client.generate_local_key();
+  DOCTEST_REQUIRE(server.compute_shared_secret(cpub));
+  DOCTEST_REQUIRE(client.compute_shared_secret(spub));
+  DOCTEST_REQUIRE(server.resumption_secret() == client.resumption_secret());
+
+  std::vector<std::uint8_t> nonce(32, 0xAA), r1(32, 0x01), r2(32, 0x02);
+  std::uint8_t k_server[32], k_client[32], k_other[32];
+  DOCTEST_REQUIRE(TicketKeeper::derive_key(server.resumption_secret(), nonce, r1, k_server));
+  DOCTEST_REQUIRE(TicketKeeper::derive_key(client.resumption_secret(), nonce, r1, k_client));
+  DOCTEST_REQUIRE(TicketKeeper::derive_key(client.resumption_secret(), nonce, r2, k_other));
+  DOCTEST_REQUIRE(std::memcmp(k_server, k_client, 32) == 0);
+  DOCTEST_REQUIRE(std::memcmp(k_client, k_other, 32) != 0);
+  DOCTEST_REQUIRE(!TicketKeeper::derive_key(client.resumption_secret(), {nonce.data(), 8}, r1,
+                                            k_other));
+
+  // The resumed sessions talk, and hand on a secret of their own.
+  crypto::CryptoSession rs(crypto::Role::Server), rc;
+  DOCTEST_REQUIRE(rs.install_key(k_server));
+  DOCTEST_REQUIRE(rc.install_key(k_client));
+  DOCTEST_REQUIRE_EQ(rs.decrypt(rc.encrypt("again")), std::string("again"));
+  DOCTEST_REQUIRE(rs.resumption_secret() == rc.resumption_secret());
+  DOCTEST_REQUIRE(rs.resumption_secret() != server.resumption_secret());
+}
@@ -0,0 +1,150 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "doctest/doctest.h"
+#include "wininspect/snapshot_journal.hpp"
+#include "wininspect/window_index.hpp"
+#include <filesystem>
+#include <limits>
+
+using namespace wininspect;
+namespace fs = std::filesystem;
+
+namespace {
+
+struct TempDir {
+  fs::path path;
+  explicit TempDir(const char *name) {
+    path = fs::temp_directory_path() / name;
+    fs::remove_all(path);
+  }
+  ~TempDir() {
+    std::error_code ec;
+    fs::remove_all(path, ec);
+  }
+};
+
+Snapshot make_snap(int n, const std::string &tag) {
+  Snapshot s;
+  std::vector<IndexedWindow> w;
+  for (int i = 0; i < n; i++) {
+    s.top.push_back(0x1000 + i);
+    w.push_back({(hwnd_u64)(0x1000 + i), tag + " window " + std::to_string(i), "Cls" + std::to_string(i)});
+  }
+  s.index = std::make_shared<WindowIndex>(std::move(w));
+  return s;
+}
+
+constexpr int64_t ALL_MIN = std::numeric_limits<int64_t>::min();
+constexpr int64_t ALL_MAX = std::numeric_limits<int64_t>::max();
+
+size_t segment_files(const fs::path &dir) {
+  size_t n = 0;
+  for (const auto &de : fs::directory_iterator(dir))
+    if (de.path().extension() == ".wij") n++;
+  return n;
+}
+
+} // namespace
+
+DOCTEST_TEST_CASE("snapshot journal: roundtrip and reopen") {
+  TempDir tmp("wininspect_journal_rt");
+  uint64_t a, b;
+  {
+    SnapshotJournal j({tmp.path.string()});
+    a = j.append(make_snap(3, "a"));
+    b = j.append(make_snap(5, "b"));
+    DOCTEST_REQUIRE(a != 0 && b == a + 1);
+    j.flush();
+
+    auto rec = j.record(b);
+    DOCTEST_REQUIRE(rec.has_value());
+    DOCTEST_REQUIRE_EQ(rec->size(), 5u);
+    DOCTEST_REQUIRE_EQ(rec->window(2).hwnd, 0x1002u);
+    DOCTEST_REQUIRE(rec->window(2).title == "b window 2");
+    DOCTEST_REQUIRE(rec->window(4).class_name == "Cls4");
+    DOCTEST_REQUIRE_EQ(j.list(ALL_MIN, ALL_MAX, 0).size(), 2u);
+  }
+  // Reopen: the segment was sealed on shutdown and numbering continues.
+  SnapshotJournal j({tmp.path.string()});
+  auto ents = j.list(ALL_MIN, ALL_MAX, 0);
+  DOCTEST_REQUIRE_EQ(ents.size(), 2u);
+  DOCTEST_REQUIRE_EQ(ents[0].seq, a);
+  DOCTEST_REQUIRE_EQ(ents[1].window_count, 5u);
+  auto snap = j.load(a);
+  DOCTEST_REQUIRE(snap.has_value());
+  DOCTEST_REQUIRE_EQ(snap->top.size(), 3u);
+  DOCTEST_REQUIRE_EQ(snap->index->find({"a window 1", "", MatchMode::Exact, false}).size(), 1u);
+  DOCTEST_REQUIRE_EQ(j.append(make_snap(1, "c")), b + 1);
+  DOCTEST_REQUIRE(!j.load(9999).has_value());
+
+  auto limited = j.list(ALL_MIN, ALL_MAX, 1);
+  DOCTEST_REQUIRE_EQ(limited.size(), 1u);
+  DOCTEST_REQUIRE_EQ(limited[0].seq, b);
+}
+
+DOCTEST_TEST_CASE("snapshot journal: unchanged snapshots share window data") {
+  TempDir tmp("wininspect_journal_dedup");
+  SnapshotJournal j({tmp.path.string()});
+  auto s = make_snap(50, "same");
+  uint64_t first = j.append(s);
+  uint64_t second = j.append(s);
+  j.flush();
+  DOCTEST_REQUIRE_EQ(j.stats().unchanged, 1u);
+  auto rec = j.record(second);
+  DOCTEST_REQUIRE(rec.has_value());
+  DOCTEST_REQUIRE_EQ(rec->size(), 50u);
+  DOCTEST_REQUIRE(rec->window(49).title == "same window 49");
+  DOCTEST_REQUIRE(j.record(first)->window(0).title == rec->window(0).title);
+}
+
+DOCTEST_TEST_CASE("snapshot journal: rotation and retention") {
+  TempDir tmp("wininspect_journal_rot");
+  SnapshotJournal::Options o;
+  o.dir = tmp.path.string();
+  o.segment_bytes = 4096;
+  o.max_segments = 3;
+  o.flush_interval_ms = 0;
+  uint64_t last = 0;
+  {
+    SnapshotJournal j(o);
+    for (int i = 0; i < 40; i++) {
+      last = j.append(make_snap(20, "r" + std::to_string(i)));
+      j.flush();
+    }
+    DOCTEST_REQUIRE(j.stats().segments <= 3u);
+    auto rec = j.record(last);
+    DOCTEST_REQUIRE(rec.has_value());
+    DOCTEST_REQUIRE(rec->window(0).title == "r39 window 0");
+    DOCTEST_REQUIRE(!j.record(1).has_value()); // retired with its segment
+  }
+  DOCTEST_REQUIRE(segment_files(tmp.path) <= 3u);
+}
+
+DOCTEST_TEST_CASE("snapshot journal: torn tail is recovered on open") {
+  TempDir tmp("wininspect_journal_crash");
+  {
+    SnapshotJournal j({tmp.path.string()});
+    j.append(make_snap(4, "x"));
+    j.append(make_snap(4, "y"));
+  }
+  // Simulate a crash mid-write: strip the index/trailer and half a record.
+  fs::path seg = tmp.path / SnapshotJournal::segment_name(1);
+  auto view = JournalSegment::open(seg.string());
+  DOCTEST_REQUIRE(view && view->sealed());
+  uint64_t second_off = view->entries()[1].offset;
+  view.reset();
+  fs::resize_file(seg, second_off + 30);
+
+  view = JournalSegment::open(seg.string());
+  DOCTEST_REQUIRE(view && !view->sealed());
+  DOCTEST_REQUIRE_EQ(view->entries().size(), 1u);
+  view.reset();
+
+  SnapshotJournal j({tmp.path.string()});
+  auto ents = j.list(ALL_MIN, ALL_MAX, 0);
+  DOCTEST_REQUIRE_EQ(ents.size(), 1u);
+  DOCTEST_REQUIRE(j.record(1)->window(3).title == "x window 3");
+  DOCTEST_REQUIRE(JournalSegment::open(seg.string())->sealed());
+  DOCTEST_REQUIRE_EQ(j.append(make_snap(1, "z")), 2u);
+}
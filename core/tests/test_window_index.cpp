@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "doctest/doctest.h"
+#include "wininspect/core.hpp"
+#include "wininspect/fake_backend.hpp"
+#include "wininspect/window_index.hpp"
+
+using namespace wininspect;
+
+static WindowIndex make_index() {
+  return WindowIndex({
+      {0x10, "Untitled - Notepad", "Notepad"},
+      {0x20, "Program Manager", "Progman"},
+      {0x30, "README.md - Notepad++", "Notepad++"},
+      {0x40, "Calculator", "ApplicationFrameWindow"},
+      {0x50, "", "Shell_TrayWnd"},
+  });
+}
+
+DOCTEST_TEST_CASE("window index: substring narrows via postings") {
+  auto idx = make_index();
+  WindowQueryStats st;
+  auto r = idx.find({"Notepad", "", MatchMode::Substring, false}, &st);
+  DOCTEST_REQUIRE_EQ(r.size(), 2u);
+  DOCTEST_REQUIRE_EQ(r[0], 0x10u);
+  DOCTEST_REQUIRE_EQ(r[1], 0x30u);
+  DOCTEST_REQUIRE(!st.full_scan);
+  DOCTEST_REQUIRE_EQ(st.candidates, 2u);
+
+  DOCTEST_REQUIRE(idx.find({"notepad", "", MatchMode::Substring, false}).empty());
+  DOCTEST_REQUIRE_EQ(idx.find({"notepad", "", MatchMode::Substring, true}).size(), 2u);
+  DOCTEST_REQUIRE(idx.find({"Wordpad", "", MatchMode::Substring, false}).empty());
+}
+
+DOCTEST_TEST_CASE("window index: prefix and exact") {
+  auto idx = make_index();
+  auto r = idx.find({"", "Notepad", MatchMode::Prefix, false});
+  DOCTEST_REQUIRE_EQ(r.size(), 2u);
+  r = idx.find({"", "Notepad", MatchMode::Exact, false});
+  DOCTEST_REQUIRE_EQ(r.size(), 1u);
+  DOCTEST_REQUIRE_EQ(r[0], 0x10u);
+  r = idx.find({"calc", "", MatchMode::Prefix, true});
+  DOCTEST_REQUIRE_EQ(r.size(), 1u);
+  DOCTEST_REQUIRE_EQ(r[0], 0x40u);
+  // Patterns shorter than a trigram still work, by scanning.
+  WindowQueryStats st;
+  r = idx.find({"Pr", "", MatchMode::Prefix, false}, &st);
+  DOCTEST_REQUIRE_EQ(r.size(), 1u);
+  DOCTEST_REQUIRE(st.full_scan);
+}
+
+DOCTEST_TEST_CASE("window index: regex uses mandatory literals") {
+  auto idx = make_index();
+  WindowQueryStats st;
+  auto r = idx.find({"^README\\.md - .*\\+\\+$", "", MatchMode::Regex, false}, &st);
+  DOCTEST_REQUIRE_EQ(r.size(), 1u);
+  DOCTEST_REQUIRE_EQ(r[0], 0x30u);
+  DOCTEST_REQUIRE(!st.full_scan);
+  DOCTEST_REQUIRE_EQ(st.candidates, 1u);
+
+  // Alternation has no mandatory literal: falls back to verifying everything.
+  r = idx.find({"Calc|Manager", "", MatchMode::Regex, false}, &st);
+  DOCTEST_REQUIRE_EQ(r.size(), 2u);
+  DOCTEST_REQUIRE(st.full_scan);
+
+  // Optional atoms must not be required by the index.
+  r = idx.find({"Note(pad)?\\+*", "", MatchMode::Regex, false});
+  DOCTEST_REQUIRE_EQ(r.size(), 2u);
+  r = idx.find({"Calcx?ulator", "", MatchMode::Regex, false});
+  DOCTEST_REQUIRE_EQ(r.size(), 1u);
+  r = idx.find({"[Uu]ntitled", "notepad", MatchMode::Regex, true});
+  DOCTEST_REQUIRE_EQ(r.size(), 1u);
+  DOCTEST_REQUIRE_EQ(r[0], 0x10u);
+  r = idx.find({".*", ".*", MatchMode::Regex, false});
+  DOCTEST_REQUIRE_EQ(r.size(), 5u);
+}
+
+DOCTEST_TEST_CASE("window index: lazy loader runs once") {
+  int loads = 0;
+  WindowIndex idx({0x1, 0x2}, [&](hwnd_u64 h) {
+    loads++;
+    return IndexedWindow{0, h == 0x1 ? "alpha window" : "beta window", "Cls"};
+  });
+  DOCTEST_REQUIRE_EQ(loads, 0);
+  DOCTEST_REQUIRE_EQ(idx.find({"beta", "", MatchMode::Substring, false}).size(), 1u);
+  DOCTEST_REQUIRE_EQ(idx.find({"window", "", MatchMode::Substring, false}).size(), 2u);
+  DOCTEST_REQUIRE_EQ(loads, 2);
+}
+
+DOCTEST_TEST_CASE("window.findRegex searches the snapshot index") {
+  FakeBackend fb({{0x1, 0, 0, "Main Window", "MainCls", true},
+                  {0x2, 0, 0, "Settings", "DialogCls", true},
+                  {0x3, 0x1, 0, "Child Main", "ChildCls", true}});
+  CoreEngine core(&fb);
+  json::Object p;
+  p["title_regex"] = std::string("main");
+  p["mode"] = std::string("substring");
+  p["case_insensitive"] = true;
+  CoreRequest req{"f1", "window.findRegex", p};
+  auto r = core.handle(req, fb.capture_snapshot());
+  DOCTEST_REQUIRE(r.ok);
+  DOCTEST_REQUIRE_EQ(r.result.as_arr().size(), 1u);
+  DOCTEST_REQUIRE_EQ(r.result.as_arr()[0].as_obj().at("hwnd").as_str(), std::string("0x1"));
+
+  p["mode"] = std::string("fuzzy");
+  CoreRequest bad{"f2", "window.findRegex", p};
+  auto r2 = core.handle(bad, fb.capture_snapshot());
+  DOCTEST_REQUIRE(!r2.ok);
+  DOCTEST_REQUIRE_EQ(r2.error_code, std::string("E_BAD_REQUEST"));
+
+  json::Object p3;
+  p3["title_regex"] = std::string("(unclosed");
+  CoreRequest bad_re{"f3", "window.findRegex", p3};
+  auto r3 = core.handle(bad_re, fb.capture_snapshot());
+  DOCTEST_REQUIRE(!r3.ok);
+}
@@ -2,12 +2,78 @@
 
 #include "wininspect/core.hpp"
 #include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
+
+namespace wininspect { struct ServerState; }
 
 namespace wininspectd {
 
+class EventFeeds;
+class HttpConnection;
+class IListener;
+class IoService;
+
+/// The REST gateway, SSE event feed and dashboard, over HTTP/1.1.
+/// Connections are persistent and may pipeline; they are read by the
+/// state's IoService (or a private one) and requests run on its threads,
+/// up to max_inflight per connection, with responses sent in request
+/// order. Requests go through the same pipeline as pipe and TCP clients
+/// (method allow/deny lists, read-only, sessions, stored snapshots). st
+/// enables GET /api/v1/events (SSE); without it that path is a 404 and
+/// the server keeps a private state.
+class HttpServer {
+public:
+  HttpServer(wininspect::CoreEngine &core, std::string auth_token,
+             wininspect::ServerState *st = nullptr, bool read_only = false,
+             bool no_clipboard = false);
+  ~HttpServer();
+
+  /// Blocks until `running` is cleared or stop() is called. Port 0 binds
+  /// an ephemeral port (see bound_port).
+  void start(std::atomic<bool> *running, int port);
+  /// Makes start() return and ends the event feeds, waiting for their
+  /// threads; safe from any thread.
+  void stop();
+  int bound_port() const { return bound_port_.load(); }
+
+  /// Largest request head and body accepted (431 and 413 beyond).
+  static constexpr size_t MAX_HEAD_BYTES = 64 * 1024;
+  static constexpr size_t MAX_BODY_BYTES = 10 * 1024 * 1024;
+  /// A connection with nothing in progress is closed after this long.
+  static constexpr int IDLE_TIMEOUT_MS = 30000;
+  /// Most requests in one POST /api/v1/rpc batch.
+  static constexpr size_t MAX_BATCH = 64;
+
+private:
+  void sweep();
+
+  wininspect::CoreEngine &core_;
+  std::string auth_token_;
+  std::unique_ptr<wininspect::ServerState> own_state_; // if none was given
+  wininspect::ServerState *st_;
+  bool read_only_, no_clipboard_;
+  std::atomic<bool> *running_ = nullptr;
+  IoService *io_ = nullptr;
+  std::unique_ptr<IoService> own_io_; // if the state has none
+  std::mutex conns_mu_;               // protects conns_, last_sweep_ms_
+  std::vector<std::weak_ptr<HttpConnection>> conns_;
+  std::int64_t last_sweep_ms_ = 0;
+  std::mutex listen_mu_;
+  IListener *listener_ = nullptr; // owned by start()
+  bool stopped_ = false;
+  std::atomic<int> bound_port_{0};
+  std::shared_ptr<EventFeeds> feeds_; // shared with the connections
+};
+
+/// Runs an HttpServer on `port` until `running` is cleared.
 void run_http_server(std::atomic<bool> *running, int port,
                       wininspect::CoreEngine &core,
-                      const std::string &auth_token);
+                      const std::string &auth_token,
+                      wininspect::ServerState *st = nullptr,
+                      bool read_only = false, bool no_clipboard = false);
 
 } // namespace wininspectd
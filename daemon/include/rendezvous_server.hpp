@@ -0,0 +1,57 @@
+#pragma once
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace wininspectd {
+
+class IListener;
+class IoService;
+class RendezvousConnection;
+class RendezvousRegistry;
+
+/// The rendezvous HTTP service (wininspect-rendezvous) over a
+/// RendezvousRegistry. Daemons keep one connection open and heartbeat on
+/// it; requests are answered inline on the I/O threads, since each is a
+/// single registry operation. Watchers poll
+/// GET /api/v1/rendezvous/instances?since=V for what changed after V.
+class RendezvousServer {
+public:
+  /// `io_threads` 0 = one per core.
+  explicit RendezvousServer(RendezvousRegistry &registry, size_t io_threads = 0);
+  ~RendezvousServer();
+
+  /// Blocks until `running` is cleared or stop() is called, expiring
+  /// instances as it goes. Port 0 binds an ephemeral port.
+  void start(std::atomic<bool> *running, int port);
+  /// Makes start() return; safe from any thread.
+  void stop();
+  int bound_port() const { return bound_port_.load(); }
+
+  /// Limits on what a registration may ask for.
+  static constexpr int MIN_TTL_SEC = 1;
+  static constexpr int MAX_TTL_SEC = 3600;
+  /// A connection that sends nothing for this long is closed; longer than
+  /// the default heartbeat interval, so a daemon keeps its connection.
+  static constexpr int IDLE_TIMEOUT_MS = 120000;
+
+private:
+  void sweep(std::int64_t now);
+
+  RendezvousRegistry &registry_;
+  std::unique_ptr<IoService> io_;
+  std::mutex conns_mu_; // protects conns_, last_sweep_ms_
+  std::vector<std::weak_ptr<RendezvousConnection>> conns_;
+  std::int64_t last_sweep_ms_ = 0;
+  std::mutex listen_mu_;
+  IListener *listener_ = nullptr; // owned by start()
+  bool stopped_ = false;
+  std::atomic<int> bound_port_{0};
+};
+
+} // namespace wininspectd
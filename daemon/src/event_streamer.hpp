@@ -0,0 +1,112 @@
+#pragma once
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+// events.stream: pushes event frames down a persistent connection.
+//
+// Each stream pulls from the shared event ring (lock-free, own cursor) into
+// the connection's bounded EventStream and writes frames as credit allows.
+// It has no thread: a PushTask runs it on the I/O threads when the ring
+// moves past its cursor or the client grants credit. Frames are tagged
+// `"push": "events"` and carry no `id`, so clients can tell them from
+// responses.
+
+#include <atomic>
+#include <functional>
+#include "push_task.hpp"
+#include "server_state.hpp"
+#include "wininspect/event_stream.hpp"
+
+namespace wininspectd {
+
+inline wininspect::json::Object event_json(const wininspect::Event &e) {
+  wininspect::json::Object o;
+  o["seq"] = (double)e.seq;
+  o["type"] = e.type;
+  o["hwnd"] = wininspect::Hwnd(e.hwnd).to_string();
+  if (!e.property.empty()) o["property"] = e.property;
+  return o;
+}
+
+class EventStreamer final : public EventPusher {
+public:
+  // Runs on an I/O thread; the transport serializes it with its own
+  // response writes. Returning false ends the stream.
+  using Writer = std::function<bool(const std::string &frame, std::uint32_t flags)>;
+
+  // With `filtered`, streams that subscription's log instead of the shared one.
+  EventStreamer(wininspect::ServerState *st, IoService *io,
+                std::shared_ptr<wininspect::FilteredSubscription> filtered, Writer writer,
+                std::string id, std::uint64_t since, wininspect::EventStream::Options opts)
+      : st_(st), filtered_(std::move(filtered)),
+        log_(filtered_ ? &filtered_->events() : st->event_log.get()),
+        writer_(std::move(writer)), id_(std::move(id)), cursor_(since), stream_(opts),
+        task_(io, [this] { return step(); }) {}
+
+  // Waits for a step in progress, so the writer is not called after this.
+  ~EventStreamer() override {
+    if (started_) unwatch_events(st_, this);
+    task_.stop();
+  }
+
+  EventStreamer(const EventStreamer &) = delete;
+  EventStreamer &operator=(const EventStreamer &) = delete;
+
+  // Called by the transport after the events.stream response is written,
+  // so no frame can overtake it. Idempotent.
+  void start() {
+    if (started_.exchange(true)) return;
+    watch_events(st_, this);
+    task_.wake();
+  }
+
+  std::uint64_t grant(std::uint64_t n) {
+    auto credit = stream_.grant(n);
+    if (started_) task_.wake();
+    return credit;
+  }
+  const std::string &id() const { return id_; }
+  std::uint64_t cursor() const { return cursor_.load(); }
+  wininspect::EventStream::Stats stats() const { return stream_.stats(); }
+
+  void on_publish() override {
+    if (log_->head() != cursor_.load()) task_.wake();
+  }
+
+private:
+  PushTask::Next step() {
+    std::vector<wininspect::Event> events;
+    auto r = log_->read(cursor_, events, 1024);
+    cursor_ = r.last_seq;
+    if (!events.empty() || r.gap) stream_.push(events, r.gap);
+
+    wininspect::EventStream::Batch b;
+    if (stream_.take(b, 256, std::chrono::milliseconds(0))) {
+      wininspect::json::Array arr;
+      for (const auto &e : b.events) arr.push_back(event_json(e));
+      wininspect::json::Object frame;
+      frame["push"] = "events";
+      frame["stream_id"] = id_;
+      frame["events"] = arr;
+      frame["gap"] = b.gap;
+      if (b.dropped) frame["dropped"] = (double)b.dropped;
+      frame["credit"] = (double)stream_.stats().credit;
+      if (!writer_(wininspect::json::dumps(frame), 0)) return PushTask::Next::Done;
+    }
+    auto s = stream_.stats();
+    bool more = (s.queued > 0 && s.credit > 0) || log_->head() != cursor_.load();
+    return more ? PushTask::Next::Again : PushTask::Next::Sleep;
+  }
+
+  wininspect::ServerState *st_;
+  std::shared_ptr<wininspect::FilteredSubscription> filtered_; // keeps log_ alive
+  const wininspect::EventRing *log_;
+  Writer writer_;
+  std::string id_;
+  std::atomic<std::uint64_t> cursor_;
+  wininspect::EventStream stream_;
+  std::atomic<bool> started_{false};
+  PushTask task_; // last: stopped before the members its step uses go
+};
+
+} // namespace wininspectd
@@ -0,0 +1,124 @@
+#pragma once
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+// file.read with "stream": true: pushes a file down a persistent connection
+// in bounded chunks, as fast as the client grants credit.
+//
+// Each step reads one chunk through the core's file.read, so only that
+// range of the file is ever mapped, and writes it as a frame tagged
+// `"push": "file"` (multipart when the client takes attachments). Steps
+// run on the I/O threads (see PushTask), one chunk per turn; each chunk
+// uses one unit of credit, and at zero the stream sleeps until file.credit.
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include "push_task.hpp"
+#include "transport.hpp"
+#include "wininspect/core.hpp"
+
+namespace wininspectd {
+
+class FileStreamer {
+public:
+  // As for EventStreamer; `flags` is 0 or FRAME_MULTIPART.
+  using Writer = std::function<bool(const std::string &frame, std::uint32_t flags)>;
+
+  struct Options {
+    std::uint64_t offset = 0;
+    std::uint64_t end = std::numeric_limits<std::uint64_t>::max(); // or the file's end
+    size_t chunk = 256 * 1024;
+    std::uint64_t credit = 4; // chunks sent before the first grant
+  };
+
+  // `read` is a file.read request carrying the path and the client's
+  // binary flag; each chunk sets its offset and length.
+  FileStreamer(wininspect::CoreEngine &core, IoService *io, Writer writer, std::string id,
+               wininspect::CoreRequest read, Options opts)
+      : core_(core), writer_(std::move(writer)), id_(std::move(id)), read_(std::move(read)),
+        opts_(opts), offset_(opts.offset), credit_(opts.credit),
+        task_(io, [this] { return step(); }) {}
+
+  // Waits for a chunk in progress, so the writer is not called after this.
+  ~FileStreamer() { task_.stop(); }
+
+  FileStreamer(const FileStreamer &) = delete;
+  FileStreamer &operator=(const FileStreamer &) = delete;
+
+  // Called by the transport after the file.read response is written, so
+  // no chunk can overtake it. Idempotent.
+  void start() {
+    if (!started_.exchange(true)) task_.wake();
+  }
+
+  std::uint64_t grant(std::uint64_t n) {
+    std::uint64_t credit;
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      credit = credit_ += n;
+    }
+    if (started_) task_.wake();
+    return credit;
+  }
+  const std::string &id() const { return id_; }
+
+private:
+  PushTask::Next step() {
+    std::uint64_t credit;
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      if (credit_ == 0) return PushTask::Next::Sleep;
+      credit = --credit_;
+    }
+    size_t n = (size_t)std::min<std::uint64_t>(opts_.chunk, opts_.end - offset_);
+    read_.params["offset"] = (double)offset_;
+    read_.params["length"] = (double)n;
+    auto resp = core_.handle(read_, wininspect::Snapshot{});
+
+    wininspect::json::Object frame;
+    bool last = true;
+    if (resp.ok) {
+      frame = resp.result.as_obj();
+      auto len = (std::uint64_t)frame["length"].as_num();
+      offset_ += len;
+      last = frame["eof"].as_bool() || offset_ >= opts_.end || len == 0;
+    } else {
+      wininspect::json::Object e;
+      e["code"] = resp.error_code;
+      e["message"] = resp.error_message;
+      frame["error"] = e;
+    }
+    frame["push"] = "file";
+    frame["stream_id"] = id_;
+    frame["last"] = last;
+    frame["credit"] = (double)credit;
+
+    auto json = wininspect::json::dumps(frame);
+    bool ok;
+    if (resp.attachments.empty()) {
+      ok = writer_(json, 0);
+    } else {
+      std::string payload;
+      wininspect::append_multipart(payload, json, resp.attachments);
+      ok = writer_(payload, FRAME_MULTIPART);
+    }
+    if (!ok || last) return PushTask::Next::Done;
+    return credit > 0 ? PushTask::Next::Again : PushTask::Next::Sleep;
+  }
+
+  wininspect::CoreEngine &core_;
+  Writer writer_;
+  std::string id_;
+  wininspect::CoreRequest read_; // step only
+  Options opts_;
+  std::uint64_t offset_;         // step only
+  std::mutex mu_;
+  std::uint64_t credit_;
+  std::atomic<bool> started_{false};
+  PushTask task_; // last: stopped before the members its step uses go
+};
+
+} // namespace wininspectd
@@ -0,0 +1,213 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "http_parser.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <sstream>
+
+namespace wininspectd {
+
+namespace {
+
+std::string lower(std::string s) {
+  for (auto &c : s) c = (char)std::tolower((unsigned char)c);
+  return s;
+}
+
+} // namespace
+
+// ── Responses ───────────────────────────────────────────────────────────────
+
+std::string build_head(const HttpResp &r, bool keep_alive) {
+  std::ostringstream ss;
+  ss << "HTTP/1.1 " << r.code << " " << r.status << "\r\n"
+     << "Content-Type: " << r.content_type << "\r\n"
+     << "Connection: " << (keep_alive ? "keep-alive" : "close") << "\r\n"
+     << "Access-Control-Allow-Origin: *\r\n"
+     << "Access-Control-Allow-Methods: GET, POST, OPTIONS\r\n"
+     << "Access-Control-Allow-Headers: Content-Type, Authorization\r\n";
+  for (auto &h : r.headers) ss << h.first << ": " << h.second << "\r\n";
+  return ss.str();
+}
+
+std::string build_response(const HttpResp &r, bool keep_alive) {
+  return build_head(r, keep_alive) + "Content-Length: " + std::to_string(r.body.size()) +
+         "\r\n\r\n" + r.body;
+}
+
+HttpResp error_resp(int code, const char *status, const char *error) {
+  HttpResp r;
+  r.code = code;
+  r.status = status;
+  r.body = std::string("{\"error\":\"") + error + "\"}";
+  return r;
+}
+
+bool query_param(const std::string &query, const char *name, std::string &out) {
+  size_t n = std::strlen(name);
+  for (size_t pos = 0; pos <= query.size();) {
+    size_t end = query.find('&', pos);
+    if (end == std::string::npos) end = query.size();
+    if (end - pos > n && query.compare(pos, n, name) == 0 && query[pos + n] == '=') {
+      out.clear();
+      for (size_t i = pos + n + 1; i < end; i++) {
+        char c = query[i];
+        if (c == '+') c = ' ';
+        if (c == '%' && i + 2 < end + 1 && std::isxdigit((unsigned char)query[i + 1]) &&
+            std::isxdigit((unsigned char)query[i + 2])) {
+          c = (char)std::stoi(query.substr(i + 1, 2), nullptr, 16);
+          i += 2;
+        }
+        out += c;
+      }
+      return true;
+    }
+    pos = end + 1;
+  }
+  return false;
+}
+
+// ── HttpParser ──────────────────────────────────────────────────────────────
+
+HttpParser::Result HttpParser::next(const std::string &in, size_t &pos, HttpReq &out) {
+  while (true) {
+    switch (st_) {
+    case St::Head: {
+      size_t end = in.find("\r\n\r\n", pos);
+      if (end == std::string::npos || end - pos > max_head_) {
+        if (in.size() - pos <= max_head_) return NEED_MORE;
+        return fail(431, "Request Header Fields Too Large");
+      }
+      req_ = HttpReq{};
+      if (!parse_head(std::string_view(in).substr(pos, end - pos))) return FAILED;
+      pos = end + 4;
+      const std::string *te = req_.header("transfer-encoding");
+      const std::string *cl = req_.header("content-length");
+      if (te) {
+        if (cl) return fail(400, "Bad Request"); // ambiguous framing
+        if (lower(*te) != "chunked") return fail(501, "Not Implemented");
+        st_ = St::ChunkSize;
+      } else if (cl) {
+        if (cl->empty() || cl->size() > 12 ||
+            cl->find_first_not_of("0123456789") != std::string::npos)
+          return fail(400, "Bad Request");
+        left_ = std::stoull(*cl);
+        if (left_ > max_body_) return fail(413, "Payload Too Large");
+        if (left_ == 0) return done(out);
+        st_ = St::Length;
+      } else {
+        return done(out);
+      }
+      const std::string *ex = req_.header("expect");
+      expect_continue_ = ex && lower(*ex) == "100-continue";
+      break;
+    }
+    case St::Length:
+    case St::ChunkData: {
+      size_t take = std::min<size_t>(left_, in.size() - pos);
+      req_.body.append(in, pos, take);
+      pos += take;
+      left_ -= take;
+      if (left_) return NEED_MORE;
+      if (st_ == St::Length) return done(out);
+      st_ = St::ChunkEnd;
+      break;
+    }
+    case St::ChunkSize: {
+      size_t eol = in.find("\r\n", pos);
+      if (eol == std::string::npos)
+        return in.size() - pos > 1024 ? fail(400, "Bad Request") : NEED_MORE;
+      size_t digits = pos;
+      std::uint64_t size = 0;
+      while (digits < eol && std::isxdigit((unsigned char)in[digits]) && size <= (1ull << 40))
+        size = size * 16 + (std::uint64_t)std::stoi(in.substr(digits++, 1), nullptr, 16);
+      if (digits == pos || (digits < eol && in[digits] != ';' && in[digits] != ' '))
+        return fail(400, "Bad Request"); // a chunk extension may follow
+      if (req_.body.size() + size > max_body_) return fail(413, "Payload Too Large");
+      pos = eol + 2;
+      left_ = size;
+      st_ = size ? St::ChunkData : St::Trailers;
+      break;
+    }
+    case St::ChunkEnd:
+      if (in.size() - pos < 2) return NEED_MORE;
+      if (in.compare(pos, 2, "\r\n") != 0) return fail(400, "Bad Request");
+      pos += 2;
+      st_ = St::ChunkSize;
+      break;
+    case St::Trailers: { // ignored, up to the empty line
+      size_t eol = in.find("\r\n", pos);
+      if (eol == std::string::npos)
+        return in.size() - pos > max_head_ ? fail(431, "Request Header Fields Too Large")
+                                           : NEED_MORE;
+      bool last = eol == pos;
+      pos = eol + 2;
+      if (last) return done(out);
+      break;
+    }
+    case St::Failed:
+      return FAILED;
+    }
+  }
+}
+
+bool HttpParser::take_continue() {
+  bool c = expect_continue_ && st_ != St::Head && st_ != St::Failed && req_.body.empty();
+  expect_continue_ = false;
+  return c;
+}
+
+HttpParser::Result HttpParser::fail(int code, const char *status) {
+  st_ = St::Failed;
+  code_ = code;
+  status_ = status;
+  return FAILED;
+}
+
+HttpParser::Result HttpParser::done(HttpReq &out) {
+  out = std::move(req_);
+  st_ = St::Head;
+  expect_continue_ = false;
+  return DONE;
+}
+
+bool HttpParser::parse_head(std::string_view h) {
+  size_t eol = h.find("\r\n");
+  std::string_view line = h.substr(0, eol);
+  size_t s1 = line.find(' '), s2 = line.rfind(' ');
+  if (s1 == std::string_view::npos || s1 == s2) return fail(400, "Bad Request"), false;
+  req_.method = std::string(line.substr(0, s1));
+  std::string target(line.substr(s1 + 1, s2 - s1 - 1));
+  std::string_view version = line.substr(s2 + 1);
+  if (version.size() != 8 || version.substr(0, 7) != "HTTP/1." ||
+      !std::isdigit((unsigned char)version[7]))
+    return fail(505, "HTTP Version Not Supported"), false;
+  req_.minor = version[7] - '0';
+  size_t q = target.find('?');
+  req_.path = target.substr(0, q);
+  if (q != std::string::npos) req_.query = target.substr(q + 1);
+
+  while (eol != std::string_view::npos) {
+    size_t start = eol + 2;
+    eol = h.find("\r\n", start);
+    std::string_view l = h.substr(start, eol == std::string_view::npos ? eol : eol - start);
+    size_t c = l.find(':');
+    if (c == std::string_view::npos || c == 0 || l[0] == ' ' || l[0] == '\t')
+      return fail(400, "Bad Request"), false; // no obsolete line folding
+    std::string name = lower(std::string(l.substr(0, c)));
+    std::string_view v = l.substr(c + 1);
+    while (!v.empty() && (v.front() == ' ' || v.front() == '\t')) v.remove_prefix(1);
+    while (!v.empty() && (v.back() == ' ' || v.back() == '\t')) v.remove_suffix(1);
+    auto [it, fresh] = req_.headers.emplace(name, std::string(v));
+    if (!fresh) it->second += ", " + std::string(v);
+  }
+  std::string conn = lower(req_.header("connection") ? *req_.header("connection") : "");
+  req_.keep_alive = req_.minor >= 1 ? conn.find("close") == std::string::npos
+                                    : conn.find("keep-alive") != std::string::npos;
+  return true;
+}
+
+} // namespace wininspectd
@@ -0,0 +1,83 @@
+#pragma once
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+// HTTP/1.x request parsing and response framing shared by the REST
+// gateway (http_server.cpp) and the rendezvous server.
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace wininspectd {
+
+struct HttpReq {
+  std::string method, path, query, body;
+  std::map<std::string, std::string> headers; // names lowercased
+  int minor = 1;                              // HTTP/1.x
+  bool keep_alive = true;
+
+  const std::string *header(const char *name) const {
+    auto it = headers.find(name);
+    return it == headers.end() ? nullptr : &it->second;
+  }
+};
+
+struct HttpResp {
+  int code = 200;
+  std::string status = "OK", body;
+  std::string content_type = "application/json; charset=utf-8";
+  std::vector<std::pair<std::string, std::string>> headers;
+};
+
+/// Status line and headers, without Content-Length or the blank line.
+std::string build_head(const HttpResp &r, bool keep_alive);
+std::string build_response(const HttpResp &r, bool keep_alive);
+/// `{"error": error}` with the given status.
+HttpResp error_resp(int code, const char *status, const char *error);
+/// `name` from a query string, percent-decoded; false if absent.
+bool query_param(const std::string &query, const char *name, std::string &out);
+
+// Incremental request parser: give it the connection's bytes as they come
+// and take requests as they complete, so pipelined requests and bodies
+// split across reads both work. Bodies are framed by Content-Length or by
+// chunked transfer coding. A failure is final and carries the status to
+// answer with before closing.
+class HttpParser {
+public:
+  enum Result { NEED_MORE, DONE, FAILED };
+
+  /// Heads beyond max_head get 431, bodies beyond max_body 413.
+  explicit HttpParser(size_t max_head = 64 * 1024, size_t max_body = 10 * 1024 * 1024)
+      : max_head_(max_head), max_body_(max_body) {}
+
+  /// Consumes from in[pos, ...).
+  Result next(const std::string &in, size_t &pos, HttpReq &out);
+
+  /// The head of a request with `Expect: 100-continue` is in and its body
+  /// is not; true once, so the interim response goes out once.
+  bool take_continue();
+
+  int code() const { return code_; }
+  const char *status() const { return status_; }
+
+private:
+  enum class St { Head, Length, ChunkSize, ChunkData, ChunkEnd, Trailers, Failed };
+
+  Result fail(int code, const char *status);
+  Result done(HttpReq &out);
+  bool parse_head(std::string_view h);
+
+  size_t max_head_, max_body_;
+  St st_ = St::Head;
+  HttpReq req_;
+  std::uint64_t left_ = 0;
+  bool expect_continue_ = false;
+  int code_ = 400;
+  const char *status_ = "Bad Request";
+};
+
+} // namespace wininspectd
@@ -16,10 +16,28 @@
 //   POST   /api/v1/hotkey       → input.hotkey
 //   GET    /api/v1/processes    → process.list
 //   POST   /api/v1/exec         → process.execute
+//   GET    /api/v1/events       → Server-Sent Events feed of the event log
+//                                 (?since=N or Last-Event-ID to resume)
+//   GET    /api/v1/file         → file.read, streamed a chunk at a time
+//                                 (?path=P[&offset=N][&length=N])
+//   POST   /api/v1/rpc          → any method: a protocol request, or an
+//                                 array of them run in order
+//
+// Connections are kept alive (HTTP/1.1, or 1.0 with Connection:
+// keep-alive) and may pipeline; request bodies may be chunked.
 
 #include "wininspect/core.hpp"
 #include "wininspect/logger.hpp"
 #include "wininspect/tinyjson.hpp"
+#include "wininspect/event_stream.hpp"
+#include "server_state.hpp"
+#include "event_streamer.hpp"
+#include "http_parser.hpp"
+#include "http_server.hpp"
+#include "io_service.hpp"
+#include "push_task.hpp"
+#include "request_handler.hpp"
+#include "transport.hpp"
 #include <fstream>
 
 // Embedded WebUI dashboard (served at /dashboard)
@@ -52,82 +70,43 @@ img{max-width:100%;border-radius:4px}
 <div class=card><h2>Screen</h2><button onclick=capture()>Capture</button><img id=ss style=display:none;margin-top:10px></div>
 <div class=card><h2>Windows</h2><button onclick=listWin()>Refresh</button><pre id=wlist></pre></div>
 <script>
-let BASE='http://localhost:8088';
-async function api(p,m,b){let o={method:m||'GET',headers:{'Content-Type':'application/json'}};if(b)o.body=JSON.stringify(b);return(await fetch(BASE+p,o)).json()}
-async function connect(){BASE=document.getElementById('url').value.replace(/\/+$/,'');document.getElementById('status').textContent='Connecting...';try{let h=await api('/api/v1/health');let i=await api('/api/v1/identity');document.getElementById('status').textContent='Connected '+(h.result?.os||'');document.getElementById('identity').textContent=JSON.stringify(i.result||i,null,2)}catch(e){document.getElementById('status').textContent='Error: '+e.message}}
-async function capture(){try{let r=await api('/api/v1/capture','POST',{left:0,top:0,right:1920,bottom:1080});let d=r.result?.data_b64;if(d){document.getElementById('ss').src='data:image/bmp;base64,'+d;document.getElementById('ss').style.display='block'}}catch(e){alert(e.message)}}
-async function doClick(){await api('/api/v1/click','POST',{x:+document.getElementById('cx').value,y:+document.getElementById('cy').value})}
-async function doType(){let t=document.getElementById('txt').value;if(t)await api('/api/v1/type','POST',{text:t})}
-async function doHotkey(){let k=document.getElementById('hk').value;if(k)await api('/api/v1/hotkey','POST',{keys:k})}
-async function listWin(){let r=await api('/api/v1/windows');document.getElementById('wlist').textContent=JSON.stringify(r.result||r,null,2)}
+let BASE='http://localhost:8088',N=0;
+async function rpc(calls){let r=await fetch(BASE+'/api/v1/rpc',{method:'POST',headers:{'Content-Type':'application/json'},body:JSON.stringify(calls.map(([m,p])=>({id:'d'+(++N),method:m,params:p||{}})))});return(await r.json()).map(x=>x.ok?x.result:x.error)}
+async function connect(){BASE=document.getElementById('url').value.replace(/\/+$/,'');document.getElementById('status').textContent='Connecting...';try{let[h,i,w]=await rpc([['daemon.health'],['daemon.identity'],['window.listTop',{max_age_ms:250}]]);document.getElementById('status').textContent='Connected '+(h?.os||'');document.getElementById('identity').textContent=JSON.stringify(i,null,2);document.getElementById('wlist').textContent=JSON.stringify(w,null,2)}catch(e){document.getElementById('status').textContent='Error: '+e.message}}
+async function capture(){try{let[r]=await rpc([['screen.capture',{left:0,top:0,right:1920,bottom:1080,max_age_ms:0}]]);let d=r?.data_b64;if(d){document.getElementById('ss').src='data:image/bmp;base64,'+d;document.getElementById('ss').style.display='block'}}catch(e){alert(e.message)}}
+async function doClick(){await rpc([['input.mouseClick',{x:+document.getElementById('cx').value,y:+document.getElementById('cy').value}]])}
+async function doType(){let t=document.getElementById('txt').value;if(t)await rpc([['input.text',{text:t}]])}
+async function doHotkey(){let k=document.getElementById('hk').value;if(k)await rpc([['input.hotkey',{keys:k}]])}
+async function listWin(){let[r]=await rpc([['window.listTop',{max_age_ms:250}]]);document.getElementById('wlist').textContent=JSON.stringify(r,null,2)}
 </script></body></html>)raw";
 
-#ifdef _WIN32
-#include <winsock2.h>
-#include <ws2tcpip.h>
-#pragma comment(lib, "ws2_32.lib")
-#endif
-
+#include <algorithm>
 #include <string>
+#include <string_view>
 #include <map>
 #include <functional>
 #include <sstream>
 #include <atomic>
 #include <thread>
 #include <cstring>
+#include <chrono>
+#include <deque>
+#include <limits>
+#include <list>
 
 using namespace wininspect;
 
 namespace wininspectd {
 
-// ── HTTP Types ──────────────────────────────────────────────────────────────
+namespace {
 
-struct HttpReq {
-  std::string method, path, body;
-  std::map<std::string, std::string> headers;
-};
-
-struct HttpResp {
-  int code = 200;
-  std::string status = "OK", body;
-  std::string content_type = "application/json; charset=utf-8";
-};
-
-static std::string build_response(const HttpResp &r) {
-  std::ostringstream ss;
-  ss << "HTTP/1.1 " << r.code << " " << r.status << "\r\n"
-     << "Content-Type: " << r.content_type << "\r\n"
-     << "Content-Length: " << r.body.size() << "\r\n"
-     << "Connection: close\r\n"
-     << "Access-Control-Allow-Origin: *\r\n"
-     << "Access-Control-Allow-Methods: GET, POST, OPTIONS\r\n"
-     << "Access-Control-Allow-Headers: Content-Type, Authorization\r\n"
-     << "\r\n" << r.body;
-  return ss.str();
+std::int64_t now_ms() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
 }
 
-static bool parse_http(const std::string &raw, HttpReq &req) {
-  auto eol = raw.find("\r\n");
-  if (eol == std::string::npos) return false;
-  auto fl = raw.substr(0, eol);
-  auto s1 = fl.find(' '), s2 = fl.rfind(' ');
-  if (s1 == std::string::npos || s2 == std::string::npos || s1 == s2) return false;
-  req.method = fl.substr(0, s1);
-  req.path = fl.substr(s1 + 1, s2 - s1 - 1);
-  size_t pos = eol + 2;
-  while (pos < raw.size()) {
-    auto he = raw.find("\r\n", pos);
-    if (he == std::string::npos) break;
-    if (he == pos) { pos = he + 2; break; }
-    auto c = raw.find(':', pos);
-    if (c != std::string::npos && c < he) {
-      req.headers[raw.substr(pos, c - pos)] = raw.substr(c + 2, he - c - 2);
-    }
-    pos = he + 2;
-  }
-  if (pos < raw.size()) req.body = raw.substr(pos);
-  return true;
-}
+} // namespace
 
 // ── Route Table ─────────────────────────────────────────────────────────────
 
@@ -147,35 +126,8 @@ static json::Object json_from(const HttpReq &req) {
   return json::Object{};
 }
 
-// ── HTTP Server ─────────────────────────────────────────────────────────────
-
-void run_http_server(std::atomic<bool> *running, int port,
-                      CoreEngine &core, const std::string &auth_token) {
-  WSADATA wsa;
-  if (WSAStartup(MAKEWORD(2,2), &wsa) != 0) { LOG_ERROR("HTTP: Winsock init failed"); return; }
-
-  SOCKET s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-  if (s == INVALID_SOCKET) { WSACleanup(); return; }
-
-  int on = 1;
-  setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (const char *)&on, sizeof(on));
-  struct sockaddr_in addr = {};
-  addr.sin_family = AF_INET; addr.sin_addr.s_addr = INADDR_ANY;
-  addr.sin_port = htons((u_short)port);
-
-  if (bind(s, (struct sockaddr *)&addr, sizeof(addr)) == SOCKET_ERROR) {
-    LOG_ERROR("HTTP: bind failed on port " + std::to_string(port));
-    closesocket(s); WSACleanup(); return;
-  }
-  listen(s, SOMAXCONN);
-
-  u_long mode = 1;
-  ioctlsocket(s, FIONBIO, &mode);
-
-  auto snapshot = core.get_backend()->capture_snapshot();
-
-  // Route table: method, path, rpc_method, param_filler
-  Route routes[] = {
+static const Route *find_route(const HttpReq &req) {
+  static const Route routes[] = {
     {"GET", "/api/v1/health", "daemon.health", nullptr},
     {"GET", "/api/v1/identity", "daemon.identity", nullptr},
     {"GET", "/api/v1/capabilities", "daemon.capabilities", nullptr},
@@ -202,103 +154,684 @@ void run_http_server(std::atomic<bool> *running, int port,
       it = j.find("args"); if (it != j.end()) p["args"] = it->second;
     }},
   };
+  for (auto &rt : routes) {
+    if (req.method == rt.method && req.path == rt.path) return &rt;
+  }
+  return nullptr;
+}
+
+// A /api/v1/rpc body that may wait: any request in it with wait_ms
+// (events.poll, file.tail) holds its thread for that long, so like
+// RequestConnection::plan it goes to the blocking pool rather than an I/O
+// thread. Bodies that do not parse are answered in place.
+static bool rpc_waits(const std::string &body) {
+  auto waits = [](const json::Value &v) {
+    if (!v.is_obj()) return false;
+    auto it = v.as_obj().find("params");
+    return it != v.as_obj().end() && it->second.is_obj() && it->second.as_obj().count("wait_ms") > 0;
+  };
+  try {
+    auto v = json::parse(body);
+    if (!v.is_arr()) return waits(v);
+    for (const auto &e : v.as_arr())
+      if (waits(e)) return true;
+  } catch (...) {}
+  return false;
+}
 
-  LOG_INFO("HTTP server listening on port " + std::to_string(port));
+// ── Server-Sent Events ──────────────────────────────────────────────────────
 
-  while (running->load()) {
-    SOCKET c = accept(s, nullptr, nullptr);
-    if (c == INVALID_SOCKET) { Sleep(100); continue; }
+static bool send_all(IConnection &c, const std::string &data) {
+  return c.write_all(data.data(), data.size());
+}
 
-    char buf[8192];
-    int r = recv(c, buf, sizeof(buf) - 1, 0);
-    if (r <= 0) { closesocket(c); continue; }
-    buf[r] = '\0';
+static std::string sse_frame(const Event &e) {
+  return "id: " + std::to_string(e.seq) + "\nevent: " + e.type +
+         "\ndata: " + json::dumps(event_json(e)) + "\n\n";
+}
 
-    HttpReq req;
-    HttpResp resp;
+// One GET /api/v1/events subscriber. Like events.stream it has no thread:
+// a PushTask writes on the I/O threads when the log moves, a keepalive is
+// due or the client goes. SSE has no credit channel, so TCP is the
+// backpressure: while a write blocks, events pile up in the EventStream
+// and are coalesced; past that the client gets an `event: gap`.
+class SseFeed final : public EventPusher {
+public:
+  static constexpr std::int64_t KEEPALIVE_MS = 15000;
+
+  /// Feeds `h`, whose response header is already out. `end` runs on the
+  /// last step (client gone, write failed, daemon stopping), not if the
+  /// server stops the feed first.
+  SseFeed(IoService *io, std::shared_ptr<IoService::Handler> h, ServerState *st,
+          std::atomic<bool> *running, const std::atomic<bool> *closed, std::uint64_t since,
+          std::function<void()> end)
+      : st_(st), running_(running), h_(h), cursor_(since), q_(options()),
+        keepalive_at_(now_ms() + KEEPALIVE_MS),
+        task_(io, [this, h = std::move(h), closed, end = std::move(end)] {
+          auto next = step(h->connection(), *closed);
+          if (next == PushTask::Next::Done) {
+            unwatch_events(st_, this);
+            done_ = true;
+            end();
+          }
+          return next;
+        }) {}
+
+  ~SseFeed() override {
+    unwatch_events(st_, this);
+    task_.stop();
+  }
 
-    if (!parse_http(std::string(buf), req)) {
-      resp.code = 400; resp.status = "Bad Request"; resp.body = R"({"error":"bad request"})";
-      std::string out = build_response(resp);
-      send(c, out.data(), (int)out.size(), 0);
-      closesocket(c); continue;
+  void start() {
+    watch_events(st_, this);
+    task_.wake();
+  }
+  /// Ends the feed: its connection is shut down and no step runs after this.
+  void stop() {
+    if (auto h = h_.lock()) h->connection().shutdown();
+    unwatch_events(st_, this);
+    task_.stop();
+  }
+  void wake() { task_.wake(); }
+  bool done() const { return done_.load(); }
+
+  void on_publish() override {
+    if (st_->event_log->head() != cursor_.load() || now_ms() >= keepalive_at_.load() ||
+        !running_->load())
+      task_.wake();
+  }
+
+private:
+  static EventStream::Options options() {
+    EventStream::Options opts;
+    opts.credit = std::numeric_limits<std::uint64_t>::max() / 2;
+    opts.max_queue = 1024;
+    return opts;
+  }
+
+  PushTask::Next step(IConnection &c, const std::atomic<bool> &closed) {
+    if (!running_->load() || closed.load()) return PushTask::Next::Done;
+    std::vector<Event> events;
+    auto r = st_->event_log->read(cursor_, events, 1024);
+    cursor_ = r.last_seq;
+    if (!events.empty() || r.gap) q_.push(events, r.gap);
+
+    EventStream::Batch b;
+    bool ok = true;
+    if (q_.take(b, 256, std::chrono::milliseconds(0))) {
+      std::string out;
+      if (b.gap) out += "event: gap\ndata: {\"dropped\":" + std::to_string(b.dropped) + "}\n\n";
+      for (const auto &e : b.events) out += sse_frame(e);
+      ok = send_all(c, out);
+      keepalive_at_ = now_ms() + KEEPALIVE_MS;
+    } else if (now_ms() >= keepalive_at_.load()) {
+      ok = send_all(c, ": keepalive\n\n");
+      keepalive_at_ = now_ms() + KEEPALIVE_MS;
+    }
+    if (!ok) return PushTask::Next::Done;
+    bool more = q_.stats().queued > 0 || st_->event_log->head() != cursor_.load();
+    return more ? PushTask::Next::Again : PushTask::Next::Sleep;
+  }
+
+  ServerState *st_;
+  std::atomic<bool> *running_;
+  std::weak_ptr<IoService::Handler> h_;
+  std::atomic<std::uint64_t> cursor_;
+  EventStream q_;
+  std::atomic<std::int64_t> keepalive_at_;
+  std::atomic<bool> done_{false};
+  PushTask task_; // last: stopped before the members its step uses go
+};
+
+// The event feeds of one server. stop() ends them, so none outlives the
+// server or the ServerState it reads; feeds asked for after that are
+// refused.
+class EventFeeds {
+public:
+  /// Starts `f` and keeps it until it ends; false once stopped.
+  bool start(const std::shared_ptr<SseFeed> &f) {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (stopping_) return false;
+    feeds_.remove_if([](const std::shared_ptr<SseFeed> &g) { return g->done(); });
+    feeds_.push_back(f);
+    f->start();
+    return true;
+  }
+
+  /// Shuts down every feed's connection and waits for its step to return.
+  void stop() {
+    std::list<std::shared_ptr<SseFeed>> feeds;
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      stopping_ = true;
+      feeds.splice(feeds.end(), feeds_);
     }
+    for (auto &f : feeds) f->stop();
+  }
+
+private:
+  std::mutex mu_;
+  std::list<std::shared_ptr<SseFeed>> feeds_;
+  bool stopping_ = false;
+};
 
-    // CORS preflight
-    if (req.method == "OPTIONS") {
-      resp.code = 204;
-      std::string out = build_response(resp);
-      send(c, out.data(), (int)out.size(), 0);
-      closesocket(c); continue;
+static const char *SSE_HEADER = "HTTP/1.1 200 OK\r\n"
+                                "Content-Type: text/event-stream\r\n"
+                                "Cache-Control: no-cache\r\n"
+                                "Connection: close\r\n"
+                                "Access-Control-Allow-Origin: *\r\n\r\n"
+                                "retry: 2000\n\n";
+
+// ── Connections ─────────────────────────────────────────────────────────────
+
+// What a connection needs from its server, copied so that an event feed
+// does not depend on the server object.
+struct HttpEnv {
+  CoreEngine *core;
+  std::string auth_token;
+  ServerState *st;
+  std::atomic<bool> *running;
+  IoService *io;
+  std::shared_ptr<EventFeeds> feeds;
+  bool events; // serve GET /api/v1/events
+  bool read_only, no_clipboard;
+};
+
+// One client. Requests are parsed on the I/O thread as bytes arrive and
+// run on the I/O threads, several at once (or, with wait_ms, on the
+// blocking pool); each response waits in done_
+// until those before it have been written, since HTTP/1.1 answers in
+// request order. The event feed and file downloads own the connection
+// while they stream, so they wait for everything before them and hold up
+// everything after.
+class HttpConnection final : public IoService::Handler,
+                             public std::enable_shared_from_this<HttpConnection> {
+public:
+  HttpConnection(std::unique_ptr<IConnection> conn, HttpEnv env)
+      : Handler(std::move(conn)), env_(std::move(env)), last_active_(now_ms()) {}
+
+  void on_data(const char *p, size_t n) override;
+  void on_close() override {
+    closed_ = true;
+    connection().shutdown();
+    std::shared_ptr<SseFeed> feed;
+    {
+      std::lock_guard<std::mutex> lk(q_mu_);
+      feed = feed_.lock();
     }
+    if (feed) feed->wake(); // to end it now rather than at its next write
+  }
+
+  /// Nothing in progress and no bytes since `before` (ms).
+  bool idle_since(std::int64_t before) {
+    std::lock_guard<std::mutex> lk(q_mu_);
+    return running_ == 0 && queue_.empty() && last_active_.load() < before;
+  }
+
+  /// Pipelined requests held before the client is dropped.
+  static constexpr size_t MAX_QUEUED = 64;
+  static constexpr size_t DOWNLOAD_CHUNK = 256 * 1024;
+
+private:
+  enum class Kind { Plain, Events, Download };
+  struct Job {
+    std::uint64_t seq;
+    HttpReq req;
+    Kind kind = Kind::Plain;
+    bool blocking = false; // may wait (wait_ms): off the I/O threads
+    int error = 0; // a parse failure to answer, then close
+    const char *status = "";
+  };
+
+  void pump();
+  void run(Job &job);
+  HttpResp respond(const HttpReq &req);
+  HttpResp rpc(const HttpReq &req);
+  // One protocol request through the shared pipeline.
+  CoreResponse call(const std::string &request);
+  bool authorized(const HttpReq &req) const;
+  bool download(const HttpReq &req);
+  // Sends the SSE header and hands the connection to an event feed, which
+  // finishes `seq` when it ends. False if there is none to hand it to.
+  bool feed(std::uint64_t seq, std::uint64_t since);
+  // Queues `bytes` as response `seq` and writes whatever is now in order.
+  void finish(std::uint64_t seq, std::string bytes, bool close, Kind kind);
+
+  const HttpEnv env_;
+  HttpParser parser_{HttpServer::MAX_HEAD_BYTES, HttpServer::MAX_BODY_BYTES};
+  std::string in_;
+  size_t pos_ = 0;
+  std::uint64_t next_seq_ = 0;
+  bool stop_reading_ = false; // after Connection: close or a bad request
+  std::atomic<bool> closed_{false};
+  std::atomic<std::int64_t> last_active_;
+
+  std::mutex q_mu_;
+  std::deque<Job> queue_;
+  size_t running_ = 0;
+  bool barrier_ = false; // a streaming response owns the connection
+  std::weak_ptr<SseFeed> feed_;
+
+  std::mutex write_mu_;
+  std::map<std::uint64_t, std::pair<std::string, bool>> done_; // seq: bytes, close
+  std::uint64_t next_send_ = 0;
+  bool close_sent_ = false;
+};
 
-    // Auth check
-    if (!auth_token.empty()) {
-      auto it = req.headers.find("Authorization");
-      std::string token_val;
-      if (it != req.headers.end() && it->second.size() > 7 && it->second.substr(0,7) == "Bearer ")
-        token_val = it->second.substr(7);
-      if (token_val != auth_token) {
-        resp.code = 401; resp.status = "Unauthorized"; resp.body = R"({"error":"unauthorized"})";
-        std::string out = build_response(resp);
-        send(c, out.data(), (int)out.size(), 0);
-        closesocket(c); continue;
+void HttpConnection::on_data(const char *p, size_t n) {
+  last_active_ = now_ms();
+  if (stop_reading_) return;
+  in_.append(p, n);
+  while (true) {
+    Job job;
+    auto r = parser_.next(in_, pos_, job.req);
+    if (r == HttpParser::NEED_MORE) {
+      if (parser_.take_continue()) {
+        std::lock_guard<std::mutex> lk(write_mu_);
+        if (next_send_ == next_seq_) // nothing of ours ahead of it
+          (void)send_all(connection(), "HTTP/1.1 100 Continue\r\n\r\n");
+      }
+      break;
+    }
+    job.seq = next_seq_++;
+    if (r == HttpParser::FAILED) {
+      job.error = parser_.code();
+      job.status = parser_.status();
+      stop_reading_ = true;
+    } else {
+      const auto &path = job.req.path;
+      if (env_.events && job.req.method == "GET" && path == "/api/v1/events")
+        job.kind = Kind::Events; // has the connection until it closes
+      else if (job.req.method == "GET" && path == "/api/v1/file")
+        job.kind = Kind::Download;
+      else if (job.req.method == "POST" && path == "/api/v1/rpc")
+        job.blocking = rpc_waits(job.req.body);
+      stop_reading_ = !job.req.keep_alive || job.kind == Kind::Events;
+    }
+    {
+      std::lock_guard<std::mutex> lk(q_mu_);
+      if (queue_.size() >= MAX_QUEUED) {
+        LOG_WARN("HTTP client pipelined too many requests; dropping it.");
+        connection().shutdown();
+        return;
       }
+      queue_.push_back(std::move(job));
     }
+    if (stop_reading_) break;
+  }
+  if (pos_ == in_.size()) {
+    in_.clear();
+    pos_ = 0;
+  } else if (pos_ > 64 * 1024) {
+    in_.erase(0, pos_);
+    pos_ = 0;
+  }
+  pump();
+}
 
-    // Find matching route
-    const Route *matched = nullptr;
-    for (auto &rt : routes) {
-      if (req.method == rt.method && req.path == rt.path) { matched = &rt; break; }
+void HttpConnection::pump() {
+  std::vector<Job> ready;
+  {
+    std::lock_guard<std::mutex> lk(q_mu_);
+    size_t cap = env_.st ? (size_t)std::max(env_.st->max_inflight, 1) : 8;
+    while (!queue_.empty() && !barrier_) {
+      auto &job = queue_.front();
+      if (job.kind != Kind::Plain) {
+        if (running_ > 0) break;
+        barrier_ = true;
+      } else if (running_ >= cap) {
+        break;
+      }
+      running_++;
+      ready.push_back(std::move(job));
+      queue_.pop_front();
     }
+  }
+  for (auto &job : ready) {
+    Kind kind = job.kind;
+    bool blocking = job.blocking || kind == Kind::Download;
+    std::function<void()> fn = [self = shared_from_this(), job = std::move(job)]() mutable {
+      self->run(job);
+    };
+    if (blocking)
+      env_.io->post_blocking(std::move(fn));
+    else
+      env_.io->post(std::move(fn));
+  }
+}
 
-    // Serve dashboard UI (embedded HTML)
-    if (req.path == "/dashboard") {
-      resp.content_type = "text/html; charset=utf-8";
-      resp.body = DASHBOARD_HTML;
-      goto send_it;
+bool HttpConnection::authorized(const HttpReq &req) const {
+  if (env_.auth_token.empty()) return true;
+  const std::string *h = req.header("authorization");
+  return h && h->size() > 7 && h->compare(0, 7, "Bearer ") == 0 &&
+         h->substr(7) == env_.auth_token;
+}
+
+void HttpConnection::run(Job &job) {
+  const HttpReq &req = job.req;
+  bool keep = req.keep_alive;
+  try {
+    if (job.error) {
+      finish(job.seq, build_response(error_resp(job.error, job.status, "bad request"), false),
+             true, job.kind);
+      return;
     }
-    // Redirect / to /dashboard
-    if (req.path == "/") {
-      resp.code = 301; resp.status = "Moved";
-      resp.body = "<html><body>Redirecting to <a href='/dashboard'>dashboard</a>...</body></html>";
-      resp.content_type = "text/html";
-      goto send_it;
+    if (job.kind != Kind::Plain && authorized(req)) {
+      if (job.kind == Kind::Events) {
+        std::uint64_t since = 0;
+        std::string v;
+        if (query_param(req.query, "since", v)) since = std::strtoull(v.c_str(), nullptr, 10);
+        if (auto lei = req.header("last-event-id")) since = std::strtoull(lei->c_str(), nullptr, 10);
+        if (feed(job.seq, since)) return; // the feed finishes it
+        keep = false;
+      } else {
+        keep = download(req) && keep;
+      }
+      finish(job.seq, {}, !keep, job.kind);
+      return;
     }
+    finish(job.seq, build_response(respond(req), keep), !keep, job.kind);
+  } catch (const std::exception &e) {
+    LOG_ERROR(std::string("HTTP request failed: ") + e.what());
+    finish(job.seq, build_response(error_resp(500, "Internal Server Error", "internal error"), false),
+           true, job.kind);
+  }
+}
+
+bool HttpConnection::feed(std::uint64_t seq, std::uint64_t since) {
+  if (!send_all(connection(), SSE_HEADER)) return false;
+  auto self = shared_from_this();
+  auto f = std::make_shared<SseFeed>(env_.io, self, env_.st, env_.running, &closed_, since,
+                                     [self, seq] { self->finish(seq, {}, true, Kind::Events); });
+  {
+    std::lock_guard<std::mutex> lk(q_mu_);
+    feed_ = f;
+  }
+  return env_.feeds->start(f);
+}
+
+HttpResp HttpConnection::respond(const HttpReq &req) {
+  HttpResp resp;
+  // CORS preflight
+  if (req.method == "OPTIONS") {
+    resp.code = 204;
+    resp.status = "No Content";
+    return resp;
+  }
+  if (!authorized(req)) return error_resp(401, "Unauthorized", "unauthorized");
 
-    if (!matched) {
-      resp.code = 404; resp.status = "Not Found"; resp.body = R"({"error":"not found"})";
-      goto send_it;
+  // Serve dashboard UI (embedded HTML)
+  if (req.path == "/dashboard") {
+    resp.content_type = "text/html; charset=utf-8";
+    resp.body = DASHBOARD_HTML;
+    return resp;
+  }
+  // Redirect / to /dashboard
+  if (req.path == "/") {
+    resp.code = 301; resp.status = "Moved Permanently";
+    resp.headers.emplace_back("Location", "/dashboard");
+    resp.body = "<html><body>Redirecting to <a href='/dashboard'>dashboard</a>...</body></html>";
+    resp.content_type = "text/html";
+    return resp;
+  }
+
+  if (req.method == "POST" && req.path == "/api/v1/rpc") return rpc(req);
+
+  const Route *matched = find_route(req);
+  if (!matched) return error_resp(404, "Not Found", "not found");
+
+  // Dispatch to core engine
+  try {
+    json::Object params;
+    if (matched->param_fill) matched->param_fill(req, params);
+    std::string v;
+    if (query_param(req.query, "max_age_ms", v)) params["max_age_ms"] = std::strtod(v.c_str(), nullptr);
+    json::Object creq;
+    creq["id"] = std::string("http-1");
+    creq["method"] = std::string(matched->rpc_method);
+    creq["params"] = params;
+    auto cresp = call(json::dumps(creq));
+
+    json::Object result;
+    result["ok"] = cresp.ok;
+    result["id"] = cresp.id;
+    result["result"] = cresp.result;
+    if (!cresp.error_code.empty()) result["error_code"] = cresp.error_code;
+    if (!cresp.error_message.empty()) result["error_message"] = cresp.error_message;
+    resp.body = json::dumps(result);
+  } catch (const std::exception &e) {
+    json::Object err;
+    err["ok"] = false; err["error"] = std::string(e.what());
+    resp.body = json::dumps(err);
+  }
+  return resp;
+}
+
+CoreResponse HttpConnection::call(const std::string &request) {
+  ClientSession session;
+  session.authenticated = true; // by bearer token, in authorized()
+  CoreResponse resp;
+  bool canonical = false;
+  std::string pinned_sid;
+  (void)process_request(request, *env_.core, env_.st, env_.core->get_backend(), session,
+                        env_.read_only, env_.no_clipboard, false, "", resp, canonical,
+                        pinned_sid);
+  if (!pinned_sid.empty()) {
+    std::lock_guard<std::mutex> lk(env_.st->snapshots_mu);
+    env_.st->pinned_counts[pinned_sid]--;
+  }
+  return resp;
+}
+
+// POST /api/v1/rpc: the body is a request as sent over the pipe or TCP
+// ({"id", "method", "params"}) and the reply is its response; an array of
+// requests runs them in order and replies with an array. Failures are in
+// each response, so the status is 200 unless the body is not a request.
+// Bytes come back base64-encoded: there are no attachments here.
+HttpResp HttpConnection::rpc(const HttpReq &req) {
+  json::Value body;
+  try {
+    body = json::parse(req.body);
+  } catch (const std::exception &) {
+    return error_resp(400, "Bad Request", "body is not JSON");
+  }
+  auto one = [&](const json::Value &v) -> json::Value {
+    if (!v.is_obj()) {
+      CoreResponse r;
+      r.ok = false; r.error_code = "E_BAD_REQUEST";
+      r.error_message = "request must be an object";
+      return r.to_json_obj(false);
     }
+    json::Object o = v.as_obj();
+    o.erase("binary");
+    return call(json::dumps(o)).to_json_obj(false);
+  };
 
-    // Dispatch to core engine
-    try {
-      json::Object params;
-      if (matched->param_fill) matched->param_fill(req, params);
-      CoreRequest creq{"http-1", matched->rpc_method, params};
-      auto snap = core.get_backend()->capture_snapshot();
-      auto cresp = core.handle(creq, snap, nullptr);
-
-      json::Object result;
-      result["ok"] = cresp.ok;
-      result["id"] = cresp.id;
-      result["result"] = cresp.result;
-      if (!cresp.error_code.empty()) result["error_code"] = cresp.error_code;
-      if (!cresp.error_message.empty()) result["error_message"] = cresp.error_message;
-      resp.body = json::dumps(result);
-    } catch (const std::exception &e) {
-      json::Object err;
-      err["ok"] = false; err["error"] = std::string(e.what());
-      resp.body = json::dumps(err);
+  HttpResp resp;
+  if (!body.is_arr()) {
+    resp.body = json::dumps(one(body));
+    return resp;
+  }
+  const auto &batch = body.as_arr();
+  if (batch.empty()) return error_resp(400, "Bad Request", "empty batch");
+  if (batch.size() > HttpServer::MAX_BATCH) return error_resp(413, "Payload Too Large", "batch too large");
+  json::Array out;
+  for (const auto &v : batch) out.push_back(one(v));
+  resp.body = json::dumps(out);
+  return resp;
+}
+
+// GET /api/v1/file?path=P[&offset=N][&length=N]: the bytes, read a chunk
+// at a time with file.read and sent as they come (chunked on HTTP/1.1, so
+// a file that grows or shrinks meanwhile still ends cleanly). False when
+// the connection cannot be reused.
+bool HttpConnection::download(const HttpReq &req) {
+  std::string path, v;
+  std::uint64_t offset = 0, length = 0; // 0: to the end
+  bool chunked = req.minor >= 1;
+  if (!query_param(req.query, "path", path) || path.empty()) {
+    std::lock_guard<std::mutex> lk(write_mu_);
+    return send_all(connection(), build_response(error_resp(400, "Bad Request", "path required"),
+                                                 req.keep_alive));
+  }
+  if (query_param(req.query, "offset", v)) offset = std::strtoull(v.c_str(), nullptr, 10);
+  if (query_param(req.query, "length", v)) length = std::strtoull(v.c_str(), nullptr, 10);
+
+  std::uint64_t sent = 0;
+  while (true) {
+    json::Object p;
+    p["path"] = path;
+    p["offset"] = (double)(offset + sent);
+    std::uint64_t want = DOWNLOAD_CHUNK;
+    if (length) want = std::min<std::uint64_t>(want, length - sent);
+    p["length"] = (double)want;
+    json::Object creq;
+    creq["id"] = std::string("http-file");
+    creq["method"] = std::string("file.read");
+    creq["params"] = p;
+    creq["binary"] = true;
+    auto r = call(json::dumps(creq));
+    std::lock_guard<std::mutex> lk(write_mu_);
+    if (sent == 0 && !r.ok) { // nothing sent yet: a plain error
+      HttpResp e = r.error_code == "E_BAD_REQUEST"     ? error_resp(400, "Bad Request", "bad request")
+                   : r.error_code == "E_ACCESS_DENIED" ? error_resp(403, "Forbidden", "forbidden")
+                                                       : error_resp(404, "Not Found", "not found");
+      if (!r.error_message.empty()) e.body = "{\"error\":" + json::dumps(r.error_message) + "}";
+      return send_all(connection(), build_response(e, req.keep_alive)) && req.keep_alive;
+    }
+    if (!r.ok) return false; // cut short: the client sees it
+    if (sent == 0) {
+      HttpResp head;
+      head.content_type = "application/octet-stream";
+      std::string h = build_head(head, req.keep_alive && chunked) +
+                      (chunked ? "Transfer-Encoding: chunked\r\n\r\n" : "\r\n");
+      if (!send_all(connection(), h)) return false;
+    }
+    static const Attachment none;
+    const auto &data = r.attachments.empty() ? none : r.attachments[0];
+    bool eof = r.result.as_obj().at("eof").as_bool() || data.empty();
+    if (!data.empty()) {
+      char size_line[24];
+      std::snprintf(size_line, sizeof(size_line), "%zx\r\n", data.size());
+      ConstBuffer parts[] = {{size_line, chunked ? std::strlen(size_line) : 0},
+                             {data.data(), data.size()},
+                             {"\r\n", chunked ? 2u : 0u}};
+      if (!connection().write_allv(parts, 3)) return false;
+      sent += data.size();
+    }
+    if (eof || (length && sent >= length) || closed_.load()) break;
+  }
+  if (!chunked) return false; // the end of the body is the end of the connection
+  std::lock_guard<std::mutex> lk(write_mu_);
+  return send_all(connection(), "0\r\n\r\n");
+}
+
+void HttpConnection::finish(std::uint64_t seq, std::string bytes, bool close, Kind kind) {
+  {
+    std::lock_guard<std::mutex> lk(write_mu_);
+    done_.emplace(seq, std::make_pair(std::move(bytes), close));
+    while (!done_.empty() && done_.begin()->first == next_send_) {
+      auto &out = done_.begin()->second;
+      if (!close_sent_ && !out.first.empty()) (void)send_all(connection(), out.first);
+      if (out.second && !close_sent_) {
+        close_sent_ = true;
+        connection().shutdown();
+      }
+      done_.erase(done_.begin());
+      next_send_++;
     }
+  }
+  last_active_ = now_ms();
+  {
+    std::lock_guard<std::mutex> lk(q_mu_);
+    running_--;
+    if (kind != Kind::Plain) barrier_ = false;
+  }
+  pump();
+}
+
+// ── HTTP Server ─────────────────────────────────────────────────────────────
+
+HttpServer::HttpServer(CoreEngine &core, std::string auth_token, ServerState *st,
+                       bool read_only, bool no_clipboard)
+    : core_(core), auth_token_(std::move(auth_token)),
+      own_state_(st ? nullptr : std::make_unique<ServerState>()),
+      st_(st ? st : own_state_.get()), read_only_(read_only), no_clipboard_(no_clipboard),
+      feeds_(std::make_shared<EventFeeds>()) {}
+
+HttpServer::~HttpServer() {
+  stop();
+  if (own_io_) own_io_->stop(); // drains what the connections posted
+}
+
+void HttpServer::stop() {
+  {
+    std::lock_guard<std::mutex> lk(listen_mu_);
+    stopped_ = true;
+    if (listener_) listener_->close();
+  }
+  feeds_->stop();
+}
+
+// Idle keep-alive connections (and clients that stall mid-request) are
+// shut down, which the I/O loop then sees as a close.
+void HttpServer::sweep() {
+  std::lock_guard<std::mutex> lk(conns_mu_);
+  auto now = now_ms();
+  if (now - last_sweep_ms_ < 1000) return;
+  last_sweep_ms_ = now;
+  std::erase_if(conns_, [&](const std::weak_ptr<HttpConnection> &w) {
+    auto c = w.lock();
+    if (!c) return true;
+    if (c->idle_since(now - IDLE_TIMEOUT_MS)) c->connection().shutdown();
+    return false;
+  });
+}
+
+void HttpServer::start(std::atomic<bool> *running, int port) {
+  running_ = running;
+  io_ = st_->io.get();
+  if (!io_) io_ = (own_io_ = std::make_unique<IoService>()).get();
+  HttpEnv env{&core_, auth_token_, st_, running, io_, feeds_, !own_state_, read_only_, no_clipboard_};
+  auto listeners = listen_tcp({{"0.0.0.0", ADDR_FAMILY_IPV4}}, port);
+  if (listeners.empty()) {
+    LOG_ERROR("HTTP: bind failed on port " + std::to_string(port));
+    return;
+  }
+  IListener &listener = *listeners.front();
+  {
+    std::lock_guard<std::mutex> lk(listen_mu_);
+    if (stopped_) return;
+    listener_ = &listener;
+  }
+  bound_port_ = listener.port();
+  LOG_INFO("HTTP server listening on port " + std::to_string(bound_port_.load()));
 
-  send_it:
-    std::string out = build_response(resp);
-    send(c, out.data(), (int)out.size(), 0);
-    closesocket(c);
+  while (running->load()) {
+    sweep();
+    auto conn = listener.accept(250);
+    if (!conn) {
+      std::lock_guard<std::mutex> lk(listen_mu_);
+      if (stopped_) break;
+      continue;
+    }
+    auto c = std::make_shared<HttpConnection>(std::move(conn), env);
+    {
+      std::lock_guard<std::mutex> lk(conns_mu_);
+      conns_.push_back(c);
+    }
+    io_->add(std::move(c));
   }
 
-  closesocket(s); WSACleanup();
+  std::lock_guard<std::mutex> lk(listen_mu_);
+  listener_ = nullptr;
+}
+
+void run_http_server(std::atomic<bool> *running, int port,
+                      CoreEngine &core, const std::string &auth_token,
+                      ServerState *st, bool read_only, bool no_clipboard) {
+  HttpServer srv(core, auth_token, st, read_only, no_clipboard);
+  srv.start(running, port);
 }
 
 } // namespace wininspectd
@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "io_service.hpp"
+#include "wininspect/logger.hpp"
+
+#include <chrono>
+#include <thread>
+
+#ifdef _WIN32
+#include "wininspect/util_win32.hpp"
+#endif
+
+namespace wininspectd {
+
+void IoService::post_blocking(std::function<void()> fn) {
+  std::lock_guard<std::mutex> lk(blk_mu_);
+  if (blk_stop_) return;
+  blk_queue_.push_back(std::move(fn));
+  if (blk_idle_ > 0) {
+    blk_cv_.notify_one();
+  } else if (blk_threads_ < blk_max_) {
+    blk_threads_++;
+    std::thread([this] { blocking_worker(); }).detach();
+  }
+}
+
+void IoService::blocking_worker() {
+#ifdef _WIN32
+  wininspect::CoInitGuard coinit;
+#endif
+  std::unique_lock<std::mutex> lk(blk_mu_);
+  while (true) {
+    if (blk_queue_.empty()) {
+      if (blk_stop_) break;
+      blk_idle_++;
+      bool woke = blk_cv_.wait_for(lk, std::chrono::seconds(30),
+                                   [&] { return !blk_queue_.empty() || blk_stop_; });
+      blk_idle_--;
+      if (!woke) break; // idle long enough; give the thread back
+      continue;
+    }
+    auto fn = std::move(blk_queue_.front());
+    blk_queue_.pop_front();
+    lk.unlock();
+    try {
+      fn();
+    } catch (const std::exception &e) {
+      LOG_ERROR(std::string("Blocking task failed: ") + e.what());
+    }
+    lk.lock();
+  }
+  blk_threads_--;
+  blk_cv_.notify_all();
+}
+
+void IoService::stop_blocking() {
+  std::unique_lock<std::mutex> lk(blk_mu_);
+  blk_stop_ = true; // queued work still runs: it owns connection state
+  blk_cv_.notify_all();
+  blk_cv_.wait(lk, [&] { return blk_threads_ == 0; });
+}
+
+} // namespace wininspectd
@@ -0,0 +1,90 @@
+#pragma once
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+// One I/O loop for every client connection: epoll on Linux
+// (io_service_posix.cpp), an I/O completion port on Windows
+// (io_service_win32.cpp). A fixed set of threads, one per core by default,
+// both reads and runs handlers, so an idle connection costs a registration
+// and a small buffer instead of a thread.
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include "transport.hpp"
+
+namespace wininspectd {
+
+class IoService {
+public:
+  /// Per-connection callbacks. For a given connection they never run
+  /// concurrently, and the next read is not issued until on_data returns,
+  /// so a handler that works inline gets backpressure and ordering for free.
+  class Handler {
+  public:
+    explicit Handler(std::unique_ptr<IConnection> conn) : conn_(std::move(conn)) {}
+    virtual ~Handler() = default;
+    IConnection &connection() { return *conn_; }
+
+    virtual void on_data(const char *p, size_t n) = 0;
+    /// EOF, error, or shutdown(); called once, after the last on_data.
+    virtual void on_close() = 0;
+
+  private:
+    std::unique_ptr<IConnection> conn_;
+  };
+
+  /// `threads` 0 = one per core. Long-running work goes to a separate pool
+  /// of at most `max_blocking` threads (see post_blocking). Handlers write
+  /// inline, so a client that stops reading would hold an I/O thread in
+  /// its write: connections get a `write_timeout_ms` write timeout, past
+  /// which they are shut down (see IConnection::set_write_timeout).
+  explicit IoService(size_t threads = 0, size_t max_blocking = 64,
+                     int write_timeout_ms = DEFAULT_WRITE_TIMEOUT_MS);
+  ~IoService();
+  IoService(const IoService &) = delete;
+  IoService &operator=(const IoService &) = delete;
+
+  /// Starts reading; the service keeps `h` alive until on_close returns.
+  /// False if the handle cannot be registered (or stop() has begun), in
+  /// which case `h` is dropped without on_close.
+  bool add(std::shared_ptr<Handler> h);
+  /// Runs `fn` on one of the I/O threads, for short work split off a
+  /// connection (a pipelined request). Work still queued when stop()
+  /// has joined the threads is dropped, not run.
+  void post(std::function<void()> fn);
+  /// Runs `fn` off the I/O threads, for work that may block for long
+  /// (long polls). Threads are started on demand up to max_blocking and
+  /// exit after idling; beyond that, work queues.
+  void post_blocking(std::function<void()> fn);
+  /// Shuts down every connection, waits for their on_close, then joins.
+  void stop();
+
+  size_t threads() const { return nthreads_; }
+  static constexpr int DEFAULT_WRITE_TIMEOUT_MS = 10000;
+  size_t connections() const { return live_.load(); }
+
+  struct Impl; // platform loop
+
+private:
+  void blocking_worker();
+
+  size_t nthreads_;
+  int write_timeout_ms_;
+  std::unique_ptr<Impl> impl_;
+  std::atomic<size_t> live_{0};
+
+  // Blocking pool; its threads are detached and counted.
+  void stop_blocking();
+  std::mutex blk_mu_;
+  std::condition_variable blk_cv_;
+  std::deque<std::function<void()>> blk_queue_;
+  size_t blk_max_, blk_threads_ = 0, blk_idle_ = 0;
+  bool blk_stop_ = false;
+};
+
+} // namespace wininspectd
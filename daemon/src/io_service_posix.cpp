@@ -0,0 +1,211 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#ifndef _WIN32
+#include "io_service.hpp"
+#include "wininspect/logger.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_set>
+
+namespace wininspectd {
+
+// Each connection is armed EPOLLONESHOT: whichever thread wakes for it owns
+// it until it re-arms, which is what serializes a connection's callbacks.
+// Reads use MSG_DONTWAIT so the fd itself stays blocking for writers.
+// Posted tasks wait in a queue counted by a semaphore eventfd, so each
+// wakeup on it hands exactly one task to one thread.
+struct IoService::Impl {
+  struct Reg {
+    std::shared_ptr<Handler> h;
+    int fd;
+  };
+
+  IoService *owner;
+  int ep = -1;
+  int wake = -1; // eventfd; readable once stop() wants the threads out
+  int task_fd = -1; // semaphore eventfd; one count per queued task
+  std::mutex task_mu;
+  std::deque<std::function<void()>> tasks;
+  bool tasks_closed = false;
+  std::vector<std::thread> threads;
+  std::mutex mu;
+  std::condition_variable cv;
+  std::unordered_set<Reg *> regs;
+  bool stopping = false;
+
+  void close_reg(Reg *r) {
+    epoll_ctl(ep, EPOLL_CTL_DEL, r->fd, nullptr);
+    r->h->on_close();
+    {
+      std::lock_guard<std::mutex> lk(mu);
+      regs.erase(r);
+      owner->live_--;
+    }
+    cv.notify_all();
+    delete r;
+  }
+
+  // Drains what is readable, then re-arms. A connection gets a bounded
+  // number of reads per wakeup so one busy client cannot hog a thread.
+  void service(Reg *r) {
+    thread_local char buf[64 * 1024];
+    for (int i = 0; i < 16; i++) {
+      ssize_t n = ::recv(r->fd, buf, sizeof(buf), MSG_DONTWAIT);
+      if (n > 0) {
+        r->h->on_data(buf, (size_t)n);
+        continue;
+      }
+      if (n < 0 && errno == EINTR) continue;
+      if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+      close_reg(r); // 0 = EOF, else an error
+      return;
+    }
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+    ev.data.ptr = r;
+    if (epoll_ctl(ep, EPOLL_CTL_MOD, r->fd, &ev) != 0) close_reg(r);
+  }
+
+  void run_task() {
+    uint64_t one = 0;
+    if (::read(task_fd, &one, sizeof(one)) != sizeof(one)) return; // another thread took it
+    std::function<void()> fn;
+    {
+      std::lock_guard<std::mutex> lk(task_mu);
+      if (tasks.empty()) return;
+      fn = std::move(tasks.front());
+      tasks.pop_front();
+    }
+    try {
+      fn();
+    } catch (const std::exception &e) {
+      LOG_ERROR(std::string("I/O task failed: ") + e.what());
+    }
+  }
+
+  void run() {
+    epoll_event evs[64];
+    while (true) {
+      int n = epoll_wait(ep, evs, 64, -1);
+      if (n < 0) {
+        if (errno == EINTR) continue;
+        LOG_ERROR(std::string("epoll_wait: ") + std::strerror(errno));
+        return;
+      }
+      for (int i = 0; i < n; i++) {
+        if (evs[i].data.ptr == nullptr) return; // the wake fd: stopping
+        if (evs[i].data.ptr == &task_fd) {
+          run_task();
+          continue;
+        }
+        service((Reg *)evs[i].data.ptr);
+      }
+    }
+  }
+};
+
+IoService::IoService(size_t threads, size_t max_blocking, int write_timeout_ms)
+    : nthreads_(threads ? threads : std::max(1u, std::thread::hardware_concurrency())),
+      write_timeout_ms_(write_timeout_ms), impl_(std::make_unique<Impl>()), blk_max_(std::max<size_t>(max_blocking, 1)) {
+  impl_->owner = this;
+  impl_->ep = epoll_create1(EPOLL_CLOEXEC);
+  impl_->wake = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  impl_->task_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK | EFD_SEMAPHORE);
+  if (impl_->ep < 0 || impl_->wake < 0 || impl_->task_fd < 0)
+    throw std::runtime_error("IoService: cannot create epoll instance");
+  epoll_event ev{};
+  ev.events = EPOLLIN; // level-triggered: wakes every thread
+  ev.data.ptr = nullptr;
+  epoll_ctl(impl_->ep, EPOLL_CTL_ADD, impl_->wake, &ev);
+  ev.data.ptr = &impl_->task_fd; // level-triggered too, while tasks remain
+  epoll_ctl(impl_->ep, EPOLL_CTL_ADD, impl_->task_fd, &ev);
+  for (size_t i = 0; i < nthreads_; i++)
+    impl_->threads.emplace_back([this] { impl_->run(); });
+}
+
+IoService::~IoService() {
+  stop();
+  ::close(impl_->wake);
+  ::close(impl_->task_fd);
+  ::close(impl_->ep);
+}
+
+bool IoService::add(std::shared_ptr<Handler> h) {
+  h->connection().set_write_timeout(write_timeout_ms_);
+  int fd = (int)h->connection().native_handle();
+  auto *r = new Impl::Reg{std::move(h), fd};
+  {
+    std::lock_guard<std::mutex> lk(impl_->mu);
+    if (impl_->stopping) {
+      delete r;
+      return false;
+    }
+    impl_->regs.insert(r);
+    live_++;
+  }
+  epoll_event ev{};
+  ev.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+  ev.data.ptr = r;
+  if (epoll_ctl(impl_->ep, EPOLL_CTL_ADD, fd, &ev) != 0) {
+    LOG_ERROR(std::string("epoll_ctl: ") + std::strerror(errno));
+    std::lock_guard<std::mutex> lk(impl_->mu);
+    impl_->regs.erase(r);
+    live_--;
+    delete r;
+    return false;
+  }
+  return true;
+}
+
+void IoService::post(std::function<void()> fn) {
+  {
+    std::lock_guard<std::mutex> lk(impl_->task_mu);
+    if (impl_->tasks_closed) return;
+    impl_->tasks.push_back(std::move(fn));
+  }
+  uint64_t one = 1;
+  (void)!::write(impl_->task_fd, &one, sizeof(one));
+}
+
+void IoService::stop() {
+  {
+    std::unique_lock<std::mutex> lk(impl_->mu);
+    if (impl_->threads.empty()) return;
+    impl_->stopping = true;
+    // Shut down every connection; each one's thread then sees EOF and
+    // closes it. Bounded: a handler stuck in a write is not waited on forever.
+    for (auto *r : impl_->regs) r->h->connection().shutdown();
+    impl_->cv.wait_for(lk, std::chrono::seconds(5), [&] { return impl_->regs.empty(); });
+  }
+  uint64_t one = 1;
+  (void)!::write(impl_->wake, &one, sizeof(one));
+  for (auto &t : impl_->threads) t.join();
+  impl_->threads.clear();
+  stop_blocking();
+  std::deque<std::function<void()>> dropped; // may hold the last connection references
+  {
+    std::lock_guard<std::mutex> lk(impl_->task_mu);
+    impl_->tasks_closed = true;
+    dropped.swap(impl_->tasks);
+  }
+  dropped.clear();
+  std::lock_guard<std::mutex> lk(impl_->mu);
+  for (auto *r : impl_->regs) { // only if a close above timed out
+    r->h->on_close();
+    delete r;
+  }
+  impl_->regs.clear();
+  live_ = 0;
+}
+
+} // namespace wininspectd
+#endif
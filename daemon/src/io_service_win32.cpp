@@ -0,0 +1,186 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#ifdef _WIN32
+#include "io_service.hpp"
+#include "wininspect/logger.hpp"
+#include "wininspect/util_win32.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <unordered_set>
+#include <winsock2.h>
+#include <windows.h>
+
+namespace wininspectd {
+
+// Each connection has at most one overlapped read outstanding, reposted
+// only after on_data returns; that is what serializes its callbacks. The
+// transports' own synchronous writes tag their event handles so their
+// completions are not queued here (see transport_win32.cpp). Posted tasks
+// travel through the port too, as packets with TASK_KEY.
+struct IoService::Impl {
+  static constexpr ULONG_PTR TASK_KEY = 1; // never a Reg address
+
+  struct Reg {
+    OVERLAPPED ov{};
+    std::shared_ptr<Handler> h;
+    HANDLE handle;
+    bool socket;
+    char buf[4096]; // small: this is per idle connection
+  };
+
+  IoService *owner;
+  HANDLE port = nullptr;
+  std::vector<std::thread> threads;
+  std::mutex mu;
+  std::condition_variable cv;
+  std::unordered_set<Reg *> regs;
+  bool stopping = false;
+  bool tasks_closed = false; // under mu
+
+  bool post_read(Reg *r) {
+    ZeroMemory(&r->ov, sizeof(r->ov));
+    if (r->socket) {
+      WSABUF wb{(ULONG)sizeof(r->buf), r->buf};
+      DWORD flags = 0;
+      if (WSARecv((SOCKET)r->handle, &wb, 1, nullptr, &flags, &r->ov, nullptr) == 0)
+        return true;
+      return WSAGetLastError() == WSA_IO_PENDING;
+    }
+    if (ReadFile(r->handle, r->buf, (DWORD)sizeof(r->buf), nullptr, &r->ov)) return true;
+    return GetLastError() == ERROR_IO_PENDING;
+  }
+
+  void close_reg(Reg *r) {
+    r->h->on_close();
+    {
+      std::lock_guard<std::mutex> lk(mu);
+      regs.erase(r);
+      owner->live_--;
+    }
+    cv.notify_all();
+    delete r;
+  }
+
+  void run() {
+    wininspect::CoInitGuard coinit; // handlers call into the Win32 backend
+    while (true) {
+      DWORD n = 0;
+      ULONG_PTR key = 0;
+      OVERLAPPED *ov = nullptr;
+      BOOL ok = GetQueuedCompletionStatus(port, &n, &key, &ov, INFINITE);
+      if (key == TASK_KEY && ov) {
+        std::unique_ptr<std::function<void()>> fn((std::function<void()> *)ov);
+        try {
+          (*fn)();
+        } catch (const std::exception &e) {
+          LOG_ERROR(std::string("I/O task failed: ") + e.what());
+        }
+        continue;
+      }
+      if (!ov) {
+        if (key == 0) return; // posted by stop()
+        continue;
+      }
+      auto *r = (Reg *)key;
+      if (!ok || n == 0) { // error, cancellation, or EOF
+        close_reg(r);
+        continue;
+      }
+      r->h->on_data(r->buf, n);
+      if (!post_read(r)) close_reg(r);
+    }
+  }
+};
+
+IoService::IoService(size_t threads, size_t max_blocking, int write_timeout_ms)
+    : nthreads_(threads ? threads : std::max(1u, std::thread::hardware_concurrency())),
+      write_timeout_ms_(write_timeout_ms), impl_(std::make_unique<Impl>()), blk_max_(std::max<size_t>(max_blocking, 1)) {
+  impl_->owner = this;
+  impl_->port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, (DWORD)nthreads_);
+  if (!impl_->port) throw std::runtime_error("IoService: cannot create completion port");
+  for (size_t i = 0; i < nthreads_; i++)
+    impl_->threads.emplace_back([this] { impl_->run(); });
+}
+
+IoService::~IoService() {
+  stop();
+  CloseHandle(impl_->port);
+}
+
+bool IoService::add(std::shared_ptr<Handler> h) {
+  auto &c = h->connection();
+  c.set_write_timeout(write_timeout_ms_);
+  auto *r = new Impl::Reg;
+  r->handle = (HANDLE)c.native_handle();
+  r->socket = c.is_socket();
+  r->h = std::move(h);
+  {
+    std::lock_guard<std::mutex> lk(impl_->mu);
+    if (impl_->stopping) {
+      delete r;
+      return false;
+    }
+  }
+  if (!CreateIoCompletionPort(r->handle, impl_->port, (ULONG_PTR)r, 0)) {
+    LOG_ERROR("CreateIoCompletionPort failed: " + std::to_string(GetLastError()));
+    delete r;
+    return false;
+  }
+  {
+    std::lock_guard<std::mutex> lk(impl_->mu);
+    impl_->regs.insert(r);
+    live_++;
+  }
+  if (!impl_->post_read(r)) impl_->close_reg(r);
+  return true;
+}
+
+void IoService::post(std::function<void()> fn) {
+  auto *task = new std::function<void()>(std::move(fn));
+  {
+    std::lock_guard<std::mutex> lk(impl_->mu);
+    if (!impl_->tasks_closed &&
+        PostQueuedCompletionStatus(impl_->port, 0, Impl::TASK_KEY, (OVERLAPPED *)task))
+      return;
+  }
+  delete task;
+}
+
+void IoService::stop() {
+  {
+    std::unique_lock<std::mutex> lk(impl_->mu);
+    if (impl_->threads.empty()) return;
+    impl_->stopping = true;
+    // Shutting a connection down cancels its read; the completion closes it.
+    for (auto *r : impl_->regs) r->h->connection().shutdown();
+    impl_->cv.wait_for(lk, std::chrono::seconds(5), [&] { return impl_->regs.empty(); });
+  }
+  for (size_t i = 0; i < impl_->threads.size(); i++)
+    PostQueuedCompletionStatus(impl_->port, 0, 0, nullptr);
+  for (auto &t : impl_->threads) t.join();
+  impl_->threads.clear();
+  stop_blocking();
+  {
+    std::lock_guard<std::mutex> lk(impl_->mu);
+    impl_->tasks_closed = true;
+  }
+  // Tasks left in the port may hold the last connection references.
+  DWORD n = 0;
+  ULONG_PTR key = 0;
+  OVERLAPPED *ov = nullptr;
+  while (GetQueuedCompletionStatus(impl_->port, &n, &key, &ov, 0) || ov) {
+    if (key == Impl::TASK_KEY && ov) delete (std::function<void()> *)ov;
+  }
+  // Anything left still has a read outstanding into its Reg; leak those
+  // rather than free memory the kernel may yet write to.
+  std::lock_guard<std::mutex> lk(impl_->mu);
+  for (auto *r : impl_->regs) r->h->on_close();
+  impl_->regs.clear();
+  live_ = 0;
+}
+
+} // namespace wininspectd
+#endif
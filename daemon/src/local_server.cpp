@@ -0,0 +1,185 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "local_server.hpp"
+#include "io_service.hpp"
+#include "request_connection.hpp"
+#include "shm_ring.hpp"
+#include "transport.hpp"
+#include "wininspect/core.hpp"
+#include "wininspect/logger.hpp"
+
+using namespace wininspect;
+
+namespace wininspectd {
+
+namespace {
+
+class LocalConnection final : public RequestConnection {
+public:
+  LocalConnection(std::unique_ptr<IConnection> conn, IoService *io, ServerState *st,
+                  CoreEngine *core, IBackend *backend, const LocalServer::Options *opts)
+      : RequestConnection(std::move(conn), io, st), core_(core), backend_(backend),
+        opts_(opts) {
+    st->active_connections++;
+    LOG_INFO("New client connection established.");
+    // Auto-auth local clients only when not in require-auth mode and no keys configured
+    if (!opts->require_auth && opts->auth_keys.empty()) {
+      session_.authenticated = true;
+      LOG_DEBUG("Local auto-auth enabled (no keys, not require-auth).");
+    }
+  }
+  ~LocalConnection() override {
+    connection().shutdown();
+    session_.stream.reset(); // they call our send()
+    session_.file_stream.reset();
+    st_->active_connections--;
+    LOG_INFO("Client connection closed.");
+  }
+
+protected:
+  // A FRAME_SHM frame locates the request in the client's ring; it is
+  // copied out and the space handed back straight away, in arrival order.
+  bool decode(std::string &frame, std::uint32_t flags) override {
+    if (flags & FRAME_COMPRESSED) return false;
+    if (!(flags & FRAME_SHM)) return true;
+    ShmRegion *shm;
+    {
+      std::lock_guard<std::mutex> lk(write_mu_);
+      shm = shm_.get();
+    }
+    ShmSpan s;
+    const std::uint8_t *p = shm && s.decode(frame.data(), frame.size())
+                                ? shm->to_daemon().at(s)
+                                : nullptr;
+    if (!p || s.len > MAX_FRAME_BYTES) return false;
+    frame.assign((const char *)p, s.len);
+    shm->to_daemon().release(s);
+    return true;
+  }
+
+  void handle_frame(std::string frame, std::vector<Attachment> attachments) override {
+    if (st_->shm_ring_bytes > 0 && session_.authenticated &&
+        frame.find("transport.shm") != std::string::npos) {
+      try {
+        auto req = parse_request_json(frame);
+        if (req.method == "transport.shm") {
+          open_shm(req.id);
+          return;
+        }
+      } catch (...) {
+        // serve() answers it
+      }
+    }
+    serve(frame, std::move(attachments), *core_, backend_, opts_->read_only, opts_->no_clipboard,
+          opts_->require_auth, opts_->auth_keys);
+  }
+
+  // Large frames go through the ring when there is room for them soon
+  // enough; the frame on the pipe keeps their place in the order.
+  bool send(const std::string &frame, std::uint32_t flags = 0) override {
+    std::lock_guard<std::mutex> lk(write_mu_);
+    if (shm_ && frame.size() >= st_->shm_min_bytes) {
+      ConstBuffer b{frame.data(), frame.size()};
+      ShmSpan s;
+      if (shm_->to_client().write(&b, 1, s, ShmClient::WAIT_MS)) {
+        std::uint8_t d[ShmSpan::WIRE_BYTES];
+        s.encode(d);
+        return write_frame(connection(), d, sizeof(d), flags | FRAME_SHM);
+      }
+    }
+    return write_frame(connection(), frame.data(), frame.size(), flags);
+  }
+
+private:
+  // transport.shm (ordered, so nothing else of ours is running): the reply
+  // carries the descriptors, and only after it do frames use the rings.
+  void open_shm(const std::string &id) {
+    CoreResponse resp;
+    resp.id = id;
+    std::lock_guard<std::mutex> lk(write_mu_);
+    auto region = shm_ ? nullptr : ShmRegion::create(st_->shm_ring_bytes);
+    if (!region) {
+      resp.ok = false;
+      resp.error_code = "E_BAD_REQUEST";
+      resp.error_message = shm_ ? "shared memory already set up" : "shared memory unavailable";
+      (void)write_frame(connection(), serialize_response_json(resp, false));
+      return;
+    }
+    json::Object r;
+    r["ring_bytes"] = (double)region->to_client().capacity();
+    r["min_bytes"] = (double)st_->shm_min_bytes;
+    if (!region->name().empty()) r["name"] = region->name();
+    resp.result = r;
+    std::string payload = serialize_response_json(resp, false);
+    std::uint32_t len = (std::uint32_t)payload.size();
+    payload.insert(0, (const char *)&len, sizeof(len));
+    auto handles = region->handles();
+    if (!connection().write_with_handles(payload.data(), payload.size(), handles.data(),
+                                         handles.size())) {
+      connection().shutdown();
+      return;
+    }
+    shm_ = std::move(region);
+    LOG_DEBUG("Local client attached shared memory rings.");
+  }
+
+  std::unique_ptr<ShmRegion> shm_; // set under write_mu_, once
+  CoreEngine *core_;
+  IBackend *backend_;
+  const LocalServer::Options *opts_;
+};
+
+} // namespace
+
+LocalServer::LocalServer(ServerState *state, IBackend *backend)
+    : state_(state), backend_(backend), core_(std::make_unique<CoreEngine>(backend)) {}
+
+LocalServer::~LocalServer() {
+  stop();
+  if (own_io_) own_io_->stop(); // connections use core_ and opts_
+}
+
+void LocalServer::stop() {
+  std::lock_guard<std::mutex> lk(listen_mu_);
+  stopped_ = true;
+  if (listener_) listener_->close();
+}
+
+void LocalServer::start(std::atomic<bool> *running, const std::string &name,
+                        const std::string &auth_keys, bool read_only,
+                        bool require_auth, bool admin_logs, bool no_clipboard) {
+  core_->set_admin_logs_enabled(admin_logs);
+  opts_ = Options{auth_keys, read_only, require_auth, no_clipboard};
+  IoService *io = state_->io.get();
+  if (!io) io = (own_io_ = std::make_unique<IoService>()).get();
+
+  auto listener = listen_local(name);
+  if (!listener) return;
+  {
+    std::lock_guard<std::mutex> lk(listen_mu_);
+    if (stopped_) return;
+    listener_ = listener.get();
+  }
+  LOG_INFO("Local server listening on: " + listener->address());
+
+  while (running->load()) {
+    auto conn = listener->accept(250);
+    if (!conn) {
+      std::lock_guard<std::mutex> lk(listen_mu_);
+      if (stopped_) break;
+      continue;
+    }
+    LOG_DEBUG("Local connection accepted.");
+
+    if (state_->active_connections >= state_->max_connections)
+      continue; // too many connections, drop this one
+    io->add(std::make_shared<LocalConnection>(std::move(conn), io, state_, core_.get(),
+                                              backend_, &opts_));
+  }
+
+  std::lock_guard<std::mutex> lk(listen_mu_);
+  listener_ = nullptr;
+}
+
+} // namespace wininspectd
@@ -0,0 +1,55 @@
+#pragma once
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "server_state.hpp"
+
+namespace wininspect {
+class CoreEngine;
+class IBackend;
+} // namespace wininspect
+
+namespace wininspectd {
+
+class IListener;
+class IoService;
+
+/// Same-machine clients: the named pipe on Windows, a Unix domain socket
+/// elsewhere (see listen_local). Frames are plain length-prefixed JSON with
+/// no handshake; clients are trusted unless require_auth or keys are set.
+/// Connections are served by the state's IoService (or a private one).
+class LocalServer {
+public:
+  LocalServer(wininspect::ServerState *state, wininspect::IBackend *backend);
+  ~LocalServer();
+
+  /// Blocks until `running` is cleared or stop() is called.
+  void start(std::atomic<bool> *running, const std::string &name,
+             const std::string &auth_keys = "", bool read_only = false,
+             bool require_auth = false, bool admin_logs = false,
+             bool no_clipboard = false);
+  void stop();
+
+  struct Options {
+    std::string auth_keys;
+    bool read_only = false;
+    bool require_auth = false;
+    bool no_clipboard = false;
+  };
+
+private:
+  wininspect::ServerState *state_;
+  wininspect::IBackend *backend_;
+  std::unique_ptr<wininspect::CoreEngine> core_; // shared by all connections
+  std::unique_ptr<IoService> own_io_;            // if the state has none
+  Options opts_;
+  std::mutex listen_mu_;
+  IListener *listener_ = nullptr; // owned by start()
+  bool stopped_ = false;
+};
+
+} // namespace wininspectd
@@ -0,0 +1,134 @@
+#pragma once
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+// Scheduling for pushed streams (events.stream, streamed file.read, the SSE
+// feed). Instead of a thread per subscriber that polls, each stream is a
+// step run on the I/O threads whenever there may be something to send: new
+// events (publish_events wakes every EventPusher after a detector tick) or
+// new credit (the grant wakes its stream).
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include "io_service.hpp"
+#include "server_state.hpp"
+
+namespace wininspectd {
+
+/// Runs a step on `io` after each wake(), never two at once. A step does
+/// what it can without waiting and says what next: Again to run once more
+/// (behind whatever else is queued, so one busy stream cannot starve the
+/// others), Sleep to wait for the next wake(), Done to finish; the step is
+/// then released and later wakes are ignored. A wake() that arrives while
+/// the step runs makes it run again, so none is lost.
+class PushTask {
+public:
+  enum class Next { Again, Sleep, Done };
+  using Step = std::function<Next()>;
+
+  PushTask(IoService *io, Step step) : s_(std::make_shared<State>()) {
+    s_->io = io;
+    s_->step = std::move(step);
+  }
+  ~PushTask() { stop(); }
+
+  PushTask(const PushTask &) = delete;
+  PushTask &operator=(const PushTask &) = delete;
+
+  void wake() {
+    std::lock_guard<std::mutex> lk(s_->mu);
+    if (s_->stopped || !s_->step) return;
+    if (s_->queued) {
+      s_->again = true;
+      return;
+    }
+    s_->queued = true;
+    s_->io->post([s = s_] { run(s); });
+  }
+
+  /// No step starts after this, and one in progress has returned. Not
+  /// from inside the step.
+  void stop() {
+    std::unique_lock<std::mutex> lk(s_->mu);
+    s_->stopped = true;
+    s_->cv.wait(lk, [&] { return !s_->running; });
+  }
+
+private:
+  struct State {
+    IoService *io = nullptr;
+    std::mutex mu;
+    std::condition_variable cv;
+    Step step;
+    bool queued = false;  // posted or running
+    bool again = false;   // woken while queued
+    bool running = false;
+    bool stopped = false;
+  };
+
+  static void run(const std::shared_ptr<State> &s) {
+    {
+      std::lock_guard<std::mutex> lk(s->mu);
+      if (s->stopped) {
+        s->queued = false;
+        return;
+      }
+      s->running = true;
+      s->again = false;
+    }
+    Next next = s->step(); // only this run touches `step` until it clears it
+    Step done;
+    {
+      std::lock_guard<std::mutex> lk(s->mu);
+      s->running = false;
+      if (next == Next::Done) {
+        done.swap(s->step);
+        s->queued = false;
+      } else if (!s->stopped && (next == Next::Again || s->again)) {
+        s->again = false;
+        s->io->post([s] { run(s); });
+      } else {
+        s->queued = false;
+      }
+    }
+    s->cv.notify_all();
+    // `done` goes here, outside the lock: it may hold the last reference
+    // to a connection.
+  }
+
+  std::shared_ptr<State> s_;
+};
+
+/// A stream of the shared event log or a filtered subscription's. While
+/// registered with watch_events, on_publish is called after every detector
+/// tick (events or not) and decides whether to wake its PushTask.
+class EventPusher {
+public:
+  virtual ~EventPusher() = default;
+  virtual void on_publish() = 0;
+};
+
+inline void watch_events(wininspect::ServerState *st, EventPusher *p) {
+  std::lock_guard<std::mutex> lk(st->pushers_mu);
+  st->event_pushers.push_back(p);
+}
+
+inline void unwatch_events(wininspect::ServerState *st, EventPusher *p) {
+  std::lock_guard<std::mutex> lk(st->pushers_mu);
+  auto &v = st->event_pushers;
+  v.erase(std::remove(v.begin(), v.end(), p), v.end());
+}
+
+/// From the detector sink. While anyone streams, this also counts as a
+/// touch, so the detector keeps ticking for them.
+inline void wake_event_pushers(wininspect::ServerState *st) {
+  std::lock_guard<std::mutex> lk(st->pushers_mu);
+  if (st->event_pushers.empty()) return;
+  if (st->detector) st->detector->touch();
+  for (auto *p : st->event_pushers) p->on_publish();
+}
+
+} // namespace wininspectd
@@ -7,17 +7,16 @@
 #include "wininspect/logger.hpp"
 #include "wininspect/crypto.hpp"
 #include "wininspect/tinyjson.hpp"
+#include "transport.hpp"
 
 using namespace wininspect;
 
 #ifdef _WIN32
 #include <windows.h>
-#include <winsock2.h>
-#include <ws2tcpip.h>
 #include <bcrypt.h>
-#pragma comment(lib, "ws2_32.lib")
 #endif
 
+#include <map>
 #include <sstream>
 #include <cstring>
 #include <thread>
@@ -58,7 +57,7 @@ static std::vector<uint8_t> hmac_sha256(const std::vector<uint8_t> &key,
 // ── Simple HTTP Client (inline, no external dependency) ──────────────────────
 
 /// Minimal HTTP/S client for rendezvous communication.
-/// Uses Winsock for TCP; no TLS — rendezvous server should be local/LAN.
+/// Plain TCP via the daemon transport; no TLS — rendezvous server should be local/LAN.
 /// For production, consider adding TLS or running behind a reverse proxy.
 struct HttpResponse {
   int status_code{};
@@ -100,22 +99,8 @@ static HttpResponse http_request(const std::string &method,
     host = host_port;
   }
 
-  // Create socket
-  SOCKET s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-  if (s == INVALID_SOCKET) return resp;
-
-  struct hostent *he = gethostbyname(host.c_str());
-  if (!he) { closesocket(s); return resp; }
-
-  struct sockaddr_in addr = {};
-  addr.sin_family = AF_INET;
-  addr.sin_port = htons((u_short)port);
-  std::memcpy(&addr.sin_addr, he->h_addr_list[0], he->h_length);
-
-  if (connect(s, (struct sockaddr *)&addr, sizeof(addr)) == SOCKET_ERROR) {
-    closesocket(s);
-    return resp;
-  }
+  auto conn = connect_tcp(host, port);
+  if (!conn) return resp;
 
   // Build HTTP request
   std::ostringstream req;
@@ -134,17 +119,15 @@ static HttpResponse http_request(const std::string &method,
     req << body;
 
   std::string req_str = req.str();
-  send(s, req_str.data(), (int)req_str.size(), 0);
+  if (!conn->write_all(req_str.data(), req_str.size())) return resp;
 
   // Read response
   char buf[4096];
   std::string raw;
-  int r;
-  while ((r = recv(s, buf, sizeof(buf) - 1, 0)) > 0) {
-    buf[r] = '\0';
-    raw += buf;
-  }
-  closesocket(s);
+  long r;
+  while ((r = conn->read_some(buf, sizeof(buf))) > 0)
+    raw.append(buf, (size_t)r);
+  conn.reset();
 
   // Parse HTTP response
   size_t hdr_end = raw.find("\r\n\r\n");
@@ -174,10 +157,7 @@ public:
     if (key_.empty()) {
       // Generate a random key on first run (for ad-hoc use)
       key_.resize(32);
-#ifdef _WIN32
-      BCryptGenRandom(nullptr, key_.data(), (ULONG)key_.size(),
-                      BCRYPT_USE_SYSTEM_PREFERRED_RNG);
-#endif
+      (void)wininspect::crypto::random_bytes(key_.data(), key_.size());
     }
   }
 
@@ -193,6 +173,7 @@ public:
     body["host"] = host;
     body["port"] = (double)port;
     body["pubkey"] = id.ecdh_pubkey;
+    body["ttl_sec"] = (double)cfg_.heartbeat_sec; // expiry follows our interval
 
     auto auth = make_auth("register:" + id.uuid);
     auto resp = http_request("POST", cfg_.url + "/register",
@@ -222,38 +203,37 @@ public:
     return (resp.status_code == 200 || resp.status_code == 204);
   }
 
+  // After the first call, asks only for what changed since the version
+  // last seen (?since=V) and applies that to the instances already known;
+  // an unchanged table costs a 304 with no body. Servers without deltas
+  // answer 404 to the query, after which the whole list is fetched.
   std::vector<DiscoveredInstance> discover() override {
-    std::vector<DiscoveredInstance> results;
     auto auth = make_auth("discover");
+    if (deltas_) {
+      auto resp = http_request("GET", cfg_.url + "/instances?since=" + std::to_string(version_),
+                                "", "", auth);
+      if (resp.status_code == 304) return known_list();
+      if (resp.status_code == 200 && apply_delta(resp.body)) return known_list();
+      if (resp.status_code != 404) return {};
+      deltas_ = false;
+    }
     auto resp = http_request("GET", cfg_.url + "/instances",
                               "", "", auth);
-    if (resp.status_code != 200) return results;
+    if (resp.status_code != 200) return {};
 
     try {
       auto v = wininspect::json::parse(resp.body);
-      if (!v.is_arr()) return results;
+      if (!v.is_arr()) return {};
+      known_.clear();
       for (auto &item : v.as_arr()) {
         if (!item.is_obj()) continue;
-        auto obj = item.as_obj();
-        DiscoveredInstance di;
-        auto it = obj.find("uuid");
-        if (it != obj.end() && it->second.is_str()) di.uuid = it->second.as_str();
-        it = obj.find("name");
-        if (it != obj.end() && it->second.is_str()) di.name = it->second.as_str();
-        it = obj.find("host");
-        if (it != obj.end() && it->second.is_str()) di.host = it->second.as_str();
-        it = obj.find("port");
-        if (it != obj.end() && it->second.is_num()) di.port = (int)it->second.as_num();
-        it = obj.find("pubkey");
-        if (it != obj.end() && it->second.is_str()) di.pubkey = it->second.as_str();
-        it = obj.find("last_seen");
-        if (it != obj.end() && it->second.is_num()) di.last_seen = (int64_t)it->second.as_num();
-        results.push_back(std::move(di));
+        auto di = parse_instance(item.as_obj());
+        known_[di.uuid] = std::move(di);
       }
     } catch (...) {
       LOG_WARN("Failed to parse rendezvous discovery response");
     }
-    return results;
+    return known_list();
   }
 
 private:
@@ -269,11 +249,68 @@ private:
     return "Rendezvous " + base64::encode(h);
   }
 
+  static DiscoveredInstance parse_instance(const wininspect::json::Object &obj) {
+    DiscoveredInstance di;
+    auto it = obj.find("uuid");
+    if (it != obj.end() && it->second.is_str()) di.uuid = it->second.as_str();
+    it = obj.find("name");
+    if (it != obj.end() && it->second.is_str()) di.name = it->second.as_str();
+    it = obj.find("host");
+    if (it != obj.end() && it->second.is_str()) di.host = it->second.as_str();
+    it = obj.find("port");
+    if (it != obj.end() && it->second.is_num()) di.port = (int)it->second.as_num();
+    it = obj.find("pubkey");
+    if (it != obj.end() && it->second.is_str()) di.pubkey = it->second.as_str();
+    it = obj.find("last_seen");
+    if (it != obj.end() && it->second.is_num()) di.last_seen = (int64_t)it->second.as_num();
+    return di;
+  }
+
+  /// {"version", "full", "instances", "removed"}; false if malformed.
+  bool apply_delta(const std::string &body) {
+    try {
+      auto v = wininspect::json::parse(body);
+      if (!v.is_obj()) return false;
+      const auto &o = v.as_obj();
+      auto ver = o.find("version");
+      auto inst = o.find("instances");
+      if (ver == o.end() || !ver->second.is_num() || inst == o.end() || !inst->second.is_arr())
+        return false;
+      auto full = o.find("full");
+      if (full != o.end() && full->second.is_bool() && full->second.as_bool()) known_.clear();
+      for (auto &item : inst->second.as_arr()) {
+        if (!item.is_obj()) continue;
+        auto di = parse_instance(item.as_obj());
+        known_[di.uuid] = std::move(di);
+      }
+      auto removed = o.find("removed");
+      if (removed != o.end() && removed->second.is_arr())
+        for (auto &u : removed->second.as_arr())
+          if (u.is_str()) known_.erase(u.as_str());
+      version_ = (std::uint64_t)ver->second.as_num();
+      return true;
+    } catch (...) {
+      LOG_WARN("Failed to parse rendezvous discovery delta");
+      return false;
+    }
+  }
+
+  std::vector<DiscoveredInstance> known_list() const {
+    std::vector<DiscoveredInstance> out;
+    out.reserve(known_.size());
+    for (auto &[uuid, di] : known_) out.push_back(di);
+    return out;
+  }
+
   wininspect::RendezvousConfig cfg_;
   std::vector<uint8_t> key_;
   std::string host_;
   int port_{};
   std::string uuid_;
+  // discover() state: the table as of version_.
+  std::map<std::string, DiscoveredInstance> known_;
+  std::uint64_t version_ = 0;
+  bool deltas_ = true; // the server supports ?since
 };
 
 // ── Factory ─────────────────────────────────────────────────────────────────
@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+// wininspect-rendezvous: the discovery service daemons register with (see
+// rendezvous_server.cpp).
+
+#include "rendezvous_registry.hpp"
+#include "rendezvous_server.hpp"
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <iostream>
+#include <string>
+
+using namespace wininspectd;
+
+namespace {
+std::atomic<bool> g_running{true};
+void on_signal(int) { g_running = false; }
+} // namespace
+
+int main(int argc, char **argv) {
+  int port = 8080;
+  RendezvousRegistry::Options opts;
+  for (int i = 1; i < argc; ++i) {
+    std::string a = argv[i];
+    if (a == "--port" && i + 1 < argc) port = std::stoi(argv[++i]);
+    else if (a == "--shards" && i + 1 < argc) opts.shards = (size_t)std::stoul(argv[++i]);
+    else if (a == "--help") {
+      std::cerr << "WinInspect Rendezvous Server\n"
+                   "Usage: wininspect-rendezvous [--port <n>] [--shards <n>]\n";
+      return 0;
+    }
+  }
+
+  std::signal(SIGINT, on_signal);
+  std::signal(SIGTERM, on_signal);
+
+  auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                 std::chrono::steady_clock::now().time_since_epoch())
+                 .count();
+  RendezvousRegistry registry(opts, now);
+  RendezvousServer srv(registry);
+  srv.start(&g_running, port);
+  return 0;
+}
@@ -0,0 +1,163 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "rendezvous_registry.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <set>
+
+using namespace wininspect;
+
+namespace wininspectd {
+
+json::Object RendezvousInstance::to_json(std::int64_t now_ms) const {
+  json::Object o;
+  o["uuid"] = uuid;
+  o["name"] = name;
+  o["host"] = host;
+  o["port"] = (double)port;
+  if (!pubkey.empty()) o["pubkey"] = pubkey;
+  o["ttl_sec"] = (double)ttl_sec;
+  o["last_seen"] = (double)(std::max<std::int64_t>(now_ms - last_heartbeat_ms, 0) / 1000);
+  o["version"] = (double)version;
+  return o;
+}
+
+RendezvousRegistry::RendezvousRegistry(Options opts, std::int64_t now_ms) : opts_(opts) {
+  opts_.shards = std::max<size_t>(opts_.shards, 1);
+  opts_.tick_ms = std::max(opts_.tick_ms, 1);
+  opts_.change_log = std::max<size_t>(opts_.change_log, 1);
+  for (size_t i = 0; i < opts_.shards; i++)
+    shards_.push_back(std::make_unique<Shard>(tick(now_ms)));
+}
+
+RendezvousRegistry::Shard &RendezvousRegistry::shard_for(const std::string &uuid) const {
+  return *shards_[std::hash<std::string>{}(uuid) % shards_.size()];
+}
+
+void RendezvousRegistry::schedule_locked(Shard &s, Entry &e) {
+  e.gen = s.next_gen++;
+  // Rounded up, so nothing expires early.
+  s.wheel.schedule(tick(deadline_ms(e.inst) + opts_.tick_ms - 1), {e.inst.uuid, e.gen});
+}
+
+std::uint64_t RendezvousRegistry::record_locked(const std::string &uuid) {
+  std::lock_guard<std::mutex> lk(log_mu_);
+  std::uint64_t v = version_.load() + 1;
+  log_.emplace_back(v, uuid);
+  if (log_.size() > opts_.change_log) {
+    log_floor_ = log_.front().first;
+    log_.pop_front();
+  }
+  version_.store(v);
+  return v;
+}
+
+std::uint64_t RendezvousRegistry::upsert(RendezvousInstance inst, std::int64_t now_ms) {
+  Shard &s = shard_for(inst.uuid);
+  std::lock_guard<std::mutex> lk(s.mu);
+  inst.last_heartbeat_ms = now_ms;
+  auto it = s.map.find(inst.uuid);
+  if (it == s.map.end()) {
+    inst.version = record_locked(inst.uuid);
+    auto &e = s.map[inst.uuid];
+    e.inst = std::move(inst);
+    schedule_locked(s, e);
+    size_++;
+    return e.inst.version;
+  }
+  Entry &e = it->second;
+  const auto &cur = e.inst;
+  bool same = cur.name == inst.name && cur.host == inst.host && cur.port == inst.port &&
+              cur.pubkey == inst.pubkey && cur.ttl_sec == inst.ttl_sec;
+  inst.version = same ? cur.version : record_locked(inst.uuid);
+  bool sooner = deadline_ms(inst) < deadline_ms(cur);
+  e.inst = std::move(inst);
+  if (sooner) schedule_locked(s, e); // a shorter TTL; the old entry is now stale
+  return e.inst.version;
+}
+
+bool RendezvousRegistry::heartbeat(const std::string &uuid, std::int64_t now_ms) {
+  Shard &s = shard_for(uuid);
+  std::lock_guard<std::mutex> lk(s.mu);
+  auto it = s.map.find(uuid);
+  if (it == s.map.end()) return false;
+  // The wheel entry stays where it is; when it fires it sees the later
+  // deadline and moves on.
+  it->second.inst.last_heartbeat_ms = std::max(it->second.inst.last_heartbeat_ms, now_ms);
+  return true;
+}
+
+bool RendezvousRegistry::remove(const std::string &uuid) {
+  Shard &s = shard_for(uuid);
+  std::lock_guard<std::mutex> lk(s.mu);
+  if (!s.map.erase(uuid)) return false;
+  size_--;
+  (void)record_locked(uuid);
+  return true;
+}
+
+size_t RendezvousRegistry::expire(std::int64_t now_ms) {
+  size_t n = 0;
+  for (auto &sp : shards_) {
+    Shard &s = *sp;
+    std::lock_guard<std::mutex> lk(s.mu);
+    s.wheel.advance(tick(now_ms), [&](std::pair<std::string, std::uint64_t> &&due) {
+      auto it = s.map.find(due.first);
+      if (it == s.map.end() || it->second.gen != due.second) return; // gone or re-filed
+      Entry &e = it->second;
+      if (deadline_ms(e.inst) > now_ms) {
+        schedule_locked(s, e); // heartbeats arrived meanwhile
+        return;
+      }
+      std::string uuid = std::move(due.first);
+      s.map.erase(it);
+      size_--;
+      (void)record_locked(uuid);
+      n++;
+    });
+  }
+  return n;
+}
+
+std::vector<RendezvousInstance> RendezvousRegistry::list(std::uint64_t *version) const {
+  if (version) *version = version_.load(); // first: what follows is at least this new
+  std::vector<RendezvousInstance> out;
+  out.reserve(size_.load());
+  for (auto &sp : shards_) {
+    std::lock_guard<std::mutex> lk(sp->mu);
+    for (auto &[uuid, e] : sp->map) out.push_back(e.inst);
+  }
+  return out;
+}
+
+RendezvousRegistry::Delta RendezvousRegistry::since(std::uint64_t since) const {
+  Delta d;
+  std::set<std::string> touched;
+  {
+    std::lock_guard<std::mutex> lk(log_mu_);
+    d.version = version_.load();
+    // A version from the future is from a previous run of the server.
+    d.full = since == 0 || since < log_floor_ || since > d.version;
+    if (!d.full) {
+      auto from = std::upper_bound(log_.begin(), log_.end(), since,
+                                   [](std::uint64_t v, const auto &e) { return v < e.first; });
+      for (auto it = from; it != log_.end(); ++it) touched.insert(it->second);
+    }
+  }
+  if (d.full) {
+    d.changed = list(nullptr);
+    return d;
+  }
+  for (const auto &uuid : touched) {
+    Shard &s = shard_for(uuid);
+    std::lock_guard<std::mutex> lk(s.mu);
+    auto it = s.map.find(uuid);
+    if (it == s.map.end()) d.removed.push_back(uuid);
+    else d.changed.push_back(it->second.inst);
+  }
+  return d;
+}
+
+} // namespace wininspectd
@@ -0,0 +1,115 @@
+#pragma once
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "timing_wheel.hpp"
+#include "wininspect/tinyjson.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace wininspectd {
+
+/// One daemon as registered with the rendezvous server.
+struct RendezvousInstance {
+  std::string uuid, name, host, pubkey;
+  int port = 0;
+  int ttl_sec = 60;                 // expected heartbeat interval
+  std::int64_t last_heartbeat_ms{}; // steady clock
+  std::uint64_t version = 0;        // of its last change
+
+  /// Wire form; last_seen is seconds since the last heartbeat.
+  wininspect::json::Object to_json(std::int64_t now_ms) const;
+};
+
+/// The rendezvous server's instance table, for tens of thousands of
+/// daemons heartbeating at once.
+///
+/// - Instances are spread over shards by uuid, each with its own lock, so
+///   heartbeats from different daemons rarely contend.
+/// - Each shard keeps a TimingWheel of heartbeat deadlines; expire() only
+///   touches instances that came due, never the whole table.
+/// - Every registration, change and removal (including expiry) takes the
+///   next version and is appended to a bounded change log, so since(V)
+///   returns what changed after V. Heartbeats change nothing a client
+///   lists by, so they are not versioned.
+///
+/// Times are steady-clock milliseconds supplied by the caller.
+class RendezvousRegistry {
+public:
+  struct Options {
+    size_t shards = 16;
+    int expiry_factor = 3;         // missed heartbeats before removal
+    size_t change_log = 65536;     // entries kept for since()
+    int tick_ms = 250;             // expiry resolution
+  };
+  RendezvousRegistry() : RendezvousRegistry(Options{}) {}
+  explicit RendezvousRegistry(Options opts, std::int64_t now_ms = 0);
+
+  /// Adds or replaces `inst` (by uuid) and counts as a heartbeat. A
+  /// registration identical to the current one does not change the version.
+  /// Returns the instance's version.
+  std::uint64_t upsert(RendezvousInstance inst, std::int64_t now_ms);
+  /// False if the uuid is not registered.
+  bool heartbeat(const std::string &uuid, std::int64_t now_ms);
+  bool remove(const std::string &uuid);
+  /// Removes instances whose last heartbeat is more than expiry_factor TTLs
+  /// old; returns how many.
+  size_t expire(std::int64_t now_ms);
+
+  /// The version of the latest change; 0 while empty.
+  std::uint64_t version() const { return version_.load(); }
+  size_t size() const { return size_.load(); }
+
+  /// Every instance, and (in *version) a version it is at least as new as.
+  std::vector<RendezvousInstance> list(std::uint64_t *version) const;
+
+  struct Delta {
+    std::uint64_t version = 0; // pass back as `since` next time
+    bool full = false;         // `since` is too old: changed holds everything
+    std::vector<RendezvousInstance> changed;
+    std::vector<std::string> removed;
+  };
+  /// What changed after version `since`. Changes made while this runs may
+  /// be reported now and again next time; applying both is harmless.
+  Delta since(std::uint64_t since) const;
+
+private:
+  struct Entry {
+    RendezvousInstance inst;
+    std::uint64_t gen = 0; // matches the live wheel entry
+  };
+  struct Shard {
+    mutable std::mutex mu;
+    std::unordered_map<std::string, Entry> map;
+    TimingWheel<std::pair<std::string, std::uint64_t>> wheel; // uuid, gen
+    std::uint64_t next_gen = 1;
+    explicit Shard(std::uint64_t now_tick) : wheel(now_tick) {}
+  };
+
+  Shard &shard_for(const std::string &uuid) const;
+  std::uint64_t tick(std::int64_t ms) const { return (std::uint64_t)(ms / opts_.tick_ms); }
+  std::int64_t deadline_ms(const RendezvousInstance &i) const {
+    return i.last_heartbeat_ms + (std::int64_t)i.ttl_sec * 1000 * opts_.expiry_factor;
+  }
+  // Both under the shard's lock. record() returns the new version.
+  void schedule_locked(Shard &s, Entry &e);
+  std::uint64_t record_locked(const std::string &uuid);
+
+  Options opts_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+  std::atomic<size_t> size_{0};
+
+  mutable std::mutex log_mu_; // after any shard's lock
+  std::deque<std::pair<std::uint64_t, std::string>> log_; // version, uuid
+  std::uint64_t log_floor_ = 0; // since() below this needs a full list
+  std::atomic<std::uint64_t> version_{0};
+};
+
+} // namespace wininspectd
@@ -8,241 +8,279 @@
 //   PUT  /api/v1/rendezvous/heartbeat/<uuid> — keep registration alive
 //   DELETE /api/v1/rendezvous/instances/<uuid> — deregister
 //   GET  /api/v1/rendezvous/instances — list all registered instances
+//                                       (?since=V: only what changed after V)
+//   GET  /health
+//
+// Connections are kept alive, so a daemon heartbeats over one connection
+// for as long as it runs.
 
-#include "wininspect/tinyjson.hpp"
+#include "rendezvous_server.hpp"
+#include "http_parser.hpp"
+#include "io_service.hpp"
+#include "rendezvous_registry.hpp"
+#include "transport.hpp"
 #include "wininspect/logger.hpp"
+#include "wininspect/tinyjson.hpp"
 
-#ifdef _WIN32
-#include <winsock2.h>
-#include <ws2tcpip.h>
-#pragma comment(lib, "ws2_32.lib")
-#endif
-
-#include <string>
-#include <vector>
-#include <map>
-#include <mutex>
-#include <thread>
-#include <atomic>
+#include <algorithm>
 #include <chrono>
-#include <cstring>
-#include <sstream>
-#include <iostream>
-#include <functional>
+#include <string>
 
 using namespace wininspect;
 
-namespace {
-
-struct RegisteredInstance {
-  std::string uuid;
-  std::string name;
-  std::string host;
-  int port{};
-  std::string pubkey;
-  json::Object extra;
-  std::chrono::steady_clock::time_point last_heartbeat;
-  int heartbeat_ttl_sec = 60;
-};
+namespace wininspectd {
 
-std::map<std::string, RegisteredInstance> g_instances;
-std::mutex g_instances_mu;
+namespace {
 
-struct HttpRequest {
-  std::string method;
-  std::string path;
-  std::string body;
-  std::map<std::string, std::string> headers;
-};
+std::int64_t now_ms() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
 
-struct HttpResponse {
-  int status_code = 200;
-  std::string status_text = "OK";
-  std::string content_type = "application/json";
-  std::string body;
-};
+const std::string kRegister = "/api/v1/rendezvous/register";
+const std::string kHeartbeat = "/api/v1/rendezvous/heartbeat/";
+const std::string kInstances = "/api/v1/rendezvous/instances";
 
-static std::string build_http_response(const HttpResponse &resp) {
-  std::ostringstream ss;
-  ss << "HTTP/1.1 " << resp.status_code << " " << resp.status_text << "\r\n"
-     << "Content-Type: " << resp.content_type << "\r\n"
-     << "Content-Length: " << resp.body.size() << "\r\n"
-     << "Connection: close\r\n"
-     << "Access-Control-Allow-Origin: *\r\n"
-     << "\r\n"
-     << resp.body;
-  return ss.str();
+bool starts_with(const std::string &s, const std::string &prefix) {
+  return s.compare(0, prefix.size(), prefix) == 0;
 }
 
-static bool parse_http_request(const std::string &raw, HttpRequest &req) {
-  auto line_end = raw.find("\r\n");
-  if (line_end == std::string::npos) return false;
-  auto first_line = raw.substr(0, line_end);
-  auto sp1 = first_line.find(' ');
-  auto sp2 = first_line.rfind(' ');
-  if (sp1 == std::string::npos || sp2 == std::string::npos || sp1 == sp2) return false;
-  req.method = first_line.substr(0, sp1);
-  req.path = first_line.substr(sp1 + 1, sp2 - sp1 - 1);
-  size_t pos = line_end + 2;
-  while (pos < raw.size()) {
-    auto hdr_end = raw.find("\r\n", pos);
-    if (hdr_end == std::string::npos) break;
-    if (hdr_end == pos) { pos = hdr_end + 2; break; }
-    auto colon = raw.find(':', pos);
-    if (colon != std::string::npos && colon < hdr_end) {
-      std::string key = raw.substr(pos, colon - pos);
-      std::string val = raw.substr(colon + 2, hdr_end - colon - 2);
-      req.headers[key] = val;
-    }
-    pos = hdr_end + 2;
-  }
-  if (pos < raw.size()) req.body = raw.substr(pos);
-  return true;
+HttpResp ok_resp(json::Object o, int code = 200, const char *status = "OK") {
+  HttpResp r;
+  r.code = code;
+  r.status = status;
+  o["ok"] = true;
+  r.body = json::dumps(o);
+  return r;
 }
 
-static void handle_register(const HttpRequest &req, HttpResponse &resp) {
+HttpResp handle_register(RendezvousRegistry &reg, const HttpReq &req) {
+  json::Value v;
   try {
-    auto v = json::parse(req.body);
-    if (!v.is_obj()) { resp.status_code = 400; resp.body = R"({"error":"expected object"})"; return; }
-    auto obj = v.as_obj();
-    auto it_uuid = obj.find("uuid");
-    if (it_uuid == obj.end() || !it_uuid->second.is_str() || it_uuid->second.as_str().empty()) {
-      resp.status_code = 400; resp.body = R"({"error":"missing uuid"})"; return;
-    }
-    RegisteredInstance inst;
-    inst.uuid = it_uuid->second.as_str();
-    auto it = obj.find("name"); if (it != obj.end() && it->second.is_str()) inst.name = it->second.as_str();
-    auto it2 = obj.find("host"); if (it2 != obj.end() && it2->second.is_str()) inst.host = it2->second.as_str();
-    auto it3 = obj.find("port"); if (it3 != obj.end() && it3->second.is_num()) inst.port = (int)it3->second.as_num();
-    auto it4 = obj.find("pubkey"); if (it4 != obj.end() && it4->second.is_str()) inst.pubkey = it4->second.as_str();
-    inst.last_heartbeat = std::chrono::steady_clock::now();
-    {
-      std::lock_guard<std::mutex> lk(g_instances_mu);
-      g_instances[inst.uuid] = std::move(inst);
-    }
-    json::Object resp_o;
-    resp_o["ok"] = true; resp_o["uuid"] = it_uuid->second.as_str();
-    resp.body = json::dumps(resp_o);
-    resp.status_code = 201;
-  } catch (const std::exception &e) {
-    resp.status_code = 400;
-    json::Object err; err["error"] = std::string(e.what());
-    resp.body = json::dumps(err);
+    v = json::parse(req.body);
+  } catch (const std::exception &) {
+    return error_resp(400, "Bad Request", "invalid JSON");
   }
-}
-
-static void handle_heartbeat(const std::string &uuid, HttpResponse &resp) {
-  std::lock_guard<std::mutex> lk(g_instances_mu);
-  auto it = g_instances.find(uuid);
-  if (it == g_instances.end()) {
-    resp.status_code = 404; resp.body = R"({"error":"instance not found"})"; return;
-  }
-  it->second.last_heartbeat = std::chrono::steady_clock::now();
-  json::Object o; o["ok"] = true; resp.body = json::dumps(o);
-}
+  if (!v.is_obj()) return error_resp(400, "Bad Request", "expected object");
+  const auto &obj = v.as_obj();
+  auto str = [&](const char *k) {
+    auto it = obj.find(k);
+    return it != obj.end() && it->second.is_str() ? it->second.as_str() : std::string();
+  };
+  RendezvousInstance inst;
+  inst.uuid = str("uuid");
+  if (inst.uuid.empty() || inst.uuid.find('/') != std::string::npos)
+    return error_resp(400, "Bad Request", "missing uuid");
+  inst.name = str("name");
+  inst.host = str("host");
+  inst.pubkey = str("pubkey");
+  auto it = obj.find("port");
+  if (it != obj.end() && it->second.is_num()) inst.port = (int)it->second.as_num();
+  it = obj.find("ttl_sec");
+  if (it != obj.end() && it->second.is_num())
+    inst.ttl_sec = std::clamp((int)it->second.as_num(), RendezvousServer::MIN_TTL_SEC,
+                              RendezvousServer::MAX_TTL_SEC);
 
-static void handle_deregister(const std::string &uuid, HttpResponse &resp) {
-  std::lock_guard<std::mutex> lk(g_instances_mu);
-  g_instances.erase(uuid);
-  json::Object o; o["ok"] = true; resp.body = json::dumps(o);
+  json::Object o;
+  o["uuid"] = inst.uuid;
+  o["ttl_sec"] = (double)inst.ttl_sec;
+  o["version"] = (double)reg.upsert(std::move(inst), now_ms());
+  return ok_resp(std::move(o), 201, "Created");
 }
 
-static void handle_list_instances(HttpResponse &resp) {
-  std::lock_guard<std::mutex> lk(g_instances_mu);
-  auto now = std::chrono::steady_clock::now();
-  for (auto it = g_instances.begin(); it != g_instances.end(); ) {
-    auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - it->second.last_heartbeat).count();
-    if (elapsed > it->second.heartbeat_ttl_sec * 3)
-      it = g_instances.erase(it);
-    else ++it;
+// Without `since`, the whole table as a bare array (what older clients
+// read). With it, {"version", "full", "instances", "removed"}: what was
+// added or changed after `since`, and the uuids that went. Both carry the
+// version as an ETag, and an unchanged table is a 304.
+HttpResp handle_list(RendezvousRegistry &reg, const HttpReq &req) {
+  std::string since_s;
+  bool delta = query_param(req.query, "since", since_s);
+  std::uint64_t since = 0;
+  if (delta) {
+    if (since_s.empty() || since_s.size() > 19 ||
+        since_s.find_first_not_of("0123456789") != std::string::npos)
+      return error_resp(400, "Bad Request", "since must be a version");
+    since = std::stoull(since_s);
   }
+  std::uint64_t version = reg.version();
+  std::string etag = "\"" + std::to_string(version) + "\"";
+  const std::string *inm = req.header("if-none-match");
+  if ((delta && since == version) || (inm && *inm == etag)) {
+    HttpResp r;
+    r.code = 304;
+    r.status = "Not Modified";
+    r.headers.emplace_back("ETag", etag);
+    return r;
+  }
+
+  auto now = now_ms();
   json::Array arr;
-  for (auto &[uuid, inst] : g_instances) {
+  HttpResp r;
+  if (!delta) {
+    for (const auto &inst : reg.list(&version)) arr.push_back(inst.to_json(now));
+    r.body = json::dumps(arr);
+  } else {
+    auto d = reg.since(since);
+    version = d.version;
+    for (const auto &inst : d.changed) arr.push_back(inst.to_json(now));
+    json::Array removed;
+    for (auto &uuid : d.removed) removed.push_back(std::move(uuid));
     json::Object o;
-    o["uuid"] = inst.uuid; o["name"] = inst.name; o["host"] = inst.host; o["port"] = (double)inst.port;
-    if (!inst.pubkey.empty()) o["pubkey"] = inst.pubkey;
-    auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - inst.last_heartbeat).count();
-    o["last_seen"] = (double)elapsed;
-    arr.push_back(o);
+    o["version"] = (double)d.version;
+    o["full"] = d.full;
+    o["instances"] = std::move(arr);
+    o["removed"] = std::move(removed);
+    r.body = json::dumps(o);
   }
-  resp.body = json::dumps(arr);
+  r.headers.emplace_back("ETag", "\"" + std::to_string(version) + "\"");
+  r.headers.emplace_back("Cache-Control", "no-cache");
+  return r;
 }
 
-static void handle_request(const HttpRequest &req, HttpResponse &resp) {
-  if (req.method == "OPTIONS") { resp.status_code = 204; return; }
-  if (req.method == "POST" && req.path == "/api/v1/rendezvous/register")
-    return handle_register(req, resp);
-  if (req.method == "PUT") {
-    std::string p = "/api/v1/rendezvous/heartbeat/";
-    if (req.path.compare(0, p.size(), p) == 0) return handle_heartbeat(req.path.substr(p.size()), resp);
+HttpResp handle(RendezvousRegistry &reg, const HttpReq &req) {
+  if (req.method == "OPTIONS") {
+    HttpResp r;
+    r.code = 204;
+    r.status = "No Content";
+    return r;
+  }
+  if (req.method == "POST" && req.path == kRegister) return handle_register(reg, req);
+  if (req.method == "PUT" && starts_with(req.path, kHeartbeat)) {
+    if (!reg.heartbeat(req.path.substr(kHeartbeat.size()), now_ms()))
+      return error_resp(404, "Not Found", "instance not found");
+    return ok_resp({});
   }
-  if (req.method == "DELETE") {
-    std::string p = "/api/v1/rendezvous/instances/";
-    if (req.path.compare(0, p.size(), p) == 0) return handle_deregister(req.path.substr(p.size()), resp);
+  if (req.method == "DELETE" && starts_with(req.path, kInstances + "/")) {
+    (void)reg.remove(req.path.substr(kInstances.size() + 1));
+    return ok_resp({});
   }
-  if (req.method == "GET" && req.path == "/api/v1/rendezvous/instances")
-    return handle_list_instances(resp);
+  if (req.method == "GET" && req.path == kInstances) return handle_list(reg, req);
   if (req.method == "GET" && req.path == "/health") {
-    json::Object o; o["ok"] = true; o["instances"] = (double)g_instances.size();
-    resp.body = json::dumps(o); return;
+    json::Object o;
+    o["instances"] = (double)reg.size();
+    o["version"] = (double)reg.version();
+    return ok_resp(std::move(o));
   }
-  resp.status_code = 404; resp.status_text = "Not Found";
-  json::Object err; err["error"] = "not found"; resp.body = json::dumps(err);
+  return error_resp(404, "Not Found", "not found");
 }
 
-} // anonymous namespace
+} // namespace
+
+// ── Connections ─────────────────────────────────────────────────────────────
+
+// One client. Every request is a single registry operation, so it is
+// answered inline as it is parsed and the response written before the
+// next read; pipelined requests are answered in order for free.
+class RendezvousConnection final : public IoService::Handler {
+public:
+  RendezvousConnection(std::unique_ptr<IConnection> conn, RendezvousRegistry &reg)
+      : Handler(std::move(conn)), reg_(reg), last_active_(now_ms()) {}
 
-int main(int argc, char **argv) {
-  int port = 8080;
-  for (int i = 1; i < argc; ++i) {
-    if (std::string(argv[i]) == "--port" && i + 1 < argc) port = std::stoi(argv[++i]);
-    if (std::string(argv[i]) == "--help") {
-      std::cerr << "WinInspect Rendezvous Server\nUsage: wininspect-rendezvous [--port <n>]\n"; return 0;
+  void on_data(const char *p, size_t n) override {
+    last_active_ = now_ms();
+    if (done_) return;
+    in_.append(p, n);
+    std::string out;
+    HttpReq req;
+    while (!done_) {
+      auto r = parser_.next(in_, pos_, req);
+      if (r == HttpParser::NEED_MORE) break;
+      if (r == HttpParser::FAILED) {
+        out += build_response(error_resp(parser_.code(), parser_.status(), "bad request"), false);
+        done_ = true;
+        break;
+      }
+      done_ = !req.keep_alive;
+      out += build_response(handle(reg_, req), req.keep_alive);
+    }
+    if (pos_ == in_.size()) {
+      in_.clear();
+      pos_ = 0;
+    } else if (pos_ > 64 * 1024) {
+      in_.erase(0, pos_);
+      pos_ = 0;
     }
+    if (!out.empty() && !connection().write_all(out.data(), out.size())) done_ = true;
+    if (done_) connection().shutdown();
   }
+  void on_close() override { connection().shutdown(); }
+
+  bool idle_since(std::int64_t before) const { return last_active_.load() < before; }
+
+private:
+  RendezvousRegistry &reg_;
+  HttpParser parser_{16 * 1024, 64 * 1024};
+  std::string in_;
+  size_t pos_ = 0;
+  bool done_ = false; // after Connection: close or a bad request
+  std::atomic<std::int64_t> last_active_;
+};
 
-  WSADATA wsa;
-  if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) { LOG_ERROR("Winsock init failed"); return 1; }
+// ── Server ──────────────────────────────────────────────────────────────────
 
-  SOCKET s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-  if (s == INVALID_SOCKET) { LOG_ERROR("socket() failed"); WSACleanup(); return 1; }
+RendezvousServer::RendezvousServer(RendezvousRegistry &registry, size_t io_threads)
+    : registry_(registry), io_(std::make_unique<IoService>(io_threads)) {}
 
-  int on = 1;
-  setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (const char *)&on, sizeof(on));
-  struct sockaddr_in addr = {};
-  addr.sin_family = AF_INET; addr.sin_addr.s_addr = INADDR_ANY; addr.sin_port = htons((u_short)port);
+RendezvousServer::~RendezvousServer() {
+  stop();
+  io_->stop();
+}
+
+void RendezvousServer::stop() {
+  std::lock_guard<std::mutex> lk(listen_mu_);
+  stopped_ = true;
+  if (listener_) listener_->close();
+}
 
-  if (bind(s, (struct sockaddr *)&addr, sizeof(addr)) == SOCKET_ERROR) {
-    LOG_ERROR("bind() failed on port " + std::to_string(port)); closesocket(s); WSACleanup(); return 1;
+void RendezvousServer::sweep(std::int64_t now) {
+  std::lock_guard<std::mutex> lk(conns_mu_);
+  if (now - last_sweep_ms_ < 1000) return;
+  last_sweep_ms_ = now;
+  std::erase_if(conns_, [&](const std::weak_ptr<RendezvousConnection> &w) {
+    auto c = w.lock();
+    if (!c) return true;
+    if (c->idle_since(now - IDLE_TIMEOUT_MS)) c->connection().shutdown();
+    return false;
+  });
+}
+
+void RendezvousServer::start(std::atomic<bool> *running, int port) {
+  auto listeners = listen_tcp({{"0.0.0.0", ADDR_FAMILY_IPV4}}, port);
+  if (listeners.empty()) {
+    LOG_ERROR("Rendezvous: bind failed on port " + std::to_string(port));
+    return;
   }
-  if (listen(s, SOMAXCONN) == SOCKET_ERROR) { LOG_ERROR("listen() failed"); closesocket(s); WSACleanup(); return 1; }
-
-  LOG_INFO("Rendezvous server listening on port " + std::to_string(port));
-
-  u_long mode = 1;
-  ioctlsocket(s, FIONBIO, &mode);
-  std::atomic<bool> running{true};
-
-  while (running.load()) {
-    SOCKET client = accept(s, nullptr, nullptr);
-    if (client == INVALID_SOCKET) { if (WSAGetLastError() == WSAEWOULDBLOCK) { Sleep(100); continue; } break; }
-
-    char buf[8192];
-    int r = recv(client, buf, sizeof(buf) - 1, 0);
-    if (r > 0) {
-      buf[r] = '\0';
-      HttpRequest req;
-      if (parse_http_request(std::string(buf), req)) {
-        HttpResponse resp;
-        handle_request(req, resp);
-        std::string response = build_http_response(resp);
-        send(client, response.data(), (int)response.size(), 0);
-        LOG_DEBUG("Rendezvous: " + req.method + " " + req.path + " -> " + std::to_string(resp.status_code));
-      }
+  IListener &listener = *listeners.front();
+  {
+    std::lock_guard<std::mutex> lk(listen_mu_);
+    if (stopped_) return;
+    listener_ = &listener;
+  }
+  bound_port_ = listener.port();
+  LOG_INFO("Rendezvous server listening on port " + std::to_string(bound_port_.load()));
+
+  while (running->load()) {
+    auto now = now_ms();
+    if (size_t n = registry_.expire(now))
+      LOG_DEBUG("Rendezvous: expired " + std::to_string(n) + " instance(s)");
+    sweep(now);
+    auto conn = listener.accept(250);
+    if (!conn) {
+      std::lock_guard<std::mutex> lk(listen_mu_);
+      if (stopped_) break;
+      continue;
     }
-    closesocket(client);
+    auto c = std::make_shared<RendezvousConnection>(std::move(conn), registry_);
+    {
+      std::lock_guard<std::mutex> lk(conns_mu_);
+      conns_.push_back(c);
+    }
+    io_->add(std::move(c));
   }
 
-  closesocket(s); WSACleanup();
-  return 0;
+  std::lock_guard<std::mutex> lk(listen_mu_);
+  listener_ = nullptr;
 }
+
+} // namespace wininspectd
@@ -0,0 +1,181 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "request_connection.hpp"
+#include "request_handler.hpp"
+#include "wininspect/logger.hpp"
+#include "wininspect/tinyjson.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace wininspectd {
+
+RequestConnection::RequestConnection(std::unique_ptr<IConnection> conn, IoService *io,
+                                     ServerState *st)
+    : Handler(std::move(conn)), io_(io), st_(st) {
+  session_.push = [this](const std::string &frame, std::uint32_t flags) {
+    return send(frame, flags);
+  };
+  session_.io = io;
+}
+
+RequestConnection::~RequestConnection() {
+  connection().shutdown(); // fails a stream's pending write
+  session_.stream.reset(); // and waits for it while send() is still valid
+  session_.file_stream.reset();
+}
+
+RequestConnection::Plan RequestConnection::plan(const std::string &frame) const {
+  Plan p;
+  try {
+    auto v = json::parse(frame);
+    const auto &o = v.as_obj();
+    auto it_o = o.find("ordered");
+    p.ordered = it_o != o.end() && it_o->second.is_bool() && it_o->second.as_bool();
+    auto it_m = o.find("method");
+    if (it_m != o.end() && it_m->second.is_str()) {
+      const auto &m = it_m->second.as_str();
+      p.ordered = p.ordered || m == "hello" || m.rfind("session.", 0) == 0 ||
+                  m.rfind("events.", 0) == 0 || m.rfind("input.", 0) == 0 ||
+                  m == "window.postMessage" || m == "window.controlClick" ||
+                  m == "window.controlSend" || m == "file.credit" || m == "file.cancel" ||
+                  m == "transport.shm";
+    }
+    auto it_p = o.find("params");
+    if (it_p != o.end() && it_p->second.is_obj()) {
+      const auto &params = it_p->second.as_obj();
+      p.ordered = p.ordered || params.count("session_id") || params.count("stream");
+      p.blocking = params.count("wait_ms") > 0;
+    }
+  } catch (...) {
+    p.ordered = true; // answered with an error, in place
+  }
+  return p;
+}
+
+bool RequestConnection::send(const std::string &frame, std::uint32_t flags) {
+  std::lock_guard<std::mutex> lk(write_mu_);
+  return write_frame(connection(), frame.data(), frame.size(), flags);
+}
+
+void RequestConnection::on_data(const char *p, size_t n) {
+  decoder_.feed(p, n);
+  std::string frame;
+  std::uint32_t flags = 0;
+  while (decoder_.next(frame, &flags)) {
+    if (!decode(frame, flags)) {
+      connection().shutdown();
+      return;
+    }
+    std::vector<Attachment> attachments;
+    if (flags & FRAME_MULTIPART) {
+      std::string json;
+      if (!split_multipart(frame, json, attachments)) {
+        LOG_WARN("Bad multipart frame from " + connection().peer() + "; dropping it.");
+        connection().shutdown();
+        return;
+      }
+      frame.swap(json);
+    }
+    Plan pl = plan(frame);
+    std::lock_guard<std::mutex> lk(q_mu_);
+    if (queue_.size() >= MAX_QUEUED_FRAMES) {
+      LOG_WARN("Client queued too many requests; dropping it.");
+      connection().shutdown();
+      return;
+    }
+    queue_.push_back({std::move(frame), std::move(attachments), pl});
+  }
+  pump();
+  if (decoder_.bad()) {
+    LOG_WARN("Bad frame length from " + connection().peer() + "; dropping it.");
+    connection().shutdown();
+  }
+}
+
+void RequestConnection::pump() {
+  std::vector<Job> ready;
+  {
+    std::lock_guard<std::mutex> lk(q_mu_);
+    size_t cap = (size_t)std::max(st_->max_inflight, 1);
+    while (!queue_.empty() && !barrier_) {
+      auto &job = queue_.front();
+      if (job.plan.ordered) {
+        if (running_ > 0) break;
+        barrier_ = true;
+      } else if (running_ >= cap) {
+        break;
+      }
+      running_++;
+      ready.push_back(std::move(job));
+      queue_.pop_front();
+    }
+  }
+  for (auto &job : ready) start(std::move(job));
+}
+
+void RequestConnection::start(Job job) {
+  bool ordered = job.plan.ordered, blocking = job.plan.blocking;
+  auto run = [self = shared_from_this(), frame = std::move(job.frame),
+              attachments = std::move(job.attachments), ordered]() mutable {
+    try {
+      self->handle_frame(std::move(frame), std::move(attachments));
+    } catch (const std::exception &e) {
+      LOG_ERROR(std::string("Request failed: ") + e.what());
+    }
+    self->finished(ordered);
+  };
+  if (blocking)
+    io_->post_blocking(std::move(run));
+  else
+    io_->post(std::move(run));
+}
+
+void RequestConnection::finished(bool ordered) {
+  {
+    std::lock_guard<std::mutex> lk(q_mu_);
+    running_--;
+    if (ordered) barrier_ = false;
+  }
+  pump();
+}
+
+void RequestConnection::on_close() {
+  // Make requests in progress stop at their next write; the destructor,
+  // which runs once the last reference goes, does the rest.
+  connection().shutdown();
+}
+
+void RequestConnection::serve(const std::string &json, std::vector<Attachment> attachments,
+                              CoreEngine &core, IBackend *backend, bool read_only,
+                              bool no_clipboard, bool require_auth,
+                              const std::string &auth_keys) {
+  CoreResponse resp;
+  bool canonical = false;
+  std::string pinned_sid;
+  try {
+    (void)process_request(json, core, st_, backend, session_, read_only, no_clipboard,
+                          require_auth, auth_keys, resp, canonical, pinned_sid,
+                          std::move(attachments));
+  } catch (...) {
+    resp.ok = false;
+    resp.error_code = "E_BAD_REQUEST";
+  }
+  if (resp.attachments.empty()) {
+    (void)send(serialize_response_json(resp, canonical));
+  } else {
+    std::string payload = BufferPool::take();
+    append_multipart(payload, serialize_response_json(resp, canonical), resp.attachments);
+    (void)send(payload, FRAME_MULTIPART);
+    BufferPool::give(std::move(payload));
+  }
+  if (session_.stream) session_.stream->start();
+  if (session_.file_stream) session_.file_stream->start();
+  if (!pinned_sid.empty()) {
+    std::lock_guard<std::mutex> lk(st_->snapshots_mu);
+    st_->pinned_counts[pinned_sid]--;
+  }
+}
+
+} // namespace wininspectd
@@ -0,0 +1,95 @@
+#pragma once
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "io_service.hpp"
+#include "server_state.hpp"
+#include "wininspect/core.hpp"
+
+namespace wininspectd {
+
+/// A client connection driven by IoService: the byte stream is framed and
+/// requests are pipelined. Up to ServerState::max_inflight run at once, on
+/// the I/O threads (or the blocking pool for long polls), and each response
+/// is written as it completes; clients match them up by id. An ordered
+/// request is a sequence point: it starts once everything before it has
+/// finished, and nothing after it starts until it has.
+class RequestConnection : public IoService::Handler,
+                          public std::enable_shared_from_this<RequestConnection> {
+public:
+  RequestConnection(std::unique_ptr<IConnection> conn, IoService *io,
+                    wininspect::ServerState *st);
+  ~RequestConnection() override;
+
+  void on_data(const char *p, size_t n) final;
+  void on_close() final;
+
+  /// Frames held waiting for a slot before the client is dropped.
+  static constexpr size_t MAX_QUEUED_FRAMES = 1024;
+
+  /// How a frame is scheduled.
+  struct Plan {
+    bool ordered = false;  // a sequence point (see above)
+    bool blocking = false; // may wait for long; runs on the blocking pool
+  };
+
+protected:
+  /// Called on every frame as it arrives, in order, before any queueing
+  /// (for decryption and decompression). `flags` are the frame's FRAME_*
+  /// bits; FRAME_COMPRESSED and FRAME_SHM are accepted only by a transport
+  /// that negotiated a codec or shared memory. A multipart frame is split
+  /// after this. False drops the connection.
+  virtual bool decode(std::string &, std::uint32_t flags) {
+    return !(flags & (FRAME_COMPRESSED | FRAME_SHM));
+  }
+  /// One complete frame: its JSON and, if it was multipart, the attachments
+  /// the JSON refers to. Runs on an I/O or blocking-pool thread, possibly
+  /// alongside other unordered frames of this connection.
+  virtual void handle_frame(std::string frame,
+                            std::vector<wininspect::Attachment> attachments) = 0;
+  /// Classifies a decoded frame. A request is ordered when it says
+  /// `"ordered": true`, when it injects input, or when it reads or changes
+  /// session state (hello, session.*, events.*, transport.shm, a session_id
+  /// parameter), which is why session_ needs no lock. It blocks when it has wait_ms.
+  virtual Plan plan(const std::string &frame) const;
+  /// Writes one frame; shared by responses and events.stream pushes. An
+  /// override must reset session_.stream in its own destructor, since the
+  /// streams call it. `flags` is 0 or FRAME_MULTIPART.
+  virtual bool send(const std::string &frame, std::uint32_t flags = 0);
+
+  /// Runs `json` through process_request and sends the response, as a
+  /// multipart frame when it carries attachments.
+  void serve(const std::string &json, std::vector<wininspect::Attachment> attachments,
+             wininspect::CoreEngine &core,
+             wininspect::IBackend *backend, bool read_only, bool no_clipboard,
+             bool require_auth, const std::string &auth_keys);
+
+  IoService *io_;
+  wininspect::ServerState *st_;
+  wininspect::ClientSession session_;
+  std::mutex write_mu_;
+
+private:
+  struct Job {
+    std::string frame;
+    std::vector<wininspect::Attachment> attachments;
+    Plan plan;
+  };
+  void pump();                // starts queued jobs while slots allow
+  void start(Job job);
+  void finished(bool ordered);
+
+  FrameDecoder decoder_;
+  std::mutex q_mu_;
+  std::deque<Job> queue_;
+  size_t running_ = 0;
+  bool barrier_ = false; // an ordered job is running
+};
+
+} // namespace wininspectd
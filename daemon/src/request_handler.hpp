@@ -6,10 +6,15 @@
 // Eliminates ~150 lines of duplicated code between handle_client and
 // handle_socket_client. Transport-specific read/write stays in each handler.
 
-#include <future>
 #include "server_state.hpp"
+#include "event_streamer.hpp"
+#include "file_streamer.hpp"
 #include "wininspect/core.hpp"
 #include "wininspect/logger.hpp"
+#include "wininspect/snapshot_journal.hpp"
+#include <algorithm>
+#include <limits>
+#include <optional>
 
 using namespace wininspect;
 
@@ -20,6 +25,140 @@ inline std::string make_snap_id(std::uint64_t n) {
   return "s-" + std::to_string(n);
 }
 
+inline std::string make_journal_id(std::uint64_t seq) {
+  return "j-" + std::to_string(seq);
+}
+
+// Live desktop state. Concurrent requests (and any within the configured
+// freshness window, or the request's own max_age_ms) share one backend
+// enumeration; metrics.capture_shared on the response says whether this
+// one did. max_age_ms 0 asks for a capture begun after the request.
+inline std::shared_ptr<const Snapshot> capture_current(ServerState *st, IBackend *backend,
+                                                       bool *shared = nullptr,
+                                                       std::optional<int> max_age_ms = {}) {
+  if (!st->capture) {
+    if (shared) *shared = false;
+    return std::make_shared<const Snapshot>(backend->capture_snapshot());
+  }
+  auto r = max_age_ms ? st->capture->capture(*max_age_ms) : st->capture->capture();
+  if (shared) *shared = r.shared;
+  return r.snap;
+}
+
+// Register a snapshot under a new id, evicting unpinned snapshots beyond
+// max_snapshots. Caller holds snapshots_mu.
+inline std::string insert_snapshot_locked(ServerState *st, std::shared_ptr<const Snapshot> s) {
+  std::string sid = make_snap_id(st->snap_counter++);
+  st->snaps.emplace(sid, std::move(s));
+  st->lru_order.push_back(sid);
+  while (st->lru_order.size() > st->max_snapshots) {
+    std::string oldest = st->lru_order.front();
+    if (st->pinned_counts[oldest] > 0) {
+      st->lru_order.pop_front(); st->lru_order.push_back(oldest); continue;
+    }
+    st->lru_order.pop_front(); st->snaps.erase(oldest); st->pinned_counts.erase(oldest);
+  }
+  return sid;
+}
+
+// Register a captured snapshot (see insert_snapshot_locked) and queue it
+// for the journal if one is enabled. Caller holds snapshots_mu.
+// journal_seq is 0 if not journaled.
+inline std::string store_snapshot_locked(ServerState *st, std::shared_ptr<const Snapshot> s,
+                                         std::uint64_t *journal_seq = nullptr) {
+  std::uint64_t seq = st->journal ? st->journal->append(*s) : 0;
+  if (journal_seq) *journal_seq = seq;
+  return insert_snapshot_locked(st, std::move(s));
+}
+
+// Detector sink (the ring's single producer), then filtered subscriptions,
+// then the streams that push either.
+inline void publish_events(ServerState *st, std::vector<Event> &events, const Snapshot &cur) {
+  for (auto &e : events) st->event_log->push(e);
+  if (st->subs) st->subs->dispatch(events, cur);
+  wininspectd::wake_event_pushers(st);
+}
+
+// The log a session reads: its filtered subscription's, or the shared one.
+inline const EventRing &session_event_log(ServerState *st, const ClientSession &session) {
+  return session.filtered ? session.filtered->events() : *st->event_log;
+}
+
+inline std::uint64_t last_event_seq(ServerState *st) {
+  return st->event_log->head();
+}
+
+// events.poll against the shared log: events with seq > since, waiting up
+// to wait_ms for the first one. Lock-free unless it has to wait; cost is
+// O(new events), independent of how many windows or sessions there are.
+inline json::Object poll_event_log(ServerState *st, const EventRing &log, std::uint64_t since,
+                                   size_t max, int wait_ms) {
+  if (st->detector) st->detector->touch(wait_ms > 0);
+  if (wait_ms > 0)
+    log.wait_for(since, std::chrono::milliseconds(std::min(wait_ms, st->max_wait_ms)));
+  std::vector<Event> events;
+  auto r = log.read(since, events, max);
+  json::Array arr;
+  for (const auto &e : events) arr.push_back(event_json(e));
+  json::Object o;
+  o["events"] = arr;
+  o["last_seq"] = (double)r.last_seq;
+  o["truncated"] = r.gap;
+  return o;
+}
+
+// snapshot.list / snapshot.load: read-side of the on-disk journal.
+inline void handle_journal_request(const CoreRequest &req, ServerState *st,
+                                   CoreResponse &resp) {
+  if (!st->journal) {
+    resp.ok = false; resp.error_code = "E_BAD_METHOD";
+    resp.error_message = "snapshot journal not enabled (--journal-dir)"; return;
+  }
+  auto num = [&](const char *k, double def) {
+    auto it = req.params.find(k);
+    return (it != req.params.end() && it->second.is_num()) ? it->second.as_num() : def;
+  };
+
+  if (req.method == "snapshot.list") {
+    auto since = (std::int64_t)num("since_ms", (double)std::numeric_limits<std::int64_t>::min());
+    auto until = (std::int64_t)num("until_ms", (double)std::numeric_limits<std::int64_t>::max());
+    auto limit = (size_t)num("limit", 1000);
+    json::Array arr;
+    for (const auto &e : st->journal->list(since, until, limit)) {
+      json::Object o;
+      o["journal_id"] = make_journal_id(e.seq);
+      o["seq"] = (double)e.seq;
+      o["time_ms"] = (double)e.time_ms;
+      o["windows"] = (double)e.window_count;
+      arr.push_back(o);
+    }
+    json::Object o; o["entries"] = arr;
+    resp.ok = true; resp.result = o; return;
+  }
+
+  auto it = req.params.find("journal_id");
+  if (it == req.params.end() || !it->second.is_str())
+    throw std::runtime_error("missing journal_id");
+  const std::string &jid = it->second.as_str();
+  std::uint64_t seq = 0;
+  if (jid.rfind("j-", 0) == 0) seq = std::strtoull(jid.c_str() + 2, nullptr, 10);
+  auto rec = seq ? st->journal->record(seq) : std::nullopt;
+  if (!rec) {
+    resp.ok = false; resp.error_code = "E_BAD_SNAPSHOT";
+    resp.error_message = "unknown journal_id"; return;
+  }
+  auto snap = rec->to_snapshot();
+  std::string sid;
+  {
+    std::lock_guard<std::mutex> lk(st->snapshots_mu);
+    sid = insert_snapshot_locked(st, std::make_shared<const Snapshot>(std::move(snap)));
+  }
+  json::Object o;
+  o["snapshot_id"] = sid; o["journal_id"] = jid;
+  o["time_ms"] = (double)rec->time_ms(); o["windows"] = (double)rec->size();
+  resp.ok = true; resp.result = o;
+}
+
 // Process one protocol request. Returns true if request was handled.
 // resp, canonical, and pinned_sid are output parameters.
 // Transport-specific read/write and unpin are handled by the caller.
@@ -29,9 +168,11 @@ inline std::string make_snap_id(std::uint64_t n) {
     ClientSession &session,
     bool read_only, bool no_clipboard, bool require_auth,
     const std::string &auth_keys_data,
-    CoreResponse &resp, bool &canonical, std::string &pinned_sid) {
+    CoreResponse &resp, bool &canonical, std::string &pinned_sid,
+    std::vector<Attachment> attachments = {}) {
   try {
     auto req = parse_request_json(json_req);
+    req.attachments = std::move(attachments);
     resp.id = req.id;
 
     if (!session.authenticated && req.method != "hello") {
@@ -63,38 +204,192 @@ inline std::string make_snap_id(std::uint64_t n) {
         session.id = SessionID(sid_str);
         session.last_snap_id = ps.last_snap_id;
         session.subscribed = ps.subscribed;
+        session.event_seq = ps.event_seq;
+        session.filtered = ps.filtered;
         ps.last_activity = std::chrono::steady_clock::now();
       } else {
         session.id = SessionID(sid_str);
-        st->sessions[sid_str] = {"", false, std::chrono::steady_clock::now()};
+        st->sessions[sid_str].last_activity = std::chrono::steady_clock::now();
       }
     }
 
     if (req.method == "events.subscribe") {
+      // With `filter` or `debounce_ms` the detector evaluates this
+      // subscription itself and queues only what matches.
+      std::shared_ptr<FilteredSubscription> filtered;
+      auto itf = req.params.find("filter");
+      auto itd = req.params.find("debounce_ms");
+      if (itf != req.params.end() || itd != req.params.end()) {
+        if (!st->subs) {
+          resp.ok = false; resp.error_code = "E_BAD_REQUEST";
+          resp.error_message = "filtered subscriptions need the change detector";
+          return true;
+        }
+        if (itf != req.params.end() && !itf->second.is_obj())
+          throw std::runtime_error("filter must be an object");
+        if (itd != req.params.end() && (!itd->second.is_num() || itd->second.as_num() < 0))
+          throw std::runtime_error("debounce_ms must be a number >= 0");
+        auto filter = itf != req.params.end() ? EventFilter::compile(itf->second.as_obj())
+                                              : EventFilter();
+        int debounce = itd != req.params.end()
+                           ? (int)std::min(itd->second.as_num(), (double)st->max_wait_ms)
+                           : 0;
+        filtered = st->subs->subscribe(std::move(filter), debounce);
+      }
       std::string sid;
+      if (st->detector) st->detector->touch();
+      std::uint64_t cursor = filtered ? 0 : last_event_seq(st);
       {
-        auto snap = backend->capture_snapshot();
+        auto snap = capture_current(st, backend);
         std::lock_guard<std::mutex> lk(st->snapshots_mu);
-        sid = make_snap_id(st->snap_counter++);
-        st->snaps.emplace(sid, std::make_shared<Snapshot>(std::move(snap)));
-        st->lru_order.push_back(sid);
+        sid = store_snapshot_locked(st, std::move(snap));
         session.subscribed = true; session.last_snap_id = sid;
+        session.event_seq = cursor;
+        session.filtered = filtered;
         if (!session.id.empty()) {
           st->sessions[session.id.val].subscribed = true;
           st->sessions[session.id.val].last_snap_id = sid;
+          st->sessions[session.id.val].event_seq = cursor;
+          st->sessions[session.id.val].filtered = filtered;
         }
       }
       json::Object o; o["subscribed"] = true; o["snapshot_id"] = sid;
+      o["last_seq"] = (double)cursor;
+      if (filtered) o["filtered"] = true;
+      resp.ok = true; resp.result = o; return true;
+    }
+
+    // With the detector running, a poll is a read of the shared event log
+    // from the session's cursor (or an explicit `since`). Passing
+    // old_snapshot_id still diffs two snapshots directly.
+    if (req.method == "events.poll" && st->detector && !req.params.count("old_snapshot_id")) {
+      auto num = [&](const char *k) -> std::optional<double> {
+        auto it = req.params.find(k);
+        if (it == req.params.end() || !it->second.is_num()) return std::nullopt;
+        return it->second.as_num();
+      };
+      std::uint64_t since = (std::uint64_t)num("since").value_or((double)session.event_seq);
+      auto o = poll_event_log(st, session_event_log(st, session), since,
+                              (size_t)num("max").value_or(1000),
+                              (int)num("wait_ms").value_or(0));
+      session.event_seq = (std::uint64_t)o["last_seq"].as_num();
+      if (!session.id.empty()) {
+        std::lock_guard<std::mutex> lk(st->snapshots_mu);
+        if (st->sessions.count(session.id.val))
+          st->sessions[session.id.val].event_seq = session.event_seq;
+      }
+      resp.ok = true; resp.result = o; return true;
+    }
+
+    // events.stream: switch this connection to server push. The streamer is
+    // started by the transport once this response is on the wire.
+    if (req.method == "events.stream" || req.method == "events.credit") {
+      auto num = [&](const char *k) -> std::optional<double> {
+        auto it = req.params.find(k);
+        if (it == req.params.end() || !it->second.is_num()) return std::nullopt;
+        return it->second.as_num();
+      };
+      if (req.method == "events.credit") {
+        if (!session.stream) throw std::runtime_error("no active event stream");
+        double n = num("n").value_or(0);
+        if (n < 0) throw std::runtime_error("n must be >= 0");
+        json::Object o; o["credit"] = (double)session.stream->grant((std::uint64_t)n);
+        resp.ok = true; resp.result = o; return true;
+      }
+      if (!session.push || !session.io) {
+        resp.ok = false; resp.error_code = "E_BAD_METHOD";
+        resp.error_message = "events.stream needs a persistent connection";
+        return true;
+      }
+      EventStream::Options opts;
+      opts.credit = (std::uint64_t)std::max(0.0, num("credit").value_or((double)opts.credit));
+      opts.max_queue = (size_t)std::clamp(num("max_queue").value_or((double)opts.max_queue),
+                                          1.0, (double)st->max_stream_queue);
+      auto ov = req.params.find("overflow");
+      if (ov != req.params.end() && ov->second.is_str()) {
+        auto p = EventStream::overflow_from_str(ov->second.as_str());
+        if (!p) throw std::runtime_error("overflow must be coalesce or drop_oldest");
+        opts.overflow = *p;
+      }
+      if (st->detector) st->detector->touch();
+      std::uint64_t since = (std::uint64_t)num("since").value_or((double)session.event_seq);
+      std::string id = "st-" + std::to_string(st->stream_counter++);
+      session.stream.reset(); // at most one stream per connection
+      session.stream = std::make_shared<EventStreamer>(st, session.io, session.filtered,
+                                                       session.push, id, since, opts);
+      json::Object o;
+      o["streaming"] = true; o["stream_id"] = id;
+      o["last_seq"] = (double)session_event_log(st, session).head();
+      o["credit"] = (double)opts.credit;
+      resp.ok = true; resp.result = o; return true;
+    }
+
+    // file.read with "stream": true pushes the file in chunks as credit
+    // allows. Like events.stream, the streamer starts once this response is
+    // on the wire.
+    auto it_stream = req.params.find("stream");
+    bool stream_file = req.method == "file.read" && it_stream != req.params.end() &&
+                       it_stream->second.is_bool() && it_stream->second.as_bool();
+    if (stream_file || req.method == "file.credit" || req.method == "file.cancel") {
+      auto num = [&](const char *k) -> std::optional<double> {
+        auto it = req.params.find(k);
+        if (it == req.params.end() || !it->second.is_num()) return std::nullopt;
+        return it->second.as_num();
+      };
+      if (req.method == "file.credit") {
+        if (!session.file_stream) throw std::runtime_error("no active file stream");
+        double n = num("n").value_or(0);
+        if (n < 0) throw std::runtime_error("n must be >= 0");
+        json::Object o; o["credit"] = (double)session.file_stream->grant((std::uint64_t)n);
+        resp.ok = true; resp.result = o; return true;
+      }
+      if (req.method == "file.cancel") {
+        json::Object o; o["cancelled"] = session.file_stream != nullptr;
+        session.file_stream.reset();
+        resp.ok = true; resp.result = o; return true;
+      }
+      if (!session.push || !session.io) {
+        resp.ok = false; resp.error_code = "E_BAD_METHOD";
+        resp.error_message = "streaming file.read needs a persistent connection";
+        return true;
+      }
+      auto itp = req.params.find("path");
+      if (itp == req.params.end() || !itp->second.is_str()) throw std::runtime_error("missing path");
+      auto fi = backend->get_file_info(itp->second.as_str());
+      if (!fi || fi->is_directory) {
+        resp.ok = false; resp.error_code = "E_READ_FAILED"; return true;
+      }
+      FileStreamer::Options opts;
+      double offset = num("offset").value_or(0), length = num("length").value_or(-1);
+      if (offset < 0) throw std::runtime_error("offset must be >= 0");
+      opts.offset = (std::uint64_t)offset;
+      if (length >= 0) opts.end = opts.offset + (std::uint64_t)length;
+      opts.chunk = (size_t)std::clamp(num("chunk").value_or((double)opts.chunk), 1.0,
+                                      (double)FILE_READ_MAX_BYTES);
+      opts.credit = (std::uint64_t)std::max(0.0, num("credit").value_or((double)opts.credit));
+      CoreRequest read{req.id, "file.read", {}, req.binary, {}};
+      read.params["path"] = itp->second;
+      std::string id = "fs-" + std::to_string(st->stream_counter++);
+      session.file_stream.reset(); // at most one per connection
+      session.file_stream = std::make_shared<FileStreamer>(core, session.io, session.push, id,
+                                                           std::move(read), opts);
+      json::Object o;
+      o["streaming"] = true; o["stream_id"] = id;
+      o["size"] = (double)fi->size;
+      o["credit"] = (double)opts.credit;
       resp.ok = true; resp.result = o; return true;
     }
 
     if (req.method == "events.unsubscribe") {
       session.subscribed = false; session.last_snap_id.clear();
+      session.stream.reset();
+      session.filtered.reset();
       if (!session.id.empty()) {
         std::lock_guard<std::mutex> lk(st->snapshots_mu);
         if (st->sessions.count(session.id.val)) {
           st->sessions[session.id.val].subscribed = false;
           st->sessions[session.id.val].last_snap_id.clear();
+          st->sessions[session.id.val].filtered.reset();
         }
       }
       json::Object o; o["unsubscribed"] = true;
@@ -126,28 +421,62 @@ inline std::string make_snap_id(std::uint64_t n) {
     auto itc = req.params.find("canonical");
     if (itc != req.params.end() && itc->second.is_bool()) canonical = itc->second.as_bool();
 
+    // Snapshot policy for live captures: the daemon's freshness window by
+    // default, at most max_age_ms old if given, or snapshot_id (below).
+    std::optional<int> max_age_ms;
+    auto itm = req.params.find("max_age_ms");
+    if (itm != req.params.end()) {
+      if (!itm->second.is_num() || itm->second.as_num() < 0)
+        throw std::runtime_error("max_age_ms must be a number >= 0");
+      max_age_ms = (int)std::min(itm->second.as_num(), (double)std::numeric_limits<int>::max());
+    }
+
     if (req.method == "snapshot.capture") {
-      auto s = backend->capture_snapshot(); std::string sid;
+      bool shared = false;
+      auto s = capture_current(st, backend, &shared, max_age_ms); std::string sid;
+      std::uint64_t jseq = 0;
       {
         std::lock_guard<std::mutex> lk(st->snapshots_mu);
-        sid = make_snap_id(st->snap_counter++);
-        st->snaps.emplace(sid, std::make_shared<Snapshot>(std::move(s)));
-        st->lru_order.push_back(sid);
-        while (st->lru_order.size() > st->max_snapshots) {
-          std::string oldest = st->lru_order.front();
-          if (st->pinned_counts[oldest] > 0) {
-            st->lru_order.pop_front(); st->lru_order.push_back(oldest); continue;
-          }
-          st->lru_order.pop_front(); st->snaps.erase(oldest); st->pinned_counts.erase(oldest);
-        }
+        sid = store_snapshot_locked(st, std::move(s), &jseq);
       }
       json::Object o; o["snapshot_id"] = sid;
+      if (jseq) o["journal_id"] = make_journal_id(jseq);
+      resp.ok = true; resp.result = o; resp.metrics["capture_shared"] = shared;
+      return true;
+    }
+
+    if (req.method == "snapshot.stats") {
+      json::Object o;
+      if (st->capture) {
+        auto cs = st->capture->stats();
+        o["capture_requests"] = (double)cs.requests;
+        o["captures"] = (double)cs.captures;
+        o["capture_joined"] = (double)cs.joined;
+        o["capture_fresh"] = (double)cs.fresh;
+        o["coalescing_ratio"] = cs.captures ? (double)cs.requests / (double)cs.captures : 0.0;
+        o["capture_freshness_ms"] = (double)st->capture->freshness_ms();
+      }
+      if (st->journal) {
+        auto js = st->journal->stats();
+        o["journal_written"] = (double)js.written;
+        o["journal_dropped"] = (double)js.dropped;
+        o["journal_unchanged"] = (double)js.unchanged;
+        o["journal_segments"] = (double)js.segments;
+      }
+      {
+        std::lock_guard<std::mutex> lk(st->snapshots_mu);
+        o["stored"] = (double)st->snaps.size();
+      }
       resp.ok = true; resp.result = o; return true;
     }
 
-    std::shared_ptr<Snapshot> snap;
-    const Snapshot *old_ptr = nullptr;
-    Snapshot old_storage;
+    if (req.method == "snapshot.list" || req.method == "snapshot.load") {
+      handle_journal_request(req, st, resp); return true;
+    }
+
+    std::shared_ptr<const Snapshot> snap;
+    std::shared_ptr<const Snapshot> old_snap;
+    bool captured = false, shared = false;
 
     auto its = req.params.find("snapshot_id");
     if (its != req.params.end() && its->second.is_str()) {
@@ -160,8 +489,11 @@ inline std::string make_snap_id(std::uint64_t n) {
       }
       snap = it->second; pinned_sid = sid;
       st->pinned_counts[sid]++; st->lru_order.remove(sid); st->lru_order.push_back(sid);
+    } else if (req.method.rfind("file.", 0) == 0) {
+      snap = std::make_shared<const Snapshot>(); // file methods never look at windows
     } else {
-      snap = std::make_shared<Snapshot>(backend->capture_snapshot());
+      snap = capture_current(st, backend, &shared, max_age_ms);
+      captured = true;
     }
 
     auto itos = req.params.find("old_snapshot_id");
@@ -169,32 +501,32 @@ inline std::string make_snap_id(std::uint64_t n) {
       std::string osid = itos->second.as_str();
       std::lock_guard<std::mutex> lk(st->snapshots_mu);
       auto it = st->snaps.find(osid);
-      if (it != st->snaps.end()) { old_storage = *it->second; old_ptr = &old_storage; }
+      if (it != st->snaps.end()) old_snap = it->second;
     } else if (req.method == "events.poll" && !session.last_snap_id.empty()) {
       std::lock_guard<std::mutex> lk(st->snapshots_mu);
       auto it = st->snaps.find(session.last_snap_id);
-      if (it != st->snaps.end()) { old_storage = *it->second; old_ptr = &old_storage; }
+      if (it != st->snaps.end()) old_snap = it->second;
     }
 
-    auto future = std::async(std::launch::async, [&core, req, snap, old_ptr]() {
-      return core.handle(req, *snap, old_ptr);
-    });
+    // Runs on the connection's I/O thread (or the blocking pool for long
+    // polls); a slow request is logged, not abandoned, since nothing could
+    // cancel the backend call anyway.
+    auto t0 = std::chrono::steady_clock::now();
+    resp = core.handle(req, *snap, old_snap.get());
+    auto took = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - t0).count();
+    if (took > st->request_timeout_ms)
+      LOG_WARN(req.method + " took " + std::to_string(took) + " ms");
 
-    if (future.wait_for(std::chrono::milliseconds(st->request_timeout_ms)) ==
-        std::future_status::timeout) {
-      resp.ok = false; resp.error_code = "E_TIMEOUT";
-      resp.error_message = "request timed out";
-    } else {
-      resp = future.get();
-    }
+    if (captured) resp.metrics["capture_shared"] = shared;
 
+    // The snapshot just diffed becomes this session's next baseline, so
+    // consecutive polls neither re-enumerate nor miss changes in between.
     if (req.method == "events.poll" && resp.ok) {
-      auto fresh = backend->capture_snapshot(); std::string sid;
+      std::string sid;
       {
         std::lock_guard<std::mutex> lk(st->snapshots_mu);
-        sid = make_snap_id(st->snap_counter++);
-        st->snaps.emplace(sid, std::make_shared<Snapshot>(std::move(fresh)));
-        st->lru_order.push_back(sid);
+        sid = store_snapshot_locked(st, snap);
         session.last_snap_id = sid;
         if (!session.id.empty()) st->sessions[session.id.val].last_snap_id = sid;
       }
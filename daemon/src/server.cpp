@@ -1,29 +1,40 @@
 // SPDX-License-Identifier: Apache-2.0
 // Copyright (c) 2026 Mark E. DeYoung
 
-#ifdef _WIN32
 #include <atomic>
+#include <chrono>
 #include <map>
 #include <mutex>
 #include <thread>
+
+#ifdef _WIN32
 #include <windows.h>
 #include <winsock2.h>
 #include <ws2tcpip.h>
+#include "tray.hpp"
+#include "wininspect/util_win32.hpp"
+#endif
 
-#include "pipe.hpp"
 #include "server_state.hpp"
 
+#include "wininspect/authorized_keys.hpp"
 #include "wininspect/core.hpp"
+#ifdef WININSPECTD_FAKE
 #include "wininspect/fake_backend.hpp"
+#include "wininspect/fake_timeline.hpp"
+#else
 #include "wininspect/win32_backend.hpp"
-#include "wininspect/util_win32.hpp"
+#endif
 
+#include "io_service.hpp"
+#include "local_server.hpp"
 #include "tcp_server.hpp"
-#include "tray.hpp"
+#include "http_server.hpp"
 #include "request_handler.hpp"
 #include "network_config.hpp"
 #include "rendezvous_client.hpp"
 
+#include <algorithm>
 #include <list>
 #include <set>
 #include <future>
@@ -35,7 +46,12 @@ using namespace wininspect;
 
 namespace {
 
-std::wstring g_pipe_name = L"\\\\.\\pipe\\wininspectd";
+// Pipe name on Windows, socket name under $XDG_RUNTIME_DIR elsewhere.
+std::string g_local_name = "wininspectd";
+
+#ifndef _WIN32
+struct CoInitGuard { ~CoInitGuard() {} }; // COM is Windows-only
+#endif
 
 void cleanup_sessions(ServerState *st) {
   std::lock_guard<std::mutex> lk(st->snapshots_mu);
@@ -50,111 +66,7 @@ void cleanup_sessions(ServerState *st) {
   }
 }
 
-void handle_client(HANDLE hPipe, ServerState *st, IBackend *backend,
-                   bool read_only, bool require_auth, bool admin_logs, bool no_clipboard,
-                   const std::string& auth_keys_data) {
-  CoInitGuard coinit;
-  CoreEngine core(backend);
-  core.set_admin_logs_enabled(admin_logs);
-  ClientSession session;
-  st->active_connections++;
-  LOG_INFO("New client connection established.");
-
-  // Auto-auth local pipes only when not in require-auth mode and no keys configured
-  if (!require_auth && auth_keys_data.empty()) {
-    session.authenticated = true;
-    LOG_DEBUG("Local auto-auth enabled (no keys, not require-auth).");
-  }
-
-  // Ensure decrement on exit
-  struct ConnGuard {
-    std::atomic<int>& count;
-    ~ConnGuard() { 
-      count--; 
-      LOG_INFO("Client connection closed.");
-    }
-  } guard{st->active_connections};
-
-  std::string pinned_sid;
-  while (true) {
-    wininspectd::PipeMessage m;
-    if (!wininspectd::pipe_read_message(hPipe, m))
-      break;
-
-    CoreResponse resp;
-    bool canonical = false;
-    pinned_sid.clear();
-
-    try {
-      wininspectd::process_request(m.json, core, st, backend, session,
-                      read_only, no_clipboard, require_auth, auth_keys_data,
-                      resp, canonical, pinned_sid);
-    } catch (...) {
-      resp.ok = false;
-      resp.error_code = "E_BAD_REQUEST";
-    }
-  send:
-    auto out = serialize_response_json(resp, canonical);
-    wininspectd::pipe_write_message(hPipe, out);
-    
-    // Unpin
-    if (!pinned_sid.empty()) {
-      std::lock_guard<std::mutex> lk(st->snapshots_mu);
-      st->pinned_counts[pinned_sid]--;
-    }
-  }
-
-  // Unpin any snapshot still pinned from an uncompleted request
-  if (!pinned_sid.empty()) {
-    std::lock_guard<std::mutex> lk(st->snapshots_mu);
-    st->pinned_counts[pinned_sid]--;
-  }
-
-  FlushFileBuffers(hPipe);
-  DisconnectNamedPipe(hPipe);
-  CloseHandle(hPipe);
-}
-
-void run_server(std::atomic<bool> *running, ServerState *st,
-                IBackend *backend, bool read_only, bool require_auth,
-                bool admin_logs, bool no_clipboard, std::string auth_keys_data) {
-  std::string pipe_name_narrow(g_pipe_name.begin(), g_pipe_name.end());
-  LOG_INFO("Named Pipe server starting on: " + pipe_name_narrow);
-  while (running->load()) {
-    HANDLE hPipe = CreateNamedPipeW(
-        g_pipe_name.c_str(), PIPE_ACCESS_DUPLEX,
-        PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT,
-        PIPE_UNLIMITED_INSTANCES, 64 * 1024, 64 * 1024, 0, nullptr);
-
-    if (hPipe == INVALID_HANDLE_VALUE) {
-      LOG_ERROR("Failed to create Named Pipe: " + std::to_string(GetLastError()));
-      break;
-    }
-
-    BOOL ok = ConnectNamedPipe(hPipe, nullptr)
-                  ? TRUE
-                  : (GetLastError() == ERROR_PIPE_CONNECTED);
-    if (!ok) {
-      CloseHandle(hPipe);
-      continue;
-    }
-
-    LOG_DEBUG("Named Pipe connection accepted.");
-
-    if (st->active_connections >= st->max_connections) {
-      // Too many connections, drop this one
-      DisconnectNamedPipe(hPipe);
-      CloseHandle(hPipe);
-      continue;
-    }
-
-    {
-    std::lock_guard<std::mutex> lk(st->thread_mu);
-    st->client_threads.emplace_back(handle_client, hPipe, st, backend, read_only, require_auth, admin_logs, no_clipboard, auth_keys_data);
-  }
-  }
-}
-
+#ifdef _WIN32
 void run_discovery_responder(std::atomic<bool> *running, ServerState *st, int tcp_port, IBackend *backend, const NetworkConfig &cfg) {
   SOCKET s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
   if (s == INVALID_SOCKET) return;
@@ -188,10 +100,7 @@ void run_discovery_responder(std::atomic<bool> *running, ServerState *st, int tc
         resp["os"] = env.at("os").as_str();
         resp["is_wine"] = env.at("is_wine").as_bool();
         
-        // Extract short pipe name from full path for discovery
-        std::string full_pipe(g_pipe_name.begin(), g_pipe_name.end());
-        size_t last_bs = full_pipe.rfind('\\');
-        resp["pipe_name"] = (last_bs != std::string::npos) ? full_pipe.substr(last_bs + 1) : full_pipe;
+        resp["pipe_name"] = g_local_name;
 
         if (cfg.include_hostname) {
           char hostname_buf[256];
@@ -206,6 +115,7 @@ void run_discovery_responder(std::atomic<bool> *running, ServerState *st, int tc
   }
   closesocket(s);
 }
+#endif
 
 } // namespace
 
@@ -223,11 +133,33 @@ int main(int argc, char **argv) {
   int max_conns = 32;
   int session_ttl = 3600;
   int poll_interval = 100;
+  int poll_interval_max = 1000;
+  bool event_hooks = true;
+  int reconcile_ms = 5000;
   int max_wait = 30000;
   int max_mem_read = 1024 * 1024;
   int uia_depth = -1;
   int service_timeout = 30;
   int max_event_log = 1000;
+  std::string journal_dir;
+  int journal_segment_mb = 64;
+  int journal_max_segments = 0;
+  int capture_freshness_ms = 20;
+  int io_threads = 0; // 0 = one per core
+  int max_wait_threads = 64;
+  int max_inflight = 8;
+  int ticket_lifetime = 3600;
+  int compress_min = 1024;
+  int shm_ring_mb = 32;
+  int shm_min = 64 * 1024;
+  int http_port = 0; // 0 = HTTP API disabled
+  std::string http_token;
+#ifdef WININSPECTD_FAKE
+  int fake_window_count = 64;
+  std::string fake_timeline; // empty = no scripted events
+  double fake_rate = 100;
+  int fake_events = 10000;
+#endif
 
   // Parse config path early (others handled by apply_cli_overrides)
   for (int i = 1; i < argc; ++i) {
@@ -282,13 +214,19 @@ int main(int argc, char **argv) {
     if (std::string(argv[i]) == "--poll-interval" && i + 1 < argc) {
       poll_interval = std::stoi(argv[++i]);
     }
+    if (std::string(argv[i]) == "--poll-interval-max" && i + 1 < argc) {
+      poll_interval_max = std::stoi(argv[++i]);
+    }
+    if (std::string(argv[i]) == "--no-event-hooks")
+      event_hooks = false;
+    if (std::string(argv[i]) == "--reconcile-ms" && i + 1 < argc) {
+      reconcile_ms = std::stoi(argv[++i]);
+    }
     if (std::string(argv[i]) == "--max-wait" && i + 1 < argc) {
       max_wait = std::stoi(argv[++i]);
     }
     if (std::string(argv[i]) == "--pipe-name" && i + 1 < argc) {
-      std::string name = argv[++i];
-      std::wstring wname(name.begin(), name.end());
-      g_pipe_name = L"\\\\.\\pipe\\" + wname;
+      g_local_name = argv[++i];
     }
     if (std::string(argv[i]) == "--max-mem-read" && i + 1 < argc) {
       max_mem_read = std::stoi(argv[++i]);
@@ -302,6 +240,59 @@ int main(int argc, char **argv) {
     if (std::string(argv[i]) == "--max-event-log" && i + 1 < argc) {
       max_event_log = std::stoi(argv[++i]);
     }
+    if (std::string(argv[i]) == "--capture-freshness-ms" && i + 1 < argc) {
+      capture_freshness_ms = std::stoi(argv[++i]);
+    }
+    if (std::string(argv[i]) == "--io-threads" && i + 1 < argc) {
+      io_threads = std::stoi(argv[++i]);
+    }
+    if (std::string(argv[i]) == "--max-wait-threads" && i + 1 < argc) {
+      max_wait_threads = std::stoi(argv[++i]);
+    }
+    if (std::string(argv[i]) == "--max-inflight" && i + 1 < argc) {
+      max_inflight = std::stoi(argv[++i]);
+    }
+    if (std::string(argv[i]) == "--ticket-lifetime" && i + 1 < argc) {
+      ticket_lifetime = std::stoi(argv[++i]);
+    }
+    if (std::string(argv[i]) == "--compress-min" && i + 1 < argc) {
+      compress_min = std::stoi(argv[++i]);
+    }
+    if (std::string(argv[i]) == "--shm-ring-mb" && i + 1 < argc) {
+      shm_ring_mb = std::stoi(argv[++i]);
+    }
+    if (std::string(argv[i]) == "--shm-min" && i + 1 < argc) {
+      shm_min = std::stoi(argv[++i]);
+    }
+    if (std::string(argv[i]) == "--http-port" && i + 1 < argc) {
+      http_port = std::stoi(argv[++i]);
+    }
+    if (std::string(argv[i]) == "--http-token" && i + 1 < argc) {
+      http_token = argv[++i];
+    }
+    if (std::string(argv[i]) == "--journal-dir" && i + 1 < argc) {
+      journal_dir = argv[++i];
+    }
+    if (std::string(argv[i]) == "--journal-segment-mb" && i + 1 < argc) {
+      journal_segment_mb = std::stoi(argv[++i]);
+    }
+    if (std::string(argv[i]) == "--journal-max-segments" && i + 1 < argc) {
+      journal_max_segments = std::stoi(argv[++i]);
+    }
+#ifdef WININSPECTD_FAKE
+    if (std::string(argv[i]) == "--fake-windows" && i + 1 < argc) {
+      fake_window_count = std::stoi(argv[++i]);
+    }
+    if (std::string(argv[i]) == "--fake-timeline" && i + 1 < argc) {
+      fake_timeline = argv[++i];
+    }
+    if (std::string(argv[i]) == "--fake-rate" && i + 1 < argc) {
+      fake_rate = std::stod(argv[++i]);
+    }
+    if (std::string(argv[i]) == "--fake-events" && i + 1 < argc) {
+      fake_events = std::stoi(argv[++i]);
+    }
+#endif
     if (std::string(argv[i]) == "--log-level" && i + 1 < argc) {
       std::string lvl = argv[++i];
       if (lvl == "TRACE") Logger::get().set_level(LogLevel::TRACE);
@@ -319,6 +310,11 @@ int main(int argc, char **argv) {
   st->request_timeout_ms = net_cfg.request_timeout_ms;
   st->poll_interval_ms = poll_interval;
   st->max_wait_ms = max_wait;
+  st->max_inflight = std::max(max_inflight, 1);
+  st->ticket_lifetime_s = std::max(ticket_lifetime, 0);
+  st->compress_min_bytes = (size_t)std::max(compress_min, 0);
+  st->shm_ring_bytes = (size_t)std::clamp(shm_ring_mb, 0, 1024) * 1024 * 1024;
+  st->shm_min_bytes = (size_t)std::max(shm_min, 1);
   st->discovery_port = net_cfg.discovery_port;
   st->rate_limit_ms = net_cfg.rate_limit_ms;
   st->net_config = net_cfg;
@@ -344,8 +340,39 @@ int main(int argc, char **argv) {
   if (uia_depth != -1) st->uia_depth = uia_depth;
   st->service_timeout_sec = service_timeout;
   st->max_event_log = (size_t)max_event_log;
+  st->event_log = std::make_unique<EventRing>(st->max_event_log);
 
+  if (!journal_dir.empty()) {
+    SnapshotJournal::Options jo;
+    jo.dir = journal_dir;
+    jo.segment_bytes = (uint64_t)std::max(journal_segment_mb, 1) * 1024 * 1024;
+    jo.max_segments = (size_t)std::max(journal_max_segments, 0);
+    try {
+      st->journal = std::make_shared<SnapshotJournal>(jo);
+      LOG_INFO("Snapshot journal: " + journal_dir);
+    } catch (const std::exception &e) {
+      LOG_ERROR(std::string("Snapshot journal disabled: ") + e.what());
+    }
+  }
+
+#ifdef WININSPECTD_FAKE
+  // Synthetic desktop for running the daemon off Windows.
+  std::vector<FakeWindow> fake_windows;
+  for (int i = 0; i < fake_window_count; i++)
+    fake_windows.push_back({(hwnd_u64)(0x1000 + i), 0, 0,
+                            "Fake Window " + std::to_string(i), "FakeClass"});
+  auto backend = std::make_unique<FakeBackend>(std::move(fake_windows));
+  if (!fake_timeline.empty()) {
+    FakeTimeline::Options to;
+    to.shape = FakeTimeline::shape_from_str(fake_timeline).value_or(FakeTimeline::Shape::Steady);
+    to.rate = fake_rate;
+    to.total = (size_t)std::max(fake_events, 0);
+    backend->set_timeline(to);
+    LOG_INFO("Fake timeline: " + fake_timeline + " at " + std::to_string((int)fake_rate) + "/s");
+  }
+#else
   auto backend = std::make_unique<Win32Backend>();
+#endif
 
   // Propagate config to backend
   json::Object bcfg;
@@ -353,6 +380,27 @@ int main(int argc, char **argv) {
   bcfg["uia_depth"] = (double)st->uia_depth;
   bcfg["service_timeout"] = (double)st->service_timeout_sec;
   backend->set_config(bcfg);
+  st->capture = std::make_unique<CaptureCoalescer>(backend.get(), capture_freshness_ms);
+
+  // One detector feeds every subscriber; events.poll reads its log. It
+  // forwards the backend's pushed events (WinEvent hooks) when available
+  // and diffs snapshots otherwise. It idles until a client subscribes or polls.
+  st->subs = std::make_unique<SubscriptionHub>(backend.get(), st->max_event_log);
+  ChangeDetector::Options dopts;
+  dopts.min_interval_ms = poll_interval;
+  dopts.max_interval_ms = poll_interval_max;
+  dopts.reconcile_ms = reconcile_ms;
+  st->detector = std::make_unique<ChangeDetector>(
+      backend.get(),
+      [st = st.get(), b = backend.get()] { return wininspectd::capture_current(st, b); },
+      [st = st.get()](std::vector<Event> &ev, const Snapshot &cur) {
+        wininspectd::publish_events(st, ev, cur);
+      },
+      dopts, event_hooks ? backend->create_event_source() : nullptr);
+
+  // Pipe/socket clients share one I/O loop; long polls get their own threads.
+  st->io = std::make_shared<wininspectd::IoService>((size_t)std::max(io_threads, 0),
+                                                    (size_t)std::max(max_wait_threads, 1));
 
   std::atomic<bool> running{true};
 
@@ -362,40 +410,44 @@ int main(int argc, char **argv) {
   LOG_INFO("Environment: " + env.at("os").as_str() + " (" + env.at("arch").as_str() + ")");
   if (env.count("wine_version")) LOG_INFO("Wine Version: " + env.at("wine_version").as_str());
 
-  // Read auth keys file once at startup (cache content, not path)
-  std::string auth_keys_data;
+  // Authorized keys are indexed once and re-read when the file changes.
+  std::shared_ptr<wininspect::AuthorizedKeysFile> auth_keys_file;
   if (!auth_keys.empty()) {
-    std::ifstream kf(auth_keys);
-    std::stringstream ks;
-    ks << kf.rdbuf();
-    auth_keys_data = ks.str();
-    LOG_INFO("Loaded " + std::to_string(auth_keys_data.size()) + " bytes of authorized keys from " + auth_keys);
+    auth_keys_file = std::make_shared<wininspect::AuthorizedKeysFile>(auth_keys);
+    (void)auth_keys_file->current(); // logs what was loaded
   }
 
   // 1. Start discovery responder
+#ifdef _WIN32
   LOG_INFO("Starting Discovery responder...");
   std::thread disc_thread([&running, st = st.get(), backend = backend.get(), &net_cfg]() {
     run_discovery_responder(&running, st, net_cfg.port, backend, net_cfg);
   });
   disc_thread.detach();
+#else
+  LOG_INFO("Discovery responder not available on this platform.");
+#endif
 
   // 2. Start cleanup thread
   LOG_INFO("Starting Cleanup thread...");
   std::thread cleanup_thread([&running, st = st.get()]() {
     while (running.load()) {
-      Sleep(60000);
+      std::this_thread::sleep_for(std::chrono::minutes(1));
       cleanup_sessions(st);
     }
   });
   cleanup_thread.detach();
 
-  // 3. Start Named Pipe server (background)
-  LOG_INFO("Starting Named Pipe server (background)...");
-  std::thread pipe_thread([&running, st = st.get(), backend = backend.get(),
-                            read_only, require_auth, admin_logs, no_clipboard, auth_keys_data]() {
-    run_server(&running, st, backend, read_only, require_auth, admin_logs, no_clipboard, auth_keys_data);
+  // 3. Start local (named pipe / Unix socket) server (background)
+  LOG_INFO("Starting local server (background)...");
+  auto local = std::make_shared<wininspectd::LocalServer>(st.get(), backend.get());
+  std::thread local_thread([&running, local, read_only, require_auth, admin_logs,
+                            no_clipboard, auth_keys]() {
+    // The local server only needs to know whether keys are configured.
+    local->start(&running, g_local_name, auth_keys, read_only, require_auth,
+                 admin_logs, no_clipboard);
   });
-  pipe_thread.detach();
+  local_thread.detach();
 
   // 4. Auto-update checker (background)
   if (net_cfg.enable_update_check) {
@@ -406,7 +458,7 @@ int main(int argc, char **argv) {
         if (info.update_available) {
           LOG_INFO("Update available: " + info.latest_version + " (current: " + info.current_version + ")");
         }
-        Sleep(net_cfg.update_check_interval_hours * 3600 * 1000);
+        std::this_thread::sleep_for(std::chrono::hours(net_cfg.update_check_interval_hours));
       }
     });
     update_thread.detach();
@@ -420,7 +472,7 @@ int main(int argc, char **argv) {
         LOG_INFO("Registered with rendezvous: " + rv_cfg.url);
         std::thread rv_thread([&running, c = std::move(rv_client)]() {
           while (running.load()) {
-            Sleep(c->heartbeat() ? 30000 : 10000);
+            std::this_thread::sleep_for(std::chrono::seconds(c->heartbeat() ? 30 : 10));
           }
           c->deregister();
         });
@@ -429,10 +481,25 @@ int main(int argc, char **argv) {
     }
   }
 
-  // 6. Run TCP server (BLOCKING MAIN THREAD)
+  // 6. HTTP/REST API and SSE event feed (background, opt-in)
+  if (http_port > 0) {
+    LOG_INFO("Starting HTTP server on port " + std::to_string(http_port) + "...");
+    std::thread http_thread([&running, st = st.get(), backend = backend.get(),
+                             http_port, http_token, admin_logs, read_only, no_clipboard]() {
+      CoInitGuard coinit;
+      CoreEngine core(backend);
+      core.set_admin_logs_enabled(admin_logs);
+      wininspectd::run_http_server(&running, http_port, core, http_token, st, read_only,
+                                   no_clipboard);
+    });
+    http_thread.detach();
+  }
+
+  // 7. Run TCP server (BLOCKING MAIN THREAD)
   LOG_INFO("Starting TCP Server (blocking main thread)...");
   auto tcp = std::make_shared<wininspectd::TcpServer>(st.get(), backend.get());
 
+#ifdef _WIN32
   if (!headless) {
     wininspectd::TrayManager tray([&]() {
       LOG_INFO("Shutdown requested via tray.");
@@ -443,19 +510,23 @@ int main(int argc, char **argv) {
     if (tray.init(GetModuleHandle(nullptr))) {
       std::thread([&, tcp, read_only]() {
         try {
-          tcp->start(&running, net_cfg, auth_keys_data, read_only, admin_logs, no_clipboard);
+          tcp->start(&running, net_cfg, auth_keys_file, read_only, admin_logs, no_clipboard);
         } catch (...) {}
       }).detach();
       tray.run();
     }
   }
+#else
+  (void)headless;
+#endif
 
   try {
-    tcp->start(&running, net_cfg, auth_keys_data, read_only, admin_logs, no_clipboard);
+    tcp->start(&running, net_cfg, auth_keys_file, read_only, admin_logs, no_clipboard);
   } catch (...) {
     LOG_ERROR("TCP Server fatal error.");
   }
 
+  st->io->stop();       // connections use backend, which is destroyed before st
+  st->detector.reset(); // likewise the detector's thread
   return 0;
 }
-#endif
@@ -12,27 +12,46 @@
 #include <vector>
 #include <set>
 #include <memory>
+#include <functional>
 #include "wininspect/types.hpp"
 #include "wininspect/network_config.hpp"
+#include "wininspect/snapshot_journal.hpp"
+#include "wininspect/capture_coalescer.hpp"
+#include "wininspect/change_detector.hpp"
+#include "wininspect/event_ring.hpp"
+#include "wininspect/subscription_hub.hpp"
+
+namespace wininspectd {
+class EventStreamer;
+class FileStreamer;
+class IoService;
+class EventPusher;
+} // namespace wininspectd
 
 namespace wininspect {
 
 struct ServerState {
   std::mutex snapshots_mu;   // protects snaps, pinned_counts, lru_order, snap_counter
-  std::mutex sessions_mu;    // protects sessions, sessionCount, event_counter, event_log
+  std::mutex sessions_mu;    // protects sessions, sessionCount
   std::uint64_t snap_counter = 1;
-  std::map<std::string, std::shared_ptr<Snapshot>> snaps;
+  std::map<std::string, std::shared_ptr<const Snapshot>> snaps;
   std::map<std::string, int> pinned_counts;
   std::list<std::string> lru_order; // LRU: front is oldest, back is newest
+  std::shared_ptr<SnapshotJournal> journal; // null unless --journal-dir
+  std::unique_ptr<CaptureCoalescer> capture; // shared live captures; see capture_current()
 
-  // Client thread tracking (joined on shutdown via jthread auto-join)
-  std::vector<std::jthread> client_threads;
-  std::mutex thread_mu; // protects client_threads
+  // Serves every pipe/socket client; stopped before the backend goes away.
+  std::shared_ptr<wininspectd::IoService> io;
 
-  // Event Sequencing
-  std::atomic<std::uint64_t> event_counter{1};
-  std::vector<Event> event_log;
+  // Event Sequencing: written by `detector`, read lock-free by events.poll.
+  // Replaced at startup once --max-event-log is known.
   size_t max_event_log = 1000;
+  std::unique_ptr<EventRing> event_log = std::make_unique<EventRing>(max_event_log);
+  std::atomic<std::uint64_t> stream_counter{1}; // events.stream and file stream ids
+  size_t max_stream_queue = 4096;               // cap on events.stream max_queue
+  // events.stream and SSE streams, told of each publish (see push_task.hpp).
+  std::mutex pushers_mu;
+  std::vector<wininspectd::EventPusher *> event_pushers;
 
   // Configurable limits
   size_t max_snapshots = 1000;
@@ -45,9 +64,14 @@ struct ServerState {
   std::atomic<int> active_connections{0};
 
   // Temporal limits
-  int request_timeout_ms = 5000; // 5s watchdog
+  int request_timeout_ms = 5000; // slower requests are logged
   int poll_interval_ms = 100;
   int max_wait_ms = 30000; // 30s max for long polls
+  int max_inflight = 8; // concurrent requests per connection
+  int ticket_lifetime_s = 3600; // TCP resumption tickets; 0 disables
+  size_t compress_min_bytes = 1024; // smallest TCP frame worth compressing; 0 disables
+  size_t shm_ring_bytes = 32 * 1024 * 1024; // per direction, for local clients; 0 disables
+  size_t shm_min_bytes = 64 * 1024;         // smallest local frame sent through the ring
   int discovery_port = 1986; // Discovery UDP port
   int rate_limit_ms = 0;
   std::chrono::steady_clock::time_point last_accept_time;
@@ -56,6 +80,8 @@ struct ServerState {
     std::string last_snap_id;
     bool subscribed = false;
     std::chrono::steady_clock::time_point last_activity;
+    std::uint64_t event_seq = 0; // last event delivered by events.poll
+    std::shared_ptr<FilteredSubscription> filtered; // see ClientSession
   };
   std::map<std::string, PersistentSession> sessions;
   // Method authorization sets
@@ -72,6 +98,12 @@ struct ServerState {
   int per_ip_rate_limit_ms = 0;
   std::map<std::string, std::chrono::steady_clock::time_point> last_accept_per_ip;
   std::mutex ip_rate_mu;
+
+  // Filtered events.subscribe; fed by `detector`. Null without a detector.
+  std::unique_ptr<SubscriptionHub> subs;
+
+  // Last member: its thread uses the state above and is joined first.
+  std::unique_ptr<ChangeDetector> detector;
 };
 
 struct ClientSession {
@@ -79,6 +111,17 @@ struct ClientSession {
   bool authenticated = false;
   std::string last_snap_id;
   bool subscribed = false;
+  std::uint64_t event_seq = 0;
+  // Filtered subscription, if events.subscribe had a filter; event_seq then
+  // counts in its sequence instead of the shared log's.
+  std::shared_ptr<FilteredSubscription> filtered;
+  // Set by transports that can write unsolicited frames (pipe, TCP); must
+  // serialize with the transport's own response writes. The second argument
+  // is 0 or FRAME_MULTIPART.
+  std::function<bool(const std::string &, std::uint32_t)> push;
+  wininspectd::IoService *io = nullptr; // runs the streams below
+  std::shared_ptr<wininspectd::EventStreamer> stream;     // events.stream, if active
+  std::shared_ptr<wininspectd::FileStreamer> file_stream; // file.read streaming, if active
 };
 
 } // namespace wininspect
@@ -0,0 +1,193 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "shm_ring.hpp"
+#include "wininspect/tinyjson.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <new>
+
+using namespace wininspect;
+
+namespace wininspectd {
+
+namespace {
+
+std::uint64_t align8(std::uint64_t v) { return (v + 7) & ~std::uint64_t(7); }
+
+} // namespace
+
+// ── ShmSpan ─────────────────────────────────────────────────────────────────
+
+void ShmSpan::encode(std::uint8_t *out) const {
+  for (int i = 0; i < 8; i++) out[i] = (std::uint8_t)(pos >> (8 * i));
+  for (int i = 0; i < 4; i++) out[8 + i] = (std::uint8_t)(len >> (8 * i));
+}
+
+bool ShmSpan::decode(const void *p, size_t n) {
+  if (n != WIRE_BYTES) return false;
+  auto *b = (const std::uint8_t *)p;
+  pos = 0;
+  len = 0;
+  for (int i = 0; i < 8; i++) pos |= (std::uint64_t)b[i] << (8 * i);
+  for (int i = 0; i < 4; i++) len |= (std::uint32_t)b[8 + i] << (8 * i);
+  return true;
+}
+
+// ── ShmRing ─────────────────────────────────────────────────────────────────
+
+bool ShmRing::write(const ConstBuffer *bufs, size_t count, ShmSpan &out, int wait_ms) {
+  size_t n = 0;
+  for (size_t i = 0; i < count; i++) n += bufs[i].size;
+  if (n == 0 || n > cap_ || n > 0xFFFFFFFFu) return false;
+
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(wait_ms);
+  std::uint64_t tail = h_->tail.load(std::memory_order_relaxed), pos;
+  while (true) {
+    std::uint64_t head = h_->head.load(std::memory_order_acquire);
+    if (head > tail || tail - head > cap_) return false; // not a state we left it in
+    pos = tail;
+    if (pos % cap_ + n > cap_) pos += cap_ - pos % cap_; // start over at the beginning
+    if (pos + n - head <= cap_) break;
+
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now());
+    if (left.count() <= 0) return false;
+    // Raise the flag, then look again: either the consumer sees the flag
+    // after it frees space, or this sees the space.
+    h_->waiting.store(1);
+    if (h_->head.load() == head) space_->wait((int)left.count() + 1);
+    h_->waiting.store(0);
+  }
+
+  std::uint8_t *dst = data_ + pos % cap_;
+  for (size_t i = 0; i < count; i++) {
+    std::memcpy(dst, bufs[i].data, bufs[i].size);
+    dst += bufs[i].size;
+  }
+  h_->tail.store(align8(pos + n), std::memory_order_release);
+  out.pos = pos;
+  out.len = (std::uint32_t)n;
+  return true;
+}
+
+const std::uint8_t *ShmRing::at(const ShmSpan &s) const {
+  if (s.len == 0 || s.len > cap_ || s.pos % cap_ + s.len > cap_) return nullptr;
+  std::uint64_t head = h_->head.load(std::memory_order_relaxed);
+  std::uint64_t tail = h_->tail.load(std::memory_order_acquire);
+  if (s.pos < head || s.pos > tail || s.len > tail - s.pos) return nullptr;
+  return data_ + s.pos % cap_;
+}
+
+void ShmRing::release(const ShmSpan &s) {
+  std::uint64_t end = align8(s.pos + s.len);
+  if (end <= h_->head.load(std::memory_order_relaxed)) return;
+  h_->head.store(end);
+  if (h_->waiting.load()) space_->ring();
+}
+
+// ── ShmRegion ───────────────────────────────────────────────────────────────
+
+bool ShmRegion::attach(void *base, size_t size, bool init) {
+  if (size < 2 * HEADER_BYTES + 16) return false;
+  std::uint64_t cap = (size - 2 * HEADER_BYTES) / 2 & ~std::uint64_t(7);
+  auto *p = (std::uint8_t *)base;
+  ShmRingHeader *h[2];
+  for (int i = 0; i < 2; i++) {
+    void *at = p + i * HEADER_BYTES;
+    if (init) {
+      h[i] = new (at) ShmRingHeader{MAGIC, VERSION, cap, {0}, {0}, {0}};
+    } else {
+      h[i] = (ShmRingHeader *)at;
+      if (h[i]->magic != MAGIC || h[i]->version != VERSION || h[i]->capacity != cap)
+        return false;
+    }
+  }
+  std::uint8_t *data = p + 2 * HEADER_BYTES;
+  to_client_ = std::make_unique<ShmRing>(h[0], data, client_space_.get());
+  to_daemon_ = std::make_unique<ShmRing>(h[1], data + cap, daemon_space_.get());
+  base_ = base;
+  size_ = size;
+  return true;
+}
+
+// ── ShmClient ───────────────────────────────────────────────────────────────
+
+ShmClient::ShmClient(IConnection &c) : c_(c), reader_(c) {
+  if (!write_frame(c, std::string(R"({"id":"shm","method":"transport.shm","params":{}})")))
+    return;
+  // The reply is read by hand: descriptors arrive with its first byte,
+  // and a plain read would drop them.
+  std::vector<int> handles;
+  std::uint32_t len = 0;
+  for (size_t got = 0; got < sizeof(len);) {
+    long r = c.read_with_handles((char *)&len + got, sizeof(len) - got, handles);
+    if (r <= 0) break;
+    got += (size_t)r;
+  }
+  std::string body;
+  bool ok = len > 0 && len <= MAX_FRAME_BYTES;
+  if (ok) {
+    body.resize(len);
+    ok = c.read_all(body.data(), len);
+  }
+  std::string name;
+  try {
+    auto v = ok ? json::parse(body) : json::Value();
+    ok = ok && v.as_obj().at("ok").as_bool();
+    if (ok) {
+      const auto &r = v.as_obj().at("result").as_obj();
+      min_bytes_ = (size_t)r.at("min_bytes").as_num();
+      auto it = r.find("name");
+      if (it != r.end()) name = it->second.as_str();
+    }
+  } catch (...) {
+    ok = false;
+  }
+  auto region = ShmRegion::open(name, handles); // also closes stray descriptors
+  if (ok) region_ = std::move(region);
+}
+
+bool ShmClient::write(const void *p, size_t n, std::uint32_t flags) {
+  if (region_ && n >= min_bytes_) {
+    ConstBuffer b{p, n};
+    ShmSpan s;
+    if (region_->to_daemon().write(&b, 1, s, WAIT_MS)) {
+      std::uint8_t d[ShmSpan::WIRE_BYTES];
+      s.encode(d);
+      return write_frame(c_, d, sizeof(d), flags | FRAME_SHM);
+    }
+  }
+  return write_frame(c_, p, n, flags);
+}
+
+bool ShmClient::read(std::string_view &payload, std::uint32_t *flags) {
+  release();
+  std::uint32_t f = 0;
+  if (!reader_.read(buf_, &f)) return false;
+  if (f & FRAME_SHM) {
+    ShmSpan s;
+    const std::uint8_t *p =
+        region_ && s.decode(buf_.data(), buf_.size()) ? region_->to_client().at(s) : nullptr;
+    if (!p) return false;
+    payload = std::string_view((const char *)p, s.len);
+    held_ = s;
+    holding_ = true;
+    in_place_++;
+    f &= ~FRAME_SHM;
+  } else {
+    payload = buf_;
+  }
+  if (!flags) return f == 0;
+  *flags = f;
+  return true;
+}
+
+void ShmClient::release() {
+  if (!holding_) return;
+  region_->to_client().release(held_);
+  holding_ = false;
+}
+
+} // namespace wininspectd
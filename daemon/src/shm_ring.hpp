@@ -0,0 +1,178 @@
+#pragma once
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+// Shared-memory transport for same-machine clients. Requests and responses
+// still travel over the pipe (or Unix socket), but a large payload is
+// written once into a ring in memory the client maps, and the frame on the
+// pipe only locates it (FRAME_SHM), so the client reads it in place rather
+// than through the kernel. The pipe keeps frames in order and wakes the
+// reader; each ring has a doorbell (an eventfd, or an Event object on
+// Windows) that the consumer rings when it frees space a blocked producer
+// is waiting for. Setup is a transport.shm request: memfd and eventfds are
+// passed over the Unix socket, and on Windows the reply names the mapping
+// and events. Mapping and doorbells live in shm_ring_posix.cpp and
+// shm_ring_win32.cpp.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "transport.hpp"
+
+namespace wininspectd {
+
+/// Where a payload sits in a ring: a position (monotonic, so that it also
+/// tells which lap of the ring it was written on) and a size. On the wire
+/// it is the whole payload of a FRAME_SHM frame, 12 bytes little-endian.
+struct ShmSpan {
+  std::uint64_t pos = 0;
+  std::uint32_t len = 0;
+
+  static constexpr size_t WIRE_BYTES = 12;
+  void encode(std::uint8_t *out) const;
+  /// False unless `n` is WIRE_BYTES.
+  bool decode(const void *p, size_t n);
+};
+
+/// The start of each ring, in shared memory. Only the producer advances
+/// tail and only the consumer advances head; neither trusts the other's.
+struct ShmRingHeader {
+  std::uint32_t magic;
+  std::uint32_t version;
+  std::uint64_t capacity;
+  alignas(64) std::atomic<std::uint64_t> head; // consumer: everything before is free
+  alignas(64) std::atomic<std::uint64_t> tail; // producer: the next record goes here
+  std::atomic<std::uint32_t> waiting;          // the producer sleeps on the doorbell
+};
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+              "ring positions are shared between processes");
+
+/// A wakeup shared with the other process: eventfd or auto-reset Event.
+class Doorbell {
+public:
+  explicit Doorbell(std::intptr_t handle) : h_(handle) {}
+  ~Doorbell();
+  Doorbell(const Doorbell &) = delete;
+  Doorbell &operator=(const Doorbell &) = delete;
+
+  void ring();
+  /// True if rung within `ms`; a ring before the wait counts.
+  bool wait(int ms);
+  std::intptr_t handle() const { return h_; }
+
+private:
+  std::intptr_t h_;
+};
+
+/// One direction: a single producer and a single consumer in different
+/// processes. A record is contiguous (one that would run past the end
+/// starts over at the beginning instead), so the consumer can use it in
+/// place, and records are freed in the order they were written.
+class ShmRing {
+public:
+  ShmRing(ShmRingHeader *h, std::uint8_t *data, Doorbell *space)
+      : h_(h), data_(data), cap_(h->capacity), space_(space) {}
+
+  /// Producer: copies the pieces into one record, waiting up to `wait_ms`
+  /// for the consumer to free room. False when they will not fit in time,
+  /// are larger than the ring, or the header is corrupt; send inline then.
+  bool write(const ConstBuffer *bufs, size_t count, ShmSpan &out, int wait_ms);
+  /// Consumer: the record in place, or null if `s` is not inside the ring.
+  const std::uint8_t *at(const ShmSpan &s) const;
+  /// Consumer: frees `s` and everything written before it.
+  void release(const ShmSpan &s);
+
+  size_t capacity() const { return (size_t)cap_; }
+
+private:
+  ShmRingHeader *h_;
+  std::uint8_t *data_;
+  std::uint64_t cap_;
+  Doorbell *space_;
+};
+
+/// The mapping behind a ring pair: [header, header, data, data]. The
+/// daemon creates it per connection; the client opens it from the
+/// handshake reply. Unmapped (and the doorbells closed) on destruction.
+class ShmRegion {
+public:
+  ~ShmRegion();
+  ShmRegion(const ShmRegion &) = delete;
+  ShmRegion &operator=(const ShmRegion &) = delete;
+
+  /// Daemon: two fresh rings of `ring_bytes` (rounded up to a page) each.
+  /// Null if shared memory cannot be had.
+  static std::unique_ptr<ShmRegion> create(size_t ring_bytes);
+  /// Client: the region from a transport.shm reply: `name` on Windows, the
+  /// descriptors passed with it elsewhere (taken over, even on failure).
+  static std::unique_ptr<ShmRegion> open(const std::string &name,
+                                         const std::vector<int> &handles);
+
+  /// What open() needs: a name to put in the reply (Windows) ...
+  const std::string &name() const { return name_; }
+  /// ... or the memfd and the two doorbells, to pass with it.
+  std::vector<int> handles() const;
+
+  ShmRing &to_client() { return *to_client_; }
+  ShmRing &to_daemon() { return *to_daemon_; }
+
+  static constexpr std::uint32_t MAGIC = 0x52534957; // "WISR"
+  static constexpr std::uint32_t VERSION = 1;
+  static constexpr size_t HEADER_BYTES = 256; // per ring, ahead of both data areas
+
+private:
+  ShmRegion() = default;
+  bool attach(void *base, size_t size, bool init);
+
+  void *base_ = nullptr;
+  size_t size_ = 0;
+  std::intptr_t mapping_ = -1; // memfd or file mapping HANDLE
+  std::string name_;
+  std::unique_ptr<Doorbell> client_space_, daemon_space_;
+  std::unique_ptr<ShmRing> to_client_, to_daemon_;
+};
+
+/// The client end of a local connection, with the shared-memory rings when
+/// the daemon offers them: frames of at least `min_bytes` go both ways
+/// through the rings, everything else (and everything, without them) as
+/// plain frames.
+class ShmClient {
+public:
+  /// Runs the transport.shm handshake on `c`, which must have nothing in
+  /// flight. Without rings (an older daemon, --shm-ring-mb 0, TCP) the
+  /// client still works, over the connection alone.
+  explicit ShmClient(IConnection &c);
+
+  bool attached() const { return region_ != nullptr; }
+
+  /// Sends one frame; `flags` is 0 or FRAME_MULTIPART.
+  bool write(const void *p, size_t n, std::uint32_t flags = 0);
+  bool write(const std::string &s) { return write(s.data(), s.size()); }
+  /// The next frame, without FRAME_SHM in `flags`. A large one is `payload`
+  /// in place in the ring, valid until the next read() or release().
+  [[nodiscard]] bool read(std::string_view &payload, std::uint32_t *flags = nullptr);
+  /// Hands the frame read last back to the daemon (read() does it anyway).
+  void release();
+
+  /// Frames read in place so far.
+  std::uint64_t in_place() const { return in_place_; }
+
+  /// How long a producer waits for ring space before sending inline.
+  static constexpr int WAIT_MS = 50;
+
+private:
+  IConnection &c_;
+  FrameReader reader_;
+  std::unique_ptr<ShmRegion> region_;
+  size_t min_bytes_ = 0;
+  std::string buf_;
+  ShmSpan held_;
+  bool holding_ = false;
+  std::uint64_t in_place_ = 0;
+};
+
+} // namespace wininspectd
@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#ifndef _WIN32
+#include "shm_ring.hpp"
+#include "wininspect/logger.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <random>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace wininspectd {
+
+namespace {
+
+// An anonymous shared file: memfd, or a POSIX shm object unlinked as soon
+// as it is open, where the kernel has no memfd_create.
+int anonymous_shm() {
+  int fd = ::memfd_create("wininspectd-shm", MFD_CLOEXEC);
+  if (fd >= 0 || errno != ENOSYS) return fd;
+  std::random_device rd;
+  std::string name = "/wininspectd-shm-" + std::to_string(::getpid()) + "-" +
+                     std::to_string(rd()) + std::to_string(rd());
+  fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+  if (fd >= 0) ::shm_unlink(name.c_str());
+  return fd;
+}
+
+} // namespace
+
+// ── Doorbell (eventfd) ──────────────────────────────────────────────────────
+
+Doorbell::~Doorbell() {
+  if (h_ >= 0) ::close((int)h_);
+}
+
+void Doorbell::ring() {
+  std::uint64_t one = 1;
+  (void)!::write((int)h_, &one, sizeof(one));
+}
+
+bool Doorbell::wait(int ms) {
+  pollfd p{(int)h_, POLLIN, 0};
+  int r;
+  do {
+    r = ::poll(&p, 1, ms);
+  } while (r < 0 && errno == EINTR);
+  if (r <= 0) return false;
+  std::uint64_t v;
+  (void)!::read((int)h_, &v, sizeof(v)); // non-blocking: resets the count
+  return true;
+}
+
+// ── ShmRegion (memfd) ───────────────────────────────────────────────────────
+
+ShmRegion::~ShmRegion() {
+  if (base_) ::munmap(base_, size_);
+  if (mapping_ >= 0) ::close((int)mapping_);
+}
+
+std::unique_ptr<ShmRegion> ShmRegion::create(size_t ring_bytes) {
+  size_t page = (size_t)::sysconf(_SC_PAGESIZE);
+  size_t size = (2 * HEADER_BYTES + 2 * ring_bytes + page - 1) / page * page;
+  std::unique_ptr<ShmRegion> r(new ShmRegion());
+  r->mapping_ = anonymous_shm();
+  int a = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK), b = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  r->client_space_ = std::make_unique<Doorbell>(a);
+  r->daemon_space_ = std::make_unique<Doorbell>(b);
+  if (r->mapping_ < 0 || a < 0 || b < 0 || ::ftruncate((int)r->mapping_, (off_t)size) != 0) {
+    LOG_WARN(std::string("Shared memory: cannot create a region: ") + std::strerror(errno));
+    return nullptr;
+  }
+  void *base = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, (int)r->mapping_, 0);
+  if (base == MAP_FAILED) return nullptr;
+  if (!r->attach(base, size, true)) {
+    ::munmap(base, size);
+    return nullptr;
+  }
+  return r;
+}
+
+std::unique_ptr<ShmRegion> ShmRegion::open(const std::string &,
+                                           const std::vector<int> &handles) {
+  std::unique_ptr<ShmRegion> r(new ShmRegion());
+  if (handles.size() != 3) {
+    for (int fd : handles) ::close(fd);
+    return nullptr;
+  }
+  r->mapping_ = handles[0];
+  r->client_space_ = std::make_unique<Doorbell>(handles[1]);
+  r->daemon_space_ = std::make_unique<Doorbell>(handles[2]);
+  struct stat sb {};
+  if (::fstat(handles[0], &sb) != 0 || sb.st_size <= 0) return nullptr;
+  void *base = ::mmap(nullptr, (size_t)sb.st_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                      handles[0], 0);
+  if (base == MAP_FAILED) return nullptr;
+  if (!r->attach(base, (size_t)sb.st_size, false)) {
+    ::munmap(base, (size_t)sb.st_size);
+    return nullptr;
+  }
+  return r;
+}
+
+std::vector<int> ShmRegion::handles() const {
+  return {(int)mapping_, (int)client_space_->handle(), (int)daemon_space_->handle()};
+}
+
+} // namespace wininspectd
+#endif
@@ -0,0 +1,106 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#ifdef _WIN32
+#include "shm_ring.hpp"
+#include "wininspect/crypto.hpp"
+#include "wininspect/logger.hpp"
+
+#include <cstdio>
+#include <windows.h>
+
+namespace wininspectd {
+
+namespace {
+
+std::wstring widen(const std::string &s) { return std::wstring(s.begin(), s.end()); }
+
+// Unguessable, so that only the client the name was sent to can open the
+// objects; they live as long as either end holds a handle.
+std::string random_name() {
+  std::uint8_t r[16];
+  if (!wininspect::crypto::random_bytes(r, sizeof(r))) return {};
+  std::string name = "Local\\wininspectd-shm-";
+  char hex[3];
+  for (auto b : r) {
+    std::snprintf(hex, sizeof(hex), "%02x", b);
+    name += hex;
+  }
+  return name;
+}
+
+} // namespace
+
+// ── Doorbell (auto-reset Event) ─────────────────────────────────────────────
+
+Doorbell::~Doorbell() {
+  if (h_) CloseHandle((HANDLE)h_);
+}
+
+void Doorbell::ring() { SetEvent((HANDLE)h_); }
+
+bool Doorbell::wait(int ms) { return WaitForSingleObject((HANDLE)h_, (DWORD)ms) == WAIT_OBJECT_0; }
+
+// ── ShmRegion (named file mapping) ──────────────────────────────────────────
+
+ShmRegion::~ShmRegion() {
+  if (base_) UnmapViewOfFile(base_);
+  if (mapping_ != -1) CloseHandle((HANDLE)mapping_);
+}
+
+std::unique_ptr<ShmRegion> ShmRegion::create(size_t ring_bytes) {
+  SYSTEM_INFO si;
+  GetSystemInfo(&si);
+  size_t page = si.dwPageSize;
+  size_t size = (2 * HEADER_BYTES + 2 * ring_bytes + page - 1) / page * page;
+  std::unique_ptr<ShmRegion> r(new ShmRegion());
+  r->name_ = random_name();
+  if (r->name_.empty()) return nullptr;
+  HANDLE m = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                (DWORD)((std::uint64_t)size >> 32), (DWORD)size,
+                                widen(r->name_).c_str());
+  if (!m) {
+    LOG_WARN("Shared memory: cannot create a region: " + std::to_string(GetLastError()));
+    return nullptr;
+  }
+  r->mapping_ = (std::intptr_t)m;
+  HANDLE a = CreateEventW(nullptr, FALSE, FALSE, widen(r->name_ + "-c").c_str());
+  HANDLE b = CreateEventW(nullptr, FALSE, FALSE, widen(r->name_ + "-d").c_str());
+  r->client_space_ = std::make_unique<Doorbell>((std::intptr_t)a);
+  r->daemon_space_ = std::make_unique<Doorbell>((std::intptr_t)b);
+  void *base = MapViewOfFile(m, FILE_MAP_ALL_ACCESS, 0, 0, size);
+  if (!a || !b || !base) return nullptr;
+  if (!r->attach(base, size, true)) {
+    UnmapViewOfFile(base);
+    return nullptr;
+  }
+  return r;
+}
+
+std::unique_ptr<ShmRegion> ShmRegion::open(const std::string &name, const std::vector<int> &) {
+  if (name.rfind("Local\\wininspectd-shm-", 0) != 0) return nullptr;
+  std::unique_ptr<ShmRegion> r(new ShmRegion());
+  HANDLE m = OpenFileMappingW(FILE_MAP_ALL_ACCESS, FALSE, widen(name).c_str());
+  if (!m) return nullptr;
+  r->mapping_ = (std::intptr_t)m;
+  HANDLE a = OpenEventW(EVENT_MODIFY_STATE | SYNCHRONIZE, FALSE, widen(name + "-c").c_str());
+  HANDLE b = OpenEventW(EVENT_MODIFY_STATE | SYNCHRONIZE, FALSE, widen(name + "-d").c_str());
+  r->client_space_ = std::make_unique<Doorbell>((std::intptr_t)a);
+  r->daemon_space_ = std::make_unique<Doorbell>((std::intptr_t)b);
+  void *base = MapViewOfFile(m, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+  MEMORY_BASIC_INFORMATION mbi{};
+  if (!a || !b || !base || !VirtualQuery(base, &mbi, sizeof(mbi))) {
+    if (base) UnmapViewOfFile(base);
+    return nullptr;
+  }
+  if (!r->attach(base, mbi.RegionSize, false)) {
+    UnmapViewOfFile(base);
+    return nullptr;
+  }
+  return r;
+}
+
+std::vector<int> ShmRegion::handles() const { return {}; }
+
+} // namespace wininspectd
+#endif
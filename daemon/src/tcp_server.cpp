@@ -4,22 +4,26 @@
 #include "wininspect/base64.hpp"
 #include "tcp_server.hpp"
 #include "control_manager.hpp"
+#include "io_service.hpp"
+#include "request_connection.hpp"
+#include "request_handler.hpp"
+#include "transport.hpp"
 #include "wininspect/core.hpp"
 #include "wininspect/logger.hpp"
+#include "wininspect/authorized_keys.hpp"
+#include "wininspect/compress.hpp"
 #include "wininspect/crypto.hpp"
+#include "wininspect/session_ticket.hpp"
 
-#ifdef _WIN32
+#include <cstring>
 #include <iostream>
 #include <sstream>
 #include <thread>
 #include <vector>
-#include <windows.h>
-#include <winsock2.h>
-#include <ws2tcpip.h>
 #include <fstream>
-#include <bcrypt.h>
 #include <future>
 #include <memory>
+#include <mutex>
 #include <set>
 
 using namespace wininspect;
@@ -35,521 +39,460 @@ static std::optional<double> get_num(const json::Object &o, const std::string &k
 
 namespace wininspectd {
 
-// ── Winsock Init ────────────────────────────────────────────────────────────
-
-static struct WsaInit {
-  WsaInit() {
-    WSADATA wsd;
-    ok = (WSAStartup(MAKEWORD(2, 2), &wsd) == 0);
+// ── Control awareness ───────────────────────────────────────────────────────
+
+// control.* is answered here rather than by the core; false for any other method.
+static bool handle_control(const wininspect::CoreRequest &req, wininspect::CoreResponse &resp) {
+  static auto s_control = std::make_unique<wininspectd::ControlManager>();
+  if (req.method == "control.take") {
+    auto who_s = get_str(req.params, "controller").value_or("human");
+    auto who = wininspect::controller_type_from_str(who_s);
+    auto id = get_str(req.params, "id").value_or("");
+    auto ok = s_control->take_control(who, id);
+    if (!ok) { resp.ok = false; resp.error_code = "E_CONTROL_DENIED"; resp.error_message = "cannot take control"; return true; }
+    wininspect::json::Object o; o["controller"] = who_s; o["ok"] = ok;
+    resp.ok = true; resp.result = o; return true;
   }
-  ~WsaInit() { if (ok) WSACleanup(); }
-  bool ok = false;
-} wsa_init;
-
-// ── Socket Helpers ──────────────────────────────────────────────────────────
-
-static bool socket_read_all(SOCKET s, void *buf, uint32_t len) {
-  char *p = (char *)buf;
-  while (len > 0) {
-    int r = recv(s, p, (int)len, 0);
-    if (r <= 0) return false;
-    p += r; len -= r;
+  if (req.method == "control.release") {
+    auto who_s = get_str(req.params, "controller").value_or("human");
+    auto who = wininspect::controller_type_from_str(who_s);
+    auto id = get_str(req.params, "id").value_or("");
+    s_control->release_control(who, id);
+    wininspect::json::Object o; o["ok"] = true; resp.ok = true; resp.result = o; return true;
   }
-  return true;
-}
-
-static bool socket_write_all(SOCKET s, const void *buf, uint32_t len) {
-  const char *p = (const char *)buf;
-  while (len > 0) {
-    int r = send(s, p, (int)len, 0);
-    if (r <= 0) return false;
-    p += r; len -= r;
+  if (req.method == "control.status") { resp.ok = true; resp.result = s_control->get_status(); return true; }
+  if (req.method == "control.setMode") {
+    auto mode = get_str(req.params, "mode").value_or("hybrid");
+    s_control->set_operation_mode(mode);
+    wininspect::json::Object o; o["mode"] = mode; o["ok"] = true; resp.ok = true; resp.result = o; return true;
+  }
+  if (req.method == "control.auditLog") {
+    auto max = (size_t)get_num(req.params, "max").value_or(100);
+    resp.ok = true; resp.result = s_control->get_audit_log(max); return true;
   }
-  return true;
+  return false;
 }
 
-static bool encrypted_send(SOCKET s, const std::string &plaintext,
-                           crypto::CryptoSession &cs) {
-  auto ct = cs.encrypt(plaintext);
-  if (ct.empty()) return false;
-  uint32_t flen = (uint32_t)ct.size();
-  return socket_write_all(s, &flen, 4) &&
-         socket_write_all(s, ct.data(), flen);
-}
+// ── Client Connection ───────────────────────────────────────────────────────
 
-static bool encrypted_recv(SOCKET s, std::string &plaintext,
-                           crypto::CryptoSession &cs) {
-  uint32_t flen = 0;
-  if (!socket_read_all(s, &flen, 4)) return false;
-  if (flen == 0 || flen > 10 * 1024 * 1024) return false;
-  std::vector<uint8_t> ct(flen);
-  if (!socket_read_all(s, ct.data(), flen)) return false;
-  plaintext = cs.decrypt(ct);
-  return !plaintext.empty();
-}
+namespace {
 
-struct AuthContext {
-  const std::string &keys_data;
-  std::string identity;
-  std::string sig_b64;
-  std::vector<uint8_t> nonce;
-};
+constexpr std::int64_t HANDSHAKE_TIMEOUT_MS = 5000;
+constexpr std::int64_t IDLE_TIMEOUT_MS = 30 * 60 * 1000;
 
-static bool verify_identity(const AuthContext &ctx) {
-  std::istringstream f(ctx.keys_data);
-  std::string line;
-  while (std::getline(f, line)) {
-    if (line.empty() || line[0] == '#') continue;
-    if (line.find(ctx.identity) != std::string::npos) {
-      return crypto::verify_ssh_sig(ctx.nonce, ctx.sig_b64, line);
-    }
-  }
-  return false;
+std::int64_t now_ms() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
-// ── Client Handler ──────────────────────────────────────────────────────────
-
-static void handle_socket_client(SOCKET s, wininspect::ServerState *st,
-                                  wininspect::IBackend *backend,
-                                  std::string auth_keys, bool read_only,
-                                  bool admin_logs, bool no_clipboard,
-                                  wininspect::InstanceIdentity identity) {
-  wininspect::CoreEngine core(backend);
-  core.set_admin_logs_enabled(admin_logs);
-
-  DWORD timeout = 5000;
-  setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, (const char *)&timeout, sizeof(timeout));
-
-  crypto::CryptoSession crypto;
-  auto server_pubkey = crypto.generate_local_key();
-  std::vector<uint8_t> nonce;
-
-  // 1. Hello/Challenge with identity + ECDH
-  json::Object challenge;
-  challenge["type"] = "hello";
-  challenge["version"] = std::string(PROTOCOL_VERSION);
-  challenge["uuid"] = identity.uuid;
-  challenge["name"] = identity.name;
-  challenge["hostname"] = identity.hostname;
-  if (!identity.ecdh_pubkey.empty())
-    challenge["server_pubkey"] = identity.ecdh_pubkey;
-
-  if (!auth_keys.empty()) {
-    nonce.resize(32);
-    BCryptGenRandom(nullptr, nonce.data(), (ULONG)nonce.size(),
-                    BCRYPT_USE_SYSTEM_PREFERRED_RNG);
-    challenge["nonce"] = base64::encode(nonce);
-    if (!server_pubkey.empty())
-      challenge["pubkey"] = base64::encode(server_pubkey);
+} // namespace
+
+// Hello on accept, then (with authorized keys) one auth frame, then
+// requests, decrypted as they arrive once ECDH has set up a key.
+class TcpConnection final : public RequestConnection {
+public:
+  TcpConnection(std::unique_ptr<IConnection> conn, IoService *io,
+                wininspect::ServerState *st, wininspect::CoreEngine *core,
+                wininspect::IBackend *backend, const TcpServer::Options *opts)
+      : RequestConnection(std::move(conn), io, st), core_(core), backend_(backend),
+        opts_(opts), crypto_(crypto::Role::Server),
+        deadline_(now_ms() + HANDSHAKE_TIMEOUT_MS) {}
+
+  ~TcpConnection() override {
+    connection().shutdown();
+    session_.stream.reset(); // they call our send()
+    session_.file_stream.reset();
   }
 
-  std::string cj = json::dumps(challenge);
-  uint32_t clen = (uint32_t)cj.size();
-  if (!socket_write_all(s, &clen, 4) || !socket_write_all(s, cj.data(), clen)) {
-    closesocket(s); return;
+  /// Sends the hello/challenge. False if the connection should be dropped.
+  bool greet(const wininspect::InstanceIdentity &identity) {
+    auto server_pubkey = crypto_.generate_local_key();
+
+    json::Object challenge;
+    challenge["type"] = "hello";
+    challenge["version"] = std::string(PROTOCOL_VERSION);
+    challenge["uuid"] = identity.uuid;
+    challenge["name"] = identity.name;
+    challenge["hostname"] = identity.hostname;
+    if (!identity.ecdh_pubkey.empty())
+      challenge["server_pubkey"] = identity.ecdh_pubkey;
+
+    if (opts_->auth_keys) {
+      // The client picks a codec in its reply; without keys there is none.
+      if (opts_->compress_min > 0) {
+        json::Array codecs;
+        for (auto &c : compress::available()) codecs.push_back(c);
+        challenge["compression"] = codecs;
+      }
+      nonce_.resize(32);
+      if (!crypto::random_bytes(nonce_.data(), nonce_.size())) return false;
+      challenge["nonce"] = base64::encode(nonce_);
+      if (!server_pubkey.empty())
+        challenge["pubkey"] = base64::encode(server_pubkey);
+    } else {
+      open();
+    }
+    return write_frame(connection(), json::dumps(challenge));
   }
 
-  // 2. Auth + Key Exchange
-  if (!auth_keys.empty()) {
-    uint32_t rlen = 0;
-    if (!socket_read_all(s, &rlen, 4)) { closesocket(s); return; }
-    std::string resp_json;
-    resp_json.resize(rlen);
-    if (!socket_read_all(s, resp_json.data(), rlen)) { closesocket(s); return; }
+  bool overdue(std::int64_t now) const { return now > deadline_.load(); }
 
-    try {
-      auto v = json::parse(resp_json).as_obj();
-      if (v.at("version").as_str() != PROTOCOL_VERSION) { closesocket(s); return; }
-      AuthContext ctx{auth_keys, v.at("identity").as_str(), v.at("signature").as_str(), nonce};
-      if (!verify_identity(ctx)) { closesocket(s); return; }
-      auto it_pk = v.find("pubkey");
-      if (it_pk != v.end() && it_pk->second.is_str()) {
-        auto client_pk = base64::decode(it_pk->second.as_str());
-        if (!crypto.compute_shared_secret(client_pk))
-          LOG_DEBUG("ECDH shared secret computation failed");
+protected:
+  bool decode(std::string &frame, std::uint32_t flags) override {
+    if (flags & FRAME_SHM) return false; // local connections only
+    if (encrypted_) {
+      {
+        std::lock_guard<std::mutex> lk(write_mu_); // crypto_ is shared with send()
+        if (!crypto_.open({(uint8_t *)frame.data(), frame.size()})) return false;
       }
-    } catch (...) { closesocket(s); return; }
-
-    json::Object status;
-    status["type"] = "auth_status";
-    status["ok"] = true;
-    std::string sj = json::dumps(status);
-    uint32_t slen = (uint32_t)sj.size();
-    if (!socket_write_all(s, &slen, 4) || !socket_write_all(s, sj.data(), slen)) {
-      closesocket(s); return;
+      frame.erase(0, crypto::RECORD_OVERHEAD);
+    }
+    if (flags & FRAME_COMPRESSED) {
+      if (codec_ == compress::Codec::None) return false;
+      std::string raw = BufferPool::take();
+      bool ok = compress::unpack(frame.data(), frame.size(), MAX_FRAME_BYTES, raw);
+      if (ok) frame.swap(raw);
+      BufferPool::give(std::move(raw));
+      if (!ok) return false;
     }
+    return !frame.empty();
   }
 
-  DWORD idle_timeout = 30 * 60 * 1000;
-  setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, (const char *)&idle_timeout, sizeof(idle_timeout));
+  Plan plan(const std::string &frame) const override {
+    if (!open_) return {true, false}; // the handshake reply
+    return RequestConnection::plan(frame);
+  }
 
-  bool encrypted = crypto.is_initialized();
+  // Encrypted responses that complete while another is being written
+  // queue in outbox_; the next writer seals the whole queue in one pass
+  // into one pooled buffer and sends it with one write.
+  bool send(const std::string &frame, std::uint32_t flags = 0) override {
+    if (!encrypted_) {
+      std::lock_guard<std::mutex> lk(write_mu_);
+      std::string packed = BufferPool::take();
+      bool ok = pack(frame, packed) ? write_frame(connection(), packed.data(), packed.size(),
+                                                  flags | FRAME_COMPRESSED)
+                                    : write_frame(connection(), frame.data(), frame.size(), flags);
+      BufferPool::give(std::move(packed));
+      return ok;
+    }
+    std::unique_lock<std::mutex> lk(write_mu_, std::try_to_lock);
+    if (lk.owns_lock()) return flush_sealed(&frame, flags);
+    {
+      std::lock_guard<std::mutex> q(out_mu_);
+      outbox_.push_back({frame, flags});
+    }
+    lk.lock();
+    return flush_sealed(nullptr, 0); // often a no-op: the holder took ours
+  }
 
-  while (true) {
-    std::string json_req;
-    if (encrypted) { if (!encrypted_recv(s, json_req, crypto)) break; }
-    else {
-      uint32_t len = 0;
-      if (!socket_read_all(s, &len, 4)) break;
-      if (len == 0 || len > 10 * 1024 * 1024) break;
-      json_req.resize(len);
-      if (!socket_read_all(s, json_req.data(), len)) break;
+  void handle_frame(std::string frame, std::vector<Attachment> attachments) override {
+    if (!open_) {
+      if (!authenticate(frame)) connection().shutdown();
+      return;
     }
+    deadline_ = now_ms() + IDLE_TIMEOUT_MS;
 
     wininspect::CoreResponse resp;
-    bool canonical = false;
-    std::string pinned_sid;
-    wininspect::ClientSession session;
-
     try {
-      auto req = wininspect::parse_request_json(json_req);
+      auto req = wininspect::parse_request_json(frame);
       resp.id = req.id;
-
-      auto itsid = req.params.find("session_id");
-      if (itsid != req.params.end() && itsid->second.is_str()) {
-        std::string sid_str = itsid->second.as_str();
-        std::lock_guard<std::mutex> lk(st->snapshots_mu);
-        if (st->sessions.size() >= st->max_sessions && !st->sessions.count(sid_str)) {
-          resp.ok = false; resp.error_code = "E_TOO_MANY_SESSIONS";
-          resp.error_message = "session limit reached"; goto send_resp;
-        }
-        if (st->sessions.count(sid_str)) {
-          auto &ps = st->sessions[sid_str];
-          session.id = SessionID(sid_str);
-          session.last_snap_id = ps.last_snap_id;
-          session.subscribed = ps.subscribed;
-          ps.last_activity = std::chrono::steady_clock::now();
-        } else {
-          session.id = SessionID(sid_str);
-          st->sessions[sid_str] = {"", false, std::chrono::steady_clock::now()};
-        }
+      if (handle_control(req, resp)) {
+        (void)send(serialize_response_json(resp, false));
+        return;
       }
+    } catch (...) {
+      resp.ok = false; resp.error_code = "E_BAD_REQUEST";
+      (void)send(serialize_response_json(resp, false));
+      return;
+    }
+    serve(frame, std::move(attachments), *core_, backend_, opts_->read_only, opts_->no_clipboard,
+          opts_->auth_keys != nullptr, std::string());
+    deadline_ = now_ms() + IDLE_TIMEOUT_MS;
+  }
 
-      if (req.method == "events.subscribe") {
-        Snapshot snap_base = backend->capture_snapshot();
-        std::string sid;
-        {
-          std::lock_guard<std::mutex> lk(st->snapshots_mu);
-          sid = "s-" + std::to_string(st->snap_counter++);
-          st->snaps.emplace(sid, std::make_shared<Snapshot>(std::move(snap_base)));
-          st->lru_order.push_back(sid);
-          session.subscribed = true; session.last_snap_id = sid;
-          if (!session.id.empty()) {
-            st->sessions[session.id.val].subscribed = true;
-            st->sessions[session.id.val].last_snap_id = sid;
-          }
-        }
-        json::Object o; o["subscribed"] = true; o["snapshot_id"] = sid;
-        resp.ok = true; resp.result = o; goto send_resp;
-      }
+private:
+  struct Outgoing {
+    std::string frame;
+    std::uint32_t flags; // FRAME_MULTIPART or 0
+  };
+
+  // Appends `frame` packed with the agreed codec to `out`, when there is
+  // one, the frame is big enough and packing shrinks it.
+  bool pack(const std::string &frame, std::string &out) const {
+    return codec_ != compress::Codec::None && frame.size() >= opts_->compress_min &&
+           compress::pack(codec_, frame.data(), frame.size(), out);
+  }
 
-      if (req.method == "events.unsubscribe") {
-        session.subscribed = false; session.last_snap_id.clear();
-        if (!session.id.empty()) {
-          std::lock_guard<std::mutex> lk(st->snapshots_mu);
-          if (st->sessions.count(session.id.val)) {
-            st->sessions[session.id.val].subscribed = false;
-            st->sessions[session.id.val].last_snap_id.clear();
-          }
-        }
-        json::Object o; o["unsubscribed"] = true;
-        resp.ok = true; resp.result = o; goto send_resp;
-      }
+  // write_mu_ held. `first` (if any) goes ahead of the queued frames.
+  // Frames are compressed before they are sealed.
+  bool flush_sealed(const std::string *first, std::uint32_t first_flags) {
+    std::vector<Outgoing> queued;
+    {
+      std::lock_guard<std::mutex> q(out_mu_);
+      queued.swap(outbox_);
+    }
+    struct Piece {
+      const std::string *frame; // null: packed[off, off + size)
+      size_t off, size;
+      std::uint32_t flags;
+    };
+    thread_local std::vector<Piece> pieces;
+    thread_local std::vector<crypto::SealJob> jobs;
+    pieces.clear();
+    jobs.clear();
+    std::string packed = BufferPool::take();
+    auto add = [&](const std::string &f, std::uint32_t flags) {
+      size_t off = packed.size();
+      if (pack(f, packed))
+        pieces.push_back({nullptr, off, packed.size() - off, flags | FRAME_COMPRESSED});
+      else
+        pieces.push_back({&f, 0, f.size(), flags});
+    };
+    if (first) add(*first, first_flags);
+    for (auto &o : queued) add(o.frame, o.flags);
+    if (pieces.empty()) {
+      BufferPool::give(std::move(packed));
+      return !write_failed_;
+    }
 
-      // ── Control awareness ──────────────────────────────────────────
-      static auto s_control = std::make_unique<wininspectd::ControlManager>();
-      if (req.method == "control.take") {
-        auto who_s = get_str(req.params, "controller").value_or("human");
-        auto who = wininspect::controller_type_from_str(who_s);
-        auto id = get_str(req.params, "id").value_or("");
-        auto ok = s_control->take_control(who, id);
-        if (!ok) { resp.ok = false; resp.error_code = "E_CONTROL_DENIED"; resp.error_message = "cannot take control"; goto send_resp; }
-        wininspect::json::Object o; o["controller"] = who_s; o["ok"] = ok;
-        resp.ok = true; resp.result = o; goto send_resp;
-      }
-      if (req.method == "control.release") {
-        auto who_s = get_str(req.params, "controller").value_or("human");
-        auto who = wininspect::controller_type_from_str(who_s);
-        auto id = get_str(req.params, "id").value_or("");
-        s_control->release_control(who, id);
-        wininspect::json::Object o; o["ok"] = true; resp.ok = true; resp.result = o; goto send_resp;
-      }
-      if (req.method == "control.status") { resp.ok = true; resp.result = s_control->get_status(); goto send_resp; }
-      if (req.method == "control.setMode") {
-        auto mode = get_str(req.params, "mode").value_or("hybrid");
-        s_control->set_operation_mode(mode);
-        wininspect::json::Object o; o["mode"] = mode; o["ok"] = true; resp.ok = true; resp.result = o; goto send_resp;
-      }
-      if (req.method == "control.auditLog") {
-        auto max = (size_t)get_num(req.params, "max").value_or(100);
-        resp.ok = true; resp.result = s_control->get_audit_log(max); goto send_resp;
-      }
+    size_t total = 0;
+    for (auto &pc : pieces) total += sizeof(std::uint32_t) + crypto::RECORD_OVERHEAD + pc.size;
+    std::string buf = BufferPool::take();
+    buf.resize(total);
+    auto *p = (std::uint8_t *)buf.data();
+    for (auto &pc : pieces) {
+      std::uint32_t len = (std::uint32_t)(crypto::RECORD_OVERHEAD + pc.size);
+      std::uint32_t word = len | pc.flags;
+      std::memcpy(p, &word, sizeof(word));
+      p += sizeof(word);
+      auto *src = (const std::uint8_t *)(pc.frame ? pc.frame->data() : packed.data() + pc.off);
+      jobs.push_back({{src, pc.size}, {p, len}});
+      p += len;
+    }
+    bool ok = crypto_.seal_batch(jobs) && connection().write_all(buf.data(), buf.size());
+    BufferPool::give(std::move(buf));
+    BufferPool::give(std::move(packed));
+    if (!ok) write_failed_ = true;
+    return !write_failed_;
+  }
 
-      if (req.method == "clipboard.read" && no_clipboard) {
-        resp.ok = false; resp.error_code = "E_ACCESS_DENIED";
-        resp.error_message = "clipboard access disabled"; goto send_resp;
-      }
-      if (req.method == "clipboard.write" && no_clipboard) {
-        resp.ok = false; resp.error_code = "E_ACCESS_DENIED";
-        resp.error_message = "clipboard access disabled"; goto send_resp;
-      }
+  // The handshake above is the authentication step for TCP, so the session
+  // (and its subscription state) lives for the whole connection.
+  void open() {
+    open_ = true;
+    session_.authenticated = true;
+    deadline_ = now_ms() + IDLE_TIMEOUT_MS;
+  }
 
-      if (!st->allow_methods.empty() && !st->allow_methods.count(req.method)) {
-        resp.ok = false; resp.error_code = "E_ACCESS_DENIED";
-        resp.error_message = "method not in allow list"; goto send_resp;
-      }
-      if (st->deny_methods.count(req.method)) {
-        resp.ok = false; resp.error_code = "E_ACCESS_DENIED";
-        resp.error_message = "method is denied"; goto send_resp;
+  bool authenticate(const std::string &resp_json) {
+    try {
+      auto v = json::parse(resp_json).as_obj();
+      if (v.at("version").as_str() != PROTOCOL_VERSION) return false;
+      if (v.count("resume")) return resume(v);
+      auto identity = v.at("identity").as_str();
+      if (!opts_->auth_keys->current()->verify(identity, nonce_, v.at("signature").as_str()))
+        return false;
+      identity_ = identity;
+      choose_codec(v);
+      auto it_pk = v.find("pubkey");
+      if (it_pk != v.end() && it_pk->second.is_str()) {
+        auto client_pk = base64::decode(it_pk->second.as_str());
+        if (!crypto_.compute_shared_secret(client_pk))
+          LOG_DEBUG("ECDH shared secret computation failed");
       }
+    } catch (...) { return false; }
+    return accept_auth(false);
+  }
 
-      if (read_only &&
-          (req.method == "window.postMessage" || req.method == "input.send" ||
-           req.method.find("reg.write") != std::string::npos)) {
-        resp.ok = false; resp.error_code = "E_ACCESS_DENIED";
-        resp.error_message = "read-only mode"; goto send_resp;
-      }
+  // A ticket stands in for the signature and the ECDH: the new key comes
+  // from its secret, our nonce and the client's random. One try per
+  // connection; a refused ticket leaves the client to send the full reply.
+  bool resume(const json::Object &v) {
+    if (resume_tried_) return false;
+    resume_tried_ = true;
+    std::optional<wininspect::TicketClaims> claims;
+    auto ticket = get_str(v, "resume");
+    if (opts_->tickets && ticket) claims = opts_->tickets->redeem(*ticket);
+    auto client_random = base64::decode(get_str(v, "client_random").value_or(""));
+    std::uint8_t key[32];
+    bool ok = claims && !opts_->auth_keys->current()->find(claims->identity).empty() &&
+              wininspect::TicketKeeper::derive_key(claims->secret, nonce_, client_random, key) &&
+              crypto_.install_key(key);
+    std::memset(key, 0, sizeof(key));
+    if (!ok) {
+      json::Object status;
+      status["type"] = "auth_status";
+      status["ok"] = false;
+      status["error"] = std::string("E_RESUME_REJECTED");
+      return write_frame(connection(), json::dumps(status));
+    }
+    identity_ = claims->identity;
+    choose_codec(v);
+    return accept_auth(true);
+  }
+
+  // The codec named in the client's handshake reply, if we offered it.
+  void choose_codec(const json::Object &v) {
+    auto name = get_str(v, "compression");
+    if (name && opts_->compress_min > 0) codec_ = compress::codec_from_name(*name);
+  }
 
-      auto itc = req.params.find("canonical");
-      if (itc != req.params.end() && itc->second.is_bool())
-        canonical = itc->second.as_bool();
-
-      if (req.method == "snapshot.capture") {
-        Snapshot s = backend->capture_snapshot();
-        std::string sid;
-        {
-          std::lock_guard<std::mutex> lk(st->snapshots_mu);
-          sid = "s-" + std::to_string(st->snap_counter++);
-          st->snaps.emplace(sid, std::make_shared<Snapshot>(std::move(s)));
-          st->lru_order.push_back(sid);
-          while (st->lru_order.size() > st->max_snapshots) {
-            std::string oldest = st->lru_order.front();
-            if (st->pinned_counts[oldest] > 0) { st->lru_order.pop_front(); st->lru_order.push_back(oldest); continue; }
-            st->lru_order.pop_front(); st->snaps.erase(oldest); st->pinned_counts.erase(oldest);
-          }
-        }
-        json::Object o; o["snapshot_id"] = sid;
-        resp.ok = true; resp.result = o;
-      } else {
-        Snapshot snap;
-        const Snapshot *old_ptr = nullptr;
-        Snapshot old_storage;
-        auto its = req.params.find("snapshot_id");
-        if (its != req.params.end() && its->second.is_str()) {
-          std::string sid = its->second.as_str();
-          std::lock_guard<std::mutex> lk(st->snapshots_mu);
-          auto it = st->snaps.find(sid);
-          if (it == st->snaps.end()) {
-            resp.ok = false; resp.error_code = "E_BAD_SNAPSHOT";
-            resp.error_message = "unknown snapshot"; goto send_resp;
-          }
-          snap = *it->second; pinned_sid = sid; st->pinned_counts[sid]++;
-        } else {
-          snap = backend->capture_snapshot();
-        }
-        auto itos = req.params.find("old_snapshot_id");
-        if (itos != req.params.end() && itos->second.is_str()) {
-          std::string osid = itos->second.as_str();
-          std::lock_guard<std::mutex> lk(st->snapshots_mu);
-          auto it = st->snaps.find(osid);
-          if (it != st->snaps.end()) { old_storage = *it->second; old_ptr = &old_storage; }
-        } else if (req.method == "events.poll" && !session.last_snap_id.empty()) {
-          std::lock_guard<std::mutex> lk(st->snapshots_mu);
-          auto it = st->snaps.find(session.last_snap_id);
-          if (it != st->snaps.end()) { old_storage = *it->second; old_ptr = &old_storage; }
-        }
-        auto future = std::async(std::launch::async, [&core, req, snap, old_ptr]() {
-          return core.handle(req, snap, old_ptr);
-        });
-        if (future.wait_for(std::chrono::milliseconds(st->request_timeout_ms)) == std::future_status::timeout) {
-          resp.ok = false; resp.error_code = "E_TIMEOUT";
-        } else { resp = future.get(); }
-        if (req.method == "events.poll" && resp.ok) {
-          Snapshot fresh = backend->capture_snapshot();
-          std::string sid;
-          { std::lock_guard<std::mutex> lk(st->snapshots_mu);
-            sid = "s-" + std::to_string(st->snap_counter++);
-            st->snaps.emplace(sid, std::make_shared<Snapshot>(std::move(fresh)));
-            st->lru_order.push_back(sid); session.last_snap_id = sid;
-            if (!session.id.empty()) st->sessions[session.id.val].last_snap_id = sid;
-          }
-        }
+  // Sends auth_status, with a ticket for next time once traffic is
+  // encrypted, and switches to the request phase.
+  bool accept_auth(bool resumed) {
+    json::Object status;
+    status["type"] = "auth_status";
+    status["ok"] = true;
+    status["encrypted"] = crypto_.is_initialized();
+    if (resumed) status["resumed"] = true;
+    if (codec_ != compress::Codec::None)
+      status["compression"] = std::string(compress::codec_name(codec_));
+    if (opts_->tickets && crypto_.is_initialized()) {
+      auto ticket = opts_->tickets->issue(identity_, crypto_.resumption_secret());
+      if (!ticket.empty()) {
+        status["ticket"] = ticket;
+        status["ticket_lifetime_ms"] = (double)opts_->tickets->lifetime().count();
       }
-    } catch (...) { resp.ok = false; resp.error_code = "E_BAD_REQUEST"; }
-
-  send_resp:
-    std::string out = serialize_response_json(resp, canonical);
-    if (encrypted) { encrypted_send(s, out, crypto); }
-    else {
-      uint32_t out_len = (uint32_t)out.size();
-      socket_write_all(s, &out_len, 4); socket_write_all(s, out.data(), out_len);
-    }
-    if (!pinned_sid.empty()) {
-      std::lock_guard<std::mutex> lk(st->snapshots_mu);
-      st->pinned_counts[pinned_sid]--;
     }
+    if (!write_frame(connection(), json::dumps(status))) return false;
+    encrypted_ = crypto_.is_initialized();
+    open();
+    return true;
   }
-  closesocket(s);
-}
+
+  wininspect::CoreEngine *core_;
+  wininspect::IBackend *backend_;
+  const TcpServer::Options *opts_;
+  crypto::CryptoSession crypto_;
+  std::mutex out_mu_;
+  std::vector<Outgoing> outbox_; // sealed by the next flush_sealed
+  bool write_failed_ = false;    // under write_mu_
+  std::vector<uint8_t> nonce_;
+  std::string identity_;     // authenticated key comment
+  // Chosen during the handshake, before any request frame can arrive.
+  compress::Codec codec_ = compress::Codec::None;
+  bool resume_tried_ = false; // the handshake is ordered; no lock needed
+  std::atomic<std::int64_t> deadline_;
+  std::atomic<bool> open_{false}; // handshake done; plan() reads it on the I/O thread
+  std::atomic<bool> encrypted_{false};
+};
 
 // ── TcpServer Implementation ────────────────────────────────────────────────
 
 TcpServer::TcpServer(wininspect::ServerState *state,
                      wininspect::IBackend *backend)
-    : state_(state), backend_(backend) {}
+    : state_(state), backend_(backend),
+      core_(std::make_unique<wininspect::CoreEngine>(backend)) {}
 
-TcpServer::~TcpServer() { stop(); }
+TcpServer::~TcpServer() {
+  stop();
+  if (own_io_) own_io_->stop(); // connections use core_ and opts_
+}
 
 void TcpServer::stop() {
-  for (auto sock : listen_socks_) {
-    if (sock != 0)
-      closesocket((SOCKET)sock);
+  std::lock_guard<std::mutex> lk(listen_mu_);
+  stopped_ = true;
+  for (auto *l : listeners_) l->close();
+}
+
+// Handshake and idle timeouts: connections past their deadline are shut
+// down, which the I/O loop then sees as a close.
+void TcpServer::sweep() {
+  std::lock_guard<std::mutex> lk(conns_mu_);
+  auto now = now_ms();
+  if (now - last_sweep_ms_ < 1000) return;
+  last_sweep_ms_ = now;
+  std::erase_if(conns_, [&](const std::weak_ptr<TcpConnection> &w) {
+    auto c = w.lock();
+    if (!c) return true;
+    if (c->overdue(now)) {
+      LOG_DEBUG("TCP connection timed out: " + c->connection().peer());
+      c->connection().shutdown();
+    }
+    return false;
+  });
+}
+
+void TcpServer::accept_loop(IListener &l, std::atomic<bool> *running,
+                            const wininspect::NetworkConfig &cfg, IoService *io) {
+  while (running->load()) {
+    sweep();
+    auto client = l.accept(100);
+    if (!client) {
+      std::lock_guard<std::mutex> lk(listen_mu_);
+      if (stopped_) break;
+      continue;
+    }
+
+    // Rate limiting
+    if (cfg.rate_limit_ms > 0) {
+      std::lock_guard<std::mutex> lk(state_->ip_rate_mu);
+      auto now = std::chrono::steady_clock::now();
+      auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+          now - state_->last_accept_time).count();
+      if (elapsed < cfg.rate_limit_ms) continue;
+      state_->last_accept_time = now;
+    }
+
+    LOG_DEBUG("TCP connection from " + client->peer());
+    auto c = std::make_shared<TcpConnection>(std::move(client), io, state_, core_.get(),
+                                             backend_, &opts_);
+    if (!c->greet(backend_->get_instance_identity())) continue;
+    {
+      std::lock_guard<std::mutex> lk(conns_mu_);
+      conns_.push_back(c);
+    }
+    io->add(std::move(c));
   }
-  listen_socks_.clear();
 }
 
 void TcpServer::start(std::atomic<bool> *running,
                        const wininspect::NetworkConfig &cfg,
-                       const std::string &auth_keys,
+                       std::shared_ptr<wininspect::AuthorizedKeysFile> auth_keys,
                        bool read_only, bool admin_logs,
                        bool no_clipboard) {
-  if (!wsa_init.ok) {
-    LOG_ERROR("TCP Server: Winsock not initialized.");
-    return;
-  }
-
   if (cfg.bind.empty()) {
     LOG_ERROR("TCP Server: No bind addresses configured.");
     return;
   }
-
-  std::string port_str = std::to_string(cfg.port);
-  std::vector<SOCKET> socks;
-
-  for (auto &ba : cfg.bind) {
-    struct addrinfo hints = {};
-    hints.ai_family = ba.family;
-    hints.ai_socktype = SOCK_STREAM;
-    hints.ai_protocol = IPPROTO_TCP;
-    hints.ai_flags = AI_PASSIVE;
-
-    struct addrinfo *result = nullptr;
-    int rc = getaddrinfo(ba.address.c_str(), port_str.c_str(), &hints, &result);
-    if (rc != 0) {
-      LOG_WARN("TCP Server: getaddrinfo failed for " + ba.address +
-               ": " + std::to_string(rc));
-      continue;
-    }
-
-    for (auto *rp = result; rp; rp = rp->ai_next) {
-      SOCKET s = socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol);
-      if (s == INVALID_SOCKET) {
-        LOG_WARN("TCP Server: socket() failed for " + ba.address +
-                 ": " + std::to_string(WSAGetLastError()));
-        continue;
-      }
-
-      // Dual-stack: disable IPV6_V6ONLY so AF_INET6 handles both v4 and v6
-      if (rp->ai_family == AF_INET6 && ba.family == AF_UNSPEC) {
-        int off = 0;
-        setsockopt(s, IPPROTO_IPV6, IPV6_V6ONLY, (const char *)&off, sizeof(off));
-      }
-
-      // Enable address reuse for quick restarts
-      int on = 1;
-      setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (const char *)&on, sizeof(on));
-
-      if (bind(s, rp->ai_addr, (int)rp->ai_addrlen) == SOCKET_ERROR) {
-        LOG_ERROR("TCP Server: bind failed on " + ba.address + ":" + port_str +
-                  " — " + std::to_string(WSAGetLastError()));
-        closesocket(s);
-        continue;
-      }
-
-      if (listen(s, SOMAXCONN) == SOCKET_ERROR) {
-        LOG_ERROR("TCP Server: listen failed on " + ba.address +
-                  ": " + std::to_string(WSAGetLastError()));
-        closesocket(s);
-        continue;
-      }
-
-      // Get the actual bound address for logging
-      struct sockaddr_storage bound_addr;
-      socklen_t bound_len = sizeof(bound_addr);
-      char addr_str[64] = {};
-      if (getsockname(s, (struct sockaddr *)&bound_addr, &bound_len) == 0) {
-        if (bound_addr.ss_family == AF_INET) {
-          auto *sin = (struct sockaddr_in *)&bound_addr;
-          inet_ntop(AF_INET, &sin->sin_addr, addr_str, sizeof(addr_str));
-        } else if (bound_addr.ss_family == AF_INET6) {
-          auto *sin6 = (struct sockaddr_in6 *)&bound_addr;
-          inet_ntop(AF_INET6, &sin6->sin6_addr, addr_str, sizeof(addr_str));
-        }
-      }
-
-      LOG_INFO("TCP Server listening on [" + std::string(addr_str) + "]:" + port_str);
-      socks.push_back(s);
-    }
-    freeaddrinfo(result);
+  core_->set_admin_logs_enabled(admin_logs);
+  opts_ = Options{std::move(auth_keys), read_only, no_clipboard};
+  opts_.compress_min = state_->compress_min_bytes;
+  if (opts_.auth_keys && state_->ticket_lifetime_s > 0) {
+    tickets_ = std::make_unique<wininspect::TicketKeeper>(
+        std::chrono::seconds(state_->ticket_lifetime_s));
+    opts_.tickets = tickets_.get();
   }
+  IoService *io = state_->io.get();
+  if (!io) io = (own_io_ = std::make_unique<IoService>()).get();
 
-  if (socks.empty()) {
+  auto listeners = listen_tcp(cfg.bind, cfg.port);
+  if (listeners.empty()) {
     LOG_ERROR("TCP Server: No sockets could be bound.");
     return;
   }
-
-  // Store for stop()
-  for (auto s : socks)
-    listen_socks_.push_back((uintptr_t)s);
-
-  // Accept loop — use select() on all listening sockets
-  fd_set read_fds;
-  while (running->load()) {
-    FD_ZERO(&read_fds);
-    SOCKET max_fd = 0;
-    for (auto s : socks) {
-      FD_SET(s, &read_fds);
-      if (s > max_fd) max_fd = s;
+  {
+    std::lock_guard<std::mutex> lk(listen_mu_);
+    if (stopped_) return;
+    for (auto &l : listeners) {
+      LOG_INFO("TCP Server listening on " + l->address());
+      listeners_.push_back(l.get());
     }
+  }
+  bound_port_ = listeners.front()->port();
 
-    struct timeval tv = {0, 100000}; // 100ms timeout
-    int sel_rc = select((int)max_fd + 1, &read_fds, nullptr, nullptr, &tv);
-    if (sel_rc == SOCKET_ERROR) break;
-    if (sel_rc == 0) continue; // timeout, loop
-
-    for (auto s : socks) {
-      if (!FD_ISSET(s, &read_fds)) continue;
-
-      SOCKET client = accept(s, nullptr, nullptr);
-      if (client == INVALID_SOCKET) continue;
-
-      u_long mode = 0;
-      ioctlsocket(client, FIONBIO, &mode);
-
-      // Rate limiting
-      if (cfg.rate_limit_ms > 0) {
-        auto now = std::chrono::steady_clock::now();
-        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-            now - state_->last_accept_time).count();
-        if (elapsed < cfg.rate_limit_ms) { closesocket(client); continue; }
-        state_->last_accept_time = now;
-      }
-
-      {
-        std::lock_guard<std::mutex> lk(state_->thread_mu);
-        state_->client_threads.emplace_back(
-            [this, client, auth_keys, read_only, admin_logs, no_clipboard]() {
-              handle_socket_client(client, state_, backend_, auth_keys,
-                                   read_only, admin_logs, no_clipboard,
-                                   backend_->get_instance_identity());
-            });
-      }
-    }
+  // One accept loop per address; the first runs on the caller's thread.
+  std::vector<std::thread> extra;
+  for (size_t i = 1; i < listeners.size(); i++) {
+    extra.emplace_back([&, l = listeners[i].get()] { accept_loop(*l, running, cfg, io); });
   }
+  accept_loop(*listeners.front(), running, cfg, io);
+  stop();
+  for (auto &t : extra) t.join();
 
-  for (auto s : socks) closesocket(s);
-  listen_socks_.clear();
+  std::lock_guard<std::mutex> lk(listen_mu_);
+  listeners_.clear();
 }
 
 } // namespace wininspectd
-#endif
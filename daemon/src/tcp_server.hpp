@@ -3,21 +3,32 @@
 // Copyright (c) 2026 Mark E. DeYoung
 
 #include <atomic>
+#include <cstdint>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
-#ifdef _WIN32
-#include <winsock2.h>
-#endif
 #include "server_state.hpp"
 #include "wininspect/network_config.hpp"
 
 namespace wininspect {
+class AuthorizedKeysFile;
+class CoreEngine;
 class IBackend;
+class TicketKeeper;
 } // namespace wininspect
 
 namespace wininspectd {
 
+class IListener;
+class IoService;
+class TcpConnection;
+
+/// Remote clients: hello/challenge, optional key auth and ECDH (or a
+/// resumption ticket in their place), then (possibly encrypted)
+/// length-prefixed JSON. Connections are served by the state's IoService
+/// (or a private one).
 class TcpServer {
 public:
   TcpServer(wininspect::ServerState *state,
@@ -26,16 +37,41 @@ public:
 
   void start(std::atomic<bool> *running,
              const wininspect::NetworkConfig &cfg,
-             const std::string &auth_keys = "",
+             std::shared_ptr<wininspect::AuthorizedKeysFile> auth_keys = nullptr,
              bool read_only = false,
              bool admin_logs = false,
              bool no_clipboard = false);
+  /// Makes start() return; safe from any thread.
   void stop();
+  /// The first listener's port once start() has bound it, else 0.
+  int bound_port() const { return bound_port_.load(); }
+
+  struct Options {
+    std::shared_ptr<wininspect::AuthorizedKeysFile> auth_keys; // null: no auth
+    bool read_only = false;
+    bool no_clipboard = false;
+    wininspect::TicketKeeper *tickets = nullptr; // null: resumption off
+    size_t compress_min = 0; // smallest frame worth compressing; 0: off
+  };
 
 private:
+  void accept_loop(IListener &l, std::atomic<bool> *running,
+                   const wininspect::NetworkConfig &cfg, IoService *io);
+  void sweep();
+
   wininspect::ServerState *state_;
   wininspect::IBackend *backend_;
-  std::vector<uintptr_t> listen_socks_;
+  std::unique_ptr<wininspect::CoreEngine> core_; // shared by all connections
+  std::unique_ptr<IoService> own_io_;            // if the state has none
+  std::unique_ptr<wininspect::TicketKeeper> tickets_;
+  Options opts_;
+  std::mutex conns_mu_; // protects conns_, last_sweep_ms_
+  std::vector<std::weak_ptr<TcpConnection>> conns_;
+  std::int64_t last_sweep_ms_ = 0;
+  std::mutex listen_mu_;
+  std::vector<IListener *> listeners_; // owned by start()
+  bool stopped_ = false;
+  std::atomic<int> bound_port_{0};
 };
 
 } // namespace wininspectd
@@ -0,0 +1,96 @@
+#pragma once
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace wininspectd {
+
+/// Hierarchical timing wheel over integer ticks. schedule() is O(1);
+/// advance() visits one slot per tick and, each time a level's index wraps,
+/// redistributes one slot of the level above, so the cost of expiry is the
+/// number of entries that come due (plus one cascade per entry per level),
+/// not the number scheduled.
+///
+/// Entries cannot be cancelled. Owners whose deadlines move (heartbeats)
+/// keep one entry and, when it fires, check the real deadline and schedule
+/// again if it has not passed. Not thread-safe.
+template <typename T>
+class TimingWheel {
+public:
+  static constexpr int LEVELS = 4;
+  static constexpr int BITS = 6;
+  static constexpr std::uint64_t SLOTS = 1ull << BITS;
+  /// Deadlines further out than this are parked at the top and re-filed.
+  static constexpr std::uint64_t SPAN = 1ull << (BITS * LEVELS);
+
+  explicit TimingWheel(std::uint64_t now = 0) : now_(now) {}
+
+  /// Fires at the first advance() to reach `tick` (the next one if it has
+  /// already passed).
+  void schedule(std::uint64_t tick, T value) {
+    if (tick < now_) tick = now_;
+    place(tick, std::move(value));
+    size_++;
+  }
+
+  /// Runs every tick up to and including `now`, calling fire(T&&) for each
+  /// entry that came due, in deadline order across ticks.
+  template <typename F>
+  void advance(std::uint64_t now, F &&fire) {
+    while (now_ <= now) {
+      if (size_ == 0) { // nothing to visit on the way
+        now_ = now + 1;
+        break;
+      }
+      int top = 0;
+      while (top + 1 < LEVELS && (now_ & ((1ull << (BITS * (top + 1))) - 1)) == 0) top++;
+      for (int l = top; l >= 1; l--) cascade(l);
+
+      auto due = std::move(slots_[0][now_ & (SLOTS - 1)]);
+      slots_[0][now_ & (SLOTS - 1)].clear();
+      for (auto &e : due) {
+        if (e.first > now_) { // parked beyond SPAN
+          place(e.first, std::move(e.second));
+          continue;
+        }
+        size_--;
+        fire(std::move(e.second));
+      }
+      now_++;
+    }
+  }
+
+  /// The next tick advance() will process.
+  std::uint64_t now() const { return now_; }
+  size_t size() const { return size_; }
+
+private:
+  using Entry = std::pair<std::uint64_t, T>;
+
+  void place(std::uint64_t tick, T value) {
+    std::uint64_t delta = tick - now_;
+    int l = 0;
+    while (l + 1 < LEVELS && delta >= (1ull << (BITS * (l + 1)))) l++;
+    std::uint64_t at = delta < SPAN ? tick : now_ + SPAN - 1;
+    slots_[l][(at >> (BITS * l)) & (SLOTS - 1)].emplace_back(tick, std::move(value));
+  }
+
+  // Re-files this period's slot of level l into the levels below.
+  void cascade(int l) {
+    auto &slot = slots_[l][(now_ >> (BITS * l)) & (SLOTS - 1)];
+    auto moving = std::move(slot);
+    slot.clear();
+    for (auto &e : moving) place(e.first, std::move(e.second));
+  }
+
+  std::uint64_t now_;
+  size_t size_ = 0;
+  std::array<std::array<std::vector<Entry>, SLOTS>, LEVELS> slots_;
+};
+
+} // namespace wininspectd
@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "transport.hpp"
+#include <cstring>
+#include <vector>
+
+namespace wininspectd {
+
+bool IConnection::read_all(void *buf, size_t n) {
+  char *p = (char *)buf;
+  while (n > 0) {
+    long r = read_some(p, n);
+    if (r <= 0) return false;
+    p += r;
+    n -= (size_t)r;
+  }
+  return true;
+}
+
+bool IConnection::write_allv(const ConstBuffer *bufs, size_t count) {
+  if (count == 1) return write_all(bufs[0].data, bufs[0].size);
+  std::string joined = BufferPool::take();
+  for (size_t i = 0; i < count; i++) joined.append((const char *)bufs[i].data, bufs[i].size);
+  bool ok = write_all(joined.data(), joined.size());
+  BufferPool::give(std::move(joined));
+  return ok;
+}
+
+IoCounters &thread_io_counters() {
+  thread_local IoCounters counters;
+  return counters;
+}
+
+namespace {
+thread_local std::vector<std::string> t_pool;
+} // namespace
+
+std::string BufferPool::take() {
+  if (t_pool.empty()) return {};
+  std::string b = std::move(t_pool.back());
+  t_pool.pop_back();
+  return b;
+}
+
+void BufferPool::give(std::string &&b) {
+  if (b.capacity() == 0 || b.capacity() > MAX_CAPACITY || t_pool.size() >= MAX_BUFFERS) return;
+  b.clear();
+  t_pool.push_back(std::move(b));
+}
+
+bool read_frame(IConnection &c, std::string &out, std::uint32_t max) {
+  std::uint32_t len = 0;
+  if (!c.read_all(&len, sizeof(len))) return false;
+  if (len == 0 || len > max) return false;
+  out.resize(len);
+  return c.read_all(out.data(), len);
+}
+
+void FrameDecoder::feed(const char *p, size_t n) {
+  if (buf_.capacity() == 0) buf_ = BufferPool::take();
+  buf_.append(p, n);
+}
+
+bool FrameDecoder::next(std::string &out, std::uint32_t *flags) {
+  if (bad_ || buf_.size() - pos_ < sizeof(std::uint32_t)) return false;
+  std::uint32_t word = 0;
+  std::memcpy(&word, buf_.data() + pos_, sizeof(word));
+  std::uint32_t flagged = flags ? word & FRAME_FLAGS : 0;
+  std::uint32_t len = word & ~flagged;
+  if (len == 0 || len > max_) {
+    bad_ = true;
+    return false;
+  }
+  if (buf_.size() - pos_ - sizeof(len) < len) return false;
+  if (flags) *flags = flagged;
+  out.assign(buf_, pos_ + sizeof(len), len);
+  pos_ += sizeof(len) + len;
+  if (pos_ == buf_.size()) {
+    BufferPool::give(std::move(buf_)); // idle connections hold no buffer
+    buf_ = std::string();
+    pos_ = 0;
+  } else if (pos_ > buf_.size() / 2) {
+    buf_.erase(0, pos_);
+    pos_ = 0;
+  }
+  return true;
+}
+
+bool FrameReader::read(std::string &out, std::uint32_t *flags) {
+  char buf[16 * 1024];
+  while (!dec_.next(out, flags)) {
+    if (dec_.bad()) return false;
+    long r = c_.read_some(buf, sizeof(buf));
+    if (r <= 0) return false;
+    dec_.feed(buf, (size_t)r);
+  }
+  return true;
+}
+
+bool write_frame(IConnection &c, const void *payload, size_t n, std::uint32_t flags) {
+  std::uint32_t len = (std::uint32_t)n | flags;
+  ConstBuffer parts[2] = {{&len, sizeof(len)}, {payload, n}};
+  return c.write_allv(parts, 2);
+}
+
+} // namespace wininspectd
@@ -0,0 +1,188 @@
+#pragma once
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+// Byte-stream transports for the daemon. Windows uses Winsock and named
+// pipes (transport_win32.cpp); everything else uses BSD sockets, with a
+// Unix domain socket standing in for the pipe (transport_posix.cpp).
+// Handlers only see IConnection, so the request path is the same on both.
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "wininspect/network_config.hpp"
+
+namespace wininspectd {
+
+/// One piece of a gathered write.
+struct ConstBuffer {
+  const void *data;
+  size_t size;
+};
+
+/// One connected client. A read and a write may be in progress on
+/// different threads at once (an events.stream push writes while the
+/// connection's reader is blocked); concurrent writers must serialize
+/// among themselves.
+class IConnection {
+public:
+  virtual ~IConnection() = default;
+
+  /// Up to `n` bytes. 0 on orderly close, -1 on error or read timeout.
+  virtual long read_some(void *buf, size_t n) = 0;
+  virtual bool write_all(const void *buf, size_t n) = 0;
+  /// Writes the pieces back to back, in one syscall where the transport
+  /// can gather (sockets); the default copies them into a pooled buffer.
+  virtual bool write_allv(const ConstBuffer *bufs, size_t count);
+  /// Make blocked and later reads/writes fail, from any thread, so that a
+  /// push in progress ends before the connection is destroyed.
+  virtual void shutdown() = 0;
+  /// 0 disables the timeout. Ignored by pipes.
+  virtual void set_read_timeout(int ms) = 0;
+  /// A write that makes no progress for `ms` fails and shuts the
+  /// connection down, since its peer has stopped reading and the stream is
+  /// cut mid-frame. 0 disables the timeout. Ignored by pipes.
+  virtual void set_write_timeout(int ms) = 0;
+  /// For logs: "tcp [addr]:port", "unix", "pipe".
+  virtual std::string peer() const = 0;
+  /// For IoService: the fd, SOCKET or pipe HANDLE, and which kind it is.
+  virtual std::intptr_t native_handle() const = 0;
+  virtual bool is_socket() const { return true; }
+  /// Passing OS handles along with bytes, for the shared-memory transport.
+  /// Only Unix domain sockets carry them (SCM_RIGHTS): elsewhere a write
+  /// with handles fails and a read collects none. Received handles belong
+  /// to the caller.
+  virtual bool write_with_handles(const void *buf, size_t n, const int * /*handles*/,
+                                  size_t count) {
+    return count == 0 && write_all(buf, n);
+  }
+  virtual long read_with_handles(void *buf, size_t n, std::vector<int> &) {
+    return read_some(buf, n);
+  }
+
+  bool read_all(void *buf, size_t n);
+};
+
+class IListener {
+public:
+  virtual ~IListener() = default;
+
+  /// Waits up to `timeout_ms` for a client. nullptr on timeout, on error,
+  /// or once close() has been called.
+  virtual std::unique_ptr<IConnection> accept(int timeout_ms) = 0;
+  /// Stops accepting; safe to call from another thread.
+  virtual void close() = 0;
+  virtual std::string address() const = 0;
+  /// Bound TCP port (useful after binding port 0); 0 for local listeners.
+  virtual int port() const = 0;
+};
+
+/// Syscalls the calling thread has made through connections, for tests
+/// that guard against extra round trips.
+struct IoCounters {
+  std::uint64_t reads = 0;
+  std::uint64_t writes = 0;
+};
+IoCounters &thread_io_counters();
+
+/// Byte buffers recycled per thread, so that framing does not allocate per
+/// request while an idle connection still holds no buffer of its own.
+class BufferPool {
+public:
+  /// An empty string, with capacity if one was available.
+  static std::string take();
+  /// Keeps `b` for reuse unless the pool is full or `b` is oversized.
+  static void give(std::string &&b);
+
+  static constexpr size_t MAX_BUFFERS = 16;
+  static constexpr size_t MAX_CAPACITY = 256 * 1024;
+};
+
+// ── Framing ─────────────────────────────────────────────────────────────────
+// Every protocol message is a 4-byte little-endian length and a payload.
+// Once a TCP handshake has agreed a codec, the length's top bit marks a
+// payload packed by wininspect::compress (inside the record, if encrypted).
+// The next bit marks a multipart payload (wininspect::split_multipart): a
+// JSON envelope and the raw attachments it refers to, seen after
+// decryption and decompression. On a local connection that set up a
+// shared-memory ring pair (shm_ring.hpp), the third bit marks a frame
+// whose payload is a ShmSpan locating the real payload in a ring.
+
+inline constexpr std::uint32_t MAX_FRAME_BYTES = 10 * 1024 * 1024;
+inline constexpr std::uint32_t FRAME_COMPRESSED = 0x80000000u;
+inline constexpr std::uint32_t FRAME_MULTIPART = 0x40000000u;
+inline constexpr std::uint32_t FRAME_SHM = 0x20000000u;
+inline constexpr std::uint32_t FRAME_FLAGS = FRAME_COMPRESSED | FRAME_MULTIPART | FRAME_SHM;
+
+/// Reads exactly one frame, with no read-ahead (two reads). Use FrameReader
+/// for a connection that carries more than one.
+/// Fails on EOF, error, or a length of 0 or over `max`.
+[[nodiscard]] bool read_frame(IConnection &c, std::string &out,
+                              std::uint32_t max = MAX_FRAME_BYTES);
+/// One gathered write per frame (length prefix and payload together), so
+/// a reader never sees a split prefix and nothing is copied on sockets.
+/// `flags` are FRAME_* bits for the length word.
+bool write_frame(IConnection &c, const void *payload, size_t n, std::uint32_t flags = 0);
+inline bool write_frame(IConnection &c, const std::string &payload) {
+  return write_frame(c, payload.data(), payload.size());
+}
+
+/// Incremental frame parser for event-driven reads: feed() whatever
+/// arrived, then take complete payloads with next(). A bad length prefix
+/// (0 or over `max`) is sticky; the connection should be dropped.
+class FrameDecoder {
+public:
+  explicit FrameDecoder(std::uint32_t max = MAX_FRAME_BYTES) : max_(max) {}
+  ~FrameDecoder() { BufferPool::give(std::move(buf_)); }
+  FrameDecoder(const FrameDecoder &) = delete;
+  FrameDecoder &operator=(const FrameDecoder &) = delete;
+
+  void feed(const char *p, size_t n);
+  /// Reuses `out`'s capacity. Flagged frames (FRAME_FLAGS) are accepted
+  /// only when `flags` is given to report them; otherwise they are bad.
+  bool next(std::string &out, std::uint32_t *flags = nullptr);
+  bool bad() const { return bad_; }
+
+private:
+  std::uint32_t max_;
+  std::string buf_; // borrowed from BufferPool while bytes are pending
+  size_t pos_ = 0;  // consumed prefix of buf_
+  bool bad_ = false;
+};
+
+/// Blocking, read-ahead frame reader for the client side of a connection:
+/// each read takes whatever has arrived, so a burst of responses costs one
+/// syscall rather than two per frame. Use one reader per connection for
+/// its whole life; bytes it has read ahead live in it.
+class FrameReader {
+public:
+  explicit FrameReader(IConnection &c, std::uint32_t max = MAX_FRAME_BYTES)
+      : c_(c), dec_(max) {}
+
+  /// Fails on EOF, error, or a bad length. See FrameDecoder::next.
+  [[nodiscard]] bool read(std::string &out, std::uint32_t *flags = nullptr);
+
+private:
+  IConnection &c_;
+  FrameDecoder dec_;
+};
+
+// ── Factories ───────────────────────────────────────────────────────────────
+
+/// The local, same-machine transport. `name` is a pipe name on Windows
+/// (\\.\pipe\<name>) and a socket path elsewhere; a bare name there is
+/// placed in $XDG_RUNTIME_DIR (or /tmp). Null if it cannot be created.
+std::unique_ptr<IListener> listen_local(const std::string &name);
+std::unique_ptr<IConnection> connect_local(const std::string &name);
+std::string local_endpoint(const std::string &name);
+
+/// One listener per address that could be bound; empty if none.
+std::vector<std::unique_ptr<IListener>> listen_tcp(
+    const std::vector<wininspect::NetworkAddress> &bind, int port);
+/// Null if `host` does not resolve or nothing accepts within the timeout.
+std::unique_ptr<IConnection> connect_tcp(const std::string &host, int port,
+                                         int timeout_ms = 5000);
+
+} // namespace wininspectd
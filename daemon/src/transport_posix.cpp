@@ -0,0 +1,359 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#ifndef _WIN32
+#include "transport.hpp"
+#include "wininspect/logger.hpp"
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace wininspectd {
+
+namespace {
+
+class SocketConnection final : public IConnection {
+public:
+  SocketConnection(int fd, std::string peer) : fd_(fd), peer_(std::move(peer)) {}
+  ~SocketConnection() override { ::close(fd_); }
+
+  long read_some(void *buf, size_t n) override {
+    while (true) {
+      thread_io_counters().reads++;
+      ssize_t r = ::recv(fd_, buf, n, 0);
+      if (r >= 0) return (long)r;
+      if (errno != EINTR) return -1;
+    }
+  }
+
+  bool write_all(const void *buf, size_t n) override {
+    ConstBuffer one{buf, n};
+    return write_allv(&one, 1);
+  }
+
+  // sendmsg rather than writev, for MSG_NOSIGNAL. A short write resumes
+  // inside the piece it stopped in.
+  bool write_allv(const ConstBuffer *bufs, size_t count) override {
+    iovec iov[8];
+    while (count > 0) {
+      size_t k = 0;
+      for (; count > 0 && k < 8; bufs++, count--)
+        if (bufs->size) iov[k++] = {(void *)bufs->data, bufs->size};
+      msghdr msg{};
+      msg.msg_iov = iov;
+      msg.msg_iovlen = k;
+      while (msg.msg_iovlen > 0) {
+        thread_io_counters().writes++;
+        ssize_t w = ::sendmsg(fd_, &msg, MSG_NOSIGNAL);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) {
+          if (w < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) shutdown(); // SO_SNDTIMEO
+          return false;
+        }
+        size_t left = (size_t)w;
+        while (msg.msg_iovlen > 0 && left >= msg.msg_iov->iov_len) {
+          left -= msg.msg_iov->iov_len;
+          msg.msg_iov++;
+          msg.msg_iovlen--;
+        }
+        if (msg.msg_iovlen > 0) {
+          msg.msg_iov->iov_base = (char *)msg.msg_iov->iov_base + left;
+          msg.msg_iov->iov_len -= left;
+        }
+      }
+    }
+    return true;
+  }
+
+  // The descriptors ride on the first byte; the rest follows as usual.
+  bool write_with_handles(const void *buf, size_t n, const int *handles,
+                          size_t count) override {
+    if (count == 0) return write_all(buf, n);
+    if (n == 0 || count > MAX_HANDLES) return false;
+    alignas(cmsghdr) char ctl[CMSG_SPACE(MAX_HANDLES * sizeof(int))] = {};
+    iovec iov{(void *)buf, 1};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctl;
+    msg.msg_controllen = CMSG_SPACE(count * sizeof(int));
+    cmsghdr *cm = CMSG_FIRSTHDR(&msg);
+    cm->cmsg_level = SOL_SOCKET;
+    cm->cmsg_type = SCM_RIGHTS;
+    cm->cmsg_len = CMSG_LEN(count * sizeof(int));
+    std::memcpy(CMSG_DATA(cm), handles, count * sizeof(int));
+    ssize_t w;
+    do {
+      thread_io_counters().writes++;
+      w = ::sendmsg(fd_, &msg, MSG_NOSIGNAL);
+    } while (w < 0 && errno == EINTR);
+    return w == 1 && write_all((const char *)buf + 1, n - 1);
+  }
+
+  long read_with_handles(void *buf, size_t n, std::vector<int> &handles) override {
+    alignas(cmsghdr) char ctl[CMSG_SPACE(MAX_HANDLES * sizeof(int))];
+    iovec iov{buf, n};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctl;
+    msg.msg_controllen = sizeof(ctl);
+    ssize_t r;
+    do {
+      thread_io_counters().reads++;
+      r = ::recvmsg(fd_, &msg, MSG_CMSG_CLOEXEC);
+    } while (r < 0 && errno == EINTR);
+    for (cmsghdr *cm = CMSG_FIRSTHDR(&msg); r >= 0 && cm; cm = CMSG_NXTHDR(&msg, cm)) {
+      if (cm->cmsg_level != SOL_SOCKET || cm->cmsg_type != SCM_RIGHTS) continue;
+      size_t k = (cm->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+      for (size_t i = 0; i < k; i++) {
+        int fd;
+        std::memcpy(&fd, CMSG_DATA(cm) + i * sizeof(int), sizeof(int));
+        handles.push_back(fd);
+      }
+    }
+    return r < 0 ? -1 : (long)r;
+  }
+
+  void shutdown() override { ::shutdown(fd_, SHUT_RDWR); }
+
+  void set_read_timeout(int ms) override {
+    timeval tv{ms / 1000, (ms % 1000) * 1000};
+    setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  }
+
+  void set_write_timeout(int ms) override {
+    timeval tv{ms / 1000, (ms % 1000) * 1000};
+    setsockopt(fd_, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+  }
+
+  std::string peer() const override { return peer_; }
+  std::intptr_t native_handle() const override { return fd_; }
+
+private:
+  static constexpr size_t MAX_HANDLES = 8;
+  int fd_;
+  std::string peer_;
+};
+
+std::string format_addr(const sockaddr_storage &ss) {
+  char host[INET6_ADDRSTRLEN] = {};
+  int port = 0;
+  if (ss.ss_family == AF_INET) {
+    auto *sin = (const sockaddr_in *)&ss;
+    inet_ntop(AF_INET, &sin->sin_addr, host, sizeof(host));
+    port = ntohs(sin->sin_port);
+  } else if (ss.ss_family == AF_INET6) {
+    auto *sin6 = (const sockaddr_in6 *)&ss;
+    inet_ntop(AF_INET6, &sin6->sin6_addr, host, sizeof(host));
+    port = ntohs(sin6->sin6_port);
+  }
+  return "[" + std::string(host) + "]:" + std::to_string(port);
+}
+
+// The listening socket is non-blocking and waited on with poll(), so
+// close() from another thread takes effect within one accept timeout.
+class SocketListener final : public IListener {
+public:
+  SocketListener(int fd, bool tcp, std::string address, int port, std::string unlink_path = {})
+      : fd_(fd), tcp_(tcp), address_(std::move(address)), port_(port),
+        unlink_path_(std::move(unlink_path)) {}
+  ~SocketListener() override {
+    close();
+    ::close(fd_);
+    if (!unlink_path_.empty()) ::unlink(unlink_path_.c_str());
+  }
+
+  std::unique_ptr<IConnection> accept(int timeout_ms) override {
+    if (closed_) return nullptr;
+    pollfd p{fd_, POLLIN, 0};
+    if (::poll(&p, 1, timeout_ms) <= 0 || closed_) return nullptr;
+    sockaddr_storage ss{};
+    socklen_t len = sizeof(ss);
+    int c = ::accept(fd_, (sockaddr *)&ss, &len);
+    if (c < 0) {
+      // Out of descriptors: the client stays queued and poll() stays
+      // readable, so back off instead of spinning.
+      if (errno == EMFILE || errno == ENFILE) {
+        LOG_WARN("accept: out of file descriptors");
+        ::poll(nullptr, 0, timeout_ms);
+      }
+      return nullptr;
+    }
+    fcntl(c, F_SETFL, fcntl(c, F_GETFL) & ~O_NONBLOCK);
+    fcntl(c, F_SETFD, FD_CLOEXEC);
+    if (!tcp_) return std::make_unique<SocketConnection>(c, "unix");
+    int on = 1;
+    setsockopt(c, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    return std::make_unique<SocketConnection>(c, "tcp " + format_addr(ss));
+  }
+
+  void close() override { closed_ = true; }
+  std::string address() const override { return address_; }
+  int port() const override { return port_; }
+
+private:
+  int fd_;
+  bool tcp_;
+  std::string address_;
+  int port_;
+  std::string unlink_path_;
+  std::atomic<bool> closed_{false};
+};
+
+int to_af(int family) {
+  if (family == wininspect::ADDR_FAMILY_IPV4) return AF_INET;
+  if (family == wininspect::ADDR_FAMILY_IPV6) return AF_INET6;
+  return AF_UNSPEC;
+}
+
+} // namespace
+
+// ── Unix domain socket (the local transport) ────────────────────────────────
+
+std::string local_endpoint(const std::string &name) {
+  if (name.find('/') != std::string::npos) return name;
+  const char *dir = getenv("XDG_RUNTIME_DIR");
+  return std::string(dir && dir[0] ? dir : "/tmp") + "/" + name + ".sock";
+}
+
+std::unique_ptr<IListener> listen_local(const std::string &name) {
+  std::string path = local_endpoint(name);
+  sockaddr_un addr{};
+  if (path.size() >= sizeof(addr.sun_path)) {
+    LOG_ERROR("Local socket path too long: " + path);
+    return nullptr;
+  }
+  addr.sun_family = AF_UNIX;
+  std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+  int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) return nullptr;
+  ::unlink(path.c_str()); // stale socket from an earlier run
+  // Owner-only, like the pipe's default DACL.
+  mode_t old = umask(077);
+  int rc = ::bind(fd, (sockaddr *)&addr, sizeof(addr));
+  umask(old);
+  if (rc != 0 || ::listen(fd, SOMAXCONN) != 0) {
+    LOG_ERROR("Local socket: cannot listen on " + path + ": " + std::strerror(errno));
+    ::close(fd);
+    return nullptr;
+  }
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  return std::make_unique<SocketListener>(fd, false, path, 0, path);
+}
+
+std::unique_ptr<IConnection> connect_local(const std::string &name) {
+  std::string path = local_endpoint(name);
+  sockaddr_un addr{};
+  if (path.size() >= sizeof(addr.sun_path)) return nullptr;
+  addr.sun_family = AF_UNIX;
+  std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+  int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) return nullptr;
+  if (::connect(fd, (sockaddr *)&addr, sizeof(addr)) != 0) {
+    ::close(fd);
+    return nullptr;
+  }
+  return std::make_unique<SocketConnection>(fd, "unix");
+}
+
+// ── TCP ─────────────────────────────────────────────────────────────────────
+
+std::vector<std::unique_ptr<IListener>> listen_tcp(
+    const std::vector<wininspect::NetworkAddress> &bind, int port) {
+  std::vector<std::unique_ptr<IListener>> out;
+  std::string port_str = std::to_string(port);
+  for (const auto &ba : bind) {
+    addrinfo hints{};
+    hints.ai_family = to_af(ba.family);
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+    hints.ai_flags = AI_PASSIVE;
+    addrinfo *res = nullptr;
+    int rc = getaddrinfo(ba.address.c_str(), port_str.c_str(), &hints, &res);
+    if (rc != 0) {
+      LOG_WARN("TCP: getaddrinfo failed for " + ba.address + ": " + gai_strerror(rc));
+      continue;
+    }
+    for (auto *rp = res; rp; rp = rp->ai_next) {
+      int fd = ::socket(rp->ai_family, rp->ai_socktype | SOCK_CLOEXEC, rp->ai_protocol);
+      if (fd < 0) continue;
+      // Dual-stack unless the config pinned a family.
+      if (rp->ai_family == AF_INET6) {
+        int v6only = ba.family == wininspect::ADDR_FAMILY_IPV6 ? 1 : 0;
+        setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &v6only, sizeof(v6only));
+      }
+      int on = 1;
+      setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+      if (::bind(fd, rp->ai_addr, rp->ai_addrlen) != 0 || ::listen(fd, SOMAXCONN) != 0) {
+        LOG_ERROR("TCP: cannot listen on " + ba.address + ":" + port_str + ": " +
+                  std::strerror(errno));
+        ::close(fd);
+        continue;
+      }
+      fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+      sockaddr_storage ss{};
+      socklen_t len = sizeof(ss);
+      getsockname(fd, (sockaddr *)&ss, &len);
+      int bound = ss.ss_family == AF_INET6 ? ntohs(((sockaddr_in6 *)&ss)->sin6_port)
+                                           : ntohs(((sockaddr_in *)&ss)->sin_port);
+      out.push_back(std::make_unique<SocketListener>(fd, true, format_addr(ss), bound));
+    }
+    freeaddrinfo(res);
+  }
+  return out;
+}
+
+std::unique_ptr<IConnection> connect_tcp(const std::string &host, int port, int timeout_ms) {
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo *res = nullptr;
+  if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &res) != 0)
+    return nullptr;
+  std::unique_ptr<IConnection> conn;
+  for (auto *rp = res; rp && !conn; rp = rp->ai_next) {
+    int fd = ::socket(rp->ai_family, rp->ai_socktype | SOCK_CLOEXEC, rp->ai_protocol);
+    if (fd < 0) continue;
+    // Non-blocking connect so the timeout applies.
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    int rc = ::connect(fd, rp->ai_addr, rp->ai_addrlen);
+    if (rc != 0 && errno == EINPROGRESS) {
+      pollfd p{fd, POLLOUT, 0};
+      int err = 0;
+      socklen_t len = sizeof(err);
+      if (::poll(&p, 1, timeout_ms) == 1 &&
+          getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) == 0 && err == 0)
+        rc = 0;
+    }
+    if (rc != 0) {
+      ::close(fd);
+      continue;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+    int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    sockaddr_storage ss{};
+    std::memcpy(&ss, rp->ai_addr, rp->ai_addrlen);
+    conn = std::make_unique<SocketConnection>(fd, "tcp " + format_addr(ss));
+  }
+  freeaddrinfo(res);
+  return conn;
+}
+
+} // namespace wininspectd
+#endif
@@ -0,0 +1,401 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#ifdef _WIN32
+#include "transport.hpp"
+#include "wininspect/logger.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+
+#pragma comment(lib, "ws2_32.lib")
+
+namespace wininspectd {
+
+namespace {
+
+static struct WsaInit {
+  WsaInit() {
+    WSADATA wsd;
+    ok = (WSAStartup(MAKEWORD(2, 2), &wsd) == 0);
+  }
+  ~WsaInit() { if (ok) WSACleanup(); }
+  bool ok = false;
+} wsa_init;
+
+// ── Named pipes ─────────────────────────────────────────────────────────────
+
+// Pipes are opened FILE_FLAG_OVERLAPPED so that a push stream can write
+// while the connection's reader is blocked in ReadFile (synchronous I/O on
+// one handle is serialized). Each call still completes before returning.
+// The event's low bit is set so that, once IoService has bound the handle
+// to its completion port, these completions are not queued there too.
+struct Overlapped {
+  OVERLAPPED ov{};
+  HANDLE ev;
+  Overlapped() : ev(CreateEventW(nullptr, TRUE, FALSE, nullptr)) {
+    ov.hEvent = ev ? (HANDLE)((ULONG_PTR)ev | 1) : nullptr;
+  }
+  ~Overlapped() { if (ev) CloseHandle(ev); }
+};
+
+bool finish(HANDLE h, BOOL started, Overlapped &o, DWORD &n) {
+  if (!started && GetLastError() != ERROR_IO_PENDING) return false;
+  return GetOverlappedResult(h, &o.ov, &n, TRUE) != FALSE;
+}
+
+class PipeConnection final : public IConnection {
+public:
+  explicit PipeConnection(HANDLE h) : h_(h) {}
+  ~PipeConnection() override {
+    FlushFileBuffers(h_);
+    DisconnectNamedPipe(h_);
+    CloseHandle(h_);
+  }
+
+  long read_some(void *buf, size_t n) override {
+    if (down_) return -1;
+    thread_io_counters().reads++;
+    Overlapped o;
+    DWORD r = 0;
+    if (!finish(h_, ReadFile(h_, buf, (DWORD)n, nullptr, &o.ov), o, r)) return -1;
+    return (long)r;
+  }
+
+  bool write_all(const void *buf, size_t n) override {
+    const BYTE *p = (const BYTE *)buf;
+    Overlapped o;
+    while (n > 0) {
+      if (down_) return false;
+      DWORD w = 0;
+      ResetEvent(o.ev);
+      thread_io_counters().writes++;
+      if (!finish(h_, WriteFile(h_, p, (DWORD)n, nullptr, &o.ov), o, w) || w == 0)
+        return false;
+      p += w;
+      n -= w;
+    }
+    return true;
+  }
+
+  void shutdown() override {
+    down_ = true;
+    CancelIoEx(h_, nullptr); // every thread's pending read/write
+  }
+  void set_read_timeout(int) override {}
+  void set_write_timeout(int) override {}
+  std::string peer() const override { return "pipe"; }
+  std::intptr_t native_handle() const override { return (std::intptr_t)h_; }
+  bool is_socket() const override { return false; }
+
+private:
+  HANDLE h_;
+  std::atomic<bool> down_{false};
+};
+
+// One pipe instance is kept waiting for a client between accept() calls,
+// so a client arriving while the caller is busy is not refused.
+class PipeListener final : public IListener {
+public:
+  explicit PipeListener(std::wstring path, std::string display)
+      : path_(std::move(path)), display_(std::move(display)),
+        stop_(CreateEventW(nullptr, TRUE, FALSE, nullptr)) {}
+  ~PipeListener() override {
+    if (pending_ != INVALID_HANDLE_VALUE) {
+      CancelIoEx(pending_, &wait_.ov);
+      DWORD n = 0;
+      GetOverlappedResult(pending_, &wait_.ov, &n, TRUE);
+      CloseHandle(pending_);
+    }
+    CloseHandle(stop_);
+  }
+
+  bool create() {
+    pending_ = CreateNamedPipeW(path_.c_str(), PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED,
+                                PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT,
+                                PIPE_UNLIMITED_INSTANCES, 64 * 1024, 64 * 1024, 0, nullptr);
+    if (pending_ == INVALID_HANDLE_VALUE) {
+      LOG_ERROR("Failed to create Named Pipe: " + std::to_string(GetLastError()));
+      return false;
+    }
+    ResetEvent(wait_.ev);
+    if (ConnectNamedPipe(pending_, &wait_.ov)) {
+      SetEvent(wait_.ev);
+    } else {
+      DWORD err = GetLastError();
+      if (err == ERROR_PIPE_CONNECTED) SetEvent(wait_.ev);
+      else if (err != ERROR_IO_PENDING) {
+        CloseHandle(pending_);
+        pending_ = INVALID_HANDLE_VALUE;
+        return false;
+      }
+    }
+    return true;
+  }
+
+  std::unique_ptr<IConnection> accept(int timeout_ms) override {
+    if (pending_ == INVALID_HANDLE_VALUE && !create()) return nullptr;
+    HANDLE waits[2] = {wait_.ev, stop_};
+    DWORD rc = WaitForMultipleObjects(2, waits, FALSE, (DWORD)timeout_ms);
+    if (rc != WAIT_OBJECT_0) return nullptr;
+    HANDLE h = pending_;
+    pending_ = INVALID_HANDLE_VALUE;
+    DWORD n = 0;
+    if (!GetOverlappedResult(h, &wait_.ov, &n, FALSE) &&
+        GetLastError() != ERROR_PIPE_CONNECTED) {
+      CloseHandle(h);
+      return nullptr;
+    }
+    return std::make_unique<PipeConnection>(h);
+  }
+
+  void close() override { SetEvent(stop_); }
+  std::string address() const override { return display_; }
+  int port() const override { return 0; }
+
+private:
+  std::wstring path_;
+  std::string display_;
+  HANDLE stop_;
+  HANDLE pending_ = INVALID_HANDLE_VALUE;
+  Overlapped wait_;
+};
+
+// ── Winsock ─────────────────────────────────────────────────────────────────
+
+class SocketConnection final : public IConnection {
+public:
+  SocketConnection(SOCKET s, std::string peer) : s_(s), peer_(std::move(peer)) {}
+  ~SocketConnection() override { closesocket(s_); }
+
+  long read_some(void *buf, size_t n) override {
+    thread_io_counters().reads++;
+    int r = recv(s_, (char *)buf, (int)n, 0);
+    return r == SOCKET_ERROR ? -1 : (long)r;
+  }
+
+  bool write_all(const void *buf, size_t n) override {
+    ConstBuffer one{buf, n};
+    return write_allv(&one, 1);
+  }
+
+  // A pipe has no gather write (the IConnection default copies); WSASend
+  // does. A short send resumes inside the piece it stopped in.
+  bool write_allv(const ConstBuffer *bufs, size_t count) override {
+    WSABUF wb[8];
+    while (count > 0) {
+      DWORD k = 0;
+      for (; count > 0 && k < 8; bufs++, count--)
+        if (bufs->size) wb[k++] = {(ULONG)bufs->size, (CHAR *)bufs->data};
+      WSABUF *p = wb;
+      while (k > 0) {
+        thread_io_counters().writes++;
+        DWORD sent = 0;
+        if (WSASend(s_, p, k, &sent, 0, nullptr, nullptr) != 0 || sent == 0) {
+          if (WSAGetLastError() == WSAETIMEDOUT) shutdown(); // SO_SNDTIMEO
+          return false;
+        }
+        while (k > 0 && sent >= p->len) {
+          sent -= p->len;
+          p++;
+          k--;
+        }
+        if (k > 0) {
+          p->buf += sent;
+          p->len -= sent;
+        }
+      }
+    }
+    return true;
+  }
+
+  void shutdown() override { ::shutdown(s_, SD_BOTH); }
+
+  void set_read_timeout(int ms) override {
+    DWORD timeout = (DWORD)ms;
+    setsockopt(s_, SOL_SOCKET, SO_RCVTIMEO, (const char *)&timeout, sizeof(timeout));
+  }
+
+  void set_write_timeout(int ms) override {
+    DWORD timeout = (DWORD)ms;
+    setsockopt(s_, SOL_SOCKET, SO_SNDTIMEO, (const char *)&timeout, sizeof(timeout));
+  }
+
+  std::string peer() const override { return peer_; }
+  std::intptr_t native_handle() const override { return (std::intptr_t)s_; }
+
+private:
+  SOCKET s_;
+  std::string peer_;
+};
+
+std::string format_addr(const sockaddr_storage &ss) {
+  char host[64] = {};
+  int port = 0;
+  if (ss.ss_family == AF_INET) {
+    auto *sin = (const sockaddr_in *)&ss;
+    inet_ntop(AF_INET, &sin->sin_addr, host, sizeof(host));
+    port = ntohs(sin->sin_port);
+  } else if (ss.ss_family == AF_INET6) {
+    auto *sin6 = (const sockaddr_in6 *)&ss;
+    inet_ntop(AF_INET6, &sin6->sin6_addr, host, sizeof(host));
+    port = ntohs(sin6->sin6_port);
+  }
+  return "[" + std::string(host) + "]:" + std::to_string(port);
+}
+
+class SocketListener final : public IListener {
+public:
+  SocketListener(SOCKET s, std::string address, int port)
+      : s_(s), address_(std::move(address)), port_(port) {}
+  ~SocketListener() override { closesocket(s_); }
+
+  std::unique_ptr<IConnection> accept(int timeout_ms) override {
+    if (closed_) return nullptr;
+    fd_set fds;
+    FD_ZERO(&fds);
+    FD_SET(s_, &fds);
+    timeval tv{timeout_ms / 1000, (timeout_ms % 1000) * 1000};
+    if (select(0, &fds, nullptr, nullptr, &tv) <= 0 || closed_) return nullptr;
+    sockaddr_storage ss{};
+    int len = sizeof(ss);
+    SOCKET c = ::accept(s_, (sockaddr *)&ss, &len);
+    if (c == INVALID_SOCKET) return nullptr;
+    u_long blocking = 0;
+    ioctlsocket(c, FIONBIO, &blocking);
+    BOOL on = TRUE;
+    setsockopt(c, IPPROTO_TCP, TCP_NODELAY, (const char *)&on, sizeof(on));
+    return std::make_unique<SocketConnection>(c, "tcp " + format_addr(ss));
+  }
+
+  void close() override { closed_ = true; }
+  std::string address() const override { return address_; }
+  int port() const override { return port_; }
+
+private:
+  SOCKET s_;
+  std::string address_;
+  int port_;
+  std::atomic<bool> closed_{false};
+};
+
+} // namespace
+
+std::string local_endpoint(const std::string &name) {
+  if (name.rfind("\\\\", 0) == 0) return name;
+  return "\\\\.\\pipe\\" + name;
+}
+
+std::unique_ptr<IListener> listen_local(const std::string &name) {
+  std::string path = local_endpoint(name);
+  auto l = std::make_unique<PipeListener>(std::wstring(path.begin(), path.end()), path);
+  if (!l->create()) return nullptr;
+  return l;
+}
+
+std::unique_ptr<IConnection> connect_local(const std::string &name) {
+  std::string path = local_endpoint(name);
+  std::wstring wpath(path.begin(), path.end());
+  HANDLE h = CreateFileW(wpath.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr,
+                         OPEN_EXISTING, FILE_FLAG_OVERLAPPED, nullptr);
+  if (h == INVALID_HANDLE_VALUE) return nullptr;
+  return std::make_unique<PipeConnection>(h);
+}
+
+std::vector<std::unique_ptr<IListener>> listen_tcp(
+    const std::vector<wininspect::NetworkAddress> &bind, int port) {
+  std::vector<std::unique_ptr<IListener>> out;
+  if (!wsa_init.ok) {
+    LOG_ERROR("TCP: Winsock not initialized.");
+    return out;
+  }
+  std::string port_str = std::to_string(port);
+  for (const auto &ba : bind) {
+    addrinfo hints = {};
+    hints.ai_family = ba.family;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+    hints.ai_flags = AI_PASSIVE;
+    addrinfo *res = nullptr;
+    int rc = getaddrinfo(ba.address.c_str(), port_str.c_str(), &hints, &res);
+    if (rc != 0) {
+      LOG_WARN("TCP: getaddrinfo failed for " + ba.address + ": " + std::to_string(rc));
+      continue;
+    }
+    for (auto *rp = res; rp; rp = rp->ai_next) {
+      SOCKET s = socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol);
+      if (s == INVALID_SOCKET) {
+        LOG_WARN("TCP: socket() failed for " + ba.address + ": " +
+                 std::to_string(WSAGetLastError()));
+        continue;
+      }
+      // Dual-stack: disable IPV6_V6ONLY so AF_INET6 handles both v4 and v6
+      if (rp->ai_family == AF_INET6 && ba.family == AF_UNSPEC) {
+        int off = 0;
+        setsockopt(s, IPPROTO_IPV6, IPV6_V6ONLY, (const char *)&off, sizeof(off));
+      }
+      int on = 1;
+      setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (const char *)&on, sizeof(on));
+      if (::bind(s, rp->ai_addr, (int)rp->ai_addrlen) == SOCKET_ERROR ||
+          listen(s, SOMAXCONN) == SOCKET_ERROR) {
+        LOG_ERROR("TCP: cannot listen on " + ba.address + ":" + port_str + " — " +
+                  std::to_string(WSAGetLastError()));
+        closesocket(s);
+        continue;
+      }
+      sockaddr_storage ss{};
+      int len = sizeof(ss);
+      getsockname(s, (sockaddr *)&ss, &len);
+      int bound = ss.ss_family == AF_INET6 ? ntohs(((sockaddr_in6 *)&ss)->sin6_port)
+                                           : ntohs(((sockaddr_in *)&ss)->sin_port);
+      out.push_back(std::make_unique<SocketListener>(s, format_addr(ss), bound));
+    }
+    freeaddrinfo(res);
+  }
+  return out;
+}
+
+std::unique_ptr<IConnection> connect_tcp(const std::string &host, int port, int timeout_ms) {
+  if (!wsa_init.ok) return nullptr;
+  addrinfo hints = {};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo *res = nullptr;
+  if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &res) != 0)
+    return nullptr;
+  std::unique_ptr<IConnection> conn;
+  for (auto *rp = res; rp && !conn; rp = rp->ai_next) {
+    SOCKET s = socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol);
+    if (s == INVALID_SOCKET) continue;
+    // Non-blocking connect so the timeout applies.
+    u_long mode = 1;
+    ioctlsocket(s, FIONBIO, &mode);
+    bool ok = ::connect(s, rp->ai_addr, (int)rp->ai_addrlen) == 0;
+    if (!ok && WSAGetLastError() == WSAEWOULDBLOCK) {
+      fd_set wr, ex;
+      FD_ZERO(&wr); FD_SET(s, &wr);
+      FD_ZERO(&ex); FD_SET(s, &ex);
+      timeval tv{timeout_ms / 1000, (timeout_ms % 1000) * 1000};
+      ok = select(0, nullptr, &wr, &ex, &tv) > 0 && FD_ISSET(s, &wr);
+    }
+    if (!ok) {
+      closesocket(s);
+      continue;
+    }
+    mode = 0;
+    ioctlsocket(s, FIONBIO, &mode);
+    BOOL on = TRUE;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char *)&on, sizeof(on));
+    sockaddr_storage ss{};
+    std::memcpy(&ss, rp->ai_addr, rp->ai_addrlen);
+    conn = std::make_unique<SocketConnection>(s, "tcp " + format_addr(ss));
+  }
+  freeaddrinfo(res);
+  return conn;
+}
+
+} // namespace wininspectd
+#endif
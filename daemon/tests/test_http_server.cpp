@@ -0,0 +1,396 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "doctest/doctest.h"
+#include "http_server.hpp"
+#include "io_service.hpp"
+#include "request_handler.hpp"
+#include "server_state.hpp"
+#include "transport.hpp"
+#include "wininspect/core.hpp"
+#include "wininspect/fake_backend.hpp"
+#include "wininspect/tinyjson.hpp"
+#include <chrono>
+#include <map>
+#include <thread>
+
+using namespace wininspect;
+using namespace wininspectd;
+
+namespace {
+
+struct Reply {
+  int code = 0;
+  std::map<std::string, std::string> headers; // names lowercased
+  std::string body;
+  bool chunked = false;
+};
+
+// Reads responses off one connection, however the bytes arrive.
+class Client {
+public:
+  explicit Client(int port) : c_(connect_tcp("127.0.0.1", port)) {
+    if (c_) c_->set_read_timeout(5000);
+  }
+  bool ok() const { return c_ != nullptr; }
+
+  bool send(const std::string &s) { return c_->write_all(s.data(), s.size()); }
+
+  bool read(Reply &r) {
+    size_t end;
+    while ((end = buf_.find("\r\n\r\n")) == std::string::npos)
+      if (!fill()) return false;
+    std::string head = buf_.substr(0, end);
+    buf_.erase(0, end + 4);
+    r = Reply{};
+    r.code = std::atoi(head.c_str() + 9);
+    for (size_t p = head.find("\r\n"); p != std::string::npos;) {
+      size_t e = head.find("\r\n", p + 2);
+      std::string line = head.substr(p + 2, e == std::string::npos ? e : e - p - 2);
+      size_t c = line.find(": ");
+      std::string name = line.substr(0, c);
+      for (auto &ch : name) ch = (char)std::tolower((unsigned char)ch);
+      r.headers[name] = line.substr(c + 2);
+      p = e;
+    }
+    if (r.code == 100) return true;
+    if (r.headers.count("transfer-encoding")) {
+      r.chunked = true;
+      while (true) {
+        size_t eol;
+        while ((eol = buf_.find("\r\n")) == std::string::npos)
+          if (!fill()) return false;
+        size_t n = std::stoul(buf_.substr(0, eol), nullptr, 16);
+        while (buf_.size() < eol + 2 + n + 2)
+          if (!fill()) return false;
+        r.body += buf_.substr(eol + 2, n);
+        buf_.erase(0, eol + 2 + n + 2);
+        if (n == 0) return true;
+      }
+    }
+    size_t n = std::stoul(r.headers["content-length"]);
+    while (buf_.size() < n)
+      if (!fill()) return false;
+    r.body = buf_.substr(0, n);
+    buf_.erase(0, n);
+    return true;
+  }
+
+  /// A response whose body ends with the connection.
+  bool read_to_close(Reply &r) {
+    size_t end;
+    while ((end = buf_.find("\r\n\r\n")) == std::string::npos)
+      if (!fill()) return false;
+    r = Reply{};
+    r.code = std::atoi(buf_.c_str() + 9);
+    r.chunked = buf_.substr(0, end).find("chunked") != std::string::npos;
+    buf_.erase(0, end + 4);
+    while (fill()) {}
+    r.body = std::move(buf_);
+    buf_.clear();
+    return true;
+  }
+
+  /// The server closed the connection (rather than the read timing out).
+  bool closed() {
+    char b[256];
+    return buf_.empty() && c_->read_some(b, sizeof(b)) == 0;
+  }
+
+private:
+  bool fill() {
+    char b[16384];
+    long n = c_->read_some(b, sizeof(b));
+    if (n <= 0) return false;
+    buf_.append(b, (size_t)n);
+    return true;
+  }
+
+  std::unique_ptr<IConnection> c_;
+  std::string buf_;
+};
+
+std::string pattern(size_t n) {
+  std::string s(n, '\0');
+  for (size_t i = 0; i < n; i++) s[i] = (char)(i * 13 + i / 509);
+  return s;
+}
+
+bool rpc_ok(const Reply &r) {
+  return r.code == 200 && json::parse(r.body).as_obj().at("ok").as_bool();
+}
+
+// An HttpServer on an ephemeral port for the life of the fixture.
+struct Running {
+  explicit Running(CoreEngine &core, std::string token = {}, ServerState *st = nullptr)
+      : srv(core, std::move(token), st) {
+    t = std::thread([this] { srv.start(&running, 0); });
+    for (int i = 0; i < 500 && srv.bound_port() == 0; i++)
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ~Running() {
+    srv.stop();
+    t.join();
+  }
+  int port() const { return srv.bound_port(); }
+
+  std::atomic<bool> running{true};
+  HttpServer srv;
+  std::thread t;
+};
+
+std::string post(const std::string &path, const std::string &body) {
+  return "POST " + path + " HTTP/1.1\r\nContent-Length: " + std::to_string(body.size()) +
+         "\r\n\r\n" + body;
+}
+
+} // namespace
+
+DOCTEST_TEST_CASE("http: keep-alive connections answer pipelined requests in order") {
+  FakeBackend fb({{0x10, 0, 0, "Untitled - Notepad", "Notepad", true}});
+  CoreEngine core(&fb);
+  Running s(core);
+  DOCTEST_REQUIRE(s.port() != 0);
+  Client c(s.port());
+  DOCTEST_REQUIRE(c.ok());
+
+  // Three requests in one write, the last with its body split across two.
+  std::string body = R"({"text":"hello"})";
+  DOCTEST_REQUIRE(c.send("GET /api/v1/health HTTP/1.1\r\nHost: x\r\n\r\n"
+                         "GET /api/v1/windows HTTP/1.1\r\nHost: x\r\n\r\n"
+                         "POST /api/v1/type HTTP/1.1\r\nHost: x\r\nContent-Length: " +
+                         std::to_string(body.size()) + "\r\n\r\n" + body.substr(0, 5)));
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  DOCTEST_REQUIRE(c.send(body.substr(5)));
+
+  Reply r;
+  DOCTEST_REQUIRE(c.read(r));
+  DOCTEST_REQUIRE(rpc_ok(r));
+  DOCTEST_REQUIRE_EQ(r.headers["connection"], std::string("keep-alive"));
+  DOCTEST_REQUIRE(json::parse(r.body).as_obj().at("result").is_obj());
+  DOCTEST_REQUIRE(c.read(r));
+  DOCTEST_REQUIRE(rpc_ok(r));
+  DOCTEST_REQUIRE(json::parse(r.body).as_obj().at("result").is_arr());
+  DOCTEST_REQUIRE(c.read(r));
+  DOCTEST_REQUIRE(rpc_ok(r));
+
+  // A chunked body larger than one read, after an interim 100 Continue.
+  std::string text(20000, 'k');
+  std::string json_body = "{\"text\":\"" + text + "\"}";
+  DOCTEST_REQUIRE(c.send("POST /api/v1/type HTTP/1.1\r\nHost: x\r\n"
+                         "Transfer-Encoding: chunked\r\nExpect: 100-continue\r\n\r\n"));
+  DOCTEST_REQUIRE(c.read(r));
+  DOCTEST_REQUIRE_EQ(r.code, 100);
+  std::string chunked;
+  for (size_t i = 0; i < json_body.size(); i += 7000) {
+    auto part = json_body.substr(i, 7000);
+    char size[16];
+    std::snprintf(size, sizeof(size), "%zx", part.size());
+    chunked += std::string(size) + ";ext=1\r\n" + part + "\r\n";
+  }
+  DOCTEST_REQUIRE(c.send(chunked + "0\r\nX-Trailer: y\r\n\r\n"));
+  DOCTEST_REQUIRE(c.read(r));
+  DOCTEST_REQUIRE(rpc_ok(r));
+
+  // Connection: close is answered, then the server hangs up.
+  DOCTEST_REQUIRE(c.send("GET /api/v1/health HTTP/1.1\r\nConnection: close\r\n\r\n"
+                         "GET /api/v1/health HTTP/1.1\r\n\r\n"));
+  DOCTEST_REQUIRE(c.read(r));
+  DOCTEST_REQUIRE(rpc_ok(r));
+  DOCTEST_REQUIRE_EQ(r.headers["connection"], std::string("close"));
+  DOCTEST_REQUIRE(c.closed());
+
+  // HTTP/1.0 closes unless asked not to.
+  Client old(s.port());
+  DOCTEST_REQUIRE(old.send("GET /api/v1/health HTTP/1.0\r\n\r\n"));
+  DOCTEST_REQUIRE(old.read(r));
+  DOCTEST_REQUIRE(rpc_ok(r));
+  DOCTEST_REQUIRE(old.closed());
+}
+
+DOCTEST_TEST_CASE("http: malformed and oversized requests get a status, then a close") {
+  FakeBackend fb({});
+  CoreEngine core(&fb);
+  Running s(core, "secret");
+  Reply r;
+
+  struct Case {
+    std::string request;
+    int code;
+  } cases[] = {
+      {"POST /api/v1/type HTTP/1.1\r\nContent-Length: 12x\r\n\r\n", 400},
+      {"POST /api/v1/type HTTP/1.1\r\nContent-Length: 999999999\r\n\r\n", 413},
+      {"POST /api/v1/type HTTP/1.1\r\nContent-Length: 2\r\nTransfer-Encoding: chunked\r\n\r\n", 400},
+      {"POST /api/v1/type HTTP/1.1\r\nTransfer-Encoding: gzip\r\n\r\n", 501},
+      {"POST /api/v1/type HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n", 400},
+      {"GET /api/v1/health HTTP/2.0\r\n\r\n", 505},
+      {"GET /api/v1/health HTTP/1.1\r\nX: " + std::string(HttpServer::MAX_HEAD_BYTES, 'h'), 431},
+  };
+  for (auto &tc : cases) {
+    Client c(s.port());
+    DOCTEST_REQUIRE(c.send(tc.request));
+    DOCTEST_REQUIRE(c.read(r));
+    DOCTEST_REQUIRE_EQ(r.code, tc.code);
+    DOCTEST_REQUIRE(c.closed());
+  }
+
+  // Auth failures and unknown paths leave the connection usable.
+  Client c(s.port());
+  DOCTEST_REQUIRE(c.send("GET /api/v1/health HTTP/1.1\r\n\r\n"
+                         "GET /nope HTTP/1.1\r\nAuthorization: Bearer secret\r\n\r\n"
+                         "GET /api/v1/health HTTP/1.1\r\nAuthorization: Bearer secret\r\n\r\n"));
+  DOCTEST_REQUIRE(c.read(r));
+  DOCTEST_REQUIRE_EQ(r.code, 401);
+  DOCTEST_REQUIRE(c.read(r));
+  DOCTEST_REQUIRE_EQ(r.code, 404);
+  DOCTEST_REQUIRE(c.read(r));
+  DOCTEST_REQUIRE(rpc_ok(r));
+}
+
+DOCTEST_TEST_CASE("http: files stream as chunked responses") {
+  FakeBackend fb({});
+  auto data = pattern(600000);
+  fb.add_file("C:\\big.bin", data);
+  CoreEngine core(&fb);
+  Running s(core);
+  Client c(s.port());
+  Reply r;
+
+  DOCTEST_REQUIRE(c.send("GET /api/v1/file?path=C%3A%5Cbig.bin HTTP/1.1\r\n\r\n"));
+  DOCTEST_REQUIRE(c.read(r));
+  DOCTEST_REQUIRE_EQ(r.code, 200);
+  DOCTEST_REQUIRE(r.chunked);
+  DOCTEST_REQUIRE_EQ(r.headers["content-type"], std::string("application/octet-stream"));
+  DOCTEST_REQUIRE(r.body == data);
+
+  // A range, a missing file, then a plain request on the same connection.
+  DOCTEST_REQUIRE(c.send("GET /api/v1/file?path=C:%5Cbig.bin&offset=1000&length=300000 HTTP/1.1\r\n\r\n"
+                         "GET /api/v1/file?path=C:%5Cmissing HTTP/1.1\r\n\r\n"
+                         "GET /api/v1/health HTTP/1.1\r\n\r\n"));
+  DOCTEST_REQUIRE(c.read(r));
+  DOCTEST_REQUIRE(r.body == data.substr(1000, 300000));
+  DOCTEST_REQUIRE(c.read(r));
+  DOCTEST_REQUIRE_EQ(r.code, 404);
+  DOCTEST_REQUIRE(c.read(r));
+  DOCTEST_REQUIRE(rpc_ok(r));
+
+  // HTTP/1.0 has no chunking: the body runs to the close.
+  Client old(s.port());
+  DOCTEST_REQUIRE(old.send("GET /api/v1/file?path=C:%5Cbig.bin&length=5000 HTTP/1.0\r\n\r\n"));
+  DOCTEST_REQUIRE(old.read_to_close(r));
+  DOCTEST_REQUIRE_EQ(r.code, 200);
+  DOCTEST_REQUIRE(!r.chunked);
+  DOCTEST_REQUIRE(r.body == data.substr(0, 5000));
+}
+
+DOCTEST_TEST_CASE("http: /api/v1/rpc runs any method, batches, and picks its snapshot") {
+  FakeBackend fb({{0x10, 0, 0, "Untitled - Notepad", "Notepad", true}});
+  CoreEngine core(&fb);
+  ServerState st;
+  st.capture = std::make_unique<CaptureCoalescer>(&fb, 60000);
+  st.deny_methods = {"input.text"};
+  Running s(core, "", &st);
+  Client c(s.port());
+  Reply r;
+
+  // One request in, one response out, in the pipe/TCP format.
+  DOCTEST_REQUIRE(c.send(post("/api/v1/rpc", R"({"id":"a","method":"snapshot.capture","params":{}})")));
+  DOCTEST_REQUIRE(c.read(r));
+  DOCTEST_REQUIRE_EQ(r.code, 200);
+  auto a = json::parse(r.body).as_obj();
+  DOCTEST_REQUIRE_EQ(a.at("id").as_str(), std::string("a"));
+  std::string sid = a.at("result").as_obj().at("snapshot_id").as_str();
+
+  // A batch runs in order, through the same allow/deny lists; the stored
+  // snapshot still has one window, a cached capture too, a fresh one two.
+  fb.add_window({0x20, 0, 0, "Calculator", "CalcFrame", true});
+  DOCTEST_REQUIRE(c.send(post("/api/v1/rpc", "["
+      R"({"id":"1","method":"window.listTop","params":{"snapshot_id":")" + sid + R"("}},)"
+      R"({"id":"2","method":"window.listTop","params":{"max_age_ms":60000}},)"
+      R"({"id":"3","method":"window.listTop","params":{"max_age_ms":0}},)"
+      R"({"id":"4","method":"input.text","params":{"text":"x"}},)"
+      R"({"id":"5","method":"window.listTop","params":{"max_age_ms":-1}},)"
+      R"(7])")));
+  DOCTEST_REQUIRE(c.read(r));
+  DOCTEST_REQUIRE_EQ(r.code, 200);
+  auto out = json::parse(r.body).as_arr();
+  DOCTEST_REQUIRE_EQ(out.size(), 6u);
+  auto res = [&](size_t i) { return out[i].as_obj(); };
+  for (size_t i = 0; i < 5; i++)
+    DOCTEST_REQUIRE_EQ(res(i).at("id").as_str(), std::to_string(i + 1));
+  DOCTEST_REQUIRE_EQ(res(0).at("result").as_arr().size(), 1u);
+  DOCTEST_REQUIRE_EQ(res(1).at("result").as_arr().size(), 1u);
+  DOCTEST_REQUIRE(res(1).at("metrics").as_obj().at("capture_shared").as_bool());
+  DOCTEST_REQUIRE_EQ(res(2).at("result").as_arr().size(), 2u);
+  DOCTEST_REQUIRE(!res(2).at("metrics").as_obj().at("capture_shared").as_bool());
+  DOCTEST_REQUIRE_EQ(res(3).at("error").as_obj().at("code").as_str(), std::string("E_ACCESS_DENIED"));
+  DOCTEST_REQUIRE_EQ(res(4).at("error").as_obj().at("code").as_str(), std::string("E_BAD_REQUEST"));
+  DOCTEST_REQUIRE(!res(5).at("ok").as_bool());
+
+  // The fixed routes use the same pipeline.
+  DOCTEST_REQUIRE(c.send(post("/api/v1/type", R"({"text":"x"})")));
+  DOCTEST_REQUIRE(c.read(r));
+  DOCTEST_REQUIRE(!json::parse(r.body).as_obj().at("ok").as_bool());
+
+  std::string big = "[";
+  for (size_t i = 0; i <= HttpServer::MAX_BATCH; i++) big += std::string(i ? "," : "") + "{}";
+  DOCTEST_REQUIRE(c.send(post("/api/v1/rpc", big + "]") + post("/api/v1/rpc", "nope")));
+  DOCTEST_REQUIRE(c.read(r));
+  DOCTEST_REQUIRE_EQ(r.code, 413);
+  DOCTEST_REQUIRE(c.read(r));
+  DOCTEST_REQUIRE_EQ(r.code, 400);
+}
+
+DOCTEST_TEST_CASE("http: a long poll waits off the I/O thread") {
+  FakeBackend fb({{0x10, 0, 0, "Untitled - Notepad", "Notepad", true}});
+  CoreEngine core(&fb);
+  ServerState st;
+  st.io = std::make_shared<IoService>(1); // one loop thread to hold up
+  st.detector = std::make_unique<ChangeDetector>(
+      &fb, nullptr, [](std::vector<Event> &, const Snapshot &) {});
+  Running s(core, "", &st);
+
+  // In a batch, so the check is on every element and not just the first.
+  Client poller(s.port());
+  DOCTEST_REQUIRE(poller.send(post("/api/v1/rpc", "["
+      R"({"id":"1","method":"daemon.health","params":{}},)"
+      R"({"id":"2","method":"events.poll","params":{"since":1000000,"wait_ms":2000}}])")));
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  auto t0 = std::chrono::steady_clock::now();
+  Client c(s.port());
+  Reply r;
+  DOCTEST_REQUIRE(c.send("GET /api/v1/health HTTP/1.1\r\n\r\n"));
+  DOCTEST_REQUIRE(c.read(r));
+  DOCTEST_REQUIRE_EQ(r.code, 200);
+  DOCTEST_REQUIRE(std::chrono::steady_clock::now() - t0 < std::chrono::milliseconds(1000));
+
+  DOCTEST_REQUIRE(poller.read(r));
+  DOCTEST_REQUIRE_EQ(json::parse(r.body).as_arr().size(), 2u);
+  st.detector.reset();
+}
+
+DOCTEST_TEST_CASE("http: stopping the server ends its event feeds") {
+  FakeBackend fb({{0x10, 0, 0, "Untitled - Notepad", "Notepad", true}});
+  CoreEngine core(&fb);
+  ServerState st;
+  auto s = std::make_unique<Running>(core, "", &st);
+  Client c(s->port());
+  DOCTEST_REQUIRE(c.send("GET /api/v1/events HTTP/1.1\r\n\r\n"));
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  std::vector<Event> events(1);
+  events[0].type = "window.created";
+  events[0].hwnd = 0x30;
+  publish_events(&st, events, Snapshot{}); // wakes the feed
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+  // stop() waits for the feed, so the subscriber is gone before st is.
+  auto t0 = std::chrono::steady_clock::now();
+  s.reset();
+  DOCTEST_REQUIRE(std::chrono::steady_clock::now() - t0 < std::chrono::milliseconds(2000));
+  Reply r;
+  DOCTEST_REQUIRE(c.read_to_close(r));
+  DOCTEST_REQUIRE_EQ(r.code, 200);
+  DOCTEST_REQUIRE(r.body.find("retry: 2000") != std::string::npos);
+  DOCTEST_REQUIRE(r.body.find("id: 1\nevent: window.created\n") != std::string::npos);
+}
@@ -0,0 +1,291 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "doctest/doctest.h"
+#include "io_service.hpp"
+#include "local_server.hpp"
+#include "request_connection.hpp"
+#include "server_state.hpp"
+#include "transport.hpp"
+#include "wininspect/fake_backend.hpp"
+#include "wininspect/tinyjson.hpp"
+#include <chrono>
+#include <thread>
+
+using namespace wininspect;
+using namespace wininspectd;
+using namespace std::chrono_literals;
+
+namespace {
+
+// Echoes each frame; a long poll (wait_ms) sleeps 300 ms first, and a
+// request with sleep_ms sleeps that long.
+class EchoConnection final : public RequestConnection {
+public:
+  using RequestConnection::RequestConnection;
+  static inline std::atomic<int> closed{0};
+  ~EchoConnection() override { closed++; }
+
+protected:
+  void handle_frame(std::string frame, std::vector<wininspect::Attachment>) override {
+    if (plan(frame).blocking) std::this_thread::sleep_for(300ms);
+    try {
+      auto v = json::parse(frame);
+      const auto &params = v.as_obj().at("params").as_obj();
+      auto it = params.find("sleep_ms");
+      if (it != params.end())
+        std::this_thread::sleep_for(std::chrono::milliseconds((int)it->second.as_num()));
+    } catch (...) {
+    }
+    (void)send(frame);
+  }
+};
+
+// Answers any bytes with BIG bytes, written inline on the I/O thread.
+class BigReply final : public IoService::Handler {
+public:
+  using Handler::Handler;
+  static constexpr size_t BIG = 8 * 1024 * 1024;
+  void on_data(const char *, size_t) override {
+    static const std::string reply(BIG, 'x');
+    (void)connection().write_all(reply.data(), reply.size());
+  }
+  void on_close() override {}
+};
+
+std::string request(const std::string &id, const std::string &method, int sleep_ms = 0,
+                    bool ordered = false) {
+  std::string r = "{\"id\":\"" + id + "\",\"method\":\"" + method + "\",";
+  if (ordered) r += "\"ordered\":true,";
+  return r + "\"params\":{\"sleep_ms\":" + std::to_string(sleep_ms) + "}}";
+}
+
+std::string id_of(const std::string &frame) {
+  return json::parse(frame).as_obj().at("id").as_str();
+}
+
+std::string unique_name(const char *tag) {
+  auto t = std::chrono::steady_clock::now().time_since_epoch().count();
+  return std::string("wininspectd-test-") + tag + "-" + std::to_string(t);
+}
+
+// A listener whose accepted connections are handed to `io` as EchoConnections.
+struct EchoServer {
+  IoService &io;
+  ServerState st{};
+  std::string name = unique_name("echo");
+  std::unique_ptr<IListener> l = listen_local(name);
+
+  std::unique_ptr<IConnection> connect() {
+    std::unique_ptr<IConnection> server;
+    std::thread t([&] { server = l->accept(5000); });
+    auto c = connect_local(name);
+    t.join();
+    if (!c || !server) return nullptr;
+    io.add(std::make_shared<EchoConnection>(std::move(server), &io, &st));
+    return c;
+  }
+};
+
+} // namespace
+
+DOCTEST_TEST_CASE("frame decoder: byte-at-a-time input and bad lengths") {
+  std::string wire;
+  for (std::string p : {std::string("a"), std::string("hello"), std::string(70000, 'z')}) {
+    uint32_t n = (uint32_t)p.size();
+    wire.append((const char *)&n, 4);
+    wire += p;
+  }
+  FrameDecoder d;
+  std::vector<std::string> got;
+  std::string f;
+  for (char ch : wire) {
+    d.feed(&ch, 1);
+    while (d.next(f)) got.push_back(f);
+  }
+  DOCTEST_REQUIRE_EQ(got.size(), 3u);
+  DOCTEST_REQUIRE_EQ(got[1], std::string("hello"));
+  DOCTEST_REQUIRE_EQ(got[2].size(), 70000u);
+  DOCTEST_REQUIRE(!d.bad());
+
+  FrameDecoder small(16);
+  uint32_t big = 17;
+  small.feed((const char *)&big, 4);
+  DOCTEST_REQUIRE(!small.next(f));
+  DOCTEST_REQUIRE(small.bad());
+}
+
+DOCTEST_TEST_CASE("io service: a long poll waits off the I/O thread, in order") {
+  IoService io(1);
+  EchoServer srv{io};
+  auto a = srv.connect();
+  auto b = srv.connect();
+  DOCTEST_REQUIRE(a && b);
+
+  std::string poll = "{\"id\":\"p\",\"method\":\"events.poll\",\"params\":{\"wait_ms\":1}}";
+  DOCTEST_REQUIRE(write_frame(*a, poll));
+  DOCTEST_REQUIRE(write_frame(*a, "after"));
+  std::this_thread::sleep_for(20ms);
+  auto t0 = std::chrono::steady_clock::now();
+  DOCTEST_REQUIRE(write_frame(*b, "ping"));
+  std::string r;
+  DOCTEST_REQUIRE(read_frame(*b, r));
+  DOCTEST_REQUIRE_EQ(r, std::string("ping"));
+  DOCTEST_REQUIRE(std::chrono::steady_clock::now() - t0 < 250ms); // not behind the sleep
+
+  DOCTEST_REQUIRE(read_frame(*a, r));
+  DOCTEST_REQUIRE_EQ(r, poll);
+  DOCTEST_REQUIRE(read_frame(*a, r)); // events.* is ordered, so this waited
+  DOCTEST_REQUIRE_EQ(r, std::string("after"));
+}
+
+DOCTEST_TEST_CASE("io service: a client that stops reading is shut down, not waited on") {
+  IoService io(1, 64, 200);
+  std::string name = unique_name("stall");
+  auto l = listen_local(name);
+  auto connect = [&] {
+    std::unique_ptr<IConnection> server;
+    std::thread t([&] { server = l->accept(5000); });
+    auto c = connect_local(name);
+    t.join();
+    DOCTEST_REQUIRE((c && server));
+    io.add(std::make_shared<BigReply>(std::move(server)));
+    c->set_read_timeout(5000);
+    return c;
+  };
+  char buf[64 * 1024];
+
+  // Its reply fills the socket buffers and holds the only I/O thread...
+  auto stalled = connect();
+  DOCTEST_REQUIRE(stalled->write_all("?", 1));
+  std::this_thread::sleep_for(50ms);
+
+  // ...until the write timeout, after which other clients are served.
+  auto t0 = std::chrono::steady_clock::now();
+  auto reader = connect();
+  DOCTEST_REQUIRE(reader->write_all("?", 1));
+  size_t got = 0;
+  for (long n; got < BigReply::BIG && (n = reader->read_some(buf, sizeof(buf))) > 0;)
+    got += (size_t)n;
+  DOCTEST_REQUIRE_EQ(got, BigReply::BIG);
+  DOCTEST_REQUIRE(std::chrono::steady_clock::now() - t0 < 3s);
+
+  // The stalled client gets what was sent before the cut, then EOF.
+  long n;
+  got = 0;
+  while ((n = stalled->read_some(buf, sizeof(buf))) > 0) got += (size_t)n;
+  DOCTEST_REQUIRE_EQ(n, 0);
+  DOCTEST_REQUIRE(got < BigReply::BIG);
+  io.stop();
+}
+
+DOCTEST_TEST_CASE("io service: pipelined requests answer as they complete") {
+  IoService io(2);
+  EchoServer srv{io};
+  auto c = srv.connect();
+  DOCTEST_REQUIRE(c != nullptr);
+
+  DOCTEST_REQUIRE(write_frame(*c, request("slow", "ui.inspect", 300)));
+  DOCTEST_REQUIRE(write_frame(*c, request("fast", "window.getInfo")));
+  std::string r;
+  DOCTEST_REQUIRE(read_frame(*c, r));
+  DOCTEST_REQUIRE_EQ(id_of(r), std::string("fast"));
+  DOCTEST_REQUIRE(read_frame(*c, r));
+  DOCTEST_REQUIRE_EQ(id_of(r), std::string("slow"));
+}
+
+DOCTEST_TEST_CASE("io service: ordered requests are sequence points") {
+  IoService io(4);
+  EchoServer srv{io};
+  auto c = srv.connect();
+  DOCTEST_REQUIRE(c != nullptr);
+
+  DOCTEST_REQUIRE(write_frame(*c, request("1", "window.getInfo", 200)));
+  DOCTEST_REQUIRE(write_frame(*c, request("2", "window.move", 0, true)));
+  DOCTEST_REQUIRE(write_frame(*c, request("3", "input.send")));
+  DOCTEST_REQUIRE(write_frame(*c, request("4", "window.getInfo")));
+  std::string r;
+  for (const char *want : {"1", "2", "3", "4"}) {
+    DOCTEST_REQUIRE(read_frame(*c, r));
+    DOCTEST_REQUIRE_EQ(id_of(r), std::string(want));
+  }
+}
+
+DOCTEST_TEST_CASE("io service: max_inflight caps one connection's concurrency") {
+  IoService io(4);
+  EchoServer srv{io};
+  srv.st.max_inflight = 2;
+  auto c = srv.connect();
+  DOCTEST_REQUIRE(c != nullptr);
+
+  auto t0 = std::chrono::steady_clock::now();
+  for (const char *id : {"a", "b", "c"})
+    DOCTEST_REQUIRE(write_frame(*c, request(id, "ui.inspect", 150)));
+  std::string r;
+  for (int i = 0; i < 2; i++) DOCTEST_REQUIRE(read_frame(*c, r));
+  DOCTEST_REQUIRE(std::chrono::steady_clock::now() - t0 < 290ms); // two at once
+  DOCTEST_REQUIRE(read_frame(*c, r));
+  DOCTEST_REQUIRE_EQ(id_of(r), std::string("c"));
+  DOCTEST_REQUIRE(std::chrono::steady_clock::now() - t0 >= 300ms); // the third waited
+}
+
+DOCTEST_TEST_CASE("io service: peer close and stop() both release connections") {
+  EchoConnection::closed = 0;
+  IoService io(2);
+  EchoServer srv{io};
+  std::vector<std::unique_ptr<IConnection>> cs;
+  for (int i = 0; i < 8; i++) cs.push_back(srv.connect());
+  for (auto &c : cs) DOCTEST_REQUIRE(c != nullptr);
+  DOCTEST_REQUIRE_EQ(io.connections(), 8u);
+
+  cs.pop_back(); // the client hangs up
+  for (int i = 0; i < 200 && io.connections() != 7; i++) std::this_thread::sleep_for(5ms);
+  DOCTEST_REQUIRE_EQ(io.connections(), 7u);
+  DOCTEST_REQUIRE_EQ(EchoConnection::closed.load(), 1);
+
+  io.stop(); // server side shuts down the rest
+  DOCTEST_REQUIRE_EQ(io.connections(), 0u);
+  DOCTEST_REQUIRE_EQ(EchoConnection::closed.load(), 8);
+  std::string r;
+  for (auto &c : cs) DOCTEST_REQUIRE(!read_frame(*c, r));
+}
+
+DOCTEST_TEST_CASE("io service: many local clients on a few threads") {
+  FakeBackend fb({{0x10, 0, 0, "Untitled - Notepad", "Notepad", true}});
+  ServerState st;
+  st.max_connections = 1000;
+  st.io = std::make_shared<IoService>(2);
+  std::atomic<bool> running{true};
+  auto name = unique_name("many");
+  LocalServer srv(&st, &fb);
+  std::thread t([&] { srv.start(&running, name); });
+
+  std::vector<std::unique_ptr<IConnection>> cs;
+  for (int i = 0; i < 300; i++) {
+    std::unique_ptr<IConnection> c;
+    for (int k = 0; k < 200 && !c; k++) {
+      c = connect_local(name);
+      if (!c) std::this_thread::sleep_for(10ms);
+    }
+    DOCTEST_REQUIRE(c != nullptr);
+    cs.push_back(std::move(c));
+  }
+  std::string req = "{\"id\":\"1\",\"method\":\"window.listTop\",\"params\":{}}";
+  for (auto &c : cs) DOCTEST_REQUIRE(write_frame(*c, req));
+  for (auto &c : cs) {
+    std::string r;
+    DOCTEST_REQUIRE(read_frame(*c, r));
+    DOCTEST_REQUIRE(json::parse(r).as_obj().at("ok").as_bool());
+    DOCTEST_REQUIRE_EQ(id_of(r), std::string("1"));
+  }
+  DOCTEST_REQUIRE_EQ(st.active_connections.load(), 300);
+  DOCTEST_REQUIRE_EQ(st.io->threads(), 2u);
+
+  cs.clear();
+  for (int i = 0; i < 200 && st.active_connections.load() != 0; i++)
+    std::this_thread::sleep_for(5ms);
+  DOCTEST_REQUIRE_EQ(st.active_connections.load(), 0);
+  srv.stop();
+  t.join();
+  st.io->stop();
+}
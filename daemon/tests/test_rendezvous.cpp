@@ -0,0 +1,293 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "doctest/doctest.h"
+#include "rendezvous_client.hpp"
+#include "rendezvous_registry.hpp"
+#include "rendezvous_server.hpp"
+#include "timing_wheel.hpp"
+#include "transport.hpp"
+#include "wininspect/tinyjson.hpp"
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <thread>
+
+using namespace wininspect;
+using namespace wininspectd;
+
+namespace {
+
+RendezvousInstance inst(const std::string &uuid, int port = 4000, int ttl_sec = 60) {
+  RendezvousInstance i;
+  i.uuid = uuid;
+  i.name = "n-" + uuid;
+  i.host = "10.0.0.1";
+  i.port = port;
+  i.ttl_sec = ttl_sec;
+  return i;
+}
+
+std::vector<std::string> uuids(const std::vector<RendezvousInstance> &v) {
+  std::vector<std::string> out;
+  for (auto &i : v) out.push_back(i.uuid);
+  std::sort(out.begin(), out.end());
+  return out;
+}
+
+struct Reply {
+  int code = 0;
+  std::map<std::string, std::string> headers; // names lowercased
+  std::string body;
+};
+
+// Keep-alive requests over one connection.
+class Client {
+public:
+  explicit Client(int port) : c_(connect_tcp("127.0.0.1", port)) {
+    if (c_) c_->set_read_timeout(5000);
+  }
+  bool ok() const { return c_ != nullptr; }
+
+  Reply request(const std::string &method, const std::string &path,
+                const std::string &body = {}, const std::string &extra = {}) {
+    std::string req = method + " " + path + " HTTP/1.1\r\nHost: x\r\n" + extra;
+    if (!body.empty()) req += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+    req += "\r\n" + body;
+    Reply r;
+    if (!c_->write_all(req.data(), req.size())) return r;
+    size_t end;
+    while ((end = buf_.find("\r\n\r\n")) == std::string::npos)
+      if (!fill()) return r;
+    std::string head = buf_.substr(0, end);
+    buf_.erase(0, end + 4);
+    r.code = std::atoi(head.c_str() + 9);
+    for (size_t p = head.find("\r\n"); p != std::string::npos;) {
+      size_t e = head.find("\r\n", p + 2);
+      std::string line = head.substr(p + 2, e == std::string::npos ? e : e - p - 2);
+      size_t c = line.find(": ");
+      std::string name = line.substr(0, c);
+      for (auto &ch : name) ch = (char)std::tolower((unsigned char)ch);
+      r.headers[name] = line.substr(c + 2);
+      p = e;
+    }
+    size_t n = std::stoul(r.headers["content-length"]);
+    while (buf_.size() < n)
+      if (!fill()) return Reply{};
+    r.body = buf_.substr(0, n);
+    buf_.erase(0, n);
+    return r;
+  }
+
+private:
+  bool fill() {
+    char b[16384];
+    long n = c_->read_some(b, sizeof(b));
+    if (n <= 0) return false;
+    buf_.append(b, (size_t)n);
+    return true;
+  }
+
+  std::unique_ptr<IConnection> c_;
+  std::string buf_;
+};
+
+// A RendezvousServer on an ephemeral port for the life of the fixture.
+struct Running {
+  Running() : srv(reg, 2) {
+    t = std::thread([this] { srv.start(&running, 0); });
+    for (int i = 0; i < 500 && srv.bound_port() == 0; i++)
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ~Running() {
+    srv.stop();
+    t.join();
+  }
+  int port() const { return srv.bound_port(); }
+
+  std::atomic<bool> running{true};
+  RendezvousRegistry reg;
+  RendezvousServer srv;
+  std::thread t;
+};
+
+std::string reg_body(const std::string &uuid, int port) {
+  return R"({"uuid":")" + uuid + R"(","name":"box","host":"10.0.0.2","port":)" +
+         std::to_string(port) + "}";
+}
+
+} // namespace
+
+DOCTEST_TEST_CASE("timing wheel: entries fire once, on their tick, across levels") {
+  TimingWheel<int> w(100);
+  for (int d : {0, 1, 63, 64, 65, 4095, 4096, 300000}) w.schedule(100 + (std::uint64_t)d, d);
+  w.schedule(50, -1); // already passed: the next tick
+  DOCTEST_REQUIRE(w.size() == 9);
+
+  std::vector<std::pair<std::uint64_t, int>> fired;
+  auto rec = [&](std::uint64_t at) { return [&, at](int &&v) { fired.emplace_back(at, v); }; };
+  for (std::uint64_t t = 100; t <= 100 + 300000; t++) w.advance(t, rec(t));
+  DOCTEST_REQUIRE(fired.size() == 9);
+  for (auto &[at, v] : fired) {
+    if (v < 0) DOCTEST_REQUIRE(at == 100);
+    else DOCTEST_REQUIRE(at == 100 + (std::uint64_t)v);
+  }
+  DOCTEST_REQUIRE(w.size() == 0);
+
+  // One advance over a long gap fires everything due, in order.
+  std::vector<int> order;
+  for (int d : {5000, 7, 70}) w.schedule(w.now() + d, d);
+  w.advance(w.now() + 10000, [&](int &&v) { order.push_back(v); });
+  DOCTEST_REQUIRE((order == std::vector<int>{7, 70, 5000}));
+}
+
+DOCTEST_TEST_CASE("rendezvous registry: versions, deltas and removals") {
+  RendezvousRegistry::Options o;
+  o.shards = 4;
+  RendezvousRegistry r(o, 0);
+  DOCTEST_REQUIRE(r.version() == 0);
+  auto va = r.upsert(inst("a"), 0);
+  auto vb = r.upsert(inst("b"), 0);
+  DOCTEST_REQUIRE(vb == va + 1);
+  DOCTEST_REQUIRE(r.size() == 2);
+
+  // Re-registering unchanged, and heartbeats, are not changes.
+  DOCTEST_REQUIRE(r.upsert(inst("a"), 10) == va);
+  DOCTEST_REQUIRE(r.heartbeat("b", 20));
+  DOCTEST_REQUIRE(!(r.heartbeat("zz", 20)));
+  DOCTEST_REQUIRE(r.version() == vb);
+
+  auto v0 = r.version();
+  DOCTEST_REQUIRE(r.upsert(inst("a", 4001), 30) == v0 + 1); // moved port
+  r.upsert(inst("c"), 30);
+  DOCTEST_REQUIRE(r.remove("b"));
+  DOCTEST_REQUIRE(!(r.remove("b")));
+
+  auto d = r.since(v0);
+  DOCTEST_REQUIRE(!(d.full));
+  DOCTEST_REQUIRE(d.version == r.version());
+  DOCTEST_REQUIRE((uuids(d.changed) == std::vector<std::string>{"a", "c"}));
+  DOCTEST_REQUIRE((d.removed == std::vector<std::string>{"b"}));
+  DOCTEST_REQUIRE(r.since(r.version()).changed.empty());
+
+  // 0 and versions the server never issued get everything.
+  for (auto v : {std::uint64_t(0), r.version() + 5}) {
+    auto f = r.since(v);
+    DOCTEST_REQUIRE(f.full);
+    DOCTEST_REQUIRE((uuids(f.changed) == std::vector<std::string>{"a", "c"}));
+  }
+  std::uint64_t lv = 0;
+  DOCTEST_REQUIRE(r.list(&lv).size() == 2);
+  DOCTEST_REQUIRE(lv == r.version());
+}
+
+DOCTEST_TEST_CASE("rendezvous registry: a trimmed change log falls back to the full list") {
+  RendezvousRegistry::Options o;
+  o.change_log = 4;
+  RendezvousRegistry r(o, 0);
+  for (int i = 0; i < 10; i++) r.upsert(inst("i" + std::to_string(i)), 0);
+  DOCTEST_REQUIRE(!(r.since(7).full));
+  DOCTEST_REQUIRE(r.since(7).changed.size() == 3);
+  auto d = r.since(2);
+  DOCTEST_REQUIRE(d.full);
+  DOCTEST_REQUIRE(d.changed.size() == 10);
+}
+
+DOCTEST_TEST_CASE("rendezvous registry: silent instances expire; heartbeats postpone it") {
+  RendezvousRegistry::Options o;
+  o.expiry_factor = 3;
+  o.tick_ms = 100;
+  RendezvousRegistry r(o, 0);
+  r.upsert(inst("quiet", 1, 1), 0);  // due at 3 s
+  r.upsert(inst("alive", 1, 1), 0);
+  r.upsert(inst("slow", 1, 60), 0); // due at 180 s
+  for (std::int64_t t = 0; t <= 2900; t += 100) DOCTEST_REQUIRE(r.expire(t) == 0);
+  r.heartbeat("alive", 2900);
+  auto v = r.version();
+  DOCTEST_REQUIRE(r.expire(3100) == 1);
+  auto d = r.since(v);
+  DOCTEST_REQUIRE((d.removed == std::vector<std::string>{"quiet"}));
+  DOCTEST_REQUIRE(r.expire(5800) == 0);
+  DOCTEST_REQUIRE(r.expire(6000) == 1); // alive's last heartbeat + 3 s
+  DOCTEST_REQUIRE(r.size() == 1);
+
+  // A shorter TTL on re-registration takes effect.
+  r.upsert(inst("slow", 1, 2), 6000);
+  DOCTEST_REQUIRE(r.expire(11900) == 0);
+  DOCTEST_REQUIRE(r.expire(12100) == 1);
+  DOCTEST_REQUIRE(r.size() == 0);
+}
+
+DOCTEST_TEST_CASE("rendezvous server: register, heartbeat, deltas and 304 over keep-alive") {
+  Running s;
+  DOCTEST_REQUIRE(s.port() != 0);
+  Client c(s.port());
+  DOCTEST_REQUIRE(c.ok());
+
+  auto r = c.request("POST", "/api/v1/rendezvous/register", reg_body("u1", 9001));
+  DOCTEST_REQUIRE(r.code == 201);
+  r = c.request("POST", "/api/v1/rendezvous/register", reg_body("u2", 9002));
+  DOCTEST_REQUIRE(r.code == 201);
+  DOCTEST_REQUIRE((c.request("POST", "/api/v1/rendezvous/register", "{}").code == 400));
+  DOCTEST_REQUIRE(c.request("PUT", "/api/v1/rendezvous/heartbeat/u1").code == 200);
+  DOCTEST_REQUIRE(c.request("PUT", "/api/v1/rendezvous/heartbeat/nope").code == 404);
+
+  // The plain list is the bare array older clients read.
+  r = c.request("GET", "/api/v1/rendezvous/instances");
+  DOCTEST_REQUIRE(r.code == 200);
+  DOCTEST_REQUIRE(json::parse(r.body).as_arr().size() == 2);
+  std::string etag = r.headers["etag"];
+  DOCTEST_REQUIRE(etag == "\"2\"");
+  DOCTEST_REQUIRE(c.request("GET", "/api/v1/rendezvous/instances", {},
+                          "If-None-Match: " + etag + "\r\n").code == 304);
+  DOCTEST_REQUIRE(c.request("GET", "/api/v1/rendezvous/instances?since=2").code == 304);
+
+  DOCTEST_REQUIRE(c.request("DELETE", "/api/v1/rendezvous/instances/u1").code == 200);
+  r = c.request("POST", "/api/v1/rendezvous/register", reg_body("u3", 9003));
+  r = c.request("GET", "/api/v1/rendezvous/instances?since=2");
+  DOCTEST_REQUIRE(r.code == 200);
+  auto o = json::parse(r.body).as_obj();
+  DOCTEST_REQUIRE(o.at("version").as_num() == 4);
+  DOCTEST_REQUIRE(!(o.at("full").as_bool()));
+  DOCTEST_REQUIRE(o.at("instances").as_arr().size() == 1);
+  auto u3 = o.at("instances").as_arr()[0].as_obj();
+  DOCTEST_REQUIRE(u3.at("uuid").as_str() == "u3");
+  DOCTEST_REQUIRE(u3.at("port").as_num() == 9003);
+  DOCTEST_REQUIRE(o.at("removed").as_arr().size() == 1);
+  DOCTEST_REQUIRE(o.at("removed").as_arr()[0].as_str() == "u1");
+  DOCTEST_REQUIRE(r.headers["etag"] == "\"4\"");
+
+  DOCTEST_REQUIRE(c.request("GET", "/api/v1/rendezvous/instances?since=x").code == 400);
+  r = c.request("GET", "/health");
+  DOCTEST_REQUIRE(json::parse(r.body).as_obj().at("instances").as_num() == 2);
+}
+
+DOCTEST_TEST_CASE("rendezvous client: discover() applies deltas on top of what it knows") {
+  Running s;
+  DOCTEST_REQUIRE(s.port() != 0);
+  RendezvousConfig cfg;
+  cfg.url = "http://127.0.0.1:" + std::to_string(s.port()) + "/api/v1/rendezvous";
+  auto rc = create_rendezvous_client(cfg);
+  DOCTEST_REQUIRE(rc);
+
+  InstanceIdentity id;
+  id.uuid = "self";
+  id.name = "me";
+  DOCTEST_REQUIRE(rc->register_instance(id, "10.0.0.9", 7000));
+  DOCTEST_REQUIRE(s.reg.size() == 1);
+  s.reg.upsert(inst("other"), 0);
+
+  auto names = [](const std::vector<DiscoveredInstance> &v) {
+    std::vector<std::string> out;
+    for (auto &d : v) out.push_back(d.uuid);
+    std::sort(out.begin(), out.end());
+    return out;
+  };
+  DOCTEST_REQUIRE((names(rc->discover()) == std::vector<std::string>{"other", "self"}));
+  DOCTEST_REQUIRE((names(rc->discover()) == std::vector<std::string>{"other", "self"})); // 304
+  s.reg.remove("other");
+  s.reg.upsert(inst("third"), 0);
+  DOCTEST_REQUIRE((names(rc->discover()) == std::vector<std::string>{"self", "third"}));
+  DOCTEST_REQUIRE(rc->deregister());
+  DOCTEST_REQUIRE((names(rc->discover()) == std::vector<std::string>{"third"}));
+}
@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "doctest/doctest.h"
+#include "request_handler.hpp"
+#include "server_state.hpp"
+#include "wininspect/snapshot_journal.hpp"
+#include "wininspect/window_index.hpp"
+#include <filesystem>
+
+using namespace wininspect;
+using namespace wininspectd;
+namespace fs = std::filesystem;
+
+DOCTEST_TEST_CASE("snapshot.load: loaded snapshots are bounded by max_snapshots") {
+  fs::path dir = fs::temp_directory_path() / "wininspect_load_lru";
+  fs::remove_all(dir);
+  {
+    ServerState st;
+    st.max_snapshots = 3;
+    st.journal = std::make_shared<SnapshotJournal>(SnapshotJournal::Options{dir.string()});
+    std::vector<std::uint64_t> seqs;
+    for (int i = 0; i < 6; i++) {
+      Snapshot s;
+      s.top.push_back(0x100 + i);
+      s.index = std::make_shared<WindowIndex>(
+          std::vector<IndexedWindow>{{(hwnd_u64)(0x100 + i), "w" + std::to_string(i), "C"}});
+      seqs.push_back(st.journal->append(s));
+    }
+    st.journal->flush();
+
+    // Pin the first load; eviction must skip it.
+    std::string first;
+    for (auto seq : seqs) {
+      CoreRequest req;
+      req.method = "snapshot.load";
+      req.params["journal_id"] = make_journal_id(seq);
+      CoreResponse resp;
+      handle_journal_request(req, &st, resp);
+      DOCTEST_REQUIRE(resp.ok);
+      std::string sid = resp.result.as_obj().at("snapshot_id").as_str();
+      if (first.empty()) {
+        first = sid;
+        st.pinned_counts[first]++;
+      }
+    }
+    DOCTEST_REQUIRE(st.snaps.size() == 3);
+    DOCTEST_REQUIRE(st.lru_order.size() == 3);
+    DOCTEST_REQUIRE(st.snaps.count(first) == 1);
+  }
+  std::error_code ec;
+  fs::remove_all(dir, ec);
+}
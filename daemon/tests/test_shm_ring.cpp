@@ -0,0 +1,227 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "doctest/doctest.h"
+#include "local_server.hpp"
+#include "server_state.hpp"
+#include "shm_ring.hpp"
+#include "transport.hpp"
+#include "wininspect/core.hpp"
+#include "wininspect/fake_backend.hpp"
+#include "wininspect/tinyjson.hpp"
+#include <chrono>
+#include <map>
+#include <thread>
+
+using namespace wininspect;
+using namespace wininspectd;
+
+namespace {
+
+std::string unique_name(const char *tag) {
+  auto t = std::chrono::steady_clock::now().time_since_epoch().count();
+  return std::string("wininspectd-test-") + tag + "-" + std::to_string(t);
+}
+
+std::unique_ptr<IConnection> connect_retry(const std::string &name) {
+  for (int i = 0; i < 200; i++) {
+    if (auto c = connect_local(name)) return c;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return nullptr;
+}
+
+std::string pattern(size_t n) {
+  std::string s(n, '\0');
+  for (size_t i = 0; i < n; i++) s[i] = (char)(i * 7 + i / 251);
+  return s;
+}
+
+std::string file_read(const std::string &id, double offset, double length) {
+  json::Object p;
+  p["path"] = std::string("C:\\big.bin");
+  p["offset"] = offset;
+  p["length"] = length;
+  json::Object req;
+  req["id"] = id;
+  req["method"] = std::string("file.read");
+  req["params"] = p;
+  req["binary"] = true;
+  return json::dumps(req);
+}
+
+// A multipart file.read response: its id and content.
+std::pair<std::string, std::string> file_chunk(std::string_view payload) {
+  std::string body;
+  std::vector<Attachment> atts;
+  if (!split_multipart(payload, body, atts) || atts.size() != 1) return {};
+  return {json::parse(body).as_obj().at("id").as_str(),
+          std::string(atts[0].begin(), atts[0].end())};
+}
+
+} // namespace
+
+DOCTEST_TEST_CASE("shm ring: records wrap, stay contiguous and free in order") {
+  auto region = ShmRegion::create(4096);
+  DOCTEST_REQUIRE(region != nullptr);
+  auto &ring = region->to_client();
+  size_t cap = ring.capacity();
+  DOCTEST_REQUIRE(cap >= 4096);
+
+  ShmSpan s;
+  std::uint8_t wire[ShmSpan::WIRE_BYTES];
+  for (int i = 0; i < 50; i++) {
+    std::string a = pattern(700 + i * 13), b = "#" + std::to_string(i);
+    ConstBuffer parts[] = {{a.data(), a.size()}, {b.data(), b.size()}};
+    DOCTEST_REQUIRE(ring.write(parts, 2, s, 0));
+    DOCTEST_REQUIRE(s.pos % cap + s.len <= cap); // never split across the end
+    s.encode(wire);
+    ShmSpan t;
+    DOCTEST_REQUIRE(t.decode(wire, sizeof(wire)));
+    const std::uint8_t *p = ring.at(t);
+    DOCTEST_REQUIRE(p != nullptr);
+    DOCTEST_REQUIRE(std::string((const char *)p, t.len) == a + b);
+    ring.release(t);
+  }
+  DOCTEST_REQUIRE(s.pos > 4 * cap); // went round several times
+  DOCTEST_REQUIRE(!s.decode(wire, sizeof(wire) - 1));
+
+  // Full: no room until the consumer frees some, which wakes the producer.
+  std::string rec(cap / 3, 'r');
+  ConstBuffer one{rec.data(), rec.size()};
+  std::vector<ShmSpan> held;
+  while (ring.write(&one, 1, s, 0)) held.push_back(s);
+  DOCTEST_REQUIRE(held.size() >= 2); // three, unless one had to skip the end
+  std::thread consumer([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ring.release(held[0]);
+  });
+  auto t0 = std::chrono::steady_clock::now();
+  DOCTEST_REQUIRE(ring.write(&one, 1, s, 5000));
+  consumer.join();
+  DOCTEST_REQUIRE(std::chrono::steady_clock::now() - t0 < std::chrono::seconds(2));
+
+  // Spans that are not records in flight are refused.
+  DOCTEST_REQUIRE(ring.at(held[0]) == nullptr); // freed
+  DOCTEST_REQUIRE(ring.at(held[1]) != nullptr);
+  DOCTEST_REQUIRE(ring.at({s.pos + 8, s.len}) == nullptr);       // past the tail
+  DOCTEST_REQUIRE(ring.at({s.pos, (std::uint32_t)cap + 1}) == nullptr);
+  DOCTEST_REQUIRE(ring.at({cap - 8 + cap * 100, 16}) == nullptr); // across the end
+  DOCTEST_REQUIRE(ring.at({s.pos, 0}) == nullptr);
+  std::string huge(cap + 1, 'h');
+  ConstBuffer too_big{huge.data(), huge.size()};
+  DOCTEST_REQUIRE(!ring.write(&too_big, 1, s, 0));
+}
+
+DOCTEST_TEST_CASE("shm transport: large frames are read in place, small ones inline") {
+  FakeBackend fb({{0x10, 0, 0, "Untitled - Notepad", "Notepad", true}});
+  auto data = pattern(1000000);
+  fb.add_file("C:\\big.bin", data);
+  ServerState st;
+  st.shm_ring_bytes = 1024 * 1024;
+  st.shm_min_bytes = 1024;
+  std::atomic<bool> running{true};
+  auto name = unique_name("shm");
+  LocalServer srv(&st, &fb);
+  std::thread t([&] { srv.start(&running, name); });
+  auto c = connect_retry(name);
+  DOCTEST_REQUIRE(c != nullptr);
+  c->set_read_timeout(5000);
+  ShmClient client(*c);
+  DOCTEST_REQUIRE(client.attached());
+
+  std::string_view payload;
+  std::uint32_t flags = 0;
+  DOCTEST_REQUIRE(client.write(file_read("a", 1000, 300000)));
+  DOCTEST_REQUIRE(client.read(payload, &flags));
+  DOCTEST_REQUIRE_EQ(flags, FRAME_MULTIPART);
+  DOCTEST_REQUIRE_EQ(client.in_place(), 1u);
+  auto got = file_chunk(payload);
+  DOCTEST_REQUIRE_EQ(got.first, std::string("a"));
+  DOCTEST_REQUIRE(got.second == data.substr(1000, 300000));
+
+  DOCTEST_REQUIRE(client.write(std::string(R"({"id":"l","method":"window.listTop","params":{}})")));
+  DOCTEST_REQUIRE(client.read(payload, &flags));
+  DOCTEST_REQUIRE_EQ(flags, 0u);
+  DOCTEST_REQUIRE_EQ(client.in_place(), 1u);
+  DOCTEST_REQUIRE(json::parse(payload).as_obj().at("ok").as_bool());
+
+  // A large request goes through the other ring.
+  json::Object ref;
+  ref["attachment"] = 0.0;
+  json::Object params;
+  params["pid"] = 1.0; params["address"] = 4096.0; params["data"] = ref;
+  json::Object req;
+  req["id"] = std::string("w");
+  req["method"] = std::string("mem.write");
+  req["params"] = params;
+  std::string mp;
+  append_multipart(mp, json::dumps(req), {Attachment(200000, 0x90)});
+  DOCTEST_REQUIRE(client.write(mp.data(), mp.size(), FRAME_MULTIPART));
+  DOCTEST_REQUIRE(client.read(payload, &flags));
+  auto w = json::parse(payload).as_obj();
+  DOCTEST_REQUIRE_EQ(w.at("id").as_str(), std::string("w"));
+  DOCTEST_REQUIRE(w.at("ok").as_bool());
+
+  // A client that falls behind fills the ring; the daemon then waits a
+  // little and sends the rest inline, so nothing is lost or reordered.
+  const int n = 10;
+  for (int i = 0; i < n; i++)
+    DOCTEST_REQUIRE(client.write(file_read(std::to_string(i), i * 50000.0, 300000)));
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  auto before = client.in_place();
+  std::map<std::string, std::string> chunks;
+  for (int i = 0; i < n; i++) {
+    DOCTEST_REQUIRE(client.read(payload, &flags));
+    DOCTEST_REQUIRE_EQ(flags, FRAME_MULTIPART);
+    chunks.insert(file_chunk(payload));
+  }
+  DOCTEST_REQUIRE_EQ(chunks.size(), (size_t)n);
+  for (int i = 0; i < n; i++)
+    DOCTEST_REQUIRE(chunks[std::to_string(i)] == data.substr(i * 50000, 300000));
+  auto ringed = client.in_place() - before;
+  DOCTEST_REQUIRE(ringed >= 2u);
+  DOCTEST_REQUIRE(ringed < (std::uint64_t)n);
+
+  // A second handshake is refused; the rings stay as they were.
+  DOCTEST_REQUIRE(client.write(std::string(R"({"id":"x","method":"transport.shm","params":{}})")));
+  DOCTEST_REQUIRE(client.read(payload, &flags));
+  DOCTEST_REQUIRE(!json::parse(payload).as_obj().at("ok").as_bool());
+  c.reset();
+
+  srv.stop();
+  t.join();
+}
+
+DOCTEST_TEST_CASE("shm transport: without rings the client uses the connection alone") {
+  FakeBackend fb({});
+  fb.add_file("C:\\big.bin", pattern(200000));
+  ServerState st;
+  st.shm_ring_bytes = 0;
+  std::atomic<bool> running{true};
+  auto name = unique_name("noshm");
+  LocalServer srv(&st, &fb);
+  std::thread t([&] { srv.start(&running, name); });
+  auto c = connect_retry(name);
+  DOCTEST_REQUIRE(c != nullptr);
+  c->set_read_timeout(5000);
+  ShmClient client(*c);
+  DOCTEST_REQUIRE(!client.attached());
+
+  std::string_view payload;
+  std::uint32_t flags = 0;
+  DOCTEST_REQUIRE(client.write(file_read("a", 0, 150000)));
+  DOCTEST_REQUIRE(client.read(payload, &flags));
+  DOCTEST_REQUIRE_EQ(flags, FRAME_MULTIPART);
+  DOCTEST_REQUIRE(file_chunk(payload).second == pattern(150000));
+  DOCTEST_REQUIRE_EQ(client.in_place(), 0u);
+
+  // A FRAME_SHM frame the daemon did not agree to drops the client.
+  std::uint8_t d[ShmSpan::WIRE_BYTES] = {};
+  DOCTEST_REQUIRE(write_frame(*c, d, sizeof(d), FRAME_SHM));
+  DOCTEST_REQUIRE(!client.read(payload, &flags));
+  c.reset();
+
+  srv.stop();
+  t.join();
+}
@@ -0,0 +1,672 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+#include "doctest/doctest.h"
+#include "local_server.hpp"
+#include "request_handler.hpp"
+#include "server_state.hpp"
+#include "tcp_server.hpp"
+#include "transport.hpp"
+#include "wininspect/authorized_keys.hpp"
+#include "wininspect/base64.hpp"
+#include "wininspect/compress.hpp"
+#include "wininspect/core.hpp"
+#include "wininspect/crypto.hpp"
+#include "wininspect/fake_backend.hpp"
+#include "wininspect/session_ticket.hpp"
+#include "wininspect/tinyjson.hpp"
+#include "wininspect/types.hpp"
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <thread>
+
+using namespace wininspect;
+using namespace wininspectd;
+
+static FakeBackend make_backend() {
+  return FakeBackend({{0x10, 0, 0, "Untitled - Notepad", "Notepad", true},
+                      {0x20, 0, 0, "Calculator", "CalcFrame", true}});
+}
+
+static std::string unique_name(const char *tag) {
+  auto t = std::chrono::steady_clock::now().time_since_epoch().count();
+  return std::string("wininspectd-test-") + tag + "-" + std::to_string(t);
+}
+
+// Retries while the server thread is still binding.
+template <typename F> static std::unique_ptr<IConnection> connect_retry(F connect) {
+  for (int i = 0; i < 200; i++) {
+    if (auto c = connect()) return c;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return nullptr;
+}
+
+static json::Object call(IConnection &c, const std::string &id, const std::string &method) {
+  json::Object req;
+  req["id"] = id;
+  req["method"] = method;
+  req["params"] = json::Object{};
+  if (!write_frame(c, json::dumps(req))) return {};
+  std::string resp;
+  if (!read_frame(c, resp)) return {};
+  return json::parse(resp).as_obj();
+}
+
+DOCTEST_TEST_CASE("transport: frames round-trip over the local transport") {
+  auto name = unique_name("frames");
+  auto l = listen_local(name);
+  DOCTEST_REQUIRE(l != nullptr);
+  std::unique_ptr<IConnection> server;
+  std::thread t([&] { server = l->accept(5000); });
+  auto client = connect_retry([&] { return connect_local(name); });
+  t.join();
+  DOCTEST_REQUIRE(client != nullptr);
+  DOCTEST_REQUIRE(server != nullptr);
+
+  std::string big(256 * 1024, 'x');
+  bool sent = false;
+  std::thread w([&] { // larger than the socket buffer, so write concurrently
+    sent = write_frame(*client, "hello") && write_frame(*client, big);
+  });
+  std::string a, b;
+  bool got_a = read_frame(*server, a);
+  bool got_b = read_frame(*server, b);
+  w.join();
+  DOCTEST_REQUIRE(sent);
+  DOCTEST_REQUIRE(got_a && got_b);
+  DOCTEST_REQUIRE_EQ(a, std::string("hello"));
+  DOCTEST_REQUIRE(b == big);
+
+  client.reset();
+  std::string got;
+  DOCTEST_REQUIRE(!read_frame(*server, got)); // EOF
+}
+
+DOCTEST_TEST_CASE("transport: a frame is one write and a burst is one read") {
+  auto name = unique_name("syscalls");
+  auto l = listen_local(name);
+  DOCTEST_REQUIRE(l != nullptr);
+  std::unique_ptr<IConnection> server;
+  std::thread t([&] { server = l->accept(5000); });
+  auto client = connect_retry([&] { return connect_local(name); });
+  t.join();
+  DOCTEST_REQUIRE(client != nullptr);
+  DOCTEST_REQUIRE(server != nullptr);
+
+  auto &io = thread_io_counters();
+  auto w0 = io.writes;
+  for (int i = 0; i < 20; i++)
+    DOCTEST_REQUIRE(write_frame(*client, "{\"id\":\"" + std::to_string(i) + "\"}"));
+  DOCTEST_REQUIRE_EQ(io.writes - w0, 20u); // prefix and payload gathered
+
+  // Everything above is already queued on the socket, so read-ahead
+  // takes all twenty frames in one recv.
+  FrameReader reader(*server);
+  auto r0 = io.reads;
+  std::string f;
+  for (int i = 0; i < 20; i++) {
+    DOCTEST_REQUIRE(reader.read(f));
+    DOCTEST_REQUIRE_EQ(f, "{\"id\":\"" + std::to_string(i) + "\"}");
+  }
+  DOCTEST_REQUIRE_EQ(io.reads - r0, 1u);
+
+  // A frame larger than one read still arrives whole.
+  std::string big(100 * 1024, 'b');
+  std::thread wt([&] { (void)write_frame(*client, big); });
+  bool got = reader.read(f);
+  wt.join();
+  DOCTEST_REQUIRE(got);
+  DOCTEST_REQUIRE_EQ(f, big);
+}
+
+DOCTEST_TEST_CASE("transport: oversized frame length is rejected") {
+  auto l = listen_tcp({{"127.0.0.1", ADDR_FAMILY_IPV4}}, 0);
+  DOCTEST_REQUIRE_EQ(l.size(), 1u);
+  DOCTEST_REQUIRE(l[0]->port() > 0);
+  std::unique_ptr<IConnection> server;
+  std::thread t([&] { server = l[0]->accept(5000); });
+  auto client = connect_tcp("127.0.0.1", l[0]->port());
+  t.join();
+  DOCTEST_REQUIRE(client != nullptr);
+  DOCTEST_REQUIRE(server != nullptr);
+
+  uint8_t len[4] = {0xff, 0xff, 0xff, 0x7f};
+  DOCTEST_REQUIRE(client->write_all(len, sizeof(len)));
+  std::string got;
+  DOCTEST_REQUIRE(!read_frame(*server, got));
+}
+
+DOCTEST_TEST_CASE("transport: local server answers requests against FakeBackend") {
+  auto fb = make_backend();
+  ServerState st;
+  std::atomic<bool> running{true};
+  auto name = unique_name("local");
+  LocalServer srv(&st, &fb);
+  std::thread t([&] { srv.start(&running, name); });
+
+  auto c = connect_retry([&] { return connect_local(name); });
+  DOCTEST_REQUIRE(c != nullptr);
+  auto resp = call(*c, "1", "window.listTop");
+  DOCTEST_REQUIRE(resp.at("ok").as_bool());
+  DOCTEST_REQUIRE_EQ(resp.at("result").as_arr().size(), 2u);
+  c.reset();
+
+  srv.stop();
+  t.join();
+}
+
+DOCTEST_TEST_CASE("transport: multipart frames carry raw attachments both ways") {
+  auto fb = make_backend();
+  ServerState st;
+  std::atomic<bool> running{true};
+  auto name = unique_name("multipart");
+  LocalServer srv(&st, &fb);
+  std::thread t([&] { srv.start(&running, name); });
+  auto c = connect_retry([&] { return connect_local(name); });
+  DOCTEST_REQUIRE(c != nullptr);
+  FrameReader reader(*c);
+
+  // A binary client gets the capture raw, beside the JSON ...
+  json::Object region;
+  region["left"] = 0.0; region["top"] = 0.0; region["right"] = 100.0; region["bottom"] = 100.0;
+  json::Object req;
+  req["id"] = std::string("cap");
+  req["method"] = std::string("screen.capture");
+  req["params"] = region;
+  req["binary"] = true;
+  DOCTEST_REQUIRE(write_frame(*c, json::dumps(req)));
+  std::string frame, body;
+  std::uint32_t flags = 0;
+  DOCTEST_REQUIRE(reader.read(frame, &flags));
+  DOCTEST_REQUIRE_EQ(flags, FRAME_MULTIPART);
+  std::vector<Attachment> atts;
+  DOCTEST_REQUIRE(split_multipart(frame, body, atts));
+  auto resp = json::parse(body).as_obj();
+  DOCTEST_REQUIRE(resp.at("ok").as_bool());
+  DOCTEST_REQUIRE_EQ(atts.size(), 1u);
+  DOCTEST_REQUIRE_EQ(resp.at("result").as_obj().at("data").as_obj().at("size").as_num(),
+                     (double)atts[0].size());
+  DOCTEST_REQUIRE(atts[0][0] == 'B');
+
+  // ... while a legacy client still gets base64 in a plain frame.
+  req.erase("binary");
+  DOCTEST_REQUIRE(write_frame(*c, json::dumps(req)));
+  DOCTEST_REQUIRE(reader.read(frame, &flags));
+  DOCTEST_REQUIRE_EQ(flags, 0u);
+  resp = json::parse(frame).as_obj();
+  DOCTEST_REQUIRE(base64::decode(resp.at("result").as_obj().at("data_b64").as_str()) == atts[0]);
+
+  // Requests can send bytes the same way.
+  json::Object ref;
+  ref["attachment"] = 0.0;
+  json::Object params;
+  params["pid"] = 1.0; params["address"] = 4096.0; params["data"] = ref;
+  req = json::Object{};
+  req["id"] = std::string("w");
+  req["method"] = std::string("mem.write");
+  req["params"] = params;
+  std::string payload;
+  append_multipart(payload, json::dumps(req), {Attachment(1000, 0x90)});
+  DOCTEST_REQUIRE(write_frame(*c, payload.data(), payload.size(), FRAME_MULTIPART));
+  DOCTEST_REQUIRE(reader.read(frame, &flags));
+  DOCTEST_REQUIRE_EQ(flags, 0u);
+  DOCTEST_REQUIRE(json::parse(frame).as_obj().at("ok").as_bool());
+
+  // A malformed multipart frame drops the client.
+  payload.resize(payload.size() - 1);
+  DOCTEST_REQUIRE(write_frame(*c, payload.data(), payload.size(), FRAME_MULTIPART));
+  DOCTEST_REQUIRE(!reader.read(frame, &flags));
+  c.reset();
+
+  srv.stop();
+  t.join();
+}
+
+DOCTEST_TEST_CASE("transport: file.read streams chunks as credit allows") {
+  auto fb = make_backend();
+  std::string data(1000000, '\0');
+  for (size_t i = 0; i < data.size(); i++) data[i] = (char)(i * 13 + i / 997);
+  fb.add_file("C:\\big.log", data);
+  ServerState st;
+  std::atomic<bool> running{true};
+  auto name = unique_name("filestream");
+  LocalServer srv(&st, &fb);
+  std::thread t([&] { srv.start(&running, name); });
+  auto c = connect_retry([&] { return connect_local(name); });
+  DOCTEST_REQUIRE(c != nullptr);
+  c->set_read_timeout(5000);
+  FrameReader reader(*c);
+
+  json::Object params;
+  params["path"] = std::string("C:\\big.log");
+  params["stream"] = true;
+  params["offset"] = 1000.0;
+  params["chunk"] = 200000.0;
+  params["credit"] = 2.0;
+  json::Object req;
+  req["id"] = std::string("fs");
+  req["method"] = std::string("file.read");
+  req["params"] = params;
+  req["binary"] = true;
+  DOCTEST_REQUIRE(write_frame(*c, json::dumps(req)));
+  std::string frame;
+  std::uint32_t flags = 0;
+  DOCTEST_REQUIRE(reader.read(frame, &flags));
+  auto resp = json::parse(frame).as_obj();
+  DOCTEST_REQUIRE(resp.at("result").as_obj().at("streaming").as_bool());
+  DOCTEST_REQUIRE_EQ(resp.at("result").as_obj().at("size").as_num(), 1e6);
+  auto id = resp.at("result").as_obj().at("stream_id").as_str();
+
+  std::string got;
+  bool last = false;
+  auto take = [&] {
+    std::string body;
+    std::vector<Attachment> atts;
+    DOCTEST_REQUIRE(reader.read(frame, &flags));
+    DOCTEST_REQUIRE_EQ(flags, FRAME_MULTIPART);
+    DOCTEST_REQUIRE(split_multipart(frame, body, atts));
+    auto push = json::parse(body).as_obj();
+    DOCTEST_REQUIRE_EQ(push.at("push").as_str(), std::string("file"));
+    DOCTEST_REQUIRE_EQ(push.at("stream_id").as_str(), id);
+    DOCTEST_REQUIRE_EQ(push.at("offset").as_num(), 1000.0 + (double)got.size());
+    got.append(atts.at(0).begin(), atts.at(0).end());
+    last = push.at("last").as_bool();
+    return push;
+  };
+  DOCTEST_REQUIRE_EQ(take().at("credit").as_num(), 1.0);
+  DOCTEST_REQUIRE_EQ(take().at("credit").as_num(), 0.0);
+
+  // Out of credit: the stream waits, and the connection still answers.
+  auto info = call(*c, "1", "window.listTop");
+  DOCTEST_REQUIRE(info.at("ok").as_bool());
+
+  req = json::Object{};
+  req["id"] = std::string("more");
+  req["method"] = std::string("file.credit");
+  json::Object n;
+  n["n"] = 10.0;
+  req["params"] = n;
+  DOCTEST_REQUIRE(write_frame(*c, json::dumps(req)));
+  while (!last) {
+    DOCTEST_REQUIRE(reader.read(frame, &flags));
+    if (flags == 0) { // the file.credit response
+      DOCTEST_REQUIRE_EQ(json::parse(frame).as_obj().at("id").as_str(), std::string("more"));
+      continue;
+    }
+    std::string body;
+    std::vector<Attachment> atts;
+    DOCTEST_REQUIRE(split_multipart(frame, body, atts));
+    auto push = json::parse(body).as_obj();
+    got.append(atts.at(0).begin(), atts.at(0).end());
+    last = push.at("last").as_bool();
+    if (last) DOCTEST_REQUIRE(push.at("eof").as_bool());
+  }
+  DOCTEST_REQUIRE(got == data.substr(1000));
+  c.reset();
+
+  srv.stop();
+  t.join();
+}
+
+static size_t thread_count() {
+#ifdef __linux__
+  size_t n = 0;
+  for (auto &e : std::filesystem::directory_iterator("/proc/self/task")) (void)e, n++;
+  return n;
+#else
+  return 0;
+#endif
+}
+
+DOCTEST_TEST_CASE("transport: events.stream subscribers share the I/O threads") {
+  auto fb = make_backend();
+  ServerState st;
+  std::atomic<bool> running{true};
+  auto name = unique_name("evstream");
+  LocalServer srv(&st, &fb);
+  std::thread t([&] { srv.start(&running, name); });
+
+  constexpr int N = 32;
+  std::vector<std::unique_ptr<IConnection>> cs;
+  for (int i = 0; i < N; i++) {
+    auto c = connect_retry([&] { return connect_local(name); });
+    DOCTEST_REQUIRE(c != nullptr);
+    c->set_read_timeout(5000);
+    DOCTEST_REQUIRE(call(*c, "h", "daemon.health").at("ok").as_bool());
+    cs.push_back(std::move(c));
+  }
+  size_t before = thread_count();
+
+  auto request = [](const char *id, const char *method, const char *key, double v) {
+    json::Object params, req;
+    params[key] = v;
+    req["id"] = std::string(id);
+    req["method"] = std::string(method);
+    req["params"] = params;
+    return json::dumps(req);
+  };
+  std::string frame;
+  for (auto &c : cs) {
+    DOCTEST_REQUIRE(write_frame(*c, request("s", "events.stream", "credit", 1)));
+    DOCTEST_REQUIRE(read_frame(*c, frame));
+    DOCTEST_REQUIRE(json::parse(frame).as_obj().at("result").as_obj().at("streaming").as_bool());
+  }
+  // A stream is a registration, not a thread.
+  DOCTEST_REQUIRE(thread_count() <= before);
+
+  std::vector<Event> events(2);
+  events[0].type = "window.created";
+  events[0].hwnd = 0x30;
+  events[1].type = "window.destroyed";
+  events[1].hwnd = 0x30;
+  publish_events(&st, events, Snapshot{});
+  auto pushed = [&](IConnection &c) {
+    DOCTEST_REQUIRE(read_frame(c, frame));
+    auto o = json::parse(frame).as_obj();
+    DOCTEST_REQUIRE_EQ(o.at("push").as_str(), std::string("events"));
+    DOCTEST_REQUIRE_EQ(o.at("events").as_arr().size(), 1u);
+    return o.at("events").as_arr()[0].as_obj();
+  };
+  for (auto &c : cs) DOCTEST_REQUIRE_EQ(pushed(*c).at("seq").as_num(), 1.0);
+
+  // Out of credit until the grant, which sends what is queued.
+  DOCTEST_REQUIRE(write_frame(*cs[0], request("c", "events.credit", "n", 5)));
+  bool replied = false, got = false;
+  while (!replied || !got) {
+    DOCTEST_REQUIRE(read_frame(*cs[0], frame));
+    auto o = json::parse(frame).as_obj();
+    if (o.count("id")) {
+      DOCTEST_REQUIRE_EQ(o.at("id").as_str(), std::string("c"));
+      replied = true;
+    } else {
+      DOCTEST_REQUIRE_EQ(o.at("events").as_arr()[0].as_obj().at("seq").as_num(), 2.0);
+      got = true;
+    }
+  }
+  cs.clear();
+
+  srv.stop();
+  t.join();
+}
+
+DOCTEST_TEST_CASE("transport: TCP server on an ephemeral port greets and serves") {
+  auto fb = make_backend();
+  ServerState st;
+  std::atomic<bool> running{true};
+  NetworkConfig cfg;
+  cfg.bind = {{"127.0.0.1", ADDR_FAMILY_IPV4}};
+  cfg.port = 0;
+  cfg.rate_limit_ms = 0;
+  TcpServer srv(&st, &fb);
+  std::thread t([&] { srv.start(&running, cfg); });
+
+  for (int i = 0; i < 200 && srv.bound_port() == 0; i++)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  DOCTEST_REQUIRE(srv.bound_port() > 0);
+  auto c = connect_tcp("127.0.0.1", srv.bound_port());
+  DOCTEST_REQUIRE(c != nullptr);
+
+  std::string hello;
+  DOCTEST_REQUIRE(read_frame(*c, hello));
+  DOCTEST_REQUIRE_EQ(json::parse(hello).as_obj().at("type").as_str(), std::string("hello"));
+  auto resp = call(*c, "7", "window.listTop");
+  DOCTEST_REQUIRE(resp.at("ok").as_bool());
+  DOCTEST_REQUIRE_EQ(resp.at("result").as_arr().size(), 2u);
+  c.reset();
+
+  srv.stop();
+  t.join();
+}
+
+// The client half of the TCP handshake, as the CLI does it.
+static json::Object full_auth(IConnection &c, const json::Object &hello,
+                              crypto::CryptoSession &session, const char *codec = nullptr) {
+  auto nonce = base64::decode(hello.at("nonce").as_str());
+  json::Object auth;
+  auth["version"] = std::string(PROTOCOL_VERSION);
+  auth["identity"] = std::string("wininspect-test");
+  auth["signature"] = crypto::sign_ssh_msg(nonce, "tests/keys/wininspect-test");
+  auth["pubkey"] = base64::encode(session.generate_local_key());
+  if (codec) auth["compression"] = std::string(codec);
+  std::string frame;
+  if (!write_frame(c, json::dumps(auth)) || !read_frame(c, frame)) return {};
+  auto status = json::parse(frame).as_obj();
+  if (!session.compute_shared_secret(base64::decode(hello.at("pubkey").as_str()))) return {};
+  return status;
+}
+
+static json::Object resume(IConnection &c, const json::Object &hello, const std::string &ticket,
+                           const std::array<std::uint8_t, 32> &secret,
+                           crypto::CryptoSession &session) {
+  std::vector<std::uint8_t> client_random(32);
+  if (!crypto::random_bytes(client_random.data(), client_random.size())) return {};
+  json::Object req;
+  req["version"] = std::string(PROTOCOL_VERSION);
+  req["resume"] = ticket;
+  req["client_random"] = base64::encode(client_random);
+  std::string frame;
+  if (!write_frame(c, json::dumps(req)) || !read_frame(c, frame)) return {};
+  auto status = json::parse(frame).as_obj();
+  std::uint8_t key[32];
+  if (status.at("ok").as_bool() &&
+      !(TicketKeeper::derive_key(secret, base64::decode(hello.at("nonce").as_str()),
+                                 client_random, key) &&
+        session.install_key(key)))
+    return {};
+  return status;
+}
+
+static bool encrypted_call(IConnection &c, crypto::CryptoSession &session, const std::string &id) {
+  json::Object req;
+  req["id"] = id;
+  req["method"] = std::string("window.listTop");
+  req["params"] = json::Object{};
+  auto rec = session.encrypt(json::dumps(req));
+  std::string frame;
+  if (!write_frame(c, rec.data(), rec.size()) || !read_frame(c, frame)) return false;
+  auto plain = session.decrypt(std::vector<uint8_t>(frame.begin(), frame.end()));
+  if (plain.empty()) return false;
+  auto resp = json::parse(plain).as_obj();
+  return resp.at("ok").as_bool() && resp.at("id").as_str() == id;
+}
+
+DOCTEST_TEST_CASE("transport: TCP server authenticates and encrypts") {
+  // Needs a backend that can sign with an OpenSSH key file (OpenSSL).
+  if (std::string(crypto::backend_name()) != "openssl") return;
+  auto keys = std::make_shared<AuthorizedKeysFile>("tests/keys/wininspect-test.pub");
+  DOCTEST_REQUIRE_EQ(keys->current()->keys(), 1u);
+
+  auto fb = make_backend();
+  ServerState st;
+  std::atomic<bool> running{true};
+  NetworkConfig cfg;
+  cfg.bind = {{"127.0.0.1", ADDR_FAMILY_IPV4}};
+  cfg.port = 0;
+  cfg.rate_limit_ms = 0;
+  TcpServer srv(&st, &fb);
+  std::thread t([&] { srv.start(&running, cfg, keys); });
+  for (int i = 0; i < 200 && srv.bound_port() == 0; i++)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  DOCTEST_REQUIRE(srv.bound_port() > 0);
+  auto c = connect_tcp("127.0.0.1", srv.bound_port());
+  DOCTEST_REQUIRE(c != nullptr);
+
+  std::string frame;
+  DOCTEST_REQUIRE(read_frame(*c, frame));
+  auto hello = json::parse(frame).as_obj();
+  crypto::CryptoSession session;
+  auto status = full_auth(*c, hello, session);
+  DOCTEST_REQUIRE(status.at("ok").as_bool());
+  DOCTEST_REQUIRE(status.at("encrypted").as_bool());
+
+  // Three pipelined requests, then their sealed responses in any order.
+  FrameReader reader(*c);
+  for (int i = 0; i < 3; i++) {
+    json::Object req;
+    req["id"] = std::to_string(i);
+    req["method"] = std::string("window.listTop");
+    req["params"] = json::Object{};
+    auto rec = session.encrypt(json::dumps(req));
+    DOCTEST_REQUIRE(write_frame(*c, rec.data(), rec.size()));
+  }
+  int seen = 0;
+  for (int i = 0; i < 3; i++) {
+    DOCTEST_REQUIRE(reader.read(frame));
+    DOCTEST_REQUIRE(frame.size() > crypto::RECORD_OVERHEAD); // sealed, not JSON
+    auto plain = session.decrypt(std::vector<uint8_t>(frame.begin(), frame.end()));
+    DOCTEST_REQUIRE(!plain.empty());
+    auto resp = json::parse(plain).as_obj();
+    DOCTEST_REQUIRE(resp.at("ok").as_bool());
+    seen |= 1 << std::stoi(resp.at("id").as_str());
+  }
+  DOCTEST_REQUIRE_EQ(seen, 7);
+  c.reset();
+
+  srv.stop();
+  t.join();
+}
+
+DOCTEST_TEST_CASE("transport: TCP clients resume with a single-use ticket") {
+  if (std::string(crypto::backend_name()) != "openssl") return;
+  auto keys = std::make_shared<AuthorizedKeysFile>("tests/keys/wininspect-test.pub");
+
+  auto fb = make_backend();
+  ServerState st;
+  std::atomic<bool> running{true};
+  NetworkConfig cfg;
+  cfg.bind = {{"127.0.0.1", ADDR_FAMILY_IPV4}};
+  cfg.port = 0;
+  cfg.rate_limit_ms = 0;
+  TcpServer srv(&st, &fb);
+  std::thread t([&] { srv.start(&running, cfg, keys); });
+  for (int i = 0; i < 200 && srv.bound_port() == 0; i++)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  DOCTEST_REQUIRE(srv.bound_port() > 0);
+
+  auto connect = [&](json::Object &hello) {
+    auto c = connect_tcp("127.0.0.1", srv.bound_port());
+    std::string frame;
+    if (c && read_frame(*c, frame)) hello = json::parse(frame).as_obj();
+    return c;
+  };
+
+  // A full handshake hands out the first ticket.
+  json::Object hello;
+  auto c = connect(hello);
+  DOCTEST_REQUIRE(c != nullptr);
+  crypto::CryptoSession s1;
+  auto status = full_auth(*c, hello, s1);
+  DOCTEST_REQUIRE(status.at("ok").as_bool());
+  DOCTEST_REQUIRE(status.at("encrypted").as_bool());
+  auto ticket = status.at("ticket").as_str();
+  auto secret = s1.resumption_secret();
+  DOCTEST_REQUIRE(encrypted_call(*c, s1, "a"));
+  c.reset();
+
+  // Resuming needs neither a signature nor ECDH, and yields the next ticket.
+  c = connect(hello);
+  crypto::CryptoSession s2;
+  status = resume(*c, hello, ticket, secret, s2);
+  DOCTEST_REQUIRE(status.at("ok").as_bool());
+  DOCTEST_REQUIRE(status.at("resumed").as_bool());
+  DOCTEST_REQUIRE(encrypted_call(*c, s2, "b"));
+  auto next = status.at("ticket").as_str();
+  DOCTEST_REQUIRE(next != ticket);
+  c.reset();
+
+  // The spent ticket is refused, and the same connection falls back.
+  c = connect(hello);
+  crypto::CryptoSession s3;
+  status = resume(*c, hello, ticket, secret, s3);
+  DOCTEST_REQUIRE(!status.at("ok").as_bool());
+  DOCTEST_REQUIRE_EQ(status.at("error").as_str(), std::string("E_RESUME_REJECTED"));
+  status = full_auth(*c, hello, s3);
+  DOCTEST_REQUIRE(status.at("ok").as_bool());
+  DOCTEST_REQUIRE(encrypted_call(*c, s3, "c"));
+  c.reset();
+
+  // A ticket is only as good as the secret that goes with it.
+  c = connect(hello);
+  crypto::CryptoSession s4;
+  std::array<std::uint8_t, 32> wrong{};
+  status = resume(*c, hello, next, wrong, s4);
+  DOCTEST_REQUIRE(status.at("ok").as_bool());
+  DOCTEST_REQUIRE(!encrypted_call(*c, s4, "d"));
+  c.reset();
+
+  srv.stop();
+  t.join();
+}
+
+DOCTEST_TEST_CASE("transport: TCP compresses large frames before sealing them") {
+  if (std::string(crypto::backend_name()) != "openssl") return;
+  auto keys = std::make_shared<AuthorizedKeysFile>("tests/keys/wininspect-test.pub");
+
+  std::vector<FakeWindow> windows;
+  for (int i = 0; i < 200; i++)
+    windows.push_back({(hwnd_u64)(0x100 + i), 0, 0, "Untitled - Notepad", "Notepad", true});
+  FakeBackend fb(windows);
+  ServerState st;
+  st.compress_min_bytes = 256;
+  std::atomic<bool> running{true};
+  NetworkConfig cfg;
+  cfg.bind = {{"127.0.0.1", ADDR_FAMILY_IPV4}};
+  cfg.port = 0;
+  cfg.rate_limit_ms = 0;
+  TcpServer srv(&st, &fb);
+  std::thread t([&] { srv.start(&running, cfg, keys); });
+  for (int i = 0; i < 200 && srv.bound_port() == 0; i++)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  DOCTEST_REQUIRE(srv.bound_port() > 0);
+  auto c = connect_tcp("127.0.0.1", srv.bound_port());
+  DOCTEST_REQUIRE(c != nullptr);
+
+  std::string frame;
+  DOCTEST_REQUIRE(read_frame(*c, frame));
+  auto hello = json::parse(frame).as_obj();
+  DOCTEST_REQUIRE_EQ(hello.at("compression").as_arr().at(0).as_str(), std::string("lz4"));
+  crypto::CryptoSession session;
+  auto status = full_auth(*c, hello, session, "lz4");
+  DOCTEST_REQUIRE(status.at("ok").as_bool());
+  DOCTEST_REQUIRE_EQ(status.at("compression").as_str(), std::string("lz4"));
+
+  // A compressed request (padded so that packing pays) ...
+  json::Object req;
+  req["id"] = std::string("big");
+  req["method"] = std::string("window.listTop");
+  req["params"] = json::Object{{"pad", std::string(2000, ' ')}};
+  auto plain = json::dumps(req);
+  std::string packed;
+  DOCTEST_REQUIRE(compress::pack(compress::Codec::Lz4, plain.data(), plain.size(), packed));
+  auto rec = session.encrypt(packed);
+  DOCTEST_REQUIRE(write_frame(*c, rec.data(), rec.size(), FRAME_COMPRESSED));
+
+  // ... gets a compressed response: flagged, sealed, then packed inside.
+  FrameReader reader(*c);
+  std::uint32_t flags = 0;
+  DOCTEST_REQUIRE(reader.read(frame, &flags));
+  DOCTEST_REQUIRE_EQ(flags, FRAME_COMPRESSED);
+  auto opened = session.decrypt(std::vector<uint8_t>(frame.begin(), frame.end()));
+  DOCTEST_REQUIRE(!opened.empty());
+  std::string body;
+  DOCTEST_REQUIRE(compress::unpack(opened.data(), opened.size(), MAX_FRAME_BYTES, body));
+  DOCTEST_REQUIRE(body.size() > 2 * opened.size());
+  auto resp = json::parse(body).as_obj();
+  DOCTEST_REQUIRE(resp.at("ok").as_bool());
+  DOCTEST_REQUIRE_EQ(resp.at("id").as_str(), std::string("big"));
+
+  // Small responses stay as they are.
+  req["id"] = std::string("small");
+  req["method"] = std::string("no.such.method"); // a short error
+  req["params"] = json::Object{};
+  rec = session.encrypt(json::dumps(req));
+  DOCTEST_REQUIRE(write_frame(*c, rec.data(), rec.size()));
+  DOCTEST_REQUIRE(reader.read(frame, &flags));
+  DOCTEST_REQUIRE_EQ(flags, 0u);
+  c.reset();
+
+  srv.stop();
+  t.join();
+}
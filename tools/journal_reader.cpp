@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2026 Mark E. DeYoung
+
+// Offline reader for a daemon snapshot journal (--journal-dir).
+//
+//   wininspect-journal <dir>              list every record
+//   wininspect-journal <dir> <seq>        dump the windows of one record
+//
+// Segments are memory-mapped read-only, so this is safe to run against the
+// journal of a live daemon; only the record asked for is decoded.
+
+#include "wininspect/snapshot_journal.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace wininspect;
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    std::cerr << "usage: wininspect-journal <dir> [seq]" << std::endl;
+    return 2;
+  }
+
+  std::vector<std::string> paths;
+  std::error_code ec;
+  for (const auto &de : fs::directory_iterator(argv[1], ec))
+    if (de.path().extension() == ".wij") paths.push_back(de.path().string());
+  if (ec) {
+    std::cerr << "cannot read " << argv[1] << ": " << ec.message() << std::endl;
+    return 1;
+  }
+  std::sort(paths.begin(), paths.end()); // names sort by first seq
+
+  uint64_t want = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 0;
+  for (const auto &p : paths) {
+    auto seg = JournalSegment::open(p);
+    if (!seg) {
+      std::cerr << "skipping " << p << ": not a journal segment" << std::endl;
+      continue;
+    }
+    if (want == 0) {
+      std::cout << "# " << fs::path(p).filename().string()
+                << (seg->sealed() ? "" : " (unsealed)") << std::endl;
+      for (const auto &e : seg->entries())
+        std::cout << "j-" << e.seq << "\t" << e.time_ms << "\t" << e.window_count
+                  << " windows" << std::endl;
+      continue;
+    }
+    auto rec = seg->record(want);
+    if (!rec) continue;
+    std::cout << "j-" << rec->seq() << " time_ms=" << rec->time_ms()
+              << " windows=" << rec->size() << std::endl;
+    for (uint32_t i = 0; i < rec->size(); i++) {
+      auto w = rec->window(i);
+      char hwnd[24];
+      std::snprintf(hwnd, sizeof(hwnd), "0x%llx", (unsigned long long)w.hwnd);
+      std::cout << hwnd << "\t" << w.class_name << "\t" << w.title << std::endl;
+    }
+    return 0;
+  }
+  if (want != 0) {
+    std::cerr << "record j-" << want << " not found" << std::endl;
+    return 1;
+  }
+  return 0;
+}